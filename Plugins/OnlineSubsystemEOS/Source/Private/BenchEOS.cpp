@@ -0,0 +1,100 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "BenchEOS.h"
+#include "SocketSubsystemEOS.h"
+#include "SessionPingEOS.h"
+#include "MatchmakingEOS.h"
+#include "SessionPrefetchEOS.h"
+#include "P2PLoopbackEOS.h"
+#include "Misc/ScopeLock.h"
+
+#if WITH_EOS_SDK && !UE_BUILD_SHIPPING
+
+namespace
+{
+	typedef bool (*FBenchHandlerEOS)(FSocketSubsystemEOS& SocketSubsystem, const TCHAR* Cmd, FOutputDevice& Ar);
+
+	struct FBenchEntryEOS
+	{
+		const TCHAR* Name;
+		const TCHAR* Description;
+		FBenchHandlerEOS Handler;
+	};
+
+	const FBenchEntryEOS Benches[] =
+	{
+		{
+			TEXT("P2P"), TEXT("P2P socket throughput over the loopback transport"),
+			[](FSocketSubsystemEOS& SocketSubsystem, const TCHAR* Cmd, FOutputDevice& Ar) { return SocketSubsystem.HandleP2PBenchExec(Cmd, Ar); }
+		},
+		{
+			TEXT("PING"), TEXT("session pings against loopback hosts with known latencies"),
+			[](FSocketSubsystemEOS& SocketSubsystem, const TCHAR* Cmd, FOutputDevice& Ar) { return FSessionPingEOS::HandleBenchExec(SocketSubsystem, Cmd, Ar); }
+		},
+		{
+			TEXT("MATCHMAKING"), TEXT("time to match against a simulated sessions backend"),
+			[](FSocketSubsystemEOS& SocketSubsystem, const TCHAR* Cmd, FOutputDevice& Ar) { return FMatchmakingEOS::HandleBenchExec(Cmd, Ar); }
+		},
+		{
+			TEXT("PREFETCH"), TEXT("server browser joins with and without prefetching"),
+			[](FSocketSubsystemEOS& SocketSubsystem, const TCHAR* Cmd, FOutputDevice& Ar) { return FSessionPrefetchEOS::HandleBenchExec(Cmd, Ar); }
+		},
+	};
+}
+
+FBenchSummaryEOS::FBenchSummaryEOS(TArray<double>& Samples)
+	: Mean(0.0)
+	, P50(0.0)
+	, P95(0.0)
+{
+	if (Samples.Num() == 0)
+	{
+		return;
+	}
+
+	Samples.Sort();
+	double Total = 0.0;
+	for (double Sample : Samples)
+	{
+		Total += Sample;
+	}
+	Mean = Total / Samples.Num();
+	P50 = Samples[Samples.Num() / 2];
+	P95 = Samples[FMath::Min(Samples.Num() * 95 / 100, Samples.Num() - 1)];
+}
+
+bool FBenchEOS::HandleExec(FSocketSubsystemEOS& SocketSubsystem, const TCHAR* Cmd, FOutputDevice& Ar)
+{
+	for (const FBenchEntryEOS& Bench : Benches)
+	{
+		if (FParse::Command(&Cmd, Bench.Name))
+		{
+			return Bench.Handler(SocketSubsystem, Cmd, Ar);
+		}
+	}
+
+	Ar.Logf(TEXT("Usage: EOS BENCH <Name> [Key=Value ...]"));
+	for (const FBenchEntryEOS& Bench : Benches)
+	{
+		Ar.Logf(TEXT("  %s - %s"), Bench.Name, Bench.Description);
+	}
+	return true;
+}
+
+FP2PLoopbackEOS* FBenchEOS::GetLoopback(FOutputDevice& Ar)
+{
+	FP2PLoopbackEOS* Loopback = FP2PLoopbackEOS::Get();
+	if (Loopback == nullptr)
+	{
+		Ar.Logf(TEXT("This bench needs the loopback transport, run with -EOSP2PLoopback or set bUseLoopbackP2P"));
+	}
+	return Loopback;
+}
+
+void FBenchEOS::TickLoopback(FSocketSubsystemEOS& SocketSubsystem, FP2PLoopbackEOS& Loopback, float DeltaTime)
+{
+	FScopeLock P2PScopeLock(&SocketSubsystem.GetP2PLock());
+	Loopback.Tick(DeltaTime);
+}
+
+#endif
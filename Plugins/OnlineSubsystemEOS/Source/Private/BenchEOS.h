@@ -0,0 +1,47 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+#if WITH_EOS_SDK && !UE_BUILD_SHIPPING
+
+class FSocketSubsystemEOS;
+class FP2PLoopbackEOS;
+
+/** Mean and percentiles of a bench's samples */
+struct FBenchSummaryEOS
+{
+	double Mean;
+	double P50;
+	double P95;
+
+	/** Sorts the samples to read the percentiles off, everything is zero when there are none */
+	explicit FBenchSummaryEOS(TArray<double>& Samples);
+};
+
+/**
+ * Runs the EOS BENCH console command. Each bench drives one part of the plugin against a mock backend or the
+ * loopback transport and logs how it does. They are development tools and aren't built into shipping builds
+ */
+class FBenchEOS
+{
+public:
+	/**
+	 * Runs the named bench, listing the benches when the name isn't known
+	 *
+	 * @param SocketSubsystem the socket subsystem the P2P benches open their sockets on
+	 * @param Cmd the rest of the command, the bench name followed by its Key=Value arguments
+	 * @param Ar where to write the results
+	 * @return true if the command was handled
+	 */
+	static bool HandleExec(FSocketSubsystemEOS& SocketSubsystem, const TCHAR* Cmd, FOutputDevice& Ar);
+
+	/** @return the loopback transport, or null after telling the user how to turn it on */
+	static FP2PLoopbackEOS* GetLoopback(FOutputDevice& Ar);
+
+	/** Advances the loopback transport the way the platform tick does, keeping the P2P I/O thread out meanwhile */
+	static void TickLoopback(FSocketSubsystemEOS& SocketSubsystem, FP2PLoopbackEOS& Loopback, float DeltaTime);
+};
+
+#endif
@@ -3,6 +3,7 @@
 #include "InternetAddrEOS.h"
 #include "UObject/CoreOnline.h"
 #include "OnlineSubsystemEOSTypes.h"
+#include "P2PLoopbackEOS.h"
 
 DEFINE_LOG_CATEGORY(LogSocketSubsystemEOS);
 
@@ -15,16 +16,27 @@ FInternetAddrEOS::FInternetAddrEOS()
 	: LocalUserId(nullptr)
 	, RemoteUserId(nullptr)
 	, Channel(0)
+	, CachedStringNoPortLen(0)
 {
 	SocketName[0] = '\0';
 }
 
+FInternetAddrEOS::FInternetAddrEOS(const FInternetAddrEOS& Other)
+	: LocalUserId(Other.LocalUserId)
+	, RemoteUserId(Other.RemoteUserId)
+	, Channel(Other.Channel)
+	, CachedStringNoPortLen(0)
+{
+	FCStringAnsi::Strcpy(SocketName, Other.SocketName);
+}
+
 FInternetAddrEOS::FInternetAddrEOS(const FString& InRemoteUserId, const FString& InSocketName, const int32 InChannel)
 	: LocalUserId(nullptr)
 	, RemoteUserId(nullptr)
+	, CachedStringNoPortLen(0)
 {
 #if WITH_EOS_SDK
-	RemoteUserId = EOS_ProductUserId_FromString(TCHAR_TO_UTF8(*InRemoteUserId));
+	RemoteUserId = FP2PTransportEOS::ProductUserIdFromString(TCHAR_TO_UTF8(*InRemoteUserId));
 #endif
 	FCStringAnsi::Strcpy(SocketName, TCHAR_TO_UTF8(*InSocketName));
 	Channel = PortToChannel(InChannel);
@@ -35,6 +47,7 @@ FInternetAddrEOS::FInternetAddrEOS(const EOS_ProductUserId InRemoteUserId, const
 	: LocalUserId(nullptr)
 	, RemoteUserId(InRemoteUserId)
 	, Channel(InChannel)
+	, CachedStringNoPortLen(0)
 {
 	FCStringAnsi::Strcpy(SocketName, TCHAR_TO_UTF8(*InSocketName));
 	Channel = PortToChannel(InChannel);
@@ -56,34 +69,72 @@ void FInternetAddrEOS::SetIp(const TCHAR* InAddr, bool& bIsValid)
 	}
 
 	Channel = 0;
+	InvalidateCachedString();
 
-	TArray<FString> UrlParts;
-	FString FullAddress = InAddr;
-	FullAddress.ParseIntoArray(UrlParts, EOS_URL_SEPARATOR, false);
 	// Expect URLs to look like "EOS:PUID:SocketName:Channel" and channel can be optional
-	if (UrlParts.Num() < 3 || UrlParts.Num() > 4)
+	// Split in place so parsing addresses does not allocate
+	const TCHAR* UrlParts[4];
+	int32 UrlPartLens[4];
+	int32 NumUrlParts = 0;
+	const TCHAR* PartStart = InAddr;
+	for (const TCHAR* Char = InAddr; ; ++Char)
+	{
+		if (*Char == EOS_URL_SEPARATOR[0] || *Char == TEXT('\0'))
+		{
+			if (NumUrlParts == UE_ARRAY_COUNT(UrlParts))
+			{
+				return;
+			}
+			UrlParts[NumUrlParts] = PartStart;
+			UrlPartLens[NumUrlParts] = (int32)(Char - PartStart);
+			NumUrlParts++;
+
+			if (*Char == TEXT('\0'))
+			{
+				break;
+			}
+			PartStart = Char + 1;
+		}
+	}
+	if (NumUrlParts < 3)
 	{
 		return;
 	}
-	if (UrlParts[0] != EOS_CONNECTION_URL_PREFIX)
+	if (UrlPartLens[0] != FCString::Strlen(EOS_CONNECTION_URL_PREFIX) || FCString::Strnicmp(UrlParts[0], EOS_CONNECTION_URL_PREFIX, UrlPartLens[0]) != 0)
 	{
 		return;
 	}
 #if WITH_EOS_SDK
-	RemoteUserId = EOS_ProductUserId_FromString(TCHAR_TO_UTF8(*UrlParts[1]));
-	if (EOS_ProductUserId_IsValid(RemoteUserId) == EOS_FALSE)
+	// Product user ids are plain hex so a straight narrowing copy is enough
+	char PuidBuffer[64];
+	if (UrlPartLens[1] >= UE_ARRAY_COUNT(PuidBuffer))
+	{
+		return;
+	}
+	for (int32 Index = 0; Index < UrlPartLens[1]; Index++)
+	{
+		PuidBuffer[Index] = (char)UrlParts[1][Index];
+	}
+	PuidBuffer[UrlPartLens[1]] = '\0';
+
+	RemoteUserId = FP2PTransportEOS::ProductUserIdFromString(PuidBuffer);
+	if (FP2PTransportEOS::ProductUserIdIsValid(RemoteUserId) == EOS_FALSE)
 #endif
 	{
 		return;
 	}
-	if (UrlParts[2].Len() == 0)
+	if (UrlPartLens[2] == 0)
 	{
 		return;
 	}
-	FCStringAnsi::Strcpy(SocketName, TCHAR_TO_UTF8(*UrlParts[2]));
-	if (UrlParts.Num() == 4)
+	FTCHARToUTF8 SocketNameUtf8(UrlParts[2], UrlPartLens[2]);
+	const int32 SocketNameLen = FMath::Min<int32>(SocketNameUtf8.Length(), UE_ARRAY_COUNT(SocketName) - 1);
+	FMemory::Memcpy(SocketName, SocketNameUtf8.Get(), SocketNameLen);
+	SocketName[SocketNameLen] = '\0';
+	if (NumUrlParts == 4)
 	{
-		Channel = FCString::Atoi(*UrlParts[3]);
+		// The channel is the last part so it is already null terminated
+		Channel = FCString::Atoi(UrlParts[3]);
 	}
 	bIsValid = true;
 }
@@ -98,6 +149,7 @@ void FInternetAddrEOS::GetIp(uint32& OutAddr) const
 void FInternetAddrEOS::SetPort(int32 InPort)
 {
 	Channel = PortToChannel(InPort);
+	InvalidateCachedString();
 }
 
 int32 FInternetAddrEOS::GetPort() const
@@ -117,18 +169,13 @@ void FInternetAddrEOS::SetRawIp(const TArray<uint8>& RawAddr)
 
 TArray<uint8> FInternetAddrEOS::GetRawIp() const
 {
-	// We could do this more efficiently, but this was much faster to write.
-	const FString StringVersion = ToString(true);
+	UpdateCachedString();
 
 	// Need auto here, as might give us different return type depending on size of TCHAR
-	auto ConvertedANSIData = StringCast<ANSICHAR>(*StringVersion, StringVersion.Len());
+	auto ConvertedANSIData = StringCast<ANSICHAR>(*CachedString, CachedString.Len());
 
 	TArray<uint8> OutData;
-	for (int32 Index = 0; Index < ConvertedANSIData.Length(); ++Index)
-	{
-		OutData.Add(ConvertedANSIData.Get()[Index]);
-	}
-
+	OutData.Append(reinterpret_cast<const uint8*>(ConvertedANSIData.Get()), ConvertedANSIData.Length());
 	return OutData;
 }
 
@@ -145,33 +192,59 @@ void FInternetAddrEOS::SetLoopbackAddress()
 }
 
 FString FInternetAddrEOS::ToString(bool bAppendPort) const
+{
+	UpdateCachedString();
+	return bAppendPort ? CachedString : CachedString.Left(CachedStringNoPortLen);
+}
+
+void FInternetAddrEOS::UpdateCachedString() const
+{
+	if (!CachedString.IsEmpty())
+	{
+		return;
+	}
+
+	TCHAR Buffer[MaxStringLength];
+	const int32 Length = WriteString(Buffer, true);
+	CachedString = FString(Length, Buffer);
+	// The channel always comes after the last separator
+	const TCHAR* ChannelSeparator = FCString::Strrchr(Buffer, EOS_URL_SEPARATOR[0]);
+	CachedStringNoPortLen = ChannelSeparator != nullptr ? (int32)(ChannelSeparator - Buffer) : Length;
+}
+
+int32 FInternetAddrEOS::WriteString(TCHAR (&OutBuffer)[MaxStringLength], bool bAppendPort) const
 {
 	char PuidBuffer[64];
 	int32 BufferLen = 64;
 #if WITH_EOS_SDK
-	if (EOS_ProductUserId_ToString(RemoteUserId, PuidBuffer, &BufferLen) != EOS_EResult::EOS_Success)
+	if (FP2PTransportEOS::ProductUserIdToString(RemoteUserId, PuidBuffer, &BufferLen) != EOS_EResult::EOS_Success)
 #endif
 	{
 		PuidBuffer[0] = '\0';
 	}
 
+	// Product user ids are plain hex and socket names are short, so everything fits in the buffer
 	if (bAppendPort)
 	{
-		return FString::Printf(TEXT("%s%s%s%s%s%s%u"), EOS_CONNECTION_URL_PREFIX, EOS_URL_SEPARATOR, UTF8_TO_TCHAR(PuidBuffer), EOS_URL_SEPARATOR, UTF8_TO_TCHAR(SocketName), EOS_URL_SEPARATOR, Channel);
+		FCString::Snprintf(OutBuffer, MaxStringLength, TEXT("%s%s%s%s%s%s%u"), EOS_CONNECTION_URL_PREFIX, EOS_URL_SEPARATOR, UTF8_TO_TCHAR(PuidBuffer), EOS_URL_SEPARATOR, UTF8_TO_TCHAR(SocketName), EOS_URL_SEPARATOR, Channel);
 	}
-
-	return FString::Printf(TEXT("%s%s%s%s%s"), EOS_CONNECTION_URL_PREFIX, EOS_URL_SEPARATOR, UTF8_TO_TCHAR(PuidBuffer), EOS_URL_SEPARATOR, UTF8_TO_TCHAR(SocketName));
+	else
+	{
+		FCString::Snprintf(OutBuffer, MaxStringLength, TEXT("%s%s%s%s%s"), EOS_CONNECTION_URL_PREFIX, EOS_URL_SEPARATOR, UTF8_TO_TCHAR(PuidBuffer), EOS_URL_SEPARATOR, UTF8_TO_TCHAR(SocketName));
+	}
+	return FCString::Strlen(OutBuffer);
 }
 
 uint32 FInternetAddrEOS::GetTypeHash() const
 {
-	return HashCombine(HashCombine(HashCombine(::GetTypeHash((void*)LocalUserId), ::GetTypeHash((void *)RemoteUserId)), ::GetTypeHash(SocketName)), Channel);
+	// Socket names compare case insensitively, so they have to hash that way too
+	return HashCombine(HashCombine(HashCombine(::GetTypeHash((void*)LocalUserId), ::GetTypeHash((void *)RemoteUserId)), FCrc::Strihash_DEPRECATED(SocketName)), Channel);
 }
 
 bool FInternetAddrEOS::IsValid() const
 {
 #if WITH_EOS_SDK
-	return (EOS_ProductUserId_IsValid(LocalUserId) == EOS_TRUE || EOS_ProductUserId_IsValid(RemoteUserId) == EOS_TRUE) && FCStringAnsi::Strlen(SocketName) > 0;
+	return (FP2PTransportEOS::ProductUserIdIsValid(LocalUserId) == EOS_TRUE || FP2PTransportEOS::ProductUserIdIsValid(RemoteUserId) == EOS_TRUE) && FCStringAnsi::Strlen(SocketName) > 0;
 #else
 	return false;
 #endif
@@ -22,6 +22,8 @@ public:
 #if WITH_EOS_SDK
 	FInternetAddrEOS(const EOS_ProductUserId InRemoteUserId, const FString& InSocketName, const int32 InChannel);
 #endif
+	/** Copies everything but the cached string, so addresses copied into packets and tables don't allocate */
+	FInternetAddrEOS(const FInternetAddrEOS& Other);
 	virtual ~FInternetAddrEOS() = default;
 
 //~ Begin FInternetAddr Interface
@@ -47,6 +49,7 @@ public:
 		RemoteUserId = Other.RemoteUserId;
 		FCStringAnsi::Strcpy(SocketName, Other.SocketName);
 		Channel = Other.Channel;
+		InvalidateCachedString();
 		return *this;
 	}
 	
@@ -70,22 +73,23 @@ public:
 		return Address.GetTypeHash();
 	}
 
+	/** Orders by the same fields operator== compares, so it is a strict weak ordering that agrees with equality */
 	friend bool operator<(const FInternetAddrEOS& Left, const FInternetAddrEOS& Right)
 	{
 #if WITH_EOS_SDK
-		if (Left.GetLocalUserId() < Right.GetLocalUserId())
+		if (Left.GetLocalUserId() != Right.GetLocalUserId())
 		{
-			return true;
+			return UPTRINT(Left.GetLocalUserId()) < UPTRINT(Right.GetLocalUserId());
 		}
-		else if (Left.GetRemoteUserId() < Right.GetRemoteUserId())
+		if (Left.GetRemoteUserId() != Right.GetRemoteUserId())
 		{
-			return true;
+			return UPTRINT(Left.GetRemoteUserId()) < UPTRINT(Right.GetRemoteUserId());
 		}
-		else
 #endif
-		if (FCStringAnsi::Stricmp(Left.GetSocketName(), Right.GetSocketName()) < 0)
+		const int32 NameCompare = FCStringAnsi::Stricmp(Left.GetSocketName(), Right.GetSocketName());
+		if (NameCompare != 0)
 		{
-			return true;
+			return NameCompare < 0;
 		}
 
 		return Left.GetChannel() < Right.GetChannel();
@@ -105,6 +109,7 @@ public:
 	void SetRemoteUserId(EOS_ProductUserId InRemoteUserId)
 	{
 		RemoteUserId = InRemoteUserId;
+		InvalidateCachedString();
 	}
 
 	EOS_ProductUserId GetRemoteUserId() const
@@ -125,6 +130,7 @@ public:
 	void SetRemoteUserId(void* InRemoteUserId)
 	{
 		RemoteUserId = InRemoteUserId;
+		InvalidateCachedString();
 	}
 
 	void* GetRemoteUserId() const
@@ -141,11 +147,13 @@ public:
 	void SetSocketName(const FString& InSocketName)
 	{
 		FCStringAnsi::Strncpy(SocketName, TCHAR_TO_UTF8(*InSocketName), 32);
+		InvalidateCachedString();
 	}
 
 	void SetSocketName(const char* InSocketName)
 	{
 		FCStringAnsi::Strncpy(SocketName, InSocketName, 32);
+		InvalidateCachedString();
 	}
 
 	uint8 GetChannel() const
@@ -156,9 +164,28 @@ public:
 	void SetChannel(uint8 InChannel)
 	{
 		Channel = InChannel;
+		InvalidateCachedString();
 	}
 
 private:
+	/** Longest "EOS:PUID:SocketName:Channel" string, including the terminator */
+	static constexpr int32 MaxStringLength = 128;
+
+	/**
+	 * Writes the canonical "EOS:PUID:SocketName:Channel" form into a caller's buffer
+	 *
+	 * @return the length written, not counting the terminator
+	 */
+	int32 WriteString(TCHAR (&OutBuffer)[MaxStringLength], bool bAppendPort) const;
+
+	/** Builds CachedString if a change emptied it */
+	void UpdateCachedString() const;
+
+	void InvalidateCachedString()
+	{
+		CachedString.Reset();
+	}
+
 #if WITH_EOS_SDK
 	EOS_ProductUserId LocalUserId;
 	EOS_ProductUserId RemoteUserId;
@@ -169,5 +196,13 @@ private:
 	char SocketName[33];
 	uint8 Channel;
 
+	/**
+	 * The canonical string with the channel, built by the first ToString() after a change and emptied by the setters.
+	 * Like the rest of the address it isn't safe to use from several threads at once
+	 */
+	mutable FString CachedString;
+	/** How much of CachedString comes before the channel */
+	mutable int32 CachedStringNoPortLen;
+
 	friend class SocketSubsystemEOS;
 };
@@ -0,0 +1,899 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "LANSessionFormatEOS.h"
+#include "Misc/Compression.h"
+#include "Misc/ConfigCacheIni.h"
+#include "OnlineSubsystem.h"
+#include "OnlineSubsystemEOSTypes.h"
+#include "SocketSubsystem.h"
+#include "IPAddress.h"
+
+#if WITH_EOS_SDK
+
+/** Set in the flags byte when the body is zlib compressed */
+#define EOS_LAN_SESSION_FLAG_COMPRESSED 0x01
+
+/** Setting tags: the value type in the low bits, then how it is advertised, a bool's value and whether the key is sent by name */
+#define EOS_LAN_SETTING_TYPE_MASK 0x0F
+#define EOS_LAN_SETTING_ADVERTISEMENT_SHIFT 4
+#define EOS_LAN_SETTING_ADVERTISEMENT_MASK 0x03
+#define EOS_LAN_SETTING_BOOL_VALUE 0x40
+#define EOS_LAN_SETTING_KEY_BY_NAME 0x80
+
+/** Net ids are up to two parts split by EOS_ID_SEPARATOR, the header byte has two bits of ELANIdPartEOS per part */
+#define EOS_LAN_ID_HAS_SEPARATOR 0x10
+
+/** Responses come from other machines so we don't trust their counts */
+#define EOS_LAN_SESSION_MAX_SESSIONS 64
+#define EOS_LAN_SESSION_MAX_SETTINGS 256
+/** Most hosts whose owner ids we keep around between responses */
+#define EOS_LAN_SESSION_MAX_INTERNED_IDS 256
+
+/** How one part of a net id is encoded */
+enum class ELANIdPartEOS : uint8
+{
+	Empty,
+	/** 32 lower case hex digits packed into 16 bytes, what EOS account ids look like */
+	LowerHex,
+	/** 32 upper case hex digits packed into 16 bytes, what guids look like */
+	UpperHex,
+	/** Anything else, sent as a string */
+	String
+};
+
+/** Reads values out of a response in place, any read past the end sets bOverflow and returns zeros */
+struct FLANSessionReaderEOS
+{
+	const uint8* Data;
+	int32 Length;
+	int32 Offset;
+	bool bOverflow;
+
+	FLANSessionReaderEOS(const uint8* InData, int32 InLength)
+		: Data(InData)
+		, Length(InLength)
+		, Offset(0)
+		, bOverflow(false)
+	{
+	}
+
+	/** @return the next Num bytes or null if there aren't that many */
+	const uint8* ReadBytes(int32 Num)
+	{
+		if (bOverflow || Num < 0 || Length - Offset < Num)
+		{
+			bOverflow = true;
+			return nullptr;
+		}
+		const uint8* Bytes = Data + Offset;
+		Offset += Num;
+		return Bytes;
+	}
+
+	uint8 ReadByte()
+	{
+		const uint8* Bytes = ReadBytes(1);
+		return Bytes != nullptr ? Bytes[0] : 0;
+	}
+
+	uint16 ReadUInt16()
+	{
+		const uint8* Bytes = ReadBytes(2);
+		return Bytes != nullptr ? (uint16)(Bytes[0] | (Bytes[1] << 8)) : 0;
+	}
+
+	uint32 ReadUInt32()
+	{
+		const uint8* Bytes = ReadBytes(4);
+		return Bytes != nullptr ? ((uint32)Bytes[0] | ((uint32)Bytes[1] << 8) | ((uint32)Bytes[2] << 16) | ((uint32)Bytes[3] << 24)) : 0;
+	}
+
+	uint64 ReadUInt64()
+	{
+		const uint64 Low = ReadUInt32();
+		const uint64 High = ReadUInt32();
+		return Low | (High << 32);
+	}
+
+	uint64 ReadVarUInt()
+	{
+		uint64 Value = 0;
+		for (int32 Shift = 0; Shift < 64; Shift += 7)
+		{
+			const uint8* Byte = ReadBytes(1);
+			if (Byte == nullptr)
+			{
+				return 0;
+			}
+			Value |= (uint64)(*Byte & 0x7F) << Shift;
+			if ((*Byte & 0x80) == 0)
+			{
+				return Value;
+			}
+		}
+		bOverflow = true;
+		return 0;
+	}
+
+	/** Signed values are zigzag encoded so small negative numbers stay small */
+	int64 ReadVarInt()
+	{
+		const uint64 Value = ReadVarUInt();
+		return (int64)(Value >> 1) ^ -(int64)(Value & 1);
+	}
+
+	/** @return the bytes of a length prefixed blob or null */
+	const uint8* ReadBlob(int32& OutLength)
+	{
+		const uint64 BlobLength = ReadVarUInt();
+		OutLength = BlobLength <= (uint64)(Length - Offset) ? (int32)BlobLength : -1;
+		return ReadBytes(OutLength);
+	}
+
+	void ReadString(FString& OutString)
+	{
+		int32 Utf8Length = 0;
+		const uint8* Utf8 = ReadBlob(Utf8Length);
+		if (Utf8 != nullptr && Utf8Length > 0)
+		{
+			FUTF8ToTCHAR Converted((const ANSICHAR*)Utf8, Utf8Length);
+			OutString = FString(Converted.Length(), Converted.Get());
+		}
+		else
+		{
+			OutString.Reset();
+		}
+	}
+};
+
+static void WriteVarUInt(TArray<uint8>& Out, uint64 Value)
+{
+	while (Value >= 0x80)
+	{
+		Out.Add((uint8)(Value | 0x80));
+		Value >>= 7;
+	}
+	Out.Add((uint8)Value);
+}
+
+static void WriteVarInt(TArray<uint8>& Out, int64 Value)
+{
+	WriteVarUInt(Out, ((uint64)Value << 1) ^ (uint64)(Value >> 63));
+}
+
+static void WriteUInt16(TArray<uint8>& Out, uint16 Value)
+{
+	Out.Add((uint8)Value);
+	Out.Add((uint8)(Value >> 8));
+}
+
+static void WriteUInt32(TArray<uint8>& Out, uint32 Value)
+{
+	Out.Add((uint8)Value);
+	Out.Add((uint8)(Value >> 8));
+	Out.Add((uint8)(Value >> 16));
+	Out.Add((uint8)(Value >> 24));
+}
+
+static void WriteUInt64(TArray<uint8>& Out, uint64 Value)
+{
+	WriteUInt32(Out, (uint32)Value);
+	WriteUInt32(Out, (uint32)(Value >> 32));
+}
+
+static void WriteBlob(TArray<uint8>& Out, const uint8* Data, int32 Length)
+{
+	WriteVarUInt(Out, Length);
+	Out.Append(Data, Length);
+}
+
+static void WriteString(TArray<uint8>& Out, const FString& String)
+{
+	FTCHARToUTF8 Utf8(*String);
+	WriteBlob(Out, (const uint8*)Utf8.Get(), Utf8.Length());
+}
+
+static ELANIdPartEOS GetIdPartEncoding(const FString& Part)
+{
+	if (Part.IsEmpty())
+	{
+		return ELANIdPartEOS::Empty;
+	}
+	if (Part.Len() != 32)
+	{
+		return ELANIdPartEOS::String;
+	}
+	bool bHasLower = false;
+	bool bHasUpper = false;
+	for (const TCHAR Char : Part)
+	{
+		if (!FChar::IsHexDigit(Char))
+		{
+			return ELANIdPartEOS::String;
+		}
+		bHasLower |= FChar::IsLower(Char);
+		bHasUpper |= FChar::IsUpper(Char);
+	}
+	// Mixed case wouldn't read back the same
+	return bHasLower && bHasUpper ? ELANIdPartEOS::String : (bHasUpper ? ELANIdPartEOS::UpperHex : ELANIdPartEOS::LowerHex);
+}
+
+static void WriteIdPart(TArray<uint8>& Out, const FString& Part, ELANIdPartEOS Encoding)
+{
+	if (Encoding == ELANIdPartEOS::LowerHex || Encoding == ELANIdPartEOS::UpperHex)
+	{
+		for (int32 Index = 0; Index < 32; Index += 2)
+		{
+			Out.Add((uint8)((FParse::HexDigit(Part[Index]) << 4) | FParse::HexDigit(Part[Index + 1])));
+		}
+	}
+	else if (Encoding == ELANIdPartEOS::String)
+	{
+		WriteString(Out, Part);
+	}
+}
+
+static void WriteNetId(TArray<uint8>& Out, const FString& NetIdStr)
+{
+	FString First;
+	FString Second;
+	const bool bHasSeparator = NetIdStr.Split(EOS_ID_SEPARATOR, &First, &Second) && !Second.Contains(EOS_ID_SEPARATOR);
+	if (!bHasSeparator)
+	{
+		First = NetIdStr;
+		Second.Reset();
+	}
+
+	const ELANIdPartEOS FirstEncoding = GetIdPartEncoding(First);
+	const ELANIdPartEOS SecondEncoding = GetIdPartEncoding(Second);
+	Out.Add((uint8)FirstEncoding | ((uint8)SecondEncoding << 2) | (bHasSeparator ? EOS_LAN_ID_HAS_SEPARATOR : 0));
+	WriteIdPart(Out, First, FirstEncoding);
+	WriteIdPart(Out, Second, SecondEncoding);
+}
+
+/** Reads one part of a net id, appending it to OutNetIdStr unless that is null */
+static void ReadIdPart(FLANSessionReaderEOS& Reader, ELANIdPartEOS Encoding, FString* OutNetIdStr)
+{
+	if (Encoding == ELANIdPartEOS::LowerHex || Encoding == ELANIdPartEOS::UpperHex)
+	{
+		const uint8* Bytes = Reader.ReadBytes(16);
+		if (Bytes != nullptr && OutNetIdStr != nullptr)
+		{
+			const TCHAR* Digits = Encoding == ELANIdPartEOS::LowerHex ? TEXT("0123456789abcdef") : TEXT("0123456789ABCDEF");
+			for (int32 Index = 0; Index < 16; Index++)
+			{
+				OutNetIdStr->AppendChar(Digits[Bytes[Index] >> 4]);
+				OutNetIdStr->AppendChar(Digits[Bytes[Index] & 0x0F]);
+			}
+		}
+	}
+	else if (Encoding == ELANIdPartEOS::String)
+	{
+		if (OutNetIdStr != nullptr)
+		{
+			FString Part;
+			Reader.ReadString(Part);
+			OutNetIdStr->Append(Part);
+		}
+		else
+		{
+			int32 Utf8Length = 0;
+			Reader.ReadBlob(Utf8Length);
+		}
+	}
+}
+
+/** Reads a net id written by WriteNetId(), or just skips it when OutNetIdStr is null */
+static void ReadNetId(FLANSessionReaderEOS& Reader, FString* OutNetIdStr)
+{
+	const uint8 Header = Reader.ReadByte();
+	ReadIdPart(Reader, (ELANIdPartEOS)(Header & 0x03), OutNetIdStr);
+	if ((Header & EOS_LAN_ID_HAS_SEPARATOR) != 0 && OutNetIdStr != nullptr)
+	{
+		OutNetIdStr->Append(EOS_ID_SEPARATOR);
+	}
+	ReadIdPart(Reader, (ELANIdPartEOS)((Header >> 2) & 0x03), OutNetIdStr);
+}
+
+FLANSessionFormatEOS::FLANSessionFormatEOS()
+	: bCompress(true)
+{
+	// The standard settings every game can search on
+	AddSharedKey(SETTING_MAPNAME);
+	AddSharedKey(SETTING_NUMBOTS);
+	AddSharedKey(SETTING_GAMEMODE);
+	AddSharedKey(SETTING_BEACONPORT);
+	AddSharedKey(SETTING_QOS);
+	AddSharedKey(SETTING_REGION);
+	AddSharedKey(SETTING_CUSTOMSEARCHINT1);
+	AddSharedKey(SETTING_CUSTOMSEARCHINT2);
+	AddSharedKey(SETTING_CUSTOMSEARCHINT3);
+	AddSharedKey(SETTING_CUSTOMSEARCHINT4);
+	AddSharedKey(SETTING_CUSTOMSEARCHINT5);
+}
+
+void FLANSessionFormatEOS::LoadConfig()
+{
+	GConfig->GetBool(TEXT("/Script/OnlineSubsystemEOS.NetDriverEOS"), TEXT("bCompressLANSessions"), bCompress, GEngineIni);
+
+	// Games list their own setting names so they can be sent as hashes too, both ends need the same list
+	TArray<FString> KeyNames;
+	GConfig->GetArray(TEXT("/Script/OnlineSubsystemEOS.NetDriverEOS"), TEXT("LANSessionSettingKeys"), KeyNames, GEngineIni);
+	for (const FString& KeyName : KeyNames)
+	{
+		AddSharedKey(FName(*KeyName));
+	}
+}
+
+void FLANSessionFormatEOS::AddSharedKey(FName Key)
+{
+	if (Key == NAME_None || SharedKeyHashes.Contains(Key))
+	{
+		return;
+	}
+
+	const uint32 Hash = FCrc::Strihash_DEPRECATED(*Key.ToString());
+	if (CollidingHashes.Contains(Hash))
+	{
+		return;
+	}
+	if (const FName* Existing = SharedKeys.Find(Hash))
+	{
+		UE_LOG_ONLINE_SESSION(Warning, TEXT("LAN session setting keys (%s) and (%s) hash the same, sending them by name"), *Existing->ToString(), *Key.ToString());
+		SharedKeyHashes.Remove(*Existing);
+		SharedKeys.Remove(Hash);
+		CollidingHashes.Add(Hash);
+		return;
+	}
+	SharedKeys.Add(Hash, Key);
+	SharedKeyHashes.Add(Key, Hash);
+}
+
+void FLANSessionFormatEOS::WriteSession(const FOnlineSession& Session, TArray<uint8>& OutBody)
+{
+	OutBody.Reset();
+
+	// Owner of the session
+	WriteNetId(OutBody, Session.OwningUserId.IsValid() ? Session.OwningUserId->ToString() : FString());
+	WriteString(OutBody, Session.OwningUserName);
+	WriteVarInt(OutBody, Session.NumOpenPrivateConnections);
+	WriteVarInt(OutBody, Session.NumOpenPublicConnections);
+
+	// Host info
+	const FOnlineSessionInfoEOS* SessionInfo = static_cast<const FOnlineSessionInfoEOS*>(Session.SessionInfo.Get());
+	check(SessionInfo != nullptr && SessionInfo->HostAddr.IsValid());
+	WriteNetId(OutBody, SessionInfo->SessionId.ToString());
+	uint32 HostIp = 0;
+	SessionInfo->HostAddr->GetIp(HostIp);
+	WriteUInt32(OutBody, HostIp);
+	WriteVarUInt(OutBody, (uint16)SessionInfo->HostAddr->GetPort());
+
+	// Members of the session settings class
+	const FOnlineSessionSettings& Settings = Session.SessionSettings;
+	WriteVarInt(OutBody, Settings.NumPublicConnections);
+	WriteVarInt(OutBody, Settings.NumPrivateConnections);
+	const uint16 Flags =
+		(Settings.bShouldAdvertise ? 1 << 0 : 0) |
+		(Settings.bIsLANMatch ? 1 << 1 : 0) |
+		(Settings.bIsDedicated ? 1 << 2 : 0) |
+		(Settings.bUsesStats ? 1 << 3 : 0) |
+		(Settings.bAllowJoinInProgress ? 1 << 4 : 0) |
+		(Settings.bAllowInvites ? 1 << 5 : 0) |
+		(Settings.bUsesPresence ? 1 << 6 : 0) |
+		(Settings.bAllowJoinViaPresence ? 1 << 7 : 0) |
+		(Settings.bAllowJoinViaPresenceFriendsOnly ? 1 << 8 : 0) |
+		(Settings.bAntiCheatProtected ? 1 << 9 : 0);
+	WriteUInt16(OutBody, Flags);
+	WriteVarInt(OutBody, Settings.BuildUniqueId);
+
+	// Count the settings first, the count goes before them
+	int32 NumAdvertisedSettings = 0;
+	for (FSessionSettings::TConstIterator It(Settings.Settings); It; ++It)
+	{
+		const FOnlineSessionSetting& Setting = It.Value();
+		if (Setting.AdvertisementType >= EOnlineDataAdvertisementType::ViaOnlineService && Setting.Data.GetType() != EOnlineKeyValuePairDataType::Json)
+		{
+			NumAdvertisedSettings++;
+		}
+	}
+	WriteVarUInt(OutBody, FMath::Min(NumAdvertisedSettings, EOS_LAN_SESSION_MAX_SETTINGS));
+
+	int32 NumWritten = 0;
+	for (FSessionSettings::TConstIterator It(Settings.Settings); It && NumWritten < EOS_LAN_SESSION_MAX_SETTINGS; ++It)
+	{
+		const FOnlineSessionSetting& Setting = It.Value();
+		const EOnlineKeyValuePairDataType::Type Type = Setting.Data.GetType();
+		if (Setting.AdvertisementType < EOnlineDataAdvertisementType::ViaOnlineService || Type == EOnlineKeyValuePairDataType::Json)
+		{
+			continue;
+		}
+		NumWritten++;
+
+		const uint32* KeyHash = SharedKeyHashes.Find(It.Key());
+		bool bBoolValue = false;
+		if (Type == EOnlineKeyValuePairDataType::Bool)
+		{
+			Setting.Data.GetValue(bBoolValue);
+		}
+		OutBody.Add((uint8)Type |
+			(uint8)((Setting.AdvertisementType & EOS_LAN_SETTING_ADVERTISEMENT_MASK) << EOS_LAN_SETTING_ADVERTISEMENT_SHIFT) |
+			(bBoolValue ? EOS_LAN_SETTING_BOOL_VALUE : 0) |
+			(KeyHash == nullptr ? EOS_LAN_SETTING_KEY_BY_NAME : 0));
+		if (KeyHash != nullptr)
+		{
+			WriteUInt32(OutBody, *KeyHash);
+		}
+		else
+		{
+			WriteString(OutBody, It.Key().ToString());
+		}
+
+		switch (Type)
+		{
+			case EOnlineKeyValuePairDataType::Int32:
+			{
+				int32 Value = 0;
+				Setting.Data.GetValue(Value);
+				WriteVarInt(OutBody, Value);
+				break;
+			}
+			case EOnlineKeyValuePairDataType::UInt32:
+			{
+				uint32 Value = 0;
+				Setting.Data.GetValue(Value);
+				WriteVarUInt(OutBody, Value);
+				break;
+			}
+			case EOnlineKeyValuePairDataType::Int64:
+			{
+				int64 Value = 0;
+				Setting.Data.GetValue(Value);
+				WriteVarInt(OutBody, Value);
+				break;
+			}
+			case EOnlineKeyValuePairDataType::UInt64:
+			{
+				uint64 Value = 0;
+				Setting.Data.GetValue(Value);
+				WriteVarUInt(OutBody, Value);
+				break;
+			}
+			case EOnlineKeyValuePairDataType::Float:
+			{
+				float Value = 0.f;
+				Setting.Data.GetValue(Value);
+				uint32 Bits = 0;
+				FMemory::Memcpy(&Bits, &Value, sizeof(Bits));
+				WriteUInt32(OutBody, Bits);
+				break;
+			}
+			case EOnlineKeyValuePairDataType::Double:
+			{
+				double Value = 0.0;
+				Setting.Data.GetValue(Value);
+				uint64 Bits = 0;
+				FMemory::Memcpy(&Bits, &Value, sizeof(Bits));
+				WriteUInt64(OutBody, Bits);
+				break;
+			}
+			case EOnlineKeyValuePairDataType::String:
+			{
+				FString Value;
+				Setting.Data.GetValue(Value);
+				WriteString(OutBody, Value);
+				break;
+			}
+			case EOnlineKeyValuePairDataType::Blob:
+			{
+				TArray<uint8> Value;
+				Setting.Data.GetValue(Value);
+				WriteBlob(OutBody, Value.GetData(), Value.Num());
+				break;
+			}
+			default:
+			{
+				// Empty and bool carry nothing past the tag
+				break;
+			}
+		}
+	}
+}
+
+uint32 FLANSessionFormatEOS::HashSettings(const FOnlineSessionSettings& Settings)
+{
+	uint32 Hash = HashCombine(::GetTypeHash(Settings.NumPublicConnections), ::GetTypeHash(Settings.NumPrivateConnections));
+	const uint16 Flags =
+		(Settings.bShouldAdvertise ? 1 << 0 : 0) |
+		(Settings.bIsLANMatch ? 1 << 1 : 0) |
+		(Settings.bIsDedicated ? 1 << 2 : 0) |
+		(Settings.bUsesStats ? 1 << 3 : 0) |
+		(Settings.bAllowJoinInProgress ? 1 << 4 : 0) |
+		(Settings.bAllowInvites ? 1 << 5 : 0) |
+		(Settings.bUsesPresence ? 1 << 6 : 0) |
+		(Settings.bAllowJoinViaPresence ? 1 << 7 : 0) |
+		(Settings.bAllowJoinViaPresenceFriendsOnly ? 1 << 8 : 0) |
+		(Settings.bAntiCheatProtected ? 1 << 9 : 0);
+	Hash = HashCombine(Hash, HashCombine(::GetTypeHash(Flags), ::GetTypeHash(Settings.BuildUniqueId)));
+
+	for (FSessionSettings::TConstIterator It(Settings.Settings); It; ++It)
+	{
+		const FOnlineSessionSetting& Setting = It.Value();
+		const EOnlineKeyValuePairDataType::Type Type = Setting.Data.GetType();
+		if (Setting.AdvertisementType < EOnlineDataAdvertisementType::ViaOnlineService || Type == EOnlineKeyValuePairDataType::Json)
+		{
+			continue;
+		}
+
+		uint32 ValueHash = 0;
+		switch (Type)
+		{
+			case EOnlineKeyValuePairDataType::Int32:
+			{
+				int32 Value = 0;
+				Setting.Data.GetValue(Value);
+				ValueHash = ::GetTypeHash(Value);
+				break;
+			}
+			case EOnlineKeyValuePairDataType::UInt32:
+			{
+				uint32 Value = 0;
+				Setting.Data.GetValue(Value);
+				ValueHash = ::GetTypeHash(Value);
+				break;
+			}
+			case EOnlineKeyValuePairDataType::Int64:
+			{
+				int64 Value = 0;
+				Setting.Data.GetValue(Value);
+				ValueHash = ::GetTypeHash(Value);
+				break;
+			}
+			case EOnlineKeyValuePairDataType::UInt64:
+			{
+				uint64 Value = 0;
+				Setting.Data.GetValue(Value);
+				ValueHash = ::GetTypeHash(Value);
+				break;
+			}
+			case EOnlineKeyValuePairDataType::Float:
+			{
+				float Value = 0.f;
+				Setting.Data.GetValue(Value);
+				ValueHash = ::GetTypeHash(Value);
+				break;
+			}
+			case EOnlineKeyValuePairDataType::Double:
+			{
+				double Value = 0.0;
+				Setting.Data.GetValue(Value);
+				ValueHash = ::GetTypeHash(Value);
+				break;
+			}
+			case EOnlineKeyValuePairDataType::Bool:
+			{
+				bool bValue = false;
+				Setting.Data.GetValue(bValue);
+				ValueHash = bValue ? 1 : 0;
+				break;
+			}
+			case EOnlineKeyValuePairDataType::String:
+			{
+				FString Value;
+				Setting.Data.GetValue(Value);
+				// Case sensitive, as the value is sent as is
+				ValueHash = FCrc::StrCrc32(*Value);
+				break;
+			}
+			case EOnlineKeyValuePairDataType::Blob:
+			{
+				TArray<uint8> Value;
+				Setting.Data.GetValue(Value);
+				ValueHash = FCrc::MemCrc32(Value.GetData(), Value.Num());
+				break;
+			}
+			default:
+			{
+				break;
+			}
+		}
+		// The map's order is what WriteSession() writes, so hashing in that order catches reordering too
+		Hash = HashCombine(Hash, HashCombine(HashCombine(::GetTypeHash(It.Key()), ::GetTypeHash((uint8)Setting.AdvertisementType)), HashCombine(::GetTypeHash((uint8)Type), ValueHash)));
+	}
+	return Hash;
+}
+
+int32 FLANSessionFormatEOS::BuildPayload(const TArray<const TArray<uint8>*>& SessionBodies, int32 FirstSession, int32 NumSessions, TArray<uint8>& OutPayload) const
+{
+	TArray<uint8> Body;
+	WriteVarUInt(Body, NumSessions);
+	for (int32 Index = FirstSession; Index < FirstSession + NumSessions; Index++)
+	{
+		Body.Append(*SessionBodies[Index]);
+	}
+
+	OutPayload.Reset();
+	OutPayload.Add(EOS_LAN_SESSION_FORMAT_VERSION);
+
+	// Only send it compressed when that actually saves something and the other end will accept the size
+	if (bCompress && Body.Num() <= EOS_LAN_SESSION_MAX_BODY_SIZE)
+	{
+		int32 CompressedSize = FCompression::CompressMemoryBound(NAME_Zlib, Body.Num());
+		TArray<uint8> Compressed;
+		Compressed.SetNumUninitialized(CompressedSize);
+		if (FCompression::CompressMemory(NAME_Zlib, Compressed.GetData(), CompressedSize, Body.GetData(), Body.Num()) &&
+			CompressedSize + 3 < Body.Num())
+		{
+			OutPayload.Add(EOS_LAN_SESSION_FLAG_COMPRESSED);
+			WriteVarUInt(OutPayload, Body.Num());
+			OutPayload.Append(Compressed.GetData(), CompressedSize);
+			return OutPayload.Num();
+		}
+	}
+
+	OutPayload.Add(0);
+	OutPayload.Append(Body);
+	return OutPayload.Num();
+}
+
+void FLANSessionFormatEOS::BuildPayloads(const TArray<const TArray<uint8>*>& SessionBodies, int32 MaxPayloadSize, TArray<TArray<uint8>>& OutPayloads) const
+{
+	OutPayloads.Reset();
+
+	// Grow each response one session at a time until the next one doesn't fit
+	TArray<uint8> Payload;
+	TArray<uint8> Candidate;
+	int32 FirstSession = 0;
+	for (int32 Index = 0; Index < SessionBodies.Num(); Index++)
+	{
+		if (BuildPayload(SessionBodies, FirstSession, Index - FirstSession + 1, Candidate) <= MaxPayloadSize)
+		{
+			Swap(Payload, Candidate);
+			continue;
+		}
+
+		if (Index > FirstSession)
+		{
+			OutPayloads.Add(MoveTemp(Payload));
+			FirstSession = Index;
+			if (BuildPayload(SessionBodies, FirstSession, 1, Payload) <= MaxPayloadSize)
+			{
+				continue;
+			}
+		}
+
+		UE_LOG_ONLINE_SESSION(Warning, TEXT("LAN session needs more than (%d) bytes to advertise, it won't be found"), MaxPayloadSize);
+		Payload.Reset();
+		FirstSession = Index + 1;
+	}
+
+	if (Payload.Num() > 0)
+	{
+		OutPayloads.Add(MoveTemp(Payload));
+	}
+}
+
+int32 FLANSessionFormatEOS::ReadPayload(const uint8* Data, int32 Length, TFunctionRef<FOnlineSession&()> AddSession)
+{
+	FLANSessionReaderEOS Header(Data, Length);
+	const uint8 Version = Header.ReadByte();
+	const uint8 Flags = Header.ReadByte();
+	if (Header.bOverflow || Version != EOS_LAN_SESSION_FORMAT_VERSION)
+	{
+		UE_LOG_ONLINE_SESSION(Verbose, TEXT("Ignoring LAN session response with format version (%d), expected (%d)"), Version, EOS_LAN_SESSION_FORMAT_VERSION);
+		return 0;
+	}
+
+	const uint8* Body = Data + Header.Offset;
+	int32 BodyLength = Length - Header.Offset;
+	uint8 UncompressedBody[EOS_LAN_SESSION_MAX_BODY_SIZE];
+	if ((Flags & EOS_LAN_SESSION_FLAG_COMPRESSED) != 0)
+	{
+		const uint64 UncompressedSize = Header.ReadVarUInt();
+		if (Header.bOverflow || UncompressedSize == 0 || UncompressedSize > EOS_LAN_SESSION_MAX_BODY_SIZE ||
+			!FCompression::UncompressMemory(NAME_Zlib, UncompressedBody, (int32)UncompressedSize, Data + Header.Offset, Length - Header.Offset))
+		{
+			UE_LOG_ONLINE_SESSION(Verbose, TEXT("Ignoring LAN session response that failed to decompress"));
+			return 0;
+		}
+		Body = UncompressedBody;
+		BodyLength = (int32)UncompressedSize;
+	}
+
+	FLANSessionReaderEOS Reader(Body, BodyLength);
+	const uint64 NumSessions = FMath::Min<uint64>(Reader.ReadVarUInt(), EOS_LAN_SESSION_MAX_SESSIONS);
+	int32 NumRead = 0;
+	while (NumRead < (int32)NumSessions && !Reader.bOverflow)
+	{
+		if (!ReadSession(Reader, AddSession()))
+		{
+			UE_LOG_ONLINE_SESSION(Verbose, TEXT("Malformed session (%d) in LAN session response"), NumRead);
+			break;
+		}
+		NumRead++;
+	}
+	return NumRead;
+}
+
+bool FLANSessionFormatEOS::ReadSession(FLANSessionReaderEOS& Reader, FOnlineSession& Session)
+{
+	// Owner of the session, hosts answer every search so we usually know them already
+	const int32 OwnerIdOffset = Reader.Offset;
+	ReadNetId(Reader, nullptr);
+	if (Reader.bOverflow)
+	{
+		return false;
+	}
+	Session.OwningUserId = FindOrAddOwnerId(Reader.Data + OwnerIdOffset, Reader.Offset - OwnerIdOffset);
+	Reader.ReadString(Session.OwningUserName);
+	Session.NumOpenPrivateConnections = (int32)Reader.ReadVarInt();
+	Session.NumOpenPublicConnections = (int32)Reader.ReadVarInt();
+
+	// Host info
+	FString SessionIdStr;
+	ReadNetId(Reader, &SessionIdStr);
+	const uint32 HostIp = Reader.ReadUInt32();
+	const int32 HostPort = (int32)Reader.ReadVarUInt();
+	if (Reader.bOverflow)
+	{
+		return false;
+	}
+	FOnlineSessionInfoEOS* SessionInfo = new FOnlineSessionInfoEOS();
+	SessionInfo->SessionId = FUniqueNetIdEOS(MoveTemp(SessionIdStr));
+	SessionInfo->HostAddr = ISocketSubsystem::Get(PLATFORM_SOCKETSUBSYSTEM)->CreateInternetAddr();
+	SessionInfo->HostAddr->SetIp(HostIp);
+	SessionInfo->HostAddr->SetPort(HostPort);
+	Session.SessionInfo = MakeShareable(SessionInfo);
+
+	// Members of the session settings class
+	FOnlineSessionSettings& Settings = Session.SessionSettings;
+	Settings.NumPublicConnections = (int32)Reader.ReadVarInt();
+	Settings.NumPrivateConnections = (int32)Reader.ReadVarInt();
+	const uint16 Flags = Reader.ReadUInt16();
+	Settings.bShouldAdvertise = (Flags & (1 << 0)) != 0;
+	Settings.bIsLANMatch = (Flags & (1 << 1)) != 0;
+	Settings.bIsDedicated = (Flags & (1 << 2)) != 0;
+	Settings.bUsesStats = (Flags & (1 << 3)) != 0;
+	Settings.bAllowJoinInProgress = (Flags & (1 << 4)) != 0;
+	Settings.bAllowInvites = (Flags & (1 << 5)) != 0;
+	Settings.bUsesPresence = (Flags & (1 << 6)) != 0;
+	Settings.bAllowJoinViaPresence = (Flags & (1 << 7)) != 0;
+	Settings.bAllowJoinViaPresenceFriendsOnly = (Flags & (1 << 8)) != 0;
+	Settings.bAntiCheatProtected = (Flags & (1 << 9)) != 0;
+	Settings.BuildUniqueId = (int32)Reader.ReadVarInt();
+
+	const uint64 NumSettings = Reader.ReadVarUInt();
+	if (Reader.bOverflow || NumSettings > EOS_LAN_SESSION_MAX_SETTINGS)
+	{
+		return false;
+	}
+	Settings.Settings.Reset();
+	Settings.Settings.Reserve((int32)NumSettings);
+	for (int32 Index = 0; Index < (int32)NumSettings; Index++)
+	{
+		const uint8 Tag = Reader.ReadByte();
+
+		FName Key;
+		if ((Tag & EOS_LAN_SETTING_KEY_BY_NAME) != 0)
+		{
+			FString KeyName;
+			Reader.ReadString(KeyName);
+			Key = FName(*KeyName);
+		}
+		else if (const FName* SharedKey = SharedKeys.Find(Reader.ReadUInt32()))
+		{
+			Key = *SharedKey;
+		}
+		// Otherwise the host knows a key we don't, we still have to read past its value
+
+		FOnlineSessionSetting Setting;
+		Setting.AdvertisementType = (EOnlineDataAdvertisementType::Type)((Tag >> EOS_LAN_SETTING_ADVERTISEMENT_SHIFT) & EOS_LAN_SETTING_ADVERTISEMENT_MASK);
+		switch ((EOnlineKeyValuePairDataType::Type)(Tag & EOS_LAN_SETTING_TYPE_MASK))
+		{
+			case EOnlineKeyValuePairDataType::Empty:
+			{
+				break;
+			}
+			case EOnlineKeyValuePairDataType::Int32:
+			{
+				Setting.Data.SetValue((int32)Reader.ReadVarInt());
+				break;
+			}
+			case EOnlineKeyValuePairDataType::UInt32:
+			{
+				Setting.Data.SetValue((uint32)Reader.ReadVarUInt());
+				break;
+			}
+			case EOnlineKeyValuePairDataType::Int64:
+			{
+				Setting.Data.SetValue((int64)Reader.ReadVarInt());
+				break;
+			}
+			case EOnlineKeyValuePairDataType::UInt64:
+			{
+				Setting.Data.SetValue((uint64)Reader.ReadVarUInt());
+				break;
+			}
+			case EOnlineKeyValuePairDataType::Float:
+			{
+				const uint32 Bits = Reader.ReadUInt32();
+				float Value = 0.f;
+				FMemory::Memcpy(&Value, &Bits, sizeof(Value));
+				Setting.Data.SetValue(Value);
+				break;
+			}
+			case EOnlineKeyValuePairDataType::Double:
+			{
+				const uint64 Bits = Reader.ReadUInt64();
+				double Value = 0.0;
+				FMemory::Memcpy(&Value, &Bits, sizeof(Value));
+				Setting.Data.SetValue(Value);
+				break;
+			}
+			case EOnlineKeyValuePairDataType::String:
+			{
+				FString Value;
+				Reader.ReadString(Value);
+				Setting.Data.SetValue(Value);
+				break;
+			}
+			case EOnlineKeyValuePairDataType::Blob:
+			{
+				int32 BlobLength = 0;
+				const uint8* Blob = Reader.ReadBlob(BlobLength);
+				if (Blob != nullptr)
+				{
+					Setting.Data.SetValue((uint32)BlobLength, Blob);
+				}
+				break;
+			}
+			case EOnlineKeyValuePairDataType::Bool:
+			{
+				Setting.Data.SetValue((Tag & EOS_LAN_SETTING_BOOL_VALUE) != 0);
+				break;
+			}
+			default:
+			{
+				// We can't know how big a type we don't understand is
+				return false;
+			}
+		}
+
+		if (Reader.bOverflow)
+		{
+			return false;
+		}
+		if (Key != NAME_None)
+		{
+			Settings.Settings.Add(Key, Setting);
+		}
+	}
+	return true;
+}
+
+TSharedPtr<const FUniqueNetIdEOS> FLANSessionFormatEOS::FindOrAddOwnerId(const uint8* Encoded, int32 EncodedLength)
+{
+	const uint32 Hash = FCrc::MemCrc32(Encoded, EncodedLength);
+	FInternedOwnerId* Interned = InternedOwnerIds.Find(Hash);
+	if (Interned != nullptr && Interned->Encoded.Num() == EncodedLength && FMemory::Memcmp(Interned->Encoded.GetData(), Encoded, EncodedLength) == 0)
+	{
+		return Interned->Id;
+	}
+
+	// Any host on the network can send us ids so don't let the table grow forever
+	if (Interned == nullptr && InternedOwnerIds.Num() >= EOS_LAN_SESSION_MAX_INTERNED_IDS)
+	{
+		InternedOwnerIds.Reset();
+	}
+
+	FLANSessionReaderEOS Reader(Encoded, EncodedLength);
+	FString NetIdStr;
+	ReadNetId(Reader, &NetIdStr);
+
+	FInternedOwnerId& NewId = InternedOwnerIds.FindOrAdd(Hash);
+	NewId.Encoded.Reset();
+	NewId.Encoded.Append(Encoded, EncodedLength);
+	NewId.Id = MakeShared<FUniqueNetIdEOS>(MoveTemp(NetIdStr));
+	return NewId.Id;
+}
+
+#endif
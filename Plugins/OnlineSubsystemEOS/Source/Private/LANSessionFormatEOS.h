@@ -0,0 +1,95 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "OnlineSessionSettings.h"
+
+class FUniqueNetIdEOS;
+struct FLANSessionReaderEOS;
+
+#if WITH_EOS_SDK
+
+/** Bumped whenever the LAN session response layout changes, responses with another version are ignored */
+#define EOS_LAN_SESSION_FORMAT_VERSION 2
+/** Largest response body we will decompress, responses claiming more are dropped */
+#define EOS_LAN_SESSION_MAX_BODY_SIZE 4096
+
+/**
+ * Encodes the sessions we advertise over LAN into beacon responses and reads them back.
+ *
+ * A response is a version byte, a flags byte and a body that may be zlib compressed. The body holds as many
+ * sessions as fit: ids as packed binary, counts as varints, the session flags as a bit field and setting keys
+ * as a hash of the name when both ends know the name. Reading works straight off the packet and only allocates
+ * for what ends up in the search results
+ */
+class FLANSessionFormatEOS
+{
+public:
+	FLANSessionFormatEOS();
+
+	/** Reads compression and the setting keys sent as hashes from the engine ini */
+	void LoadConfig();
+
+	/**
+	 * Encodes one session, the bodies are packed into responses by BuildPayloads() and can be kept until the session changes
+	 *
+	 * @param Session the session to advertise, its session info must have a host address
+	 * @param OutBody receives the encoded session
+	 */
+	void WriteSession(const FOnlineSession& Session, TArray<uint8>& OutBody);
+
+	/**
+	 * Hashes the session settings WriteSession() encodes, so a kept body can be checked against settings that were
+	 * changed in place rather than through UpdateSession()
+	 */
+	static uint32 HashSettings(const FOnlineSessionSettings& Settings);
+
+	/**
+	 * Packs encoded sessions into as few responses as possible
+	 *
+	 * @param SessionBodies sessions from WriteSession()
+	 * @param MaxPayloadSize the room left in a beacon packet after its header
+	 * @param OutPayloads receives one entry per packet to send
+	 */
+	void BuildPayloads(const TArray<const TArray<uint8>*>& SessionBodies, int32 MaxPayloadSize, TArray<TArray<uint8>>& OutPayloads) const;
+
+	/**
+	 * Reads the sessions out of a response
+	 *
+	 * @param Data the response without its beacon header
+	 * @param Length size of Data
+	 * @param AddSession called for each session in the response, returns the session to read it into
+	 *
+	 * @return the number of sessions read. Reading stops at the first malformed session, so when this is less
+	 *		than the number of AddSession calls the last session added is half read and should be dropped
+	 */
+	int32 ReadPayload(const uint8* Data, int32 Length, TFunctionRef<FOnlineSession&()> AddSession);
+
+private:
+	void AddSharedKey(FName Key);
+	/** Builds the response for a run of sessions. @return its size in bytes */
+	int32 BuildPayload(const TArray<const TArray<uint8>*>& SessionBodies, int32 FirstSession, int32 NumSessions, TArray<uint8>& OutPayload) const;
+	bool ReadSession(FLANSessionReaderEOS& Reader, FOnlineSession& Session);
+	/** @return the owner id for the encoded id bytes, reusing the one from earlier responses from that host */
+	TSharedPtr<const FUniqueNetIdEOS> FindOrAddOwnerId(const uint8* Encoded, int32 EncodedLength);
+
+	/** Whether bodies are compressed when that makes them smaller */
+	bool bCompress;
+
+	/** Setting keys both ends know, keyed by the hash we send in their place */
+	TMap<uint32, FName> SharedKeys;
+	TMap<FName, uint32> SharedKeyHashes;
+	/** Hashes more than one key mapped to, those keys are always sent by name */
+	TSet<uint32> CollidingHashes;
+
+	struct FInternedOwnerId
+	{
+		TArray<uint8> Encoded;
+		TSharedPtr<const FUniqueNetIdEOS> Id;
+	};
+	/** Owner ids we have already read, keyed by a hash of their encoded bytes */
+	TMap<uint32, FInternedOwnerId> InternedOwnerIds;
+};
+
+#endif
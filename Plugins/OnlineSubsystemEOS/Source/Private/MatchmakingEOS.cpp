@@ -0,0 +1,858 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "MatchmakingEOS.h"
+#include "OnlineSessionEOS.h"
+#include "Misc/ConfigCacheIni.h"
+#include "Math/RandomStream.h"
+#include "BenchEOS.h"
+
+#if WITH_EOS_SDK
+
+FMatchmakingSettingsEOS::FMatchmakingSettingsEOS()
+	: TimeBudget(10.f)
+	, RetryDelay(1.f)
+	, MaxJoinAttempts(3)
+	, PingTimeout(2.5f)
+	, StepTimeout(30.f)
+	, MaxPingMs(200.f)
+	, FillWeight(1.f)
+	, PingWeight(1.f)
+	, AttributeWeight(1.f)
+	, bCreateOnTimeout(true)
+{
+}
+
+void FMatchmakingSettingsEOS::LoadConfig()
+{
+	GConfig->GetFloat(TEXT("/Script/OnlineSubsystemEOS.NetDriverEOS"), TEXT("MatchmakingTimeBudget"), TimeBudget, GEngineIni);
+	GConfig->GetFloat(TEXT("/Script/OnlineSubsystemEOS.NetDriverEOS"), TEXT("MatchmakingRetryDelay"), RetryDelay, GEngineIni);
+	GConfig->GetInt(TEXT("/Script/OnlineSubsystemEOS.NetDriverEOS"), TEXT("MatchmakingMaxJoinAttempts"), MaxJoinAttempts, GEngineIni);
+	GConfig->GetFloat(TEXT("/Script/OnlineSubsystemEOS.NetDriverEOS"), TEXT("MatchmakingPingTimeout"), PingTimeout, GEngineIni);
+	GConfig->GetFloat(TEXT("/Script/OnlineSubsystemEOS.NetDriverEOS"), TEXT("MatchmakingStepTimeout"), StepTimeout, GEngineIni);
+	GConfig->GetFloat(TEXT("/Script/OnlineSubsystemEOS.NetDriverEOS"), TEXT("MatchmakingMaxPing"), MaxPingMs, GEngineIni);
+	GConfig->GetFloat(TEXT("/Script/OnlineSubsystemEOS.NetDriverEOS"), TEXT("MatchmakingFillWeight"), FillWeight, GEngineIni);
+	GConfig->GetFloat(TEXT("/Script/OnlineSubsystemEOS.NetDriverEOS"), TEXT("MatchmakingPingWeight"), PingWeight, GEngineIni);
+	GConfig->GetFloat(TEXT("/Script/OnlineSubsystemEOS.NetDriverEOS"), TEXT("MatchmakingAttributeWeight"), AttributeWeight, GEngineIni);
+	GConfig->GetBool(TEXT("/Script/OnlineSubsystemEOS.NetDriverEOS"), TEXT("bMatchmakingCreateOnTimeout"), bCreateOnTimeout, GEngineIni);
+	TimeBudget = FMath::Max(TimeBudget, 0.f);
+	RetryDelay = FMath::Max(RetryDelay, 0.f);
+	MaxJoinAttempts = FMath::Max(MaxJoinAttempts, 1);
+	PingTimeout = FMath::Max(PingTimeout, 0.f);
+	StepTimeout = FMath::Max(StepTimeout, 0.f);
+	FillWeight = FMath::Max(FillWeight, 0.f);
+	PingWeight = FMath::Max(PingWeight, 0.f);
+	AttributeWeight = FMath::Max(AttributeWeight, 0.f);
+}
+
+FSessionMatchmakingBackendEOS::FSessionMatchmakingBackendEOS(FOnlineSessionEOS& InSessionInterface, int32 InLocalUserNum)
+	: SessionInterface(InSessionInterface)
+	, LocalUserNum(InLocalUserNum)
+{
+	FindSessionsCompleteHandle = SessionInterface.AddOnFindSessionsCompleteDelegate_Handle(FOnFindSessionsCompleteDelegate::CreateRaw(this, &FSessionMatchmakingBackendEOS::OnFindSessionsComplete));
+	JoinSessionCompleteHandle = SessionInterface.AddOnJoinSessionCompleteDelegate_Handle(FOnJoinSessionCompleteDelegate::CreateRaw(this, &FSessionMatchmakingBackendEOS::OnJoinSessionComplete));
+	CreateSessionCompleteHandle = SessionInterface.AddOnCreateSessionCompleteDelegate_Handle(FOnCreateSessionCompleteDelegate::CreateRaw(this, &FSessionMatchmakingBackendEOS::OnCreateSessionComplete));
+}
+
+FSessionMatchmakingBackendEOS::~FSessionMatchmakingBackendEOS()
+{
+	SessionInterface.ClearOnFindSessionsCompleteDelegate_Handle(FindSessionsCompleteHandle);
+	SessionInterface.ClearOnJoinSessionCompleteDelegate_Handle(JoinSessionCompleteHandle);
+	SessionInterface.ClearOnCreateSessionCompleteDelegate_Handle(CreateSessionCompleteHandle);
+}
+
+bool FSessionMatchmakingBackendEOS::StartSearch(const TSharedRef<FOnlineSessionSearch>& Search, FOnMatchmakingStepCompleteEOS&& OnComplete)
+{
+	// Forget how the last round ended so an early failure can't be mistaken for old results
+	if (Search->SearchState != EOnlineAsyncTaskState::InProgress)
+	{
+		Search->SearchState = EOnlineAsyncTaskState::NotStarted;
+	}
+
+	PendingSearch = Search;
+	OnSearchComplete = MoveTemp(OnComplete);
+	// Early failures complete before FindSessions returns
+	if (!SessionInterface.FindSessions(LocalUserNum, Search) && OnSearchComplete)
+	{
+		PendingSearch.Reset();
+		OnSearchComplete = nullptr;
+		return false;
+	}
+	return true;
+}
+
+void FSessionMatchmakingBackendEOS::CancelSearch(const TSharedRef<FOnlineSessionSearch>& Search)
+{
+	PendingSearch.Reset();
+	OnSearchComplete = nullptr;
+	if (Search->SearchState == EOnlineAsyncTaskState::InProgress)
+	{
+		SessionInterface.CancelFindSessions(Search);
+	}
+}
+
+void FSessionMatchmakingBackendEOS::OnFindSessionsComplete(bool bWasSuccessful)
+{
+	// Every search fires this delegate, ours is done once its state moves on
+	if (!PendingSearch.IsValid() || PendingSearch->SearchState == EOnlineAsyncTaskState::InProgress)
+	{
+		return;
+	}
+
+	const bool bFoundResults = PendingSearch->SearchState == EOnlineAsyncTaskState::Done;
+	PendingSearch.Reset();
+	FOnMatchmakingStepCompleteEOS OnComplete = MoveTemp(OnSearchComplete);
+	OnSearchComplete = nullptr;
+	OnComplete(bFoundResults);
+}
+
+bool FSessionMatchmakingBackendEOS::StartPing(const TSharedRef<FOnlineSessionSearch>& Search, FOnMatchmakingStepCompleteEOS&& OnComplete)
+{
+	OnPingComplete = MakeShared<FOnMatchmakingStepCompleteEOS>(MoveTemp(OnComplete));
+	TWeakPtr<FOnMatchmakingStepCompleteEOS> WeakOnComplete = OnPingComplete;
+	const bool bIsPinging = SessionInterface.PingSearchResults(Search, [WeakOnComplete](bool bAnyAnswered)
+	{
+		TSharedPtr<FOnMatchmakingStepCompleteEOS> Callback = WeakOnComplete.Pin();
+		if (Callback.IsValid())
+		{
+			(*Callback)(bAnyAnswered);
+		}
+	});
+	if (!bIsPinging)
+	{
+		OnPingComplete.Reset();
+	}
+	return bIsPinging;
+}
+
+bool FSessionMatchmakingBackendEOS::StartJoin(FName SessionName, const FOnlineSessionSearchResult& Result, FOnMatchmakingStepCompleteEOS&& OnComplete)
+{
+	PendingJoinName = SessionName;
+	OnJoinComplete = MoveTemp(OnComplete);
+	if (!SessionInterface.JoinSession(LocalUserNum, SessionName, Result) && OnJoinComplete)
+	{
+		PendingJoinName = NAME_None;
+		OnJoinComplete = nullptr;
+		return false;
+	}
+	return true;
+}
+
+void FSessionMatchmakingBackendEOS::OnJoinSessionComplete(FName SessionName, EOnJoinSessionCompleteResult::Type Result)
+{
+	if (SessionName != PendingJoinName || !OnJoinComplete)
+	{
+		return;
+	}
+
+	const bool bWasSuccessful = Result == EOnJoinSessionCompleteResult::Success;
+	if (!bWasSuccessful && SessionInterface.GetNamedSession(SessionName) != nullptr)
+	{
+		// A failed EOS join leaves the pending session behind and the next candidate needs the name
+		SessionInterface.RemoveNamedSession(SessionName);
+	}
+
+	PendingJoinName = NAME_None;
+	FOnMatchmakingStepCompleteEOS OnComplete = MoveTemp(OnJoinComplete);
+	OnJoinComplete = nullptr;
+	OnComplete(bWasSuccessful);
+}
+
+bool FSessionMatchmakingBackendEOS::StartCreate(FName SessionName, const FOnlineSessionSettings& Settings, FOnMatchmakingStepCompleteEOS&& OnComplete)
+{
+	PendingCreateName = SessionName;
+	OnCreateComplete = MoveTemp(OnComplete);
+	if (!SessionInterface.CreateSession(LocalUserNum, SessionName, Settings) && OnCreateComplete)
+	{
+		PendingCreateName = NAME_None;
+		OnCreateComplete = nullptr;
+		return false;
+	}
+	return true;
+}
+
+void FSessionMatchmakingBackendEOS::OnCreateSessionComplete(FName SessionName, bool bWasSuccessful)
+{
+	if (SessionName != PendingCreateName || !OnCreateComplete)
+	{
+		return;
+	}
+
+	if (!bWasSuccessful && SessionInterface.GetNamedSession(SessionName) != nullptr)
+	{
+		SessionInterface.RemoveNamedSession(SessionName);
+	}
+
+	PendingCreateName = NAME_None;
+	FOnMatchmakingStepCompleteEOS OnComplete = MoveTemp(OnCreateComplete);
+	OnCreateComplete = nullptr;
+	OnComplete(bWasSuccessful);
+}
+
+FMatchmakingEOS::FMatchmakingEOS(TUniquePtr<IMatchmakingBackendEOS>&& InBackend, FName InSessionName, const FOnlineSessionSettings& InNewSessionSettings, const TSharedRef<FOnlineSessionSearch>& InSearch, const FMatchmakingSettingsEOS& InSettings)
+	: Backend(MoveTemp(InBackend))
+	, SessionName(InSessionName)
+	, NewSessionSettings(InNewSessionSettings)
+	, Search(InSearch)
+	, Settings(InSettings)
+	, State(EMatchmakingStateEOS::Idle)
+	, ElapsedTime(0.0)
+	, StateTime(0.0)
+	, NextCandidate(0)
+{
+}
+
+void FMatchmakingEOS::Start()
+{
+	check(State == EMatchmakingStateEOS::Idle);
+	ElapsedTime = 0.0;
+	StartSearch();
+}
+
+void FMatchmakingEOS::Tick(float DeltaTime)
+{
+	if (State == EMatchmakingStateEOS::Idle || IsFinished())
+	{
+		return;
+	}
+
+	ElapsedTime += DeltaTime;
+	StateTime += DeltaTime;
+	Backend->Tick(DeltaTime);
+
+	if (State == EMatchmakingStateEOS::Searching)
+	{
+		// A search cancelled by CancelFindSessions() fails without ever completing
+		if (Search->SearchState == EOnlineAsyncTaskState::Failed || StateTime >= Settings.StepTimeout)
+		{
+			Backend->CancelSearch(Search);
+			RetryOrCreate();
+		}
+	}
+	else if (State == EMatchmakingStateEOS::Pinging && StateTime >= Settings.PingTimeout)
+	{
+		// Rank with whatever pings made it back
+		JoinBestCandidates();
+	}
+	else if (State == EMatchmakingStateEOS::Joining && StateTime >= Settings.StepTimeout)
+	{
+		// The join can't be taken back, joining another candidate would only fail on the session name
+		Finish(EMatchmakingStateEOS::Failed);
+	}
+	else if (State == EMatchmakingStateEOS::Waiting)
+	{
+		if (ElapsedTime >= Settings.TimeBudget)
+		{
+			StartCreate();
+		}
+		else if (StateTime >= Settings.RetryDelay)
+		{
+			StartSearch();
+		}
+	}
+}
+
+bool FMatchmakingEOS::Cancel()
+{
+	if (IsFinished())
+	{
+		return false;
+	}
+
+	if (State == EMatchmakingStateEOS::Searching)
+	{
+		Backend->CancelSearch(Search);
+	}
+	Finish(EMatchmakingStateEOS::Cancelled);
+	return true;
+}
+
+void FMatchmakingEOS::SetState(EMatchmakingStateEOS NewState)
+{
+	State = NewState;
+	StateTime = 0.0;
+}
+
+void FMatchmakingEOS::Finish(EMatchmakingStateEOS FinalState)
+{
+	SetState(FinalState);
+	if (FinalState == EMatchmakingStateEOS::Succeeded)
+	{
+		Stats.TimeToMatch = ElapsedTime;
+	}
+}
+
+void FMatchmakingEOS::StartSearch()
+{
+	Stats.NumSearches++;
+	SetState(EMatchmakingStateEOS::Searching);
+	if (!Backend->StartSearch(Search, [this](bool bWasSuccessful) { OnSearchComplete(bWasSuccessful); }))
+	{
+		OnSearchComplete(false);
+	}
+}
+
+void FMatchmakingEOS::OnSearchComplete(bool bWasSuccessful)
+{
+	if (State != EMatchmakingStateEOS::Searching)
+	{
+		return;
+	}
+
+	if (!bWasSuccessful || Search->SearchResults.Num() == 0)
+	{
+		RetryOrCreate();
+		return;
+	}
+
+	SetState(EMatchmakingStateEOS::Pinging);
+	const bool bIsPinging = Backend->StartPing(Search, [this](bool)
+	{
+		if (State == EMatchmakingStateEOS::Pinging)
+		{
+			JoinBestCandidates();
+		}
+	});
+	if (!bIsPinging)
+	{
+		// Nothing we can measure, rank on fill and attributes alone
+		JoinBestCandidates();
+	}
+}
+
+void FMatchmakingEOS::JoinBestCandidates()
+{
+	TArray<TPair<float, int32>, TInlineAllocator<64>> Ranked;
+	for (int32 ResultIndex = 0; ResultIndex < Search->SearchResults.Num(); ResultIndex++)
+	{
+		const FOnlineSessionSearchResult& Result = Search->SearchResults[ResultIndex];
+		if (FailedSessionIds.Contains(Result.GetSessionIdStr()))
+		{
+			continue;
+		}
+		const float Score = ScoreResult(Result, *Search, Settings);
+		if (Score >= 0.f)
+		{
+			Ranked.Emplace(Score, ResultIndex);
+		}
+	}
+	// Stable so equal scores keep the backend's order
+	Ranked.StableSort([](const TPair<float, int32>& A, const TPair<float, int32>& B)
+	{
+		return A.Key > B.Key;
+	});
+
+	Candidates.Reset();
+	NextCandidate = 0;
+	for (int32 RankIndex = 0; RankIndex < Ranked.Num() && Candidates.Num() < Settings.MaxJoinAttempts; RankIndex++)
+	{
+		Candidates.Add(Search->SearchResults[Ranked[RankIndex].Value]);
+	}
+	JoinNextCandidate();
+}
+
+void FMatchmakingEOS::JoinNextCandidate()
+{
+	if (NextCandidate >= Candidates.Num())
+	{
+		RetryOrCreate();
+		return;
+	}
+
+	// Copied since a join that fails straight away can start a new search that replaces the candidates
+	const FOnlineSessionSearchResult Candidate = Candidates[NextCandidate++];
+	JoiningSessionId = Candidate.GetSessionIdStr();
+	Stats.NumJoinAttempts++;
+	SetState(EMatchmakingStateEOS::Joining);
+	if (!Backend->StartJoin(SessionName, Candidate, [this](bool bWasSuccessful) { OnJoinComplete(bWasSuccessful); }))
+	{
+		OnJoinComplete(false);
+	}
+}
+
+void FMatchmakingEOS::OnJoinComplete(bool bWasSuccessful)
+{
+	if (State != EMatchmakingStateEOS::Joining)
+	{
+		return;
+	}
+
+	if (bWasSuccessful)
+	{
+		Finish(EMatchmakingStateEOS::Succeeded);
+		return;
+	}
+
+	Stats.NumJoinFailures++;
+	FailedSessionIds.Add(JoiningSessionId);
+	JoinNextCandidate();
+}
+
+void FMatchmakingEOS::RetryOrCreate()
+{
+	if (ElapsedTime >= Settings.TimeBudget)
+	{
+		StartCreate();
+	}
+	else
+	{
+		SetState(EMatchmakingStateEOS::Waiting);
+	}
+}
+
+void FMatchmakingEOS::StartCreate()
+{
+	if (!Settings.bCreateOnTimeout)
+	{
+		Finish(EMatchmakingStateEOS::Failed);
+		return;
+	}
+
+	SetState(EMatchmakingStateEOS::Creating);
+	if (!Backend->StartCreate(SessionName, NewSessionSettings, [this](bool bWasSuccessful) { OnCreateComplete(bWasSuccessful); }))
+	{
+		OnCreateComplete(false);
+	}
+}
+
+void FMatchmakingEOS::OnCreateComplete(bool bWasSuccessful)
+{
+	if (State != EMatchmakingStateEOS::Creating)
+	{
+		return;
+	}
+
+	Stats.bCreatedSession = bWasSuccessful;
+	Finish(bWasSuccessful ? EMatchmakingStateEOS::Succeeded : EMatchmakingStateEOS::Failed);
+}
+
+/** @return true if the value is a number, written to OutValue */
+static bool GetNumericValue(const FVariantData& Data, double& OutValue)
+{
+	switch (Data.GetType())
+	{
+		case EOnlineKeyValuePairDataType::Int32:
+		{
+			int32 Value;
+			Data.GetValue(Value);
+			OutValue = Value;
+			return true;
+		}
+		case EOnlineKeyValuePairDataType::UInt32:
+		{
+			uint32 Value;
+			Data.GetValue(Value);
+			OutValue = Value;
+			return true;
+		}
+		case EOnlineKeyValuePairDataType::Int64:
+		{
+			int64 Value;
+			Data.GetValue(Value);
+			OutValue = (double)Value;
+			return true;
+		}
+		case EOnlineKeyValuePairDataType::UInt64:
+		{
+			uint64 Value;
+			Data.GetValue(Value);
+			OutValue = (double)Value;
+			return true;
+		}
+		case EOnlineKeyValuePairDataType::Float:
+		{
+			float Value;
+			Data.GetValue(Value);
+			OutValue = Value;
+			return true;
+		}
+		case EOnlineKeyValuePairDataType::Double:
+		{
+			Data.GetValue(OutValue);
+			return true;
+		}
+		case EOnlineKeyValuePairDataType::Bool:
+		{
+			bool Value;
+			Data.GetValue(Value);
+			OutValue = Value ? 1.0 : 0.0;
+			return true;
+		}
+		default:
+		{
+			break;
+		}
+	}
+	return false;
+}
+
+/** @return how well a setting satisfies a search param between 0 and 1, or a negative value if the param can't be scored */
+static float ScoreSearchParam(const FOnlineSessionSearchParam& Param, const FOnlineSessionSetting* Setting)
+{
+	if (Param.ComparisonOp == EOnlineComparisonOp::In || Param.ComparisonOp == EOnlineComparisonOp::NotIn)
+	{
+		return -1.f;
+	}
+	if (Setting == nullptr)
+	{
+		return 0.f;
+	}
+
+	double Wanted = 0.0;
+	double Actual = 0.0;
+	const bool bIsNumeric = GetNumericValue(Param.Data, Wanted) && GetNumericValue(Setting->Data, Actual);
+	const bool bIsEqual = bIsNumeric ? Actual == Wanted : Setting->Data == Param.Data;
+	switch (Param.ComparisonOp)
+	{
+		case EOnlineComparisonOp::Equals:
+			return bIsEqual ? 1.f : 0.f;
+		case EOnlineComparisonOp::NotEquals:
+			return bIsEqual ? 0.f : 1.f;
+		case EOnlineComparisonOp::GreaterThan:
+			return bIsNumeric && Actual > Wanted ? 1.f : 0.f;
+		case EOnlineComparisonOp::GreaterThanEquals:
+			return bIsNumeric && Actual >= Wanted ? 1.f : 0.f;
+		case EOnlineComparisonOp::LessThan:
+			return bIsNumeric && Actual < Wanted ? 1.f : 0.f;
+		case EOnlineComparisonOp::LessThanEquals:
+			return bIsNumeric && Actual <= Wanted ? 1.f : 0.f;
+		case EOnlineComparisonOp::Near:
+		{
+			if (!bIsNumeric)
+			{
+				return bIsEqual ? 1.f : 0.f;
+			}
+			// Relative distance so skill ratings and small counts both fall off sensibly
+			const double Distance = FMath::Abs(Actual - Wanted) / FMath::Max(FMath::Abs(Wanted), 1.0);
+			return 1.f - (float)FMath::Min(Distance, 1.0);
+		}
+		default:
+		{
+			break;
+		}
+	}
+	return -1.f;
+}
+
+float FMatchmakingEOS::ScoreResult(const FOnlineSessionSearchResult& Result, const FOnlineSessionSearch& Search, const FMatchmakingSettingsEOS& Settings)
+{
+	const FOnlineSession& Session = Result.Session;
+	const int32 NumSlots = Session.SessionSettings.NumPublicConnections;
+	if (NumSlots <= 0 || Session.NumOpenPublicConnections <= 0)
+	{
+		return -1.f;
+	}
+
+	// Fuller sessions start sooner
+	const float Fill = FMath::Clamp((float)(NumSlots - Session.NumOpenPublicConnections) / NumSlots, 0.f, 1.f);
+	// Unmeasured pings are MAX_QUERY_PING and score nothing
+	const float Latency = Settings.MaxPingMs > 0.f ? 1.f - FMath::Clamp(Result.PingInMs / Settings.MaxPingMs, 0.f, 1.f) : 0.f;
+
+	float AttributeTotal = 0.f;
+	int32 NumAttributes = 0;
+	for (FSearchParams::TConstIterator It(Search.QuerySettings.SearchParams); It; ++It)
+	{
+		const float ParamScore = ScoreSearchParam(It.Value(), Session.SessionSettings.Settings.Find(It.Key()));
+		if (ParamScore >= 0.f)
+		{
+			AttributeTotal += ParamScore;
+			NumAttributes++;
+		}
+	}
+	const float Attributes = NumAttributes > 0 ? AttributeTotal / NumAttributes : 1.f;
+
+	const float TotalWeight = Settings.FillWeight + Settings.PingWeight + Settings.AttributeWeight;
+	if (TotalWeight <= 0.f)
+	{
+		return 0.f;
+	}
+	return (Settings.FillWeight * Fill + Settings.PingWeight * Latency + Settings.AttributeWeight * Attributes) / TotalWeight;
+}
+
+#if !UE_BUILD_SHIPPING
+/** Hosted sessions the bench matchmakes into, shared by every run so joins fill them up */
+struct FMockSessionPoolEOS
+{
+	struct FHostedSession
+	{
+		FOnlineSessionSearchResult Result;
+		/** What a ping to the host would measure */
+		int32 PingInMs;
+	};
+
+	TArray<FHostedSession> Sessions;
+	FRandomStream Random;
+	int32 NumSlots;
+	/** Chance a join fails even though the session has room, e.g. the host left */
+	float JoinFailureRate;
+	/** Chance per search that someone else takes a slot in each session */
+	float ChurnRate;
+	int32 NextSessionId;
+
+	FHostedSession& AddSession(const FOnlineSessionSettings& Settings, int32 NumOpenSlots)
+	{
+		FHostedSession& Hosted = Sessions.AddDefaulted_GetRef();
+		FOnlineSession& Session = Hosted.Result.Session;
+		Session.SessionSettings = Settings;
+		Session.SessionSettings.NumPublicConnections = NumSlots;
+		Session.NumOpenPublicConnections = NumOpenSlots;
+		Session.OwningUserId = MakeShared<FUniqueNetIdEOS>(FString::Printf(TEXT("MockHost%d"), NextSessionId));
+		FOnlineSessionInfoEOS* SessionInfo = new FOnlineSessionInfoEOS();
+		SessionInfo->SessionId = FUniqueNetIdEOS(FString::Printf(TEXT("MockSession%d"), NextSessionId));
+		Session.SessionInfo = MakeShareable(SessionInfo);
+		Hosted.PingInMs = Random.RandRange(20, 250);
+		NextSessionId++;
+		return Hosted;
+	}
+
+	FHostedSession* Find(const FString& SessionId)
+	{
+		return Sessions.FindByPredicate([&SessionId](const FHostedSession& Hosted) { return Hosted.Result.GetSessionIdStr() == SessionId; });
+	}
+
+	/** Other players join sessions between our searches and full sessions leave the list as their matches start */
+	void Churn()
+	{
+		for (int32 SessionIndex = Sessions.Num() - 1; SessionIndex >= 0; SessionIndex--)
+		{
+			FOnlineSession& Session = Sessions[SessionIndex].Result.Session;
+			if (Session.NumOpenPublicConnections > 0 && Random.GetFraction() < ChurnRate)
+			{
+				Session.NumOpenPublicConnections--;
+			}
+			if (Session.NumOpenPublicConnections == 0 && Random.GetFraction() < 0.5f)
+			{
+				Sessions.RemoveAt(SessionIndex);
+			}
+		}
+	}
+};
+
+/** Answers the matchmaker from the mock pool after fixed delays, the way the EOS backend would */
+class FMockMatchmakingBackendEOS :
+	public IMatchmakingBackendEOS
+{
+public:
+	FMockMatchmakingBackendEOS(FMockSessionPoolEOS& InPool)
+		: Pool(InPool)
+		, Time(0.0)
+	{
+	}
+
+	virtual bool StartSearch(const TSharedRef<FOnlineSessionSearch>& Search, FOnMatchmakingStepCompleteEOS&& OnComplete) override
+	{
+		Search->SearchState = EOnlineAsyncTaskState::InProgress;
+		Search->SearchResults.Reset();
+		Defer(0.3, true, [this, Search, OnComplete]()
+		{
+			Pool.Churn();
+			// Equals params are filtered by the backend, everything else is left to scoring
+			for (const FMockSessionPoolEOS::FHostedSession& Hosted : Pool.Sessions)
+			{
+				bool bMatches = true;
+				for (FSearchParams::TConstIterator It(Search->QuerySettings.SearchParams); It && bMatches; ++It)
+				{
+					if (It.Value().ComparisonOp == EOnlineComparisonOp::Equals)
+					{
+						const FOnlineSessionSetting* Setting = Hosted.Result.Session.SessionSettings.Settings.Find(It.Key());
+						bMatches = Setting != nullptr && Setting->Data == It.Value().Data;
+					}
+				}
+				if (bMatches && Search->SearchResults.Num() < Search->MaxSearchResults)
+				{
+					Search->SearchResults.Add(Hosted.Result);
+				}
+			}
+			Search->SearchState = EOnlineAsyncTaskState::Done;
+			OnComplete(true);
+		});
+		return true;
+	}
+
+	virtual void CancelSearch(const TSharedRef<FOnlineSessionSearch>& Search) override
+	{
+		Pending.RemoveAll([](const FPendingStep& Step) { return Step.bIsSearch; });
+		Search->SearchState = EOnlineAsyncTaskState::Failed;
+	}
+
+	virtual bool StartPing(const TSharedRef<FOnlineSessionSearch>& Search, FOnMatchmakingStepCompleteEOS&& OnComplete) override
+	{
+		Defer(0.1, false, [this, Search, OnComplete]()
+		{
+			for (FOnlineSessionSearchResult& Result : Search->SearchResults)
+			{
+				if (const FMockSessionPoolEOS::FHostedSession* Hosted = Pool.Find(Result.GetSessionIdStr()))
+				{
+					Result.PingInMs = Hosted->PingInMs;
+				}
+			}
+			OnComplete(true);
+		});
+		return true;
+	}
+
+	virtual bool StartJoin(FName SessionName, const FOnlineSessionSearchResult& Result, FOnMatchmakingStepCompleteEOS&& OnComplete) override
+	{
+		const FString SessionId = Result.GetSessionIdStr();
+		Defer(0.2, false, [this, SessionId, OnComplete]()
+		{
+			// The session may have filled up or gone away since we searched
+			FMockSessionPoolEOS::FHostedSession* Hosted = Pool.Find(SessionId);
+			const bool bWasSuccessful = Hosted != nullptr && Hosted->Result.Session.NumOpenPublicConnections > 0 && Pool.Random.GetFraction() >= Pool.JoinFailureRate;
+			if (bWasSuccessful)
+			{
+				Hosted->Result.Session.NumOpenPublicConnections--;
+			}
+			OnComplete(bWasSuccessful);
+		});
+		return true;
+	}
+
+	virtual bool StartCreate(FName SessionName, const FOnlineSessionSettings& Settings, FOnMatchmakingStepCompleteEOS&& OnComplete) override
+	{
+		Defer(0.5, false, [this, Settings, OnComplete]()
+		{
+			Pool.AddSession(Settings, Pool.NumSlots - 1);
+			OnComplete(true);
+		});
+		return true;
+	}
+
+	virtual void Tick(float DeltaTime) override
+	{
+		Time += DeltaTime;
+		// Steps can queue more steps so run them one at a time
+		for (int32 StepIndex = 0; StepIndex < Pending.Num(); )
+		{
+			if (Pending[StepIndex].DueTime <= Time)
+			{
+				TFunction<void()> Step = MoveTemp(Pending[StepIndex].Step);
+				Pending.RemoveAt(StepIndex);
+				Step();
+				StepIndex = 0;
+			}
+			else
+			{
+				StepIndex++;
+			}
+		}
+	}
+
+private:
+	struct FPendingStep
+	{
+		double DueTime;
+		bool bIsSearch;
+		TFunction<void()> Step;
+	};
+
+	void Defer(double Delay, bool bIsSearch, TFunction<void()>&& Step)
+	{
+		FPendingStep& PendingStep = Pending.AddDefaulted_GetRef();
+		PendingStep.DueTime = Time + Delay;
+		PendingStep.bIsSearch = bIsSearch;
+		PendingStep.Step = MoveTemp(Step);
+	}
+
+	FMockSessionPoolEOS& Pool;
+	TArray<FPendingStep> Pending;
+	double Time;
+};
+
+bool FMatchmakingEOS::HandleBenchExec(const TCHAR* Cmd, FOutputDevice& Ar)
+{
+	int32 NumRuns = 100;
+	int32 NumSessions = 8;
+	int32 NumSlots = 8;
+	float FailPercent = 10.f;
+	int32 Seed = 1;
+	FMatchmakingSettingsEOS BenchSettings;
+	BenchSettings.LoadConfig();
+	FParse::Value(Cmd, TEXT("Runs="), NumRuns);
+	FParse::Value(Cmd, TEXT("Sessions="), NumSessions);
+	FParse::Value(Cmd, TEXT("Slots="), NumSlots);
+	FParse::Value(Cmd, TEXT("Fail="), FailPercent);
+	FParse::Value(Cmd, TEXT("Seed="), Seed);
+	FParse::Value(Cmd, TEXT("Budget="), BenchSettings.TimeBudget);
+	NumRuns = FMath::Clamp(NumRuns, 1, 10000);
+	NumSessions = FMath::Clamp(NumSessions, 0, 1000);
+	NumSlots = FMath::Clamp(NumSlots, 2, 64);
+
+	const FName ModeKey(TEXT("MODE"));
+	const FName SkillKey(TEXT("SKILL"));
+
+	FMockSessionPoolEOS Pool;
+	Pool.Random.Initialize(Seed);
+	Pool.NumSlots = NumSlots;
+	Pool.JoinFailureRate = FMath::Clamp(FailPercent / 100.f, 0.f, 1.f);
+	Pool.ChurnRate = 0.2f;
+	Pool.NextSessionId = 0;
+	for (int32 SessionIndex = 0; SessionIndex < NumSessions; SessionIndex++)
+	{
+		FOnlineSessionSettings HostSettings;
+		HostSettings.Set(ModeKey, FString(Pool.Random.GetFraction() < 0.75f ? TEXT("TDM") : TEXT("CTF")), EOnlineDataAdvertisementType::ViaOnlineService);
+		HostSettings.Set(SkillKey, Pool.Random.RandRange(0, 2000), EOnlineDataAdvertisementType::ViaOnlineService);
+		Pool.AddSession(HostSettings, Pool.Random.RandRange(1, NumSlots));
+	}
+
+	const float TickDelta = 0.05f;
+	const double MaxRunTime = BenchSettings.TimeBudget + 60.0;
+	TArray<double> TimesToMatch;
+	int32 NumJoined = 0;
+	int32 NumCreated = 0;
+	int32 NumFailed = 0;
+	int32 NumSearches = 0;
+	int32 NumJoinAttempts = 0;
+	int32 NumJoinFailures = 0;
+	for (int32 Run = 0; Run < NumRuns; Run++)
+	{
+		const int32 Skill = Pool.Random.RandRange(0, 2000);
+		TSharedRef<FOnlineSessionSearch> Search = MakeShared<FOnlineSessionSearch>();
+		Search->MaxSearchResults = 20;
+		Search->QuerySettings.Set(ModeKey, FString(TEXT("TDM")), EOnlineComparisonOp::Equals);
+		Search->QuerySettings.Set(SkillKey, Skill, EOnlineComparisonOp::Near);
+
+		FOnlineSessionSettings NewSettings;
+		NewSettings.Set(ModeKey, FString(TEXT("TDM")), EOnlineDataAdvertisementType::ViaOnlineService);
+		NewSettings.Set(SkillKey, Skill, EOnlineDataAdvertisementType::ViaOnlineService);
+
+		FMatchmakingEOS Matchmaker(MakeUnique<FMockMatchmakingBackendEOS>(Pool), NAME_GameSession, NewSettings, Search, BenchSettings);
+		Matchmaker.Start();
+		for (double RunTime = 0.0; !Matchmaker.IsFinished() && RunTime < MaxRunTime; RunTime += TickDelta)
+		{
+			Matchmaker.Tick(TickDelta);
+		}
+
+		const FMatchmakingStatsEOS& RunStats = Matchmaker.GetStats();
+		NumSearches += RunStats.NumSearches;
+		NumJoinAttempts += RunStats.NumJoinAttempts;
+		NumJoinFailures += RunStats.NumJoinFailures;
+		if (Matchmaker.GetState() == EMatchmakingStateEOS::Succeeded)
+		{
+			TimesToMatch.Add(RunStats.TimeToMatch);
+			if (RunStats.bCreatedSession)
+			{
+				NumCreated++;
+			}
+			else
+			{
+				NumJoined++;
+			}
+		}
+		else
+		{
+			NumFailed++;
+		}
+	}
+
+	Ar.Logf(TEXT("%d runs: %d joined, %d created, %d failed, %d searches"), NumRuns, NumJoined, NumCreated, NumFailed, NumSearches);
+	if (TimesToMatch.Num() > 0)
+	{
+		const FBenchSummaryEOS Summary(TimesToMatch);
+		Ar.Logf(TEXT("Time to match: mean %.2f s, p50 %.2f s, p95 %.2f s"), Summary.Mean, Summary.P50, Summary.P95);
+	}
+	Ar.Logf(TEXT("Join attempts %d, failures %d (%.1f%%)"), NumJoinAttempts, NumJoinFailures, NumJoinAttempts > 0 ? 100.f * NumJoinFailures / NumJoinAttempts : 0.f);
+	return true;
+}
+#endif
+
+#endif
@@ -0,0 +1,241 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "OnlineSessionSettings.h"
+#include "Interfaces/OnlineSessionInterface.h"
+
+class FOnlineSessionEOS;
+
+#if WITH_EOS_SDK
+
+/** Where a matchmaking attempt is */
+enum class EMatchmakingStateEOS : uint8
+{
+	Idle,
+	Searching,
+	/** Measuring latency to the search results before ranking them */
+	Pinging,
+	Joining,
+	/** Nothing joinable was found, waiting before searching again */
+	Waiting,
+	/** Out of time, hosting our own session instead */
+	Creating,
+	Succeeded,
+	Failed,
+	Cancelled
+};
+
+/** Matchmaking tunables, read from the engine ini */
+struct FMatchmakingSettingsEOS
+{
+	/** Seconds spent looking for a session before creating one */
+	float TimeBudget;
+	/** Seconds between searches that found nothing joinable */
+	float RetryDelay;
+	/** Most candidates we try to join per search */
+	int32 MaxJoinAttempts;
+	/** Seconds we wait on pings before ranking with whatever came back */
+	float PingTimeout;
+	/** Seconds we wait on a search or a join before giving up on it */
+	float StepTimeout;
+	/** Ping in milliseconds at which a candidate gets no latency score */
+	float MaxPingMs;
+	/** How much fuller sessions are preferred, they start sooner */
+	float FillWeight;
+	/** How much lower latency is preferred */
+	float PingWeight;
+	/** How much sessions that match more of the search params are preferred */
+	float AttributeWeight;
+	/** Whether to host a session once the time budget runs out rather than fail */
+	bool bCreateOnTimeout;
+
+	FMatchmakingSettingsEOS();
+
+	void LoadConfig();
+};
+
+/** Called once a backend step finishes, may be called before the step's Start function returns */
+typedef TFunction<void(bool bWasSuccessful)> FOnMatchmakingStepCompleteEOS;
+
+/** The session calls the matchmaker is built on, so it can be driven by a mock as well as by EOS */
+class IMatchmakingBackendEOS
+{
+public:
+	virtual ~IMatchmakingBackendEOS() {}
+
+	/** @return false if the search could not be started, OnComplete is not called */
+	virtual bool StartSearch(const TSharedRef<FOnlineSessionSearch>& Search, FOnMatchmakingStepCompleteEOS&& OnComplete) = 0;
+	/** Stops a search started by StartSearch, its OnComplete is not called */
+	virtual void CancelSearch(const TSharedRef<FOnlineSessionSearch>& Search) = 0;
+	/** Writes PingInMs into the search results. @return false if nothing could be pinged, OnComplete is not called */
+	virtual bool StartPing(const TSharedRef<FOnlineSessionSearch>& Search, FOnMatchmakingStepCompleteEOS&& OnComplete) = 0;
+	/** @return false if the join could not be started, OnComplete is not called */
+	virtual bool StartJoin(FName SessionName, const FOnlineSessionSearchResult& Result, FOnMatchmakingStepCompleteEOS&& OnComplete) = 0;
+	/** @return false if the session could not be created, OnComplete is not called */
+	virtual bool StartCreate(FName SessionName, const FOnlineSessionSettings& Settings, FOnMatchmakingStepCompleteEOS&& OnComplete) = 0;
+	/** Advances backends that simulate time */
+	virtual void Tick(float DeltaTime) {}
+};
+
+/** Runs matchmaking through FOnlineSessionEOS, one per StartMatchmaking call */
+class FSessionMatchmakingBackendEOS :
+	public IMatchmakingBackendEOS
+{
+public:
+	FSessionMatchmakingBackendEOS(FOnlineSessionEOS& InSessionInterface, int32 InLocalUserNum);
+	virtual ~FSessionMatchmakingBackendEOS();
+
+// IMatchmakingBackendEOS
+	virtual bool StartSearch(const TSharedRef<FOnlineSessionSearch>& Search, FOnMatchmakingStepCompleteEOS&& OnComplete) override;
+	virtual void CancelSearch(const TSharedRef<FOnlineSessionSearch>& Search) override;
+	virtual bool StartPing(const TSharedRef<FOnlineSessionSearch>& Search, FOnMatchmakingStepCompleteEOS&& OnComplete) override;
+	virtual bool StartJoin(FName SessionName, const FOnlineSessionSearchResult& Result, FOnMatchmakingStepCompleteEOS&& OnComplete) override;
+	virtual bool StartCreate(FName SessionName, const FOnlineSessionSettings& Settings, FOnMatchmakingStepCompleteEOS&& OnComplete) override;
+// ~IMatchmakingBackendEOS
+
+private:
+	void OnFindSessionsComplete(bool bWasSuccessful);
+	void OnJoinSessionComplete(FName SessionName, EOnJoinSessionCompleteResult::Type Result);
+	void OnCreateSessionComplete(FName SessionName, bool bWasSuccessful);
+
+	FOnlineSessionEOS& SessionInterface;
+	int32 LocalUserNum;
+
+	/** The session delegates are shared by every caller, so each step remembers what it is waiting for */
+	TSharedPtr<FOnlineSessionSearch> PendingSearch;
+	FOnMatchmakingStepCompleteEOS OnSearchComplete;
+	FName PendingJoinName;
+	FOnMatchmakingStepCompleteEOS OnJoinComplete;
+	FName PendingCreateName;
+	FOnMatchmakingStepCompleteEOS OnCreateComplete;
+	/** Pings outlive us in the ping service, they only hold a weak reference to this */
+	TSharedPtr<FOnMatchmakingStepCompleteEOS> OnPingComplete;
+
+	FDelegateHandle FindSessionsCompleteHandle;
+	FDelegateHandle JoinSessionCompleteHandle;
+	FDelegateHandle CreateSessionCompleteHandle;
+};
+
+/** What a matchmaking attempt cost, the bench aggregates these */
+struct FMatchmakingStatsEOS
+{
+	int32 NumSearches;
+	int32 NumJoinAttempts;
+	int32 NumJoinFailures;
+	/** Seconds from Start until we were in a session, only valid once succeeded */
+	double TimeToMatch;
+	/** True if we ended up hosting rather than joining */
+	bool bCreatedSession;
+
+	FMatchmakingStatsEOS()
+		: NumSearches(0)
+		, NumJoinAttempts(0)
+		, NumJoinFailures(0)
+		, TimeToMatch(0.0)
+		, bCreatedSession(false)
+	{
+	}
+};
+
+/**
+ * Client side matchmaking: searches, ranks the results by fill, latency and how well they match the search,
+ * joins the best one and moves down the list when a join fails. Searches again until the time budget runs
+ * out and then creates a session instead. Driven by Tick and backend callbacks on the game thread
+ */
+class FMatchmakingEOS
+{
+public:
+	FMatchmakingEOS(TUniquePtr<IMatchmakingBackendEOS>&& InBackend, FName InSessionName, const FOnlineSessionSettings& InNewSessionSettings, const TSharedRef<FOnlineSessionSearch>& InSearch, const FMatchmakingSettingsEOS& InSettings);
+
+	/** Starts the first search */
+	void Start();
+
+	/** Advances timers and the backend */
+	void Tick(float DeltaTime);
+
+	/**
+	 * Stops searching. A join or create that is already in flight still completes and the game owns the session,
+	 * the same goes for a join that timed out
+	 *
+	 * @return false if matchmaking had already finished
+	 */
+	bool Cancel();
+
+	EMatchmakingStateEOS GetState() const
+	{
+		return State;
+	}
+
+	/** @return true once succeeded, failed or cancelled */
+	bool IsFinished() const
+	{
+		return State == EMatchmakingStateEOS::Succeeded || State == EMatchmakingStateEOS::Failed || State == EMatchmakingStateEOS::Cancelled;
+	}
+
+	const FMatchmakingStatsEOS& GetStats() const
+	{
+		return Stats;
+	}
+
+	/**
+	 * Rates a search result as a match
+	 *
+	 * @param Result the candidate session
+	 * @param Search the search it came from, its params are the attributes we want
+	 * @param Settings the weights to use
+	 *
+	 * @return a score between 0 and 1, higher is better, or a negative value if the session can't be joined
+	 */
+	static float ScoreResult(const FOnlineSessionSearchResult& Result, const FOnlineSessionSearch& Search, const FMatchmakingSettingsEOS& Settings);
+
+#if !UE_BUILD_SHIPPING
+	/**
+	 * Runs matchmaking repeatedly against a simulated sessions backend and reports time to match and join failures
+	 *
+	 * @param Cmd the rest of the command, Runs= Sessions= Slots= Fail= (join failure %) Seed= Budget= (seconds)
+	 * @param Ar where to write the results
+	 * @return true if the command was handled
+	 */
+	static bool HandleBenchExec(const TCHAR* Cmd, FOutputDevice& Ar);
+#endif
+
+private:
+	void StartSearch();
+	void OnSearchComplete(bool bWasSuccessful);
+	/** Ranks the current results and starts joining them */
+	void JoinBestCandidates();
+	void JoinNextCandidate();
+	void OnJoinComplete(bool bWasSuccessful);
+	/** Searches again after the retry delay, or creates once out of time */
+	void RetryOrCreate();
+	void StartCreate();
+	void OnCreateComplete(bool bWasSuccessful);
+	void Finish(EMatchmakingStateEOS FinalState);
+	void SetState(EMatchmakingStateEOS NewState);
+
+	TUniquePtr<IMatchmakingBackendEOS> Backend;
+	FName SessionName;
+	FOnlineSessionSettings NewSessionSettings;
+	TSharedRef<FOnlineSessionSearch> Search;
+	FMatchmakingSettingsEOS Settings;
+
+	EMatchmakingStateEOS State;
+	/** Seconds since Start */
+	double ElapsedTime;
+	/** Seconds since the last state change */
+	double StateTime;
+
+	/** Best first, copied out of the search so a new search can't change them under us */
+	TArray<FOnlineSessionSearchResult> Candidates;
+	int32 NextCandidate;
+	/** The candidate being joined, remembered so a failure can skip it from then on */
+	FString JoiningSessionId;
+	/** Sessions we failed to join, they are skipped by later searches */
+	TSet<FString> FailedSessionIds;
+
+	FMatchmakingStatsEOS Stats;
+};
+
+#endif
@@ -43,9 +43,9 @@ public:
 	 */
 	friend inline FNboSerializeToBufferEOS& operator<<(FNboSerializeToBufferEOS& Ar, const FUniqueNetIdEOS& UniqueId)
 	{
-		Ar << UniqueId.UniqueNetIdStr;
-		Ar << UniqueId.EpicAccountIdStr;
-		Ar << UniqueId.ProductUserIdStr;
+		Ar << UniqueId.GetNetIdStr();
+		Ar << UniqueId.GetEpicAccountIdStr();
+		Ar << UniqueId.GetProductUserIdStr();
 		return Ar;
 	}
 };
@@ -81,9 +81,26 @@ public:
 	 */
 	friend inline FNboSerializeFromBufferEOS& operator>>(FNboSerializeFromBufferEOS& Ar, FUniqueNetIdEOS& UniqueId)
 	{
-		Ar >> UniqueId.UniqueNetIdStr;
-		Ar >> UniqueId.EpicAccountIdStr;
-		Ar >> UniqueId.ProductUserIdStr;
+		FString NetIdStr;
+		FString EpicAccountIdStr;
+		FString ProductUserIdStr;
+		Ar >> NetIdStr;
+		Ar >> EpicAccountIdStr;
+		Ar >> ProductUserIdStr;
+		UniqueId.UpdateNetIdStr(NetIdStr);
+		// The parts are split back out of the whole id when it is interned, if that doesn't give what was sent then
+		// build the id from the parts so both account ids come back as written
+		if (!UniqueId.GetEpicAccountIdStr().Equals(EpicAccountIdStr, ESearchCase::CaseSensitive)
+			|| !UniqueId.GetProductUserIdStr().Equals(ProductUserIdStr, ESearchCase::CaseSensitive))
+		{
+			FString PartsNetIdStr = EpicAccountIdStr;
+			if (!ProductUserIdStr.IsEmpty())
+			{
+				PartsNetIdStr += EOS_ID_SEPARATOR;
+				PartsNetIdStr += ProductUserIdStr;
+			}
+			UniqueId.UpdateNetIdStr(PartsNetIdStr);
+		}
 		return Ar;
 	}
 };
@@ -198,6 +198,21 @@ void UNetDriverEOS::Shutdown()
 	}
 }
 
+void UNetDriverEOS::TickFlush(float DeltaSeconds)
+{
+	FSocketEOS* const EOSSocket = bIsPassthrough ? nullptr : static_cast<FSocketEOS*>(GetSocket());
+	if (EOSSocket == nullptr)
+	{
+		Super::TickFlush(DeltaSeconds);
+		return;
+	}
+
+	// Every connection's packets for this frame go out together once replication is done
+	EOSSocket->BeginSendBatch();
+	Super::TickFlush(DeltaSeconds);
+	EOSSocket->EndSendBatch();
+}
+
 int UNetDriverEOS::GetClientPort()
 {
 	if (bIsPassthrough)
@@ -51,7 +51,7 @@ void FOnlineAchievementsEOS::QueryAchievements(const FUniqueNetId& PlayerId, con
 		if (bWasSuccessful)
 		{
 			TSharedPtr<TArray<FOnlineAchievement>> Cheevos = MakeShareable(new TArray<FOnlineAchievement>());
-			CachedAchievementsMap.Add(LambaPlayerId.UniqueNetIdStr, Cheevos);
+			CachedAchievementsMap.Add(LambaPlayerId.GetNetIdStr(), Cheevos);
 
 			int32 LocalUserNum = EOSSubsystem->UserManager->GetLocalUserNumFromUniqueNetId(LambaPlayerId);
 			EOS_ProductUserId UserId = EOSSubsystem->UserManager->GetLocalProductUserId(LocalUserNum);
@@ -180,9 +180,9 @@ void FOnlineAchievementsEOS::QueryAchievementDescriptions(const FUniqueNetId& Pl
 EOnlineCachedResult::Type FOnlineAchievementsEOS::GetCachedAchievement(const FUniqueNetId& PlayerId, const FString& AchievementId, FOnlineAchievement& OutAchievement)
 {
 	FUniqueNetIdEOS EOSID(PlayerId);
-	if (CachedAchievementsMap.Contains(EOSID.UniqueNetIdStr))
+	if (CachedAchievementsMap.Contains(EOSID.GetNetIdStr()))
 	{
-		const TArray<FOnlineAchievement>& Achievements = *CachedAchievementsMap[EOSID.UniqueNetIdStr];
+		const TArray<FOnlineAchievement>& Achievements = *CachedAchievementsMap[EOSID.GetNetIdStr()];
 		for (const FOnlineAchievement& Achievement : Achievements)
 		{
 			if (Achievement.Id == AchievementId)
@@ -198,9 +198,9 @@ EOnlineCachedResult::Type FOnlineAchievementsEOS::GetCachedAchievement(const FUn
 EOnlineCachedResult::Type FOnlineAchievementsEOS::GetCachedAchievements(const FUniqueNetId& PlayerId, TArray<FOnlineAchievement>& OutAchievements)
 {
 	FUniqueNetIdEOS EOSID(PlayerId);
-	if (CachedAchievementsMap.Contains(EOSID.UniqueNetIdStr))
+	if (CachedAchievementsMap.Contains(EOSID.GetNetIdStr()))
 	{
-		OutAchievements = *CachedAchievementsMap[EOSID.UniqueNetIdStr];
+		OutAchievements = *CachedAchievementsMap[EOSID.GetNetIdStr()];
 		return EOnlineCachedResult::Success;
 	}
 	return EOnlineCachedResult::NotFound;
@@ -88,7 +88,7 @@ bool FOnlineLeaderboardsEOS::ReadLeaderboards(const TArray<TSharedRef<const FUni
 	for (TSharedRef<const FUniqueNetId> NetId : Players)
 	{
 		FUniqueNetIdEOS EOSId(*NetId);
-		EOS_ProductUserId UserId = EOS_ProductUserId_FromString(TCHAR_TO_UTF8(*EOSId.ProductUserIdStr));
+		EOS_ProductUserId UserId = EOSId.GetProductUserId();
 		if (UserId != nullptr)
 		{
 			ProductUserIds.Add(UserId);
@@ -16,6 +16,23 @@
 	#include "eos_sessions.h"
 	#include "eos_metrics.h"
 
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Session Attributes Sent"), STAT_EOS_SessionAttributesSent, STATGROUP_EOS);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Session Attributes Skipped"), STAT_EOS_SessionAttributesSkipped, STATGROUP_EOS);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Session Attributes Removed"), STAT_EOS_SessionAttributesRemoved, STATGROUP_EOS);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Session Search Cache Hits"), STAT_EOS_SessionSearchCacheHits, STATGROUP_EOS);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Session Search Cache Misses"), STAT_EOS_SessionSearchCacheMisses, STATGROUP_EOS);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Session Search Cache Refreshes"), STAT_EOS_SessionSearchCacheRefreshes, STATGROUP_EOS);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Matchmaking Sessions Joined"), STAT_EOS_MatchmakingJoined, STATGROUP_EOS);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Matchmaking Sessions Created"), STAT_EOS_MatchmakingCreated, STATGROUP_EOS);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Matchmaking Join Attempts"), STAT_EOS_MatchmakingJoinAttempts, STATGROUP_EOS);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Matchmaking Join Failures"), STAT_EOS_MatchmakingJoinFailures, STATGROUP_EOS);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Session Player Batches Sent"), STAT_EOS_SessionPlayerBatches, STATGROUP_EOS);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Session Players Batched"), STAT_EOS_SessionPlayersBatched, STATGROUP_EOS);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("LAN Session Responses Sent"), STAT_EOS_LANSessionResponses, STATGROUP_EOS);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("LAN Session Encodes"), STAT_EOS_LANSessionEncodes, STATGROUP_EOS);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("LAN Queries Coalesced"), STAT_EOS_LANQueriesCoalesced, STATGROUP_EOS);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Session Prefetch Hits"), STAT_EOS_SessionPrefetchHits, STATGROUP_EOS);
+
 /** This is the game name plus version in ansi done once for optimization */
 char BucketIdAnsi[EOS_OSS_STRING_BUFFER_LENGTH];
 
@@ -227,6 +244,7 @@ FOnlineSessionInfoEOS::FOnlineSessionInfoEOS()
 	, SessionId(TEXT("INVALID"))
 	, SessionHandle(nullptr)
 	, bIsFromClone(false)
+	, PrefetchedBeaconPort(0)
 {
 }
 
@@ -235,6 +253,7 @@ FOnlineSessionInfoEOS::FOnlineSessionInfoEOS(const FString& InHostIp, const FStr
 	, SessionId(InSessionId)
 	, SessionHandle(InSessionHandle)
 	, bIsFromClone(false)
+	, PrefetchedBeaconPort(0)
 {
 	if (InHostIp.StartsWith(EOS_CONNECTION_URL_PREFIX, ESearchCase::IgnoreCase))
 	{
@@ -305,6 +324,42 @@ void FOnlineSessionEOS::Init(const char* InBucketId)
 	bIsDedicatedServer = IsRunningDedicatedServer();
 	bIsUsingP2PSockets = false;
 	GConfig->GetBool(TEXT("/Script/OnlineSubsystemEOS.NetDriverEOS"), TEXT("bIsUsingP2PSockets"), bIsUsingP2PSockets, GEngineIni);
+
+	SearchCache.LoadConfig();
+	GConfig->GetInt(TEXT("/Script/OnlineSubsystemEOS.NetDriverEOS"), TEXT("MaxActiveSessionSearches"), MaxActiveSessionSearches, GEngineIni);
+	MaxActiveSessionSearches = FMath::Max(MaxActiveSessionSearches, 1);
+	MatchmakingSettings.LoadConfig();
+	LANSessionFormat.LoadConfig();
+	GConfig->GetFloat(TEXT("/Script/OnlineSubsystemEOS.NetDriverEOS"), TEXT("LANQueryResponseInterval"), LANResponseInterval, GEngineIni);
+	GConfig->GetInt(TEXT("/Script/OnlineSubsystemEOS.NetDriverEOS"), TEXT("MaxLANQueryResponsesPerInterval"), MaxLANResponsesPerInterval, GEngineIni);
+	LANResponseInterval = FMath::Max(LANResponseInterval, 0.f);
+	MaxLANResponsesPerInterval = FMath::Max(MaxLANResponsesPerInterval, 1);
+
+	if (EOSSubsystem->SocketSubsystem.IsValid())
+	{
+		SessionPing = MakeUnique<FSessionPingEOS>(*EOSSubsystem->SocketSubsystem);
+		SessionPing->LoadConfig();
+		SessionPrefetch = MakeUnique<FSessionPrefetchEOS>(MakeUnique<FSessionPingWarmBackendEOS>(*SessionPing));
+		SessionPrefetch->LoadConfig();
+	}
+}
+
+void FOnlineSessionEOS::Shutdown()
+{
+	// Matchmaking holds session delegates and may be waiting on pings
+	ActiveMatchmaking.Empty();
+	// Warms in flight are pings, so this has to go first
+	SessionPrefetch.Reset();
+	// Ping sockets call into the SDK when they close
+	SessionPing.Reset();
+
+	if (SessionInviteAcceptedId != EOS_INVALID_NOTIFICATIONID)
+	{
+		EOS_Sessions_RemoveNotifySessionInviteAccepted(EOSSubsystem->SessionsHandle, SessionInviteAcceptedId);
+		SessionInviteAcceptedId = EOS_INVALID_NOTIFICATIONID;
+	}
+	delete SessionInviteAcceptedCallback;
+	SessionInviteAcceptedCallback = nullptr;
 }
 
 bool FOnlineSessionEOS::CreateSession(int32 HostingPlayerNum, FName SessionName, const FOnlineSessionSettings& NewSessionSettings)
@@ -459,7 +514,7 @@ void FOnlineSessionEOS::SetJoinInProgress(EOS_HSessionModification SessionModHan
 	}
 }
 
-void FOnlineSessionEOS::AddAttribute(EOS_HSessionModification SessionModHandle, const EOS_Sessions_AttributeData* Attribute)
+bool FOnlineSessionEOS::AddAttribute(EOS_HSessionModification SessionModHandle, const EOS_Sessions_AttributeData* Attribute)
 {
 	EOS_SessionModification_AddAttributeOptions Options = { };
 	Options.ApiVersion = EOS_SESSIONMODIFICATION_ADDATTRIBUTE_API_LATEST;
@@ -472,16 +527,55 @@ void FOnlineSessionEOS::AddAttribute(EOS_HSessionModification SessionModHandle,
 	if (ResultCode != EOS_EResult::EOS_Success)
 	{
 		UE_LOG_ONLINE_SESSION(Error, TEXT("EOS_SessionModification_AddAttribute() failed for attribute name (%s) with EOS result code (%s)"), *FString(Attribute->Key), ANSI_TO_TCHAR(EOS_EResult_ToString(ResultCode)));
+		return false;
+	}
+	INC_DWORD_STAT(STAT_EOS_SessionAttributesSent);
+	return true;
+}
+
+bool FOnlineSessionEOS::RemoveAttribute(EOS_HSessionModification SessionModHandle, const char* Key)
+{
+	EOS_SessionModification_RemoveAttributeOptions Options = { };
+	Options.ApiVersion = EOS_SESSIONMODIFICATION_REMOVEATTRIBUTE_API_LATEST;
+	Options.Key = Key;
+
+	UE_LOG_ONLINE_SESSION(Log, TEXT("EOS_SessionModification_RemoveAttribute() named (%s)"), UTF8_TO_TCHAR(Key));
+
+	EOS_EResult ResultCode = EOS_SessionModification_RemoveAttribute(SessionModHandle, &Options);
+	if (ResultCode != EOS_EResult::EOS_Success)
+	{
+		UE_LOG_ONLINE_SESSION(Error, TEXT("EOS_SessionModification_RemoveAttribute() failed for attribute name (%s) with EOS result code (%s)"), UTF8_TO_TCHAR(Key), ANSI_TO_TCHAR(EOS_EResult_ToString(ResultCode)));
+		return false;
 	}
+	INC_DWORD_STAT(STAT_EOS_SessionAttributesRemoved);
+	return true;
 }
 
 void FOnlineSessionEOS::SetAttributes(EOS_HSessionModification SessionModHandle, FNamedOnlineSession* Session)
 {
-	FAttributeOptions Opt1("NumPrivateConnections", Session->SessionSettings.NumPrivateConnections);
-	AddAttribute(SessionModHandle, &Opt1);
+	FPublishedSessionAttributesEOS& Published = PublishedAttributes.FindOrAdd(Session->SessionName);
+	const bool bForce = !Published.bHasFixedAttributes;
+	Published.bHasFixedAttributes = true;
+	Published.Generation++;
 
-	FAttributeOptions Opt2("NumPublicConnections", Session->SessionSettings.NumPublicConnections);
-	AddAttribute(SessionModHandle, &Opt2);
+	// Sends a fixed attribute when it differs from what we last published and remembers the new value
+	auto AddChangedAttribute = [this, SessionModHandle, bForce](const char* Key, auto& PublishedValue, auto Value)
+	{
+		if (!bForce && PublishedValue == Value)
+		{
+			INC_DWORD_STAT(STAT_EOS_SessionAttributesSkipped);
+			return;
+		}
+		FAttributeOptions Attribute(Key, Value);
+		if (AddAttribute(SessionModHandle, &Attribute))
+		{
+			PublishedValue = Value;
+		}
+	};
+
+	const FOnlineSessionSettings& Settings = Session->SessionSettings;
+	AddChangedAttribute("NumPrivateConnections", Published.NumPrivateConnections, Settings.NumPrivateConnections);
+	AddChangedAttribute("NumPublicConnections", Published.NumPublicConnections, Settings.NumPublicConnections);
 
 	// Handle auto generation of dedicated server names
 	if (Session->OwningUserName.IsEmpty())
@@ -501,27 +595,41 @@ void FOnlineSessionEOS::SetAttributes(EOS_HSessionModification SessionModHandle,
 		Session->OwningUserName = OwningPlayerName;
 	}
 
-	FAttributeOptions Opt3("OwningPlayerName", TCHAR_TO_UTF8(*Session->OwningUserName));
-	AddAttribute(SessionModHandle, &Opt3);
+	// FString compares are case insensitive and these are shown to players, so compare them exactly
+	if (bForce || !Published.OwningUserName.Equals(Session->OwningUserName, ESearchCase::CaseSensitive))
+	{
+		FAttributeOptions Opt3("OwningPlayerName", TCHAR_TO_UTF8(*Session->OwningUserName));
+		if (AddAttribute(SessionModHandle, &Opt3))
+		{
+			Published.OwningUserName = Session->OwningUserName;
+		}
+	}
+	else
+	{
+		INC_DWORD_STAT(STAT_EOS_SessionAttributesSkipped);
+	}
 
 	FString NetId = Session->OwningUserId->ToString();
-	FAttributeOptions Opt4("OwningNetId", TCHAR_TO_UTF8(*NetId));
-	AddAttribute(SessionModHandle, &Opt4);
-
-	FAttributeOptions Opt5("bAntiCheatProtected", Session->SessionSettings.bAntiCheatProtected);
-	AddAttribute(SessionModHandle, &Opt5);
-
-	FAttributeOptions Opt6("bUsesStats", Session->SessionSettings.bUsesStats);
-	AddAttribute(SessionModHandle, &Opt6);
-
-	FAttributeOptions Opt7("bIsDedicated", Session->SessionSettings.bIsDedicated);
-	AddAttribute(SessionModHandle, &Opt7);
+	if (bForce || !Published.OwningNetId.Equals(NetId, ESearchCase::CaseSensitive))
+	{
+		FAttributeOptions Opt4("OwningNetId", TCHAR_TO_UTF8(*NetId));
+		if (AddAttribute(SessionModHandle, &Opt4))
+		{
+			Published.OwningNetId = MoveTemp(NetId);
+		}
+	}
+	else
+	{
+		INC_DWORD_STAT(STAT_EOS_SessionAttributesSkipped);
+	}
 
-	FAttributeOptions Opt8("BuildUniqueId", Session->SessionSettings.BuildUniqueId);
-	AddAttribute(SessionModHandle, &Opt8);
+	AddChangedAttribute("bAntiCheatProtected", Published.bAntiCheatProtected, Settings.bAntiCheatProtected);
+	AddChangedAttribute("bUsesStats", Published.bUsesStats, Settings.bUsesStats);
+	AddChangedAttribute("bIsDedicated", Published.bIsDedicated, Settings.bIsDedicated);
+	AddChangedAttribute("BuildUniqueId", Published.BuildUniqueId, Settings.BuildUniqueId);
 
-	// Add all of the session settings
-	for (FSessionSettings::TConstIterator It(Session->SessionSettings.Settings); It; ++It)
+	// Add any session settings that are new or have a different value
+	for (FSessionSettings::TConstIterator It(Settings.Settings); It; ++It)
 	{
 		const FName KeyName = It.Key();
 		const FOnlineSessionSetting& Setting = It.Value();
@@ -532,10 +640,40 @@ void FOnlineSessionEOS::SetAttributes(EOS_HSessionModification SessionModHandle,
 			continue;
 		}
 
-		FString SettingName(TEXT("FOSS=") + KeyName.ToString());
-		FAttributeOptions Attribute(TCHAR_TO_UTF8(*SettingName), Setting.Data);
+		FPublishedSessionSettingEOS* PublishedSetting = Published.Settings.Find(KeyName);
+		if (PublishedSetting != nullptr && PublishedSetting->Data == Setting.Data)
+		{
+			PublishedSetting->Generation = Published.Generation;
+			INC_DWORD_STAT(STAT_EOS_SessionAttributesSkipped);
+			continue;
+		}
+
+		const char* Key = AttributeSchema.GetSettingKey(KeyName);
+		FAttributeOptions Attribute(Key, Setting.Data);
+		if (AddAttribute(SessionModHandle, &Attribute))
+		{
+			if (PublishedSetting == nullptr)
+			{
+				PublishedSetting = &Published.Settings.Add(KeyName);
+				PublishedSetting->Key = Key;
+			}
+			PublishedSetting->Data = Setting.Data;
+			PublishedSetting->Generation = Published.Generation;
+		}
+		else if (PublishedSetting != nullptr)
+		{
+			// Leave the old value advertised rather than treating it as removed
+			PublishedSetting->Generation = Published.Generation;
+		}
+	}
 
-		AddAttribute(SessionModHandle, &Attribute);
+	// Anything we advertised that the game no longer has needs to come off the session
+	for (TMap<FName, FPublishedSessionSettingEOS>::TIterator It(Published.Settings); It; ++It)
+	{
+		if (It.Value().Generation != Published.Generation && RemoveAttribute(SessionModHandle, It.Value().Key))
+		{
+			It.RemoveCurrent();
+		}
 	}
 }
 
@@ -628,6 +766,8 @@ uint32 FOnlineSessionEOS::CreateEOSSession(int32 HostingPlayerNum, FNamedOnlineS
 	}
 
 	Session->SessionState = EOnlineSessionState::Creating;
+	// A new EOS session starts with no attributes so everything has to be sent
+	PublishedAttributes.Remove(Session->SessionName);
 
 	FString HostAddr;
 	// If we are not a dedicated server and are using p2p sockets, then we need to add a custom URL for connecting
@@ -644,6 +784,12 @@ uint32 FOnlineSessionEOS::CreateEOSSession(int32 HostingPlayerNum, FNamedOnlineS
 		HostOptions.HostAddress = HostAddrAnsi;
 		EOS_EResult HostResult = EOS_SessionModification_SetHostAddress(SessionModHandle, &HostOptions);
 		UE_LOG_ONLINE_SESSION(Log, TEXT("EOS_SessionModification_SetHostAddress(%s) returned (%s)"), *HostAddr, ANSI_TO_TCHAR(EOS_EResult_ToString(HostResult)));
+
+		// Let searchers measure their latency to us
+		if (SessionPing.IsValid())
+		{
+			SessionPing->AddResponder(Session->SessionName, Options.LocalUserId);
+		}
 	}
 	else
 	{
@@ -653,10 +799,13 @@ uint32 FOnlineSessionEOS::CreateEOSSession(int32 HostingPlayerNum, FNamedOnlineS
 	Session->SessionInfo = MakeShareable(new FOnlineSessionInfoEOS(HostAddr, Session->SessionName.ToString(), nullptr));
 
 	FUpdateSessionCallback* CallbackObj = new FUpdateSessionCallback();
-	CallbackObj->CallbackLambda = [this, Session](const EOS_Sessions_UpdateSessionCallbackInfo* Data)
+	const FName SessionName = Session->SessionName;
+	CallbackObj->CallbackLambda = [this, SessionName](const EOS_Sessions_UpdateSessionCallbackInfo* Data)
 	{
 		bool bWasSuccessful = Data->ResultCode == EOS_EResult::EOS_Success || Data->ResultCode == EOS_EResult::EOS_Sessions_OutOfSync;
-		if (bWasSuccessful)
+		// The session may have been destroyed while we waited
+		FNamedOnlineSession* Session = GetNamedSession(SessionName);
+		if (bWasSuccessful && Session != nullptr)
 		{
 			Session->SessionState = EOnlineSessionState::Pending;
 			BeginSessionAnalytics(Session);
@@ -665,10 +814,14 @@ uint32 FOnlineSessionEOS::CreateEOSSession(int32 HostingPlayerNum, FNamedOnlineS
 		}
 		else
 		{
-			Session->SessionState = EOnlineSessionState::NoSession;
+			if (Session != nullptr)
+			{
+				Session->SessionState = EOnlineSessionState::NoSession;
+			}
+			PublishedAttributes.Remove(SessionName);
 			UE_LOG_ONLINE_SESSION(Error, TEXT("EOS_Sessions_UpdateSession() failed with EOS result code (%s)"), ANSI_TO_TCHAR(EOS_EResult_ToString(Data->ResultCode)));
 		}
-		TriggerOnCreateSessionCompleteDelegates(Session->SessionName, bWasSuccessful);
+		TriggerOnCreateSessionCompleteDelegates(SessionName, bWasSuccessful);
 	};
 
 	return SharedSessionUpdate(SessionModHandle, Session, CallbackObj);
@@ -759,16 +912,20 @@ uint32 FOnlineSessionEOS::StartEOSSession(FNamedOnlineSession* Session)
 
 	FSessionStartOptions Options(TCHAR_TO_UTF8(*Session->SessionName.ToString()));
 	FStartSessionCallback* CallbackObj = new FStartSessionCallback();
-	CallbackObj->CallbackLambda = [this, Session](const EOS_Sessions_StartSessionCallbackInfo* Data)
+	const FName SessionName = Session->SessionName;
+	CallbackObj->CallbackLambda = [this, SessionName](const EOS_Sessions_StartSessionCallbackInfo* Data)
 	{
-		Session->SessionState = EOnlineSessionState::InProgress;
+		if (FNamedOnlineSession* Session = GetNamedSession(SessionName))
+		{
+			Session->SessionState = EOnlineSessionState::InProgress;
+		}
 
 		bool bWasSuccessful = Data->ResultCode == EOS_EResult::EOS_Success;
 		if (!bWasSuccessful)
 		{
 			UE_LOG_ONLINE_SESSION(Error, TEXT("EOS_Sessions_StartSession() failed with EOS result code (%s)"), ANSI_TO_TCHAR(EOS_EResult_ToString(Data->ResultCode)));
 		}
-		TriggerOnStartSessionCompleteDelegates(Session->SessionName, bWasSuccessful);
+		TriggerOnStartSessionCompleteDelegates(SessionName, bWasSuccessful);
 	};
 
 	EOS_Sessions_StartSession(EOSSubsystem->SessionsHandle, &Options, CallbackObj, CallbackObj->GetCallbackPtr());
@@ -781,10 +938,12 @@ bool FOnlineSessionEOS::UpdateSession(FName SessionName, FOnlineSessionSettings&
 	int32 Result = ONLINE_FAIL;
 
 	// Grab the session information by name
-	FNamedOnlineSession* Session = GetNamedSession(SessionName);
+	FNamedOnlineSessionEOS* Session = GetNamedSessionEOS(SessionName);
 	if (Session)
 	{
 		Session->SessionSettings = UpdatedSessionSettings;
+		// LAN queries get the new settings from now on
+		Session->LANResponseBody.Reset();
 
 		if (!Session->SessionSettings.bIsLANMatch)
 		{
@@ -836,15 +995,21 @@ uint32 FOnlineSessionEOS::UpdateEOSSession(FNamedOnlineSession* Session, FOnline
 	}
 
 	FUpdateSessionCallback* CallbackObj = new FUpdateSessionCallback();
-	CallbackObj->CallbackLambda = [this, Session](const EOS_Sessions_UpdateSessionCallbackInfo* Data)
+	const FName SessionName = Session->SessionName;
+	CallbackObj->CallbackLambda = [this, SessionName](const EOS_Sessions_UpdateSessionCallbackInfo* Data)
 	{
 		bool bWasSuccessful = Data->ResultCode == EOS_EResult::EOS_Success || Data->ResultCode == EOS_EResult::EOS_Sessions_OutOfSync;
 		if (!bWasSuccessful)
 		{
-			Session->SessionState = EOnlineSessionState::NoSession;
+			if (FNamedOnlineSession* Session = GetNamedSession(SessionName))
+			{
+				Session->SessionState = EOnlineSessionState::NoSession;
+			}
+			// We don't know which of our changes made it, so the next update sends everything
+			PublishedAttributes.Remove(SessionName);
 			UE_LOG_ONLINE_SESSION(Error, TEXT("EOS_Sessions_UpdateSession() failed with EOS result code (%s)"), ANSI_TO_TCHAR(EOS_EResult_ToString(Data->ResultCode)));
 		}
-		TriggerOnUpdateSessionCompleteDelegates(Session->SessionName, bWasSuccessful);
+		TriggerOnUpdateSessionCompleteDelegates(SessionName, bWasSuccessful);
 	};
 
 	return SharedSessionUpdate(SessionModHandle, Session, CallbackObj);
@@ -929,16 +1094,20 @@ uint32 FOnlineSessionEOS::EndEOSSession(FNamedOnlineSession* Session)
 
 	FSessionEndOptions Options(TCHAR_TO_UTF8(*Session->SessionName.ToString()));
 	FEndSessionCallback* CallbackObj = new FEndSessionCallback();
-	CallbackObj->CallbackLambda = [this, Session](const EOS_Sessions_EndSessionCallbackInfo* Data)
+	const FName SessionName = Session->SessionName;
+	CallbackObj->CallbackLambda = [this, SessionName](const EOS_Sessions_EndSessionCallbackInfo* Data)
 	{
-		Session->SessionState = EOnlineSessionState::Ended;
+		if (FNamedOnlineSession* Session = GetNamedSession(SessionName))
+		{
+			Session->SessionState = EOnlineSessionState::Ended;
+		}
 
 		bool bWasSuccessful = Data->ResultCode == EOS_EResult::EOS_Success;
 		if (!bWasSuccessful)
 		{
 			UE_LOG_ONLINE_SESSION(Error, TEXT("EOS_Sessions_EndSession() failed with EOS result code (%s)"), ANSI_TO_TCHAR(EOS_EResult_ToString(Data->ResultCode)));
 		}
-		TriggerOnEndSessionCompleteDelegates(Session->SessionName, bWasSuccessful);
+		TriggerOnEndSessionCompleteDelegates(SessionName, bWasSuccessful);
 	};
 
 	EOS_Sessions_EndSession(EOSSubsystem->SessionsHandle, &Options, CallbackObj, CallbackObj->GetCallbackPtr());
@@ -1051,13 +1220,11 @@ uint32 FOnlineSessionEOS::DestroyEOSSession(FNamedOnlineSession* Session, const
 
 	FSessionDestroyOptions Options(TCHAR_TO_UTF8(*Session->SessionName.ToString()));
 	FDestroySessionCallback* CallbackObj = new FDestroySessionCallback();
-	CallbackObj->CallbackLambda = [this, Session](const EOS_Sessions_DestroySessionCallbackInfo* Data)
+	const FName SessionName = Session->SessionName;
+	CallbackObj->CallbackLambda = [this, SessionName](const EOS_Sessions_DestroySessionCallbackInfo* Data)
 	{
 		EndSessionAnalytics();
 
-		Session->SessionState = EOnlineSessionState::NoSession;
-		FName SessionName = Session->SessionName;
-
 		bool bWasSuccessful = Data->ResultCode == EOS_EResult::EOS_Success;
 		if (!bWasSuccessful)
 		{
@@ -1074,53 +1241,160 @@ uint32 FOnlineSessionEOS::DestroyEOSSession(FNamedOnlineSession* Session, const
 
 bool FOnlineSessionEOS::IsPlayerInSession(FName SessionName, const FUniqueNetId& UniqueId)
 {
-	return IsPlayerInSessionImpl(this, SessionName, UniqueId);
+	FNamedOnlineSessionEOS* Session = GetNamedSessionEOS(SessionName);
+	if (Session == nullptr)
+	{
+		return false;
+	}
+	const bool bIsSessionOwner = Session->OwningUserId.IsValid() && *Session->OwningUserId == UniqueId;
+	return bIsSessionOwner || Session->IsPlayerRegistered(UniqueId);
 }
 
 bool FOnlineSessionEOS::StartMatchmaking(const TArray< TSharedRef<const FUniqueNetId> >& LocalPlayers, FName SessionName, const FOnlineSessionSettings& NewSessionSettings, TSharedRef<FOnlineSessionSearch>& SearchSettings)
 {
-	UE_LOG_ONLINE_SESSION(Warning, TEXT("StartMatchmaking is not supported on this platform. Use FindSessions or FindSessionById."));
-	TriggerOnMatchmakingCompleteDelegates(SessionName, false);
-	return false;
+	bool bWasStarted = false;
+	if (LocalPlayers.Num() == 0)
+	{
+		UE_LOG_ONLINE_SESSION(Warning, TEXT("Can't start matchmaking for session (%s) without a local player"), *SessionName.ToString());
+	}
+	else if (ActiveMatchmaking.Contains(SessionName))
+	{
+		UE_LOG_ONLINE_SESSION(Warning, TEXT("Matchmaking for session (%s) is already running"), *SessionName.ToString());
+	}
+	else if (GetNamedSession(SessionName) != nullptr)
+	{
+		UE_LOG_ONLINE_SESSION(Warning, TEXT("Can't matchmake into session (%s), it already exists"), *SessionName.ToString());
+	}
+	else
+	{
+		const int32 LocalUserNum = EOSSubsystem->UserManager->GetLocalUserNumFromUniqueNetId(*LocalPlayers[0]);
+		TUniquePtr<FMatchmakingEOS>& Matchmaker = ActiveMatchmaking.Add(SessionName, MakeUnique<FMatchmakingEOS>(MakeUnique<FSessionMatchmakingBackendEOS>(*this, LocalUserNum), SessionName, NewSessionSettings, SearchSettings, MatchmakingSettings));
+		// Completion is reported from Tick, even when the first steps finish straight away
+		Matchmaker->Start();
+		bWasStarted = true;
+	}
+
+	if (!bWasStarted)
+	{
+		TriggerOnMatchmakingCompleteDelegates(SessionName, false);
+	}
+	return bWasStarted;
 }
 
 bool FOnlineSessionEOS::CancelMatchmaking(int32 SearchingPlayerNum, FName SessionName)
 {
-	UE_LOG_ONLINE_SESSION(Warning, TEXT("CancelMatchmaking is not supported on this platform. Use CancelFindSessions."));
-	TriggerOnCancelMatchmakingCompleteDelegates(SessionName, false);
-	return false;
+	// Removed on the next tick, we may be inside one of its callbacks
+	TUniquePtr<FMatchmakingEOS>* Matchmaker = ActiveMatchmaking.Find(SessionName);
+	const bool bWasCancelled = Matchmaker != nullptr && (*Matchmaker)->Cancel();
+	if (!bWasCancelled)
+	{
+		UE_LOG_ONLINE_SESSION(Warning, TEXT("No matchmaking in progress for session (%s)"), *SessionName.ToString());
+	}
+	TriggerOnCancelMatchmakingCompleteDelegates(SessionName, bWasCancelled);
+	return bWasCancelled;
 }
 
 bool FOnlineSessionEOS::CancelMatchmaking(const FUniqueNetId& SearchingPlayerId, FName SessionName)
 {
-	UE_LOG_ONLINE_SESSION(Warning, TEXT("CancelMatchmaking is not supported on this platform. Use CancelFindSessions."));
-	TriggerOnCancelMatchmakingCompleteDelegates(SessionName, false);
-	return false;
+	return CancelMatchmaking(EOSSubsystem->UserManager->GetLocalUserNumFromUniqueNetId(SearchingPlayerId), SessionName);
+}
+
+void FOnlineSessionEOS::TickMatchmaking(float DeltaTime)
+{
+	if (ActiveMatchmaking.Num() == 0)
+	{
+		return;
+	}
+
+	// Game code runs from the session delegates and can start or cancel matchmaking while we iterate
+	TArray<FName, TInlineAllocator<4>> SessionNames;
+	ActiveMatchmaking.GenerateKeyArray(SessionNames);
+	for (FName SessionName : SessionNames)
+	{
+		TUniquePtr<FMatchmakingEOS>* Matchmaker = ActiveMatchmaking.Find(SessionName);
+		if (Matchmaker == nullptr)
+		{
+			continue;
+		}
+		(*Matchmaker)->Tick(DeltaTime);
+		// Only we remove entries but the map may have grown while it ticked
+		Matchmaker = ActiveMatchmaking.Find(SessionName);
+		if (!(*Matchmaker)->IsFinished())
+		{
+			continue;
+		}
+
+		const EMatchmakingStateEOS FinalState = (*Matchmaker)->GetState();
+		const FMatchmakingStatsEOS Stats = (*Matchmaker)->GetStats();
+		ActiveMatchmaking.Remove(SessionName);
+
+		INC_DWORD_STAT_BY(STAT_EOS_MatchmakingJoinAttempts, Stats.NumJoinAttempts);
+		INC_DWORD_STAT_BY(STAT_EOS_MatchmakingJoinFailures, Stats.NumJoinFailures);
+		if (FinalState == EMatchmakingStateEOS::Succeeded)
+		{
+			if (Stats.bCreatedSession)
+			{
+				INC_DWORD_STAT(STAT_EOS_MatchmakingCreated);
+			}
+			else
+			{
+				INC_DWORD_STAT(STAT_EOS_MatchmakingJoined);
+			}
+			UE_LOG_ONLINE_SESSION(Log, TEXT("Matchmaking %s session (%s) after %.2f seconds, %d searches, %d of %d joins failed"),
+				Stats.bCreatedSession ? TEXT("created") : TEXT("joined"), *SessionName.ToString(), Stats.TimeToMatch, Stats.NumSearches, Stats.NumJoinFailures, Stats.NumJoinAttempts);
+		}
+		else if (FinalState == EMatchmakingStateEOS::Failed)
+		{
+			UE_LOG_ONLINE_SESSION(Warning, TEXT("Matchmaking for session (%s) failed after %d searches, %d of %d joins failed"),
+				*SessionName.ToString(), Stats.NumSearches, Stats.NumJoinFailures, Stats.NumJoinAttempts);
+		}
+
+		// Cancelled matchmaking already reported through OnCancelMatchmakingComplete
+		if (FinalState != EMatchmakingStateEOS::Cancelled)
+		{
+			TriggerOnMatchmakingCompleteDelegates(SessionName, FinalState == EMatchmakingStateEOS::Succeeded);
+		}
+	}
 }
 
 bool FOnlineSessionEOS::FindSessions(int32 SearchingPlayerNum, const TSharedRef<FOnlineSessionSearch>& SearchSettings)
 {
 	uint32 Return = ONLINE_FAIL;
 
-	// Don't start another search while one is in progress
-	if (!CurrentSessionSearch.IsValid() || SearchSettings->SearchState != EOnlineAsyncTaskState::InProgress)
+	// Don't start the same search twice, other searches can run alongside it
+	if (SearchSettings->SearchState != EOnlineAsyncTaskState::InProgress)
 	{
-		// LAN searching uses this as an approximation for ping so make sure to set it
-		SessionSearchStartInSeconds = FPlatformTime::Seconds();
-
 		// Free up previous results
 		SearchSettings->SearchResults.Empty();
-		// Copy the search pointer so we can keep it around
-		CurrentSessionSearch = SearchSettings;
 
 		// Check if its a LAN query
 		if (SearchSettings->bIsLanQuery == false)
 		{
-			Return = FindEOSSession(SearchingPlayerNum, SearchSettings);
+			if (ActiveSessionSearches.Num() < MaxActiveSessionSearches)
+			{
+				Return = FindCachedEOSSession(SearchingPlayerNum, SearchSettings);
+			}
+			else
+			{
+				UE_LOG_ONLINE_SESSION(Warning, TEXT("Ignoring game search request, already running (%d) searches"), ActiveSessionSearches.Num());
+				SearchSettings->SearchState = EOnlineAsyncTaskState::Failed;
+				TriggerOnFindSessionsCompleteDelegates(false);
+			}
+		}
+		else if (!CurrentLANSessionSearch.IsValid())
+		{
+			// LAN searching uses this as an approximation for ping so make sure to set it
+			SessionSearchStartInSeconds = FPlatformTime::Seconds();
+			// Copy the search pointer so we can keep it around
+			CurrentLANSessionSearch = SearchSettings;
+
+			Return = FindLANSession();
 		}
 		else
 		{
-			Return = FindLANSession();
+			UE_LOG_ONLINE_SESSION(Warning, TEXT("Ignoring LAN search request while another LAN search is pending"));
+			SearchSettings->SearchState = EOnlineAsyncTaskState::Failed;
+			TriggerOnFindSessionsCompleteDelegates(false);
 		}
 
 		if (Return == ONLINE_IO_PENDING)
@@ -1130,7 +1404,7 @@ bool FOnlineSessionEOS::FindSessions(int32 SearchingPlayerNum, const TSharedRef<
 	}
 	else
 	{
-		UE_LOG_ONLINE_SESSION(Warning, TEXT("Ignoring game search request while another search is pending"));
+		UE_LOG_ONLINE_SESSION(Warning, TEXT("Ignoring game search request while it is pending"));
 		Return = ONLINE_IO_PENDING;
 	}
 
@@ -1217,73 +1491,82 @@ void FOnlineSessionEOS::CopyAttributes(EOS_HSessionDetails SessionHandle, FOnlin
 		EOS_EResult ResultCode = EOS_SessionDetails_CopySessionAttributeByIndex(SessionHandle, &AttrOptions, &Attribute);
 		if (ResultCode == EOS_EResult::EOS_Success)
 		{
-			FString Key = Attribute->Data->Key;
-			if (Key == TEXT("NumPublicConnections"))
+			const FSessionAttributeSchemaEOS::FEntry* SchemaEntry = AttributeSchema.Find(Attribute->Data->Key);
+			if (SchemaEntry != nullptr)
 			{
-				// Adjust the public connections based upon this
-				OutSession.SessionSettings.NumPublicConnections = Attribute->Data->Value.AsInt64;
-			}
-			else if (Key == TEXT("NumPrivateConnections"))
-			{
-				// Adjust the private connections based upon this
-				OutSession.SessionSettings.NumPrivateConnections = Attribute->Data->Value.AsInt64;
-			}
-			else if (Key == TEXT("bAntiCheatProtected"))
-			{
-				OutSession.SessionSettings.bAntiCheatProtected = Attribute->Data->Value.AsBool == EOS_TRUE;
-			}
-			else if (Key == TEXT("bUsesStats"))
-			{
-				OutSession.SessionSettings.bUsesStats = Attribute->Data->Value.AsBool == EOS_TRUE;
-			}
-			else if (Key == TEXT("bIsDedicated"))
-			{
-				OutSession.SessionSettings.bIsDedicated = Attribute->Data->Value.AsBool == EOS_TRUE;
-			}
-			else if (Key == TEXT("BuildUniqueId"))
-			{
-				OutSession.SessionSettings.BuildUniqueId = Attribute->Data->Value.AsInt64;
-			}
-			else if (Key == TEXT("OwningPlayerName"))
-			{
-				OutSession.OwningUserName = ANSI_TO_TCHAR(Attribute->Data->Value.AsUtf8);
-			}
-			else if (Key == TEXT("OwningNetId"))
-			{
-				OutSession.OwningUserId = MakeShareable(new FUniqueNetIdEOS(ANSI_TO_TCHAR(Attribute->Data->Value.AsUtf8)));
-			}
-			// Handle FOnlineSessionSetting settings
-			else if (Key.StartsWith(TEXT("FOSS=")))
-			{
-				FString KeyName;
-				FParse::Value(*Key, TEXT("FOSS="), KeyName);
-				if (KeyName.Len() > 0)
+				switch (SchemaEntry->Field)
 				{
-					FOnlineSessionSetting Setting;
-					switch (Attribute->Data->ValueType)
+					case ESessionAttributeFieldEOS::NumPublicConnections:
 					{
-						case EOS_ESessionAttributeType::EOS_SAT_Boolean:
-						{
-							Setting.Data.SetValue(Attribute->Data->Value.AsBool == EOS_TRUE);
-							break;
-						}
-						case EOS_ESessionAttributeType::EOS_SAT_Int64:
-						{
-							Setting.Data.SetValue(static_cast<int64>(Attribute->Data->Value.AsInt64));
-							break;
-						}
-						case EOS_ESessionAttributeType::EOS_SAT_Double:
-						{
-							Setting.Data.SetValue(Attribute->Data->Value.AsDouble);
-							break;
-						}
-						case EOS_ESessionAttributeType::EOS_SAT_String:
+						// Adjust the public connections based upon this
+						OutSession.SessionSettings.NumPublicConnections = Attribute->Data->Value.AsInt64;
+						break;
+					}
+					case ESessionAttributeFieldEOS::NumPrivateConnections:
+					{
+						// Adjust the private connections based upon this
+						OutSession.SessionSettings.NumPrivateConnections = Attribute->Data->Value.AsInt64;
+						break;
+					}
+					case ESessionAttributeFieldEOS::bAntiCheatProtected:
+					{
+						OutSession.SessionSettings.bAntiCheatProtected = Attribute->Data->Value.AsBool == EOS_TRUE;
+						break;
+					}
+					case ESessionAttributeFieldEOS::bUsesStats:
+					{
+						OutSession.SessionSettings.bUsesStats = Attribute->Data->Value.AsBool == EOS_TRUE;
+						break;
+					}
+					case ESessionAttributeFieldEOS::bIsDedicated:
+					{
+						OutSession.SessionSettings.bIsDedicated = Attribute->Data->Value.AsBool == EOS_TRUE;
+						break;
+					}
+					case ESessionAttributeFieldEOS::BuildUniqueId:
+					{
+						OutSession.SessionSettings.BuildUniqueId = Attribute->Data->Value.AsInt64;
+						break;
+					}
+					case ESessionAttributeFieldEOS::OwningPlayerName:
+					{
+						OutSession.OwningUserName = ANSI_TO_TCHAR(Attribute->Data->Value.AsUtf8);
+						break;
+					}
+					case ESessionAttributeFieldEOS::OwningNetId:
+					{
+						OutSession.OwningUserId = MakeShareable(new FUniqueNetIdEOS(ANSI_TO_TCHAR(Attribute->Data->Value.AsUtf8)));
+						break;
+					}
+					// Handle FOnlineSessionSetting settings
+					case ESessionAttributeFieldEOS::Setting:
+					{
+						FOnlineSessionSetting& Setting = OutSession.SessionSettings.Settings.Add(SchemaEntry->SettingName);
+						switch (Attribute->Data->ValueType)
 						{
-							Setting.Data.SetValue(ANSI_TO_TCHAR(Attribute->Data->Value.AsUtf8));
-							break;
+							case EOS_ESessionAttributeType::EOS_SAT_Boolean:
+							{
+								Setting.Data.SetValue(Attribute->Data->Value.AsBool == EOS_TRUE);
+								break;
+							}
+							case EOS_ESessionAttributeType::EOS_SAT_Int64:
+							{
+								Setting.Data.SetValue(static_cast<int64>(Attribute->Data->Value.AsInt64));
+								break;
+							}
+							case EOS_ESessionAttributeType::EOS_SAT_Double:
+							{
+								Setting.Data.SetValue(Attribute->Data->Value.AsDouble);
+								break;
+							}
+							case EOS_ESessionAttributeType::EOS_SAT_String:
+							{
+								Setting.Data.SetValue(ANSI_TO_TCHAR(Attribute->Data->Value.AsUtf8));
+								break;
+							}
 						}
+						break;
 					}
-					OutSession.SessionSettings.Settings.Add(FName(KeyName), Setting);
 				}
 			}
 		}
@@ -1311,9 +1594,60 @@ void FOnlineSessionEOS::AddSearchResult(EOS_HSessionDetails SessionHandle, const
 	}
 }
 
+uint32 FOnlineSessionEOS::FindCachedEOSSession(int32 SearchingPlayerNum, const TSharedRef<FOnlineSessionSearch>& SearchSettings)
+{
+	if (!SearchCache.IsEnabled())
+	{
+		return FindEOSSession(SearchingPlayerNum, SearchSettings, FString(), false);
+	}
+
+	const FString CacheKey = FSessionSearchCacheEOS::MakeKey(BucketIdAnsi, *SearchSettings);
+	TArray<FOnlineSessionSearchResult> CachedResults;
+	const ESessionSearchCacheStateEOS CacheState = SearchCache.Find(CacheKey, FPlatformTime::Seconds(), CachedResults);
+	if (CacheState == ESessionSearchCacheStateEOS::Miss)
+	{
+		INC_DWORD_STAT(STAT_EOS_SessionSearchCacheMisses);
+		return FindEOSSession(SearchingPlayerNum, SearchSettings, CacheKey, false);
+	}
+
+	INC_DWORD_STAT(STAT_EOS_SessionSearchCacheHits);
+	if (CacheState == ESessionSearchCacheStateEOS::Stale && SearchCache.BeginRefresh(CacheKey))
+	{
+		// Refresh in the background with our own copy so the game's search is finished right away
+		TSharedRef<FOnlineSessionSearch> RefreshSearch = MakeShared<FOnlineSessionSearch>(*SearchSettings);
+		RefreshSearch->SearchResults.Empty();
+		if (FindEOSSession(SearchingPlayerNum, RefreshSearch, CacheKey, true) != ONLINE_IO_PENDING)
+		{
+			SearchCache.EndRefresh(CacheKey);
+		}
+		INC_DWORD_STAT(STAT_EOS_SessionSearchCacheRefreshes);
+	}
+
+	UE_LOG_ONLINE_SESSION(Verbose, TEXT("Returning %d %s cached search results"), CachedResults.Num(), CacheState == ESessionSearchCacheStateEOS::Fresh ? TEXT("fresh") : TEXT("stale"));
+
+	// Complete on the next tick like a backend search would, so callers never see the delegate fire inside FindSessions.
+	// Until then it is an active search and can be cancelled like one
+	ActiveSessionSearches.Add(SearchSettings);
+	EOSSubsystem->ExecuteNextTick([this, SearchSettings, CachedResults = MoveTemp(CachedResults)]() mutable
+	{
+		if (ActiveSessionSearches.Remove(SearchSettings) == 0)
+		{
+			// Cancelled
+			return;
+		}
+		SearchSettings->SearchResults = MoveTemp(CachedResults);
+		SearchSettings->SearchState = EOnlineAsyncTaskState::Done;
+		AddPingableSearch(SearchSettings);
+		PrefetchSearchResults(*SearchSettings);
+		TriggerOnFindSessionsCompleteDelegates(true);
+	});
+
+	return ONLINE_IO_PENDING;
+}
+
 typedef TEOSCallback<EOS_SessionSearch_OnFindCallback, EOS_SessionSearch_FindCallbackInfo> FFindSessionsCallback;
 
-uint32 FOnlineSessionEOS::FindEOSSession(int32 SearchingPlayerNum, const TSharedRef<FOnlineSessionSearch>& SearchSettings)
+uint32 FOnlineSessionEOS::FindEOSSession(int32 SearchingPlayerNum, const TSharedRef<FOnlineSessionSearch>& SearchSettings, const FString& CacheKey, bool bIsCacheRefresh)
 {
 	EOS_HSessionSearch SearchHandle = nullptr;
 	EOS_Sessions_CreateSessionSearchOptions HandleOptions = { };
@@ -1326,8 +1660,8 @@ uint32 FOnlineSessionEOS::FindEOSSession(int32 SearchingPlayerNum, const TShared
 		UE_LOG_ONLINE_SESSION(Error, TEXT("EOS_Sessions_CreateSessionSearch() failed with EOS result code (%s)"), ANSI_TO_TCHAR(EOS_EResult_ToString(ResultCode)));
 		return ONLINE_FAIL;
 	}
-	// Store our search handle for use/cleanup later
-	CurrentSearchHandle = MakeShareable(new FSessionSearchEOS(SearchHandle));
+	// The callback holds the search handle for the scope of the search
+	TSharedPtr<FSessionSearchEOS> SearchHandleWrapper = MakeShareable(new FSessionSearchEOS(SearchHandle));
 
 	FAttributeOptions Opt1("NumPublicConnections", 1);
 	AddSearchAttribute(SearchHandle, &Opt1, EOS_EOnlineComparisonOp::EOS_OCO_GREATERTHANOREQUAL);
@@ -1349,20 +1683,25 @@ uint32 FOnlineSessionEOS::FindEOSSession(int32 SearchingPlayerNum, const TShared
 #if UE_BUILD_DEBUG
 		UE_LOG_ONLINE_SESSION(Log, TEXT("Adding search param named (%s), (%s)"), *Key.ToString(), *SearchParam.ToString());
 #endif
-		FString ParamName(TEXT("FOSS=") + Key.ToString());
-		FAttributeOptions Attribute(TCHAR_TO_UTF8(*ParamName), SearchParam.Data);
+		FAttributeOptions Attribute(AttributeSchema.GetSettingKey(Key), SearchParam.Data);
 		AddSearchAttribute(SearchHandle, &Attribute, ToEOSSearchOp(SearchParam.ComparisonOp));
 	}
 
 	FFindSessionsCallback* CallbackObj = new FFindSessionsCallback();
-	CallbackObj->CallbackLambda = [this, SearchSettings](const EOS_SessionSearch_FindCallbackInfo* Data)
+	CallbackObj->CallbackLambda = [this, SearchSettings, SearchHandleWrapper, CacheKey, bIsCacheRefresh](const EOS_SessionSearch_FindCallbackInfo* Data)
 	{
+		// Searches that were cancelled are no longer in the table and nobody wants their results
+		if (!bIsCacheRefresh && ActiveSessionSearches.Remove(SearchSettings) == 0)
+		{
+			return;
+		}
+
 		bool bWasSuccessful = Data->ResultCode == EOS_EResult::EOS_Success;
 		if (bWasSuccessful)
 		{
 			EOS_SessionSearch_GetSearchResultCountOptions SearchResultOptions = { };
 			SearchResultOptions.ApiVersion = EOS_SESSIONSEARCH_GETSEARCHRESULTCOUNT_API_LATEST;
-			int32 NumSearchResults = EOS_SessionSearch_GetSearchResultCount(CurrentSearchHandle->SearchHandle, &SearchResultOptions);
+			int32 NumSearchResults = EOS_SessionSearch_GetSearchResultCount(SearchHandleWrapper->SearchHandle, &SearchResultOptions);
 
 			EOS_SessionSearch_CopySearchResultByIndexOptions IndexOptions = { };
 			IndexOptions.ApiVersion = EOS_SESSIONSEARCH_COPYSEARCHRESULTBYINDEX_API_LATEST;
@@ -1370,23 +1709,44 @@ uint32 FOnlineSessionEOS::FindEOSSession(int32 SearchingPlayerNum, const TShared
 			{
 				EOS_HSessionDetails SessionHandle = nullptr;
 				IndexOptions.SessionIndex = Index;
-				EOS_EResult Result = EOS_SessionSearch_CopySearchResultByIndex(CurrentSearchHandle->SearchHandle, &IndexOptions, &SessionHandle);
+				EOS_EResult Result = EOS_SessionSearch_CopySearchResultByIndex(SearchHandleWrapper->SearchHandle, &IndexOptions, &SessionHandle);
 				if (Result == EOS_EResult::EOS_Success)
 				{
 					AddSearchResult(SessionHandle, SearchSettings);
 				}
 			}
 			SearchSettings->SearchState = EOnlineAsyncTaskState::Done;
+			if (!bIsCacheRefresh)
+			{
+				AddPingableSearch(SearchSettings);
+				PrefetchSearchResults(*SearchSettings);
+			}
+
+			if (!CacheKey.IsEmpty())
+			{
+				SearchCache.Store(CacheKey, SearchSettings->SearchResults, FPlatformTime::Seconds());
+			}
 		}
 		else
 		{
 			SearchSettings->SearchState = EOnlineAsyncTaskState::Failed;
 			UE_LOG_ONLINE_SESSION(Error, TEXT("EOS_SessionSearch_Find() failed with EOS result code (%s)"), ANSI_TO_TCHAR(EOS_EResult_ToString(Data->ResultCode)));
 		}
+
+		if (bIsCacheRefresh)
+		{
+			// Nobody is waiting on a background refresh, the next search picks the results up
+			SearchCache.EndRefresh(CacheKey);
+			return;
+		}
 		TriggerOnFindSessionsCompleteDelegates(bWasSuccessful);
 	};
 
 	SearchSettings->SearchState = EOnlineAsyncTaskState::InProgress;
+	if (!bIsCacheRefresh)
+	{
+		ActiveSessionSearches.Add(SearchSettings);
+	}
 
 	// Execute the search
 	EOS_SessionSearch_FindOptions Options = { };
@@ -1421,7 +1781,8 @@ uint32 FOnlineSessionEOS::FindLANSession()
 
 	if (Return == ONLINE_FAIL)
 	{
-		CurrentSessionSearch->SearchState = EOnlineAsyncTaskState::Failed;
+		CurrentLANSessionSearch->SearchState = EOnlineAsyncTaskState::Failed;
+		CurrentLANSessionSearch = nullptr;
 
 		// Just trigger the delegate as having failed
 		TriggerOnFindSessionsCompleteDelegates(false);
@@ -1433,23 +1794,22 @@ uint32 FOnlineSessionEOS::FindLANSession()
 bool FOnlineSessionEOS::CancelFindSessions()
 {
 	uint32 Return = ONLINE_FAIL;
-	if (CurrentSessionSearch.IsValid() && CurrentSessionSearch->SearchState == EOnlineAsyncTaskState::InProgress)
+	if (ActiveSessionSearches.Num() > 0 || CurrentLANSessionSearch.IsValid())
 	{
-		// Make sure it's the right type
-		if (CurrentSessionSearch->bIsLanQuery)
+		Return = ONLINE_SUCCESS;
+		// Removing the searches from the table will prevent the async events from adding the results
+		for (const TSharedRef<FOnlineSessionSearch>& Search : ActiveSessionSearches)
 		{
-			check(LANSession);
-			Return = ONLINE_SUCCESS;
-			LANSession->StopLANSession();
-			CurrentSessionSearch->SearchState = EOnlineAsyncTaskState::Failed;
-			CurrentSessionSearch = nullptr;
+			Search->SearchState = EOnlineAsyncTaskState::Failed;
 		}
-		else
+		ActiveSessionSearches.Empty();
+
+		if (CurrentLANSessionSearch.IsValid())
 		{
-			Return = ONLINE_SUCCESS;
-			// NULLing out the object will prevent the async event from adding the results
-			CurrentSessionSearch->SearchState = EOnlineAsyncTaskState::Failed;
-			CurrentSessionSearch = nullptr;
+			check(LANSession);
+			LANSession->StopLANSession();
+			CurrentLANSessionSearch->SearchState = EOnlineAsyncTaskState::Failed;
+			CurrentLANSessionSearch = nullptr;
 		}
 	}
 	else
@@ -1465,6 +1825,37 @@ bool FOnlineSessionEOS::CancelFindSessions()
 	return Return == ONLINE_SUCCESS || Return == ONLINE_IO_PENDING;
 }
 
+bool FOnlineSessionEOS::CancelFindSessions(const TSharedRef<FOnlineSessionSearch>& SearchSettings)
+{
+	bool bWasCancelled = false;
+	if (SearchSettings->bIsLanQuery)
+	{
+		if (CurrentLANSessionSearch == SearchSettings)
+		{
+			check(LANSession);
+			LANSession->StopLANSession();
+			CurrentLANSessionSearch = nullptr;
+			bWasCancelled = true;
+		}
+	}
+	else
+	{
+		bWasCancelled = ActiveSessionSearches.Remove(SearchSettings) > 0;
+	}
+
+	if (bWasCancelled)
+	{
+		SearchSettings->SearchState = EOnlineAsyncTaskState::Failed;
+	}
+	else
+	{
+		UE_LOG_ONLINE_SESSION(Warning, TEXT("Can't cancel a search that isn't in progress"));
+	}
+
+	TriggerOnCancelFindSessionsCompleteDelegates(bWasCancelled);
+	return bWasCancelled;
+}
+
 bool FOnlineSessionEOS::JoinSession(int32 PlayerNum, FName SessionName, const FOnlineSessionSearchResult& DesiredSession)
 {
 	uint32 Return = ONLINE_FAIL;
@@ -1567,23 +1958,38 @@ uint32 FOnlineSessionEOS::JoinEOSSession(int32 PlayerNum, FNamedOnlineSession* S
 
 	// Copy the session info over
 	TSharedPtr<const FOnlineSessionInfoEOS> SearchSessionInfo = StaticCastSharedPtr<const FOnlineSessionInfoEOS>(SearchSession->SessionInfo);
-	EOSSessionInfo->HostAddr = SearchSessionInfo->HostAddr->Clone();
+	if (SearchSessionInfo->PrefetchedHostAddr.IsValid())
+	{
+		// Take the copy made when the result was prefetched, a later join of the same result clones its own
+		EOSSessionInfo->HostAddr = MoveTemp(SearchSessionInfo->PrefetchedHostAddr);
+		INC_DWORD_STAT(STAT_EOS_SessionPrefetchHits);
+	}
+	else
+	{
+		EOSSessionInfo->HostAddr = SearchSessionInfo->HostAddr->Clone();
+	}
+	EOSSessionInfo->PrefetchedConnectString = SearchSessionInfo->PrefetchedConnectString;
+	EOSSessionInfo->PrefetchedBeaconConnectString = SearchSessionInfo->PrefetchedBeaconConnectString;
+	EOSSessionInfo->PrefetchedBeaconPort = SearchSessionInfo->PrefetchedBeaconPort;
 
 	Session->SessionState = EOnlineSessionState::Pending;
 
 	FJoinSessionCallback* CallbackObj = new FJoinSessionCallback();
-	CallbackObj->CallbackLambda = [this, Session](const EOS_Sessions_JoinSessionCallbackInfo* Data)
+	const FName SessionName = Session->SessionName;
+	CallbackObj->CallbackLambda = [this, SessionName](const EOS_Sessions_JoinSessionCallbackInfo* Data)
 	{
 		bool bWasSuccessful = Data->ResultCode == EOS_EResult::EOS_Success;
-		if (bWasSuccessful)
+		// Look the session up again, it may have been removed while the join was in flight
+		FNamedOnlineSession* Session = GetNamedSession(SessionName);
+		if (bWasSuccessful && Session != nullptr)
 		{
 			BeginSessionAnalytics(Session);
 		}
-		else
+		else if (!bWasSuccessful)
 		{
-			UE_LOG_ONLINE_SESSION(Error, TEXT("EOS_Sessions_JoinSession() failed for session (%s) with EOS result code (%s)"), *Session->SessionName.ToString(), ANSI_TO_TCHAR(EOS_EResult_ToString(Data->ResultCode)));
+			UE_LOG_ONLINE_SESSION(Error, TEXT("EOS_Sessions_JoinSession() failed for session (%s) with EOS result code (%s)"), *SessionName.ToString(), ANSI_TO_TCHAR(EOS_EResult_ToString(Data->ResultCode)));
 		}
-		TriggerOnJoinSessionCompleteDelegates(Session->SessionName, bWasSuccessful ? EOnJoinSessionCompleteResult::Success : EOnJoinSessionCompleteResult::UnknownError);
+		TriggerOnJoinSessionCompleteDelegates(SessionName, bWasSuccessful ? EOnJoinSessionCompleteResult::Success : EOnJoinSessionCompleteResult::UnknownError);
 	};
 
 	FJoinSessionOptions Options(TCHAR_TO_UTF8(*Session->SessionName.ToString()));
@@ -1604,7 +2010,18 @@ uint32 FOnlineSessionEOS::JoinLANSession(int32 PlayerNum, FNamedOnlineSession* S
 		// Copy the session info over
 		TSharedPtr<const FOnlineSessionInfoEOS> SearchSessionInfo = StaticCastSharedPtr<const FOnlineSessionInfoEOS>(SearchSession->SessionInfo);
 		TSharedPtr<FOnlineSessionInfoEOS> SessionInfo = StaticCastSharedPtr<FOnlineSessionInfoEOS>(Session->SessionInfo);
-		SessionInfo->HostAddr = SearchSessionInfo->HostAddr->Clone();
+		if (SearchSessionInfo->PrefetchedHostAddr.IsValid())
+		{
+			SessionInfo->HostAddr = MoveTemp(SearchSessionInfo->PrefetchedHostAddr);
+			INC_DWORD_STAT(STAT_EOS_SessionPrefetchHits);
+		}
+		else
+		{
+			SessionInfo->HostAddr = SearchSessionInfo->HostAddr->Clone();
+		}
+		SessionInfo->PrefetchedConnectString = SearchSessionInfo->PrefetchedConnectString;
+		SessionInfo->PrefetchedBeaconConnectString = SearchSessionInfo->PrefetchedBeaconConnectString;
+		SessionInfo->PrefetchedBeaconPort = SearchSessionInfo->PrefetchedBeaconPort;
 		Result = ONLINE_SUCCESS;
 	}
 	else
@@ -1732,9 +2149,166 @@ bool FOnlineSessionEOS::SendSessionInviteToFriends(const FUniqueNetId& LocalUser
 	return true;
 }
 
+void FOnlineSessionEOS::AddPingableSearch(const TSharedRef<FOnlineSessionSearch>& SearchSettings)
+{
+	PingableSessionSearches.RemoveAll([](const TWeakPtr<FOnlineSessionSearch>& Search)
+	{
+		return !Search.IsValid();
+	});
+	PingableSessionSearches.AddUnique(SearchSettings);
+}
+
+void FOnlineSessionEOS::PrefetchSearchResults(FOnlineSessionSearch& SearchSettings)
+{
+	if (!SessionPrefetch.IsValid() || !SessionPrefetch->IsEnabled())
+	{
+		return;
+	}
+	EOS_ProductUserId LocalUserId = EOSSubsystem->UserManager->GetLocalProductUserId(EOSSubsystem->UserManager->GetDefaultLocalUser());
+	SessionPrefetch->Prefetch(SearchSettings, LocalUserId, [this](const FOnlineSessionSearchResult& SearchResult)
+	{
+		return GetP2PHostAddress(SearchResult);
+	});
+}
+
+const FInternetAddrEOS* FOnlineSessionEOS::GetP2PHostAddress(const FOnlineSessionSearchResult& SearchResult) const
+{
+	const FOnlineSessionInfoEOS* SessionInfo = static_cast<const FOnlineSessionInfoEOS*>(SearchResult.Session.SessionInfo.Get());
+	// Only P2P hosted sessions have an EOS address, dedicated servers advertise an IP
+	if (SessionInfo == nullptr || SessionInfo->EOSAddress.IsEmpty() || !SessionInfo->HostAddr.IsValid())
+	{
+		return nullptr;
+	}
+	return static_cast<const FInternetAddrEOS*>(SessionInfo->HostAddr.Get());
+}
+
+EOS_ProductUserId FOnlineSessionEOS::GetPingableHostId(const FOnlineSessionSearchResult& SearchResult) const
+{
+	const FInternetAddrEOS* HostAddress = GetP2PHostAddress(SearchResult);
+	return HostAddress != nullptr ? HostAddress->GetRemoteUserId() : nullptr;
+}
+
 bool FOnlineSessionEOS::PingSearchResults(const FOnlineSessionSearchResult& SearchResult)
 {
-	return false;
+	EOS_ProductUserId HostUserId = GetPingableHostId(SearchResult);
+	if (!SessionPing.IsValid() || HostUserId == nullptr)
+	{
+		UE_LOG_ONLINE_SESSION(Warning, TEXT("PingSearchResults() can only ping P2P hosted sessions"));
+		return false;
+	}
+
+	// Find the search that owns the result so we can write the ping back once it arrives
+	TWeakPtr<FOnlineSessionSearch> OwningSearch;
+	for (const TWeakPtr<FOnlineSessionSearch>& WeakSearch : PingableSessionSearches)
+	{
+		TSharedPtr<FOnlineSessionSearch> Search = WeakSearch.Pin();
+		if (Search.IsValid() && Search->SearchResults.ContainsByPredicate([&SearchResult](const FOnlineSessionSearchResult& Result) { return Result.Session.SessionInfo == SearchResult.Session.SessionInfo; }))
+		{
+			OwningSearch = Search;
+			break;
+		}
+	}
+	if (!OwningSearch.IsValid())
+	{
+		UE_LOG_ONLINE_SESSION(Warning, TEXT("PingSearchResults() was passed a result that doesn't belong to a live search"));
+		return false;
+	}
+
+	TWeakPtr<FOnlineSessionInfo> WeakSessionInfo = SearchResult.Session.SessionInfo;
+	EOS_ProductUserId LocalUserId = EOSSubsystem->UserManager->GetLocalProductUserId(EOSSubsystem->UserManager->GetDefaultLocalUser());
+	return SessionPing->Ping(LocalUserId, HostUserId, [this, OwningSearch, WeakSessionInfo](int32 PingInMs)
+	{
+		TSharedPtr<FOnlineSessionSearch> Search = OwningSearch.Pin();
+		TSharedPtr<FOnlineSessionInfo> SessionInfo = WeakSessionInfo.Pin();
+		if (Search.IsValid() && SessionInfo.IsValid())
+		{
+			for (FOnlineSessionSearchResult& Result : Search->SearchResults)
+			{
+				if (Result.Session.SessionInfo == SessionInfo)
+				{
+					Result.PingInMs = PingInMs;
+					break;
+				}
+			}
+		}
+		TriggerOnPingSearchResultsCompleteDelegates(PingInMs != MAX_QUERY_PING);
+	});
+}
+
+bool FOnlineSessionEOS::PingSearchResults(const TSharedRef<FOnlineSessionSearch>& SearchSettings)
+{
+	return PingSearchResults(SearchSettings, [this](bool bAnyAnswered)
+	{
+		TriggerOnPingSearchResultsCompleteDelegates(bAnyAnswered);
+	});
+}
+
+bool FOnlineSessionEOS::PingSearchResults(const TSharedRef<FOnlineSessionSearch>& SearchSettings, TFunction<void(bool bAnyAnswered)>&& OnComplete)
+{
+	if (!SessionPing.IsValid())
+	{
+		return false;
+	}
+
+	// Shared by every probe so the last one to finish reports for the batch
+	struct FPingBatch
+	{
+		int32 NumPending;
+		bool bAnyAnswered;
+		TFunction<void(bool bAnyAnswered)> OnComplete;
+	};
+	TSharedRef<FPingBatch> Batch = MakeShared<FPingBatch>();
+	Batch->NumPending = 0;
+	Batch->bAnyAnswered = false;
+	Batch->OnComplete = MoveTemp(OnComplete);
+
+	EOS_ProductUserId LocalUserId = EOSSubsystem->UserManager->GetLocalProductUserId(EOSSubsystem->UserManager->GetDefaultLocalUser());
+	TWeakPtr<FOnlineSessionSearch> WeakSearch = SearchSettings;
+	for (FOnlineSessionSearchResult& Result : SearchSettings->SearchResults)
+	{
+		EOS_ProductUserId HostUserId = GetPingableHostId(Result);
+		if (HostUserId == nullptr)
+		{
+			continue;
+		}
+
+		TWeakPtr<FOnlineSessionInfo> WeakSessionInfo = Result.Session.SessionInfo;
+		const bool bStarted = SessionPing->Ping(LocalUserId, HostUserId, [Batch, WeakSearch, WeakSessionInfo](int32 PingInMs)
+		{
+			TSharedPtr<FOnlineSessionSearch> Search = WeakSearch.Pin();
+			TSharedPtr<FOnlineSessionInfo> SessionInfo = WeakSessionInfo.Pin();
+			if (Search.IsValid() && SessionInfo.IsValid())
+			{
+				// Results can be reordered while we wait so look ours up again
+				for (FOnlineSessionSearchResult& SearchResult : Search->SearchResults)
+				{
+					if (SearchResult.Session.SessionInfo == SessionInfo)
+					{
+						SearchResult.PingInMs = PingInMs;
+						break;
+					}
+				}
+			}
+			Batch->bAnyAnswered |= PingInMs != MAX_QUERY_PING;
+			if (--Batch->NumPending == 0)
+			{
+				Batch->OnComplete(Batch->bAnyAnswered);
+			}
+		});
+		if (bStarted)
+		{
+			Batch->NumPending++;
+		}
+	}
+	return Batch->NumPending > 0;
+}
+
+void FOnlineSessionEOS::SortSearchResultsByPing(FOnlineSessionSearch& SearchSettings)
+{
+	SearchSettings.SearchResults.StableSort([](const FOnlineSessionSearchResult& A, const FOnlineSessionSearchResult& B)
+	{
+		return A.PingInMs < B.PingInMs;
+	});
 }
 
 /** Get a resolved connection string from a session info */
@@ -1745,7 +2319,16 @@ static bool GetConnectStringFromSessionInfo(TSharedPtr<FOnlineSessionInfoEOS>& S
 		return false;
 	}
 
-	if (PortOverride != 0)
+	// Use the strings built when the search result was prefetched, if any
+	if (PortOverride != 0 && PortOverride == SessionInfo->PrefetchedBeaconPort && SessionInfo->PrefetchedBeaconConnectString.Len() > 0)
+	{
+		ConnectInfo = SessionInfo->PrefetchedBeaconConnectString;
+	}
+	else if (PortOverride == 0 && SessionInfo->PrefetchedConnectString.Len() > 0)
+	{
+		ConnectInfo = SessionInfo->PrefetchedConnectString;
+	}
+	else if (PortOverride != 0)
 	{
 		ConnectInfo = FString::Printf(TEXT("%s:%d"), *SessionInfo->HostAddr->ToString(false), PortOverride);
 	}
@@ -1846,19 +2429,23 @@ bool FOnlineSessionEOS::RegisterPlayer(FName SessionName, const FUniqueNetId& Pl
 bool FOnlineSessionEOS::RegisterPlayers(FName SessionName, const TArray< TSharedRef<const FUniqueNetId> >& Players, bool bWasInvited)
 {
 	bool bSuccess = false;
-	FNamedOnlineSession* Session = GetNamedSession(SessionName);
+	FNamedOnlineSessionEOS* Session = GetNamedSessionEOS(SessionName);
 	if (Session)
 	{
 		bSuccess = true;
+		// Only the host tells EOS who is in the session
+		const bool bShouldTellEOS = !Session->SessionSettings.bIsLANMatch && IsHost(*Session);
 
 		for (int32 PlayerIdx=0; PlayerIdx<Players.Num(); PlayerIdx++)
 		{
 			const TSharedRef<const FUniqueNetId>& PlayerId = Players[PlayerIdx];
 
-			FUniqueNetIdMatcher PlayerMatch(*PlayerId);
-			if (Session->RegisteredPlayers.IndexOfByPredicate(PlayerMatch) == INDEX_NONE)
+			if (Session->AddRegisteredPlayer(PlayerId))
 			{
-				Session->RegisteredPlayers.Add(PlayerId);
+				if (bShouldTellEOS)
+				{
+					QueuePlayerRegistration(*Session, *PlayerId, true);
+				}
 
 				// update number of open connections
 				if (Session->NumOpenPublicConnections > 0)
@@ -1896,18 +2483,21 @@ bool FOnlineSessionEOS::UnregisterPlayers(FName SessionName, const TArray< TShar
 {
 	bool bSuccess = true;
 
-	FNamedOnlineSession* Session = GetNamedSession(SessionName);
+	FNamedOnlineSessionEOS* Session = GetNamedSessionEOS(SessionName);
 	if (Session)
 	{
+		const bool bShouldTellEOS = !Session->SessionSettings.bIsLANMatch && IsHost(*Session);
+
 		for (int32 PlayerIdx=0; PlayerIdx < Players.Num(); PlayerIdx++)
 		{
 			const TSharedRef<const FUniqueNetId>& PlayerId = Players[PlayerIdx];
 
-			FUniqueNetIdMatcher PlayerMatch(*PlayerId);
-			int32 RegistrantIndex = Session->RegisteredPlayers.IndexOfByPredicate(PlayerMatch);
-			if (RegistrantIndex != INDEX_NONE)
+			if (Session->RemoveRegisteredPlayer(*PlayerId))
 			{
-				Session->RegisteredPlayers.RemoveAtSwap(RegistrantIndex);
+				if (bShouldTellEOS)
+				{
+					QueuePlayerRegistration(*Session, *PlayerId, false);
+				}
 
 				// update number of open connections
 				if (Session->NumOpenPublicConnections < Session->SessionSettings.NumPublicConnections)
@@ -1935,98 +2525,205 @@ bool FOnlineSessionEOS::UnregisterPlayers(FName SessionName, const TArray< TShar
 	return bSuccess;
 }
 
-void FOnlineSessionEOS::Tick(float DeltaTime)
+bool FNamedOnlineSessionEOS::AddRegisteredPlayer(const TSharedRef<const FUniqueNetId>& PlayerId)
 {
-	SCOPE_CYCLE_COUNTER(STAT_Session_Interface);
-	TickLanTasks(DeltaTime);
+	const FUniqueNetIdEOS EOSId(*PlayerId);
+	if (RegisteredPlayerIndices.Contains(EOSId))
+	{
+		return false;
+	}
+	RegisteredPlayerIndices.Add(EOSId, RegisteredPlayers.Add(PlayerId));
+	return true;
 }
 
-void FOnlineSessionEOS::TickLanTasks(float DeltaTime)
+bool FNamedOnlineSessionEOS::RemoveRegisteredPlayer(const FUniqueNetId& PlayerId)
 {
-	if (LANSession.IsValid() &&
-		LANSession->GetBeaconState() > ELanBeaconState::NotUsingLanBeacon)
+	int32 PlayerIndex = INDEX_NONE;
+	if (!RegisteredPlayerIndices.RemoveAndCopyValue(FUniqueNetIdEOS(PlayerId), PlayerIndex))
 	{
-		LANSession->Tick(DeltaTime);
+		return false;
 	}
+	RegisteredPlayers.RemoveAt(PlayerIndex);
+	// Everyone after the player moved down one
+	for (int32 Index = PlayerIndex; Index < RegisteredPlayers.Num(); Index++)
+	{
+		RegisteredPlayerIndices[FUniqueNetIdEOS(*RegisteredPlayers[Index])] = Index;
+	}
+	return true;
 }
 
-void FOnlineSessionEOS::AppendSessionToPacket(FNboSerializeToBufferEOS& Packet, FOnlineSession* Session)
+void FOnlineSessionEOS::QueuePlayerRegistration(FNamedOnlineSessionEOS& Session, const FUniqueNetId& PlayerId, bool bIsRegistering)
 {
-	/** Owner of the session */
-	Packet << *StaticCastSharedPtr<const FUniqueNetIdEOS>(Session->OwningUserId)
-		<< Session->OwningUserName
-		<< Session->NumOpenPrivateConnections
-		<< Session->NumOpenPublicConnections;
+	FUniqueNetIdEOS EOSId(PlayerId);
+	EOS_ProductUserId ProductUserId = EOSId.GetProductUserId();
+	if (ProductUserId == nullptr)
+	{
+		UE_LOG_ONLINE_SESSION(Warning, TEXT("Player %s has no product user id, EOS won't see them in session (%s)"), *PlayerId.ToDebugString(), *Session.SessionName.ToString());
+		return;
+	}
 
-	// Try to get the actual port the netdriver is using
-	SetPortFromNetDriver(*EOSSubsystem, Session->SessionInfo);
+	TSet<EOS_ProductUserId>& Queue = bIsRegistering ? Session.PendingRegistrations : Session.PendingUnregistrations;
+	TSet<EOS_ProductUserId>& OppositeQueue = bIsRegistering ? Session.PendingUnregistrations : Session.PendingRegistrations;
+	if (OppositeQueue.Remove(ProductUserId) == 0)
+	{
+		Queue.Add(ProductUserId);
+	}
+}
 
-	// Write host info (host addr, session id, and key)
-	Packet << *StaticCastSharedPtr<FOnlineSessionInfoEOS>(Session->SessionInfo);
+struct FRegisterPlayersOptions :
+	public TNamedSessionOptions<EOS_Sessions_RegisterPlayersOptions>
+{
+	FRegisterPlayersOptions(const char* InSessionNameAnsi) :
+		TNamedSessionOptions<EOS_Sessions_RegisterPlayersOptions>(InSessionNameAnsi)
+	{
+		ApiVersion = EOS_SESSIONS_REGISTERPLAYERS_API_LATEST;
+	}
+};
 
-	// Now append per game settings
-	AppendSessionSettingsToPacket(Packet, &Session->SessionSettings);
-}
+struct FUnregisterPlayersOptions :
+	public TNamedSessionOptions<EOS_Sessions_UnregisterPlayersOptions>
+{
+	FUnregisterPlayersOptions(const char* InSessionNameAnsi) :
+		TNamedSessionOptions<EOS_Sessions_UnregisterPlayersOptions>(InSessionNameAnsi)
+	{
+		ApiVersion = EOS_SESSIONS_UNREGISTERPLAYERS_API_LATEST;
+	}
+};
 
-void FOnlineSessionEOS::AppendSessionSettingsToPacket(FNboSerializeToBufferEOS& Packet, FOnlineSessionSettings* SessionSettings)
+typedef TEOSCallback<EOS_Sessions_OnRegisterPlayersCallback, EOS_Sessions_RegisterPlayersCallbackInfo> FRegisterPlayersCallback;
+typedef TEOSCallback<EOS_Sessions_OnUnregisterPlayersCallback, EOS_Sessions_UnregisterPlayersCallbackInfo> FUnregisterPlayersCallback;
+
+void FOnlineSessionEOS::FlushPlayerRegistrations()
 {
-#if DEBUG_LAN_BEACON
-	UE_LOG_ONLINE_SESSION(Verbose, TEXT("Sending session settings to client"));
-#endif 
+	FScopeLock ScopeLock(&SessionLock);
+	for (const TUniquePtr<FNamedOnlineSessionEOS>& Session : Sessions)
+	{
+		if (Session->PendingRegistrations.Num() == 0 && Session->PendingUnregistrations.Num() == 0)
+		{
+			continue;
+		}
+		// EOS doesn't know the session until creating it finishes
+		if (Session->SessionState == EOnlineSessionState::Creating)
+		{
+			continue;
+		}
+		if (Session->SessionState == EOnlineSessionState::Destroying)
+		{
+			Session->PendingRegistrations.Reset();
+			Session->PendingUnregistrations.Reset();
+			continue;
+		}
 
-	// Members of the session settings class
-	Packet << SessionSettings->NumPublicConnections
-		<< SessionSettings->NumPrivateConnections
-		<< (uint8)SessionSettings->bShouldAdvertise
-		<< (uint8)SessionSettings->bIsLANMatch
-		<< (uint8)SessionSettings->bIsDedicated
-		<< (uint8)SessionSettings->bUsesStats
-		<< (uint8)SessionSettings->bAllowJoinInProgress
-		<< (uint8)SessionSettings->bAllowInvites
-		<< (uint8)SessionSettings->bUsesPresence
-		<< (uint8)SessionSettings->bAllowJoinViaPresence
-		<< (uint8)SessionSettings->bAllowJoinViaPresenceFriendsOnly
-		<< (uint8)SessionSettings->bAntiCheatProtected
-	    << SessionSettings->BuildUniqueId;
+		const FName SessionName = Session->SessionName;
+		if (Session->PendingRegistrations.Num() > 0)
+		{
+			TArray<EOS_ProductUserId> Players = Session->PendingRegistrations.Array();
+			Session->PendingRegistrations.Reset();
+			INC_DWORD_STAT(STAT_EOS_SessionPlayerBatches);
+			INC_DWORD_STAT_BY(STAT_EOS_SessionPlayersBatched, Players.Num());
 
-	// First count number of advertised keys
-	int32 NumAdvertisedProperties = 0;
-	for (FSessionSettings::TConstIterator It(SessionSettings->Settings); It; ++It)
-	{	
-		const FOnlineSessionSetting& Setting = It.Value();
-		if (Setting.AdvertisementType >= EOnlineDataAdvertisementType::ViaOnlineService)
+			FRegisterPlayersCallback* CallbackObj = new FRegisterPlayersCallback();
+			const int32 NumPlayers = Players.Num();
+			CallbackObj->CallbackLambda = [SessionName, NumPlayers](const EOS_Sessions_RegisterPlayersCallbackInfo* Data)
+			{
+				if (Data->ResultCode != EOS_EResult::EOS_Success)
+				{
+					UE_LOG_ONLINE_SESSION(Error, TEXT("EOS_Sessions_RegisterPlayers() failed for (%d) players in session (%s) with EOS result code (%s)"), NumPlayers, *SessionName.ToString(), ANSI_TO_TCHAR(EOS_EResult_ToString(Data->ResultCode)));
+				}
+			};
+
+			FRegisterPlayersOptions Options(TCHAR_TO_UTF8(*SessionName.ToString()));
+			Options.PlayersToRegister = Players.GetData();
+			Options.PlayersToRegisterCount = Players.Num();
+			EOS_Sessions_RegisterPlayers(EOSSubsystem->SessionsHandle, &Options, CallbackObj, CallbackObj->GetCallbackPtr());
+		}
+		if (Session->PendingUnregistrations.Num() > 0)
 		{
-			NumAdvertisedProperties++;
+			TArray<EOS_ProductUserId> Players = Session->PendingUnregistrations.Array();
+			Session->PendingUnregistrations.Reset();
+			INC_DWORD_STAT(STAT_EOS_SessionPlayerBatches);
+			INC_DWORD_STAT_BY(STAT_EOS_SessionPlayersBatched, Players.Num());
+
+			FUnregisterPlayersCallback* CallbackObj = new FUnregisterPlayersCallback();
+			const int32 NumPlayers = Players.Num();
+			CallbackObj->CallbackLambda = [SessionName, NumPlayers](const EOS_Sessions_UnregisterPlayersCallbackInfo* Data)
+			{
+				if (Data->ResultCode != EOS_EResult::EOS_Success)
+				{
+					UE_LOG_ONLINE_SESSION(Error, TEXT("EOS_Sessions_UnregisterPlayers() failed for (%d) players in session (%s) with EOS result code (%s)"), NumPlayers, *SessionName.ToString(), ANSI_TO_TCHAR(EOS_EResult_ToString(Data->ResultCode)));
+				}
+			};
+
+			FUnregisterPlayersOptions Options(TCHAR_TO_UTF8(*SessionName.ToString()));
+			Options.PlayersToUnregister = Players.GetData();
+			Options.PlayersToUnregisterCount = Players.Num();
+			EOS_Sessions_UnregisterPlayers(EOSSubsystem->SessionsHandle, &Options, CallbackObj, CallbackObj->GetCallbackPtr());
 		}
 	}
+}
 
-	// Add count of advertised keys and the data
-	Packet << (int32)NumAdvertisedProperties;
-	for (FSessionSettings::TConstIterator It(SessionSettings->Settings); It; ++It)
+void FOnlineSessionEOS::Tick(float DeltaTime)
+{
+	SCOPE_CYCLE_COUNTER(STAT_Session_Interface);
+	TickLanTasks(DeltaTime);
+	if (SessionPing.IsValid())
 	{
-		const FOnlineSessionSetting& Setting = It.Value();
-		if (Setting.AdvertisementType >= EOnlineDataAdvertisementType::ViaOnlineService)
+		SessionPing->Tick(DeltaTime);
+	}
+	if (SessionPrefetch.IsValid())
+	{
+		SessionPrefetch->Tick(DeltaTime);
+	}
+	TickMatchmaking(DeltaTime);
+	// Everything registered this frame goes to EOS together
+	FlushPlayerRegistrations();
+}
+
+void FOnlineSessionEOS::TickLanTasks(float DeltaTime)
+{
+	if (LANSession.IsValid() &&
+		LANSession->GetBeaconState() > ELanBeaconState::NotUsingLanBeacon)
+	{
+		LANSession->Tick(DeltaTime);
+
+		if (PendingLANQueryNonces.Num() > 0 && FPlatformTime::Seconds() - LastLANResponseTime >= LANResponseInterval)
 		{
-			Packet << It.Key();
-			Packet << Setting;
-#if DEBUG_LAN_BEACON
-			UE_LOG_ONLINE_SESSION(Verbose, TEXT("%s"), *Setting.ToString());
-#endif
+			SendLANQueryResponses();
 		}
 	}
 }
 
 void FOnlineSessionEOS::OnValidQueryPacketReceived(uint8* PacketData, int32 PacketLength, uint64 ClientNonce)
 {
-	// Iterate through all registered sessions and respond for each LAN match
-	FScopeLock ScopeLock(&SessionLock);
-	for (int32 SessionIndex = 0; SessionIndex < Sessions.Num(); SessionIndex++)
+	// Answered from TickLanTasks so a burst of queries costs one pass over the sessions
+	if (PendingLANQueryNonces.Contains(ClientNonce))
 	{
-		FNamedOnlineSession* Session = &Sessions[SessionIndex];
+		INC_DWORD_STAT(STAT_EOS_LANQueriesCoalesced);
+		return;
+	}
+	// Don't let clients spamming searches grow the queue forever, they'll search again
+	if (PendingLANQueryNonces.Num() >= MaxLANResponsesPerInterval * 16)
+	{
+		UE_LOG_ONLINE_SESSION(Verbose, TEXT("Dropping LAN query, (%d) are already waiting for a response"), PendingLANQueryNonces.Num());
+		return;
+	}
+	PendingLANQueryNonces.Add(ClientNonce);
+}
+
+void FOnlineSessionEOS::SendLANQueryResponses()
+{
+	LastLANResponseTime = FPlatformTime::Seconds();
 
-		// Don't respond to query if the session is not a joinable LAN match.
-		if (Session != nullptr)
+	{
+		// Iterate through all registered sessions and respond for each LAN match
+		FScopeLock ScopeLock(&SessionLock);
+		const int32 NetDriverPort = GetPortFromNetDriver(EOSSubsystem->GetInstanceName());
+		TArray<FName> SessionNames;
+		TArray<const TArray<uint8>*> SessionBodies;
+		bool bAnySessionChanged = false;
+		for (const TUniquePtr<FNamedOnlineSessionEOS>& Session : Sessions)
 		{
+			// Don't respond to query if the session is not a joinable LAN match.
 			const FOnlineSessionSettings& Settings = Session->SessionSettings;
 
 			const bool bIsMatchInProgress = Session->SessionState == EOnlineSessionState::InProgress;
@@ -2035,133 +2732,80 @@ void FOnlineSessionEOS::OnValidQueryPacketReceived(uint8* PacketData, int32 Pack
 				(!bIsMatchInProgress || Settings.bAllowJoinInProgress) &&
 				Settings.NumPublicConnections > 0;
 
-			if (bIsMatchJoinable)
+			if (!bIsMatchJoinable)
 			{
-				FNboSerializeToBufferEOS Packet(LAN_BEACON_MAX_PACKET_SIZE);
-				// Create the basic header before appending additional information
-				LANSession->CreateHostResponsePacket(Packet, ClientNonce);
-
-				// Add all the session details
-				AppendSessionToPacket(Packet, Session);
+				continue;
+			}
 
-				// Broadcast this response so the client can see us
-				LANSession->BroadcastPacket(Packet, Packet.GetByteCount());
+			// UpdateSession clears the body, the settings hash catches changes made through GetSessionSettings()
+			const uint32 SettingsHash = FLANSessionFormatEOS::HashSettings(Settings);
+			if (Session->LANResponseBody.Num() == 0 ||
+				Session->LANResponseNumOpenPublicConnections != Session->NumOpenPublicConnections ||
+				Session->LANResponseNumOpenPrivateConnections != Session->NumOpenPrivateConnections ||
+				Session->LANResponsePort != NetDriverPort ||
+				Session->LANResponseSettingsHash != SettingsHash)
+			{
+				// Use the actual port the netdriver is using
+				SetPortFromNetDriver(*EOSSubsystem, Session->SessionInfo);
+				LANSessionFormat.WriteSession(*Session, Session->LANResponseBody);
+				Session->LANResponseNumOpenPublicConnections = Session->NumOpenPublicConnections;
+				Session->LANResponseNumOpenPrivateConnections = Session->NumOpenPrivateConnections;
+				Session->LANResponsePort = NetDriverPort;
+				Session->LANResponseSettingsHash = SettingsHash;
+				bAnySessionChanged = true;
+				INC_DWORD_STAT(STAT_EOS_LANSessionEncodes);
 			}
+			SessionNames.Add(Session->SessionName);
+			SessionBodies.Add(&Session->LANResponseBody);
 		}
-	}
-}
 
-void FOnlineSessionEOS::ReadSessionFromPacket(FNboSerializeFromBufferEOS& Packet, FOnlineSession* Session)
-{
-#if DEBUG_LAN_BEACON
-	UE_LOG_ONLINE_SESSION(Verbose, TEXT("Reading session information from server"));
-#endif
-
-	/** Owner of the session */
-	FUniqueNetIdEOS* UniqueId = new FUniqueNetIdEOS;
-	Packet >> *UniqueId
-		>> Session->OwningUserName
-		>> Session->NumOpenPrivateConnections
-		>> Session->NumOpenPublicConnections;
-
-	Session->OwningUserId = MakeShareable(UniqueId);
-
-	// Allocate and read the connection data
-	FOnlineSessionInfoEOS* EOSSessionInfo = new FOnlineSessionInfoEOS();
-	EOSSessionInfo->HostAddr = ISocketSubsystem::Get(PLATFORM_SOCKETSUBSYSTEM)->CreateInternetAddr();
-	Packet >> *EOSSessionInfo;
-	Session->SessionInfo = MakeShareable(EOSSessionInfo); 
-
-	// Read any per object data using the server object
-	ReadSettingsFromPacket(Packet, Session->SessionSettings);
-}
-
-void FOnlineSessionEOS::ReadSettingsFromPacket(FNboSerializeFromBufferEOS& Packet, FOnlineSessionSettings& SessionSettings)
-{
-#if DEBUG_LAN_BEACON
-	UE_LOG_ONLINE_SESSION(Verbose, TEXT("Reading game settings from server"));
-#endif
-
-	// Clear out any old settings
-	SessionSettings.Settings.Empty();
-
-	// Members of the session settings class
-	Packet >> SessionSettings.NumPublicConnections
-		>> SessionSettings.NumPrivateConnections;
-	uint8 Read = 0;
-	// Read all the bools as bytes
-	Packet >> Read;
-	SessionSettings.bShouldAdvertise = !!Read;
-	Packet >> Read;
-	SessionSettings.bIsLANMatch = !!Read;
-	Packet >> Read;
-	SessionSettings.bIsDedicated = !!Read;
-	Packet >> Read;
-	SessionSettings.bUsesStats = !!Read;
-	Packet >> Read;
-	SessionSettings.bAllowJoinInProgress = !!Read;
-	Packet >> Read;
-	SessionSettings.bAllowInvites = !!Read;
-	Packet >> Read;
-	SessionSettings.bUsesPresence = !!Read;
-	Packet >> Read;
-	SessionSettings.bAllowJoinViaPresence = !!Read;
-	Packet >> Read;
-	SessionSettings.bAllowJoinViaPresenceFriendsOnly = !!Read;
-	Packet >> Read;
-	SessionSettings.bAntiCheatProtected = !!Read;
-
-	// BuildId
-	Packet >> SessionSettings.BuildUniqueId;
-
-	// Now read the contexts and properties from the settings class
-	int32 NumAdvertisedProperties = 0;
-	// First, read the number of advertised properties involved, so we can presize the array
-	Packet >> NumAdvertisedProperties;
-	if (Packet.HasOverflow() == false)
-	{
-		FName Key;
-		// Now read each context individually
-		for (int32 Index = 0;
-			Index < NumAdvertisedProperties && Packet.HasOverflow() == false;
-			Index++)
-		{
-			FOnlineSessionSetting Setting;
-			Packet >> Key;
-			Packet >> Setting;
-			SessionSettings.Set(Key, Setting);
-
-#if DEBUG_LAN_BEACON
-			UE_LOG_ONLINE_SESSION(Verbose, TEXT("%s"), *Setting->ToString());
-#endif
+		if (bAnySessionChanged || SessionNames != LANResponseSessionNames)
+		{
+			// Pack as many sessions into each response as fit after the beacon header
+			FNboSerializeToBufferEOS HeaderPacket(LAN_BEACON_MAX_PACKET_SIZE);
+			LANSession->CreateHostResponsePacket(HeaderPacket, 0);
+			LANSessionFormat.BuildPayloads(SessionBodies, LAN_BEACON_MAX_PACKET_SIZE - (int32)HeaderPacket.GetByteCount(), LANResponsePayloads);
+			LANResponseSessionNames = SessionNames;
 		}
 	}
-	
-	// If there was an overflow, treat the string settings/properties as broken
-	if (Packet.HasOverflow())
+
+	// Every client gets the same payloads, only the nonce in the header differs
+	const int32 NumToAnswer = FMath::Min(PendingLANQueryNonces.Num(), MaxLANResponsesPerInterval);
+	for (int32 NonceIndex = 0; NonceIndex < NumToAnswer; NonceIndex++)
 	{
-		SessionSettings.Settings.Empty();
-		UE_LOG_ONLINE_SESSION(Verbose, TEXT("Packet overflow detected in ReadGameSettingsFromPacket()"));
+		for (const TArray<uint8>& Payload : LANResponsePayloads)
+		{
+			FNboSerializeToBufferEOS Packet(LAN_BEACON_MAX_PACKET_SIZE);
+			// Create the basic header before appending additional information
+			LANSession->CreateHostResponsePacket(Packet, PendingLANQueryNonces[NonceIndex]);
+			Packet.WriteBinary(Payload.GetData(), Payload.Num());
+
+			// Broadcast this response so the client can see us
+			LANSession->BroadcastPacket(Packet, Packet.GetByteCount());
+		}
 	}
+	INC_DWORD_STAT_BY(STAT_EOS_LANSessionResponses, NumToAnswer * LANResponsePayloads.Num());
+	PendingLANQueryNonces.RemoveAt(0, NumToAnswer, false);
 }
 
 void FOnlineSessionEOS::OnValidResponsePacketReceived(uint8* PacketData, int32 PacketLength)
 {
-	// Create an object that we'll copy the data to
-	FOnlineSessionSettings NewServer;
-	if (CurrentSessionSearch.IsValid())
+	if (CurrentLANSessionSearch.IsValid())
 	{
-		// Add space in the search results array
-		FOnlineSessionSearchResult* NewResult = new (CurrentSessionSearch->SearchResults) FOnlineSessionSearchResult();
+		TArray<FOnlineSessionSearchResult>& SearchResults = CurrentLANSessionSearch->SearchResults;
 		// this is not a correct ping, but better than nothing
-		NewResult->PingInMs = static_cast<int32>((FPlatformTime::Seconds() - SessionSearchStartInSeconds) * 1000);
-
-		FOnlineSession* NewSession = &NewResult->Session;
+		const int32 PingInMs = static_cast<int32>((FPlatformTime::Seconds() - SessionSearchStartInSeconds) * 1000);
 
-		// Prepare to read data from the packet
-		FNboSerializeFromBufferEOS Packet(PacketData, PacketLength);
-		
-		ReadSessionFromPacket(Packet, NewSession);
+		// A host answers with all of its sessions at once, add space in the search results array for each
+		const int32 NumResultsBefore = SearchResults.Num();
+		const int32 NumRead = LANSessionFormat.ReadPayload(PacketData, PacketLength, [&SearchResults, PingInMs]() -> FOnlineSession&
+		{
+			FOnlineSessionSearchResult& NewResult = SearchResults.AddDefaulted_GetRef();
+			NewResult.PingInMs = PingInMs;
+			return NewResult.Session;
+		});
+		// Drop the session we stopped part way through, if any
+		SearchResults.SetNum(NumResultsBefore + NumRead);
 
 		// NOTE: we don't notify until the timeout happens
 	}
@@ -2180,7 +2824,7 @@ void FOnlineSessionEOS::OnLANSearchTimeout()
 		FScopeLock ScopeLock(&SessionLock);
 		for (int32 SessionIdx = 0; SessionIdx < Sessions.Num(); SessionIdx++)
 		{
-			FNamedOnlineSession& Session = Sessions[SessionIdx];
+			FNamedOnlineSession& Session = *Sessions[SessionIdx];
 			if (Session.SessionSettings.bShouldAdvertise &&
 				Session.SessionSettings.bIsLANMatch &&
 				EOSSubsystem->IsServer())
@@ -2206,17 +2850,19 @@ void FOnlineSessionEOS::OnLANSearchTimeout()
 		LANSession->StopLANSession();
 	}
 
-	if (CurrentSessionSearch.IsValid())
+	if (CurrentLANSessionSearch.IsValid())
 	{
-		if (CurrentSessionSearch->SearchResults.Num() > 0)
+		if (CurrentLANSessionSearch->SearchResults.Num() > 0)
 		{
 			// Allow game code to sort the servers
-			CurrentSessionSearch->SortSearchResults();
+			CurrentLANSessionSearch->SortSearchResults();
+			// Prefetch in the order the results will be shown
+			PrefetchSearchResults(*CurrentLANSessionSearch);
 		}
 
-		CurrentSessionSearch->SearchState = EOnlineAsyncTaskState::Done;
+		CurrentLANSessionSearch->SearchState = EOnlineAsyncTaskState::Done;
 
-		CurrentSessionSearch = nullptr;
+		CurrentLANSessionSearch = nullptr;
 	}
 
 	// Trigger the delegate as complete
@@ -2235,7 +2881,7 @@ void FOnlineSessionEOS::DumpSessionState()
 
 	for (int32 SessionIdx=0; SessionIdx < Sessions.Num(); SessionIdx++)
 	{
-		DumpNamedSession(&Sessions[SessionIdx]);
+		DumpNamedSession(Sessions[SessionIdx].Get());
 	}
 }
 
@@ -10,6 +10,12 @@
 #include "OnlineSubsystemEOSPackage.h"
 #include "LANBeacon.h"
 #include "OnlineSubsystemEOSTypes.h"
+#include "SessionAttributeSchemaEOS.h"
+#include "SessionSearchCacheEOS.h"
+#include "SessionPingEOS.h"
+#include "MatchmakingEOS.h"
+#include "LANSessionFormatEOS.h"
+#include "SessionPrefetchEOS.h"
 
 class FOnlineSubsystemEOS;
 
@@ -34,6 +40,97 @@ struct FSessionSearchEOS
 	}
 };
 
+/** A game setting as we last advertised it */
+struct FPublishedSessionSettingEOS
+{
+	FVariantData Data;
+	/** Attribute key owned by the attribute schema */
+	const char* Key;
+	/** Publish pass that last saw this setting, anything older was removed by the game */
+	uint32 Generation;
+};
+
+/** What we last sent to EOS for a session, so updates only carry what changed */
+struct FPublishedSessionAttributesEOS
+{
+	/** False until the fixed attributes have been sent once */
+	bool bHasFixedAttributes;
+	int32 NumPrivateConnections;
+	int32 NumPublicConnections;
+	FString OwningUserName;
+	FString OwningNetId;
+	bool bAntiCheatProtected;
+	bool bUsesStats;
+	bool bIsDedicated;
+	int32 BuildUniqueId;
+
+	TMap<FName, FPublishedSessionSettingEOS> Settings;
+	uint32 Generation;
+
+	FPublishedSessionAttributesEOS()
+		: bHasFixedAttributes(false)
+		, NumPrivateConnections(0)
+		, NumPublicConnections(0)
+		, bAntiCheatProtected(false)
+		, bUsesStats(false)
+		, bIsDedicated(false)
+		, BuildUniqueId(0)
+		, Generation(0)
+	{
+	}
+};
+
+/** A named session that can find its registered players without scanning them */
+class FNamedOnlineSessionEOS :
+	public FNamedOnlineSession
+{
+public:
+	FNamedOnlineSessionEOS(FName InSessionName, const FOnlineSessionSettings& InSessionSettings)
+		: FNamedOnlineSession(InSessionName, InSessionSettings)
+		, LANResponseNumOpenPublicConnections(0)
+		, LANResponseNumOpenPrivateConnections(0)
+		, LANResponsePort(0)
+		, LANResponseSettingsHash(0)
+	{
+	}
+
+	FNamedOnlineSessionEOS(FName InSessionName, const FOnlineSession& Session)
+		: FNamedOnlineSession(InSessionName, Session)
+		, LANResponseNumOpenPublicConnections(0)
+		, LANResponseNumOpenPrivateConnections(0)
+		, LANResponsePort(0)
+		, LANResponseSettingsHash(0)
+	{
+	}
+
+	/** @return true if the player is in RegisteredPlayers */
+	bool IsPlayerRegistered(const FUniqueNetId& PlayerId) const
+	{
+		return RegisteredPlayerIndices.Contains(FUniqueNetIdEOS(PlayerId));
+	}
+
+	/** Appends to RegisteredPlayers. @return false if the player was already registered */
+	bool AddRegisteredPlayer(const TSharedRef<const FUniqueNetId>& PlayerId);
+	/** Removes from RegisteredPlayers, keeping the order of the rest. @return false if the player wasn't registered */
+	bool RemoveRegisteredPlayer(const FUniqueNetId& PlayerId);
+
+	/** Players to send to EOS with the next batch, a player that leaves and rejoins before then cancels out */
+	TSet<EOS_ProductUserId> PendingRegistrations;
+	TSet<EOS_ProductUserId> PendingUnregistrations;
+
+	/** This session as encoded for LAN query responses, empty when it needs encoding again */
+	TArray<uint8> LANResponseBody;
+	/** What the open connections, host port and settings were when LANResponseBody was encoded */
+	int32 LANResponseNumOpenPublicConnections;
+	int32 LANResponseNumOpenPrivateConnections;
+	int32 LANResponsePort;
+	uint32 LANResponseSettingsHash;
+
+private:
+	/** Where each player is in RegisteredPlayers, keyed by net id so lookups match the way ids compare */
+	TMap<FUniqueNetIdEOS, int32> RegisteredPlayerIndices;
+};
+
 /**
  * Interface for interacting with EOS sessions
  */
@@ -47,27 +144,33 @@ public:
 	virtual TSharedPtr<const FUniqueNetId> CreateSessionIdFromString(const FString& SessionIdStr) override;
 
 	FNamedOnlineSession* GetNamedSession(FName SessionName) override
+	{
+		return GetNamedSessionEOS(SessionName);
+	}
+
+	FNamedOnlineSessionEOS* GetNamedSessionEOS(FName SessionName)
 	{
 		FScopeLock ScopeLock(&SessionLock);
-		for (int32 SearchIndex = 0; SearchIndex < Sessions.Num(); SearchIndex++)
-		{
-			if (Sessions[SearchIndex].SessionName == SessionName)
-			{
-				return &Sessions[SearchIndex];
-			}
-		}
-		return nullptr;
+		const int32* SessionIndex = SessionIndices.Find(SessionName);
+		return SessionIndex != nullptr ? Sessions[*SessionIndex].Get() : nullptr;
 	}
 
 	virtual void RemoveNamedSession(FName SessionName) override
 	{
 		FScopeLock ScopeLock(&SessionLock);
-		for (int32 SearchIndex = 0; SearchIndex < Sessions.Num(); SearchIndex++)
+		int32 SessionIndex = INDEX_NONE;
+		if (SessionIndices.RemoveAndCopyValue(SessionName, SessionIndex))
 		{
-			if (Sessions[SearchIndex].SessionName == SessionName)
+			Sessions.RemoveAtSwap(SessionIndex);
+			if (SessionIndex < Sessions.Num())
+			{
+				// Point the name of the session that was swapped into the gap at its new slot
+				SessionIndices[Sessions[SessionIndex]->SessionName] = SessionIndex;
+			}
+			PublishedAttributes.Remove(SessionName);
+			if (SessionPing.IsValid())
 			{
-				Sessions.RemoveAtSwap(SearchIndex);
-				return;
+				SessionPing->RemoveResponder(SessionName);
 			}
 		}
 	}
@@ -75,23 +178,16 @@ public:
 	virtual EOnlineSessionState::Type GetSessionState(FName SessionName) const override
 	{
 		FScopeLock ScopeLock(&SessionLock);
-		for (int32 SearchIndex = 0; SearchIndex < Sessions.Num(); SearchIndex++)
-		{
-			if (Sessions[SearchIndex].SessionName == SessionName)
-			{
-				return Sessions[SearchIndex].SessionState;
-			}
-		}
-
-		return EOnlineSessionState::NoSession;
+		const int32* SessionIndex = SessionIndices.Find(SessionName);
+		return SessionIndex != nullptr ? Sessions[*SessionIndex]->SessionState : EOnlineSessionState::NoSession;
 	}
 
 	virtual bool HasPresenceSession() override
 	{
 		FScopeLock ScopeLock(&SessionLock);
-		for (int32 SearchIndex = 0; SearchIndex < Sessions.Num(); SearchIndex++)
+		for (const TUniquePtr<FNamedOnlineSessionEOS>& Session : Sessions)
 		{
-			if (Sessions[SearchIndex].SessionSettings.bUsesPresence)
+			if (Session->SessionSettings.bUsesPresence)
 			{
 				return true;
 			}
@@ -142,22 +238,73 @@ PACKAGE_SCOPE:
 	/** Critical sections for thread safe operation of session lists */
 	mutable FCriticalSection SessionLock;
 
-	/** Current session settings */
-	TArray<FNamedOnlineSession> Sessions;
+	/** Current session settings, allocated one by one so pointers to a session survive others being added */
+	TArray<TUniquePtr<FNamedOnlineSessionEOS>> Sessions;
+	/** Where each named session is in Sessions */
+	TMap<FName, int32> SessionIndices;
 
-	/** Current search object */
-	TSharedPtr<FOnlineSessionSearch> CurrentSessionSearch;
+	/** Online searches waiting on EOS, each one completes on its own */
+	TArray<TSharedRef<FOnlineSessionSearch>> ActiveSessionSearches;
 
-	/** Current search start time. */
+	/** Current LAN search object, there is only one beacon so only one LAN search at a time */
+	TSharedPtr<FOnlineSessionSearch> CurrentLANSessionSearch;
+
+	/** Current LAN search start time. */
 	double SessionSearchStartInSeconds;
 
+	/** How many online searches can be in flight at once */
+	int32 MaxActiveSessionSearches;
+
+	/** Client nonces of LAN queries waiting for the next response broadcast */
+	TArray<uint64> PendingLANQueryNonces;
+	/** Responses for the sessions we advertised last time, rebuilt only when one of those sessions changes */
+	TArray<TArray<uint8>> LANResponsePayloads;
+	/** The sessions LANResponsePayloads were built from, in order */
+	TArray<FName> LANResponseSessionNames;
+	/** When we last broadcast responses to LAN queries */
+	double LastLANResponseTime;
+	/** Seconds between response broadcasts, queries that arrive in between are answered together */
+	float LANResponseInterval;
+	/** Most clients answered per broadcast, the rest wait for the next one */
+	int32 MaxLANResponsesPerInterval;
+
 	FOnlineSessionEOS(FOnlineSubsystemEOS* InSubsystem)
-		: CurrentSessionSearch(nullptr)
+		: CurrentLANSessionSearch(nullptr)
 		, SessionSearchStartInSeconds(0)
+		, MaxActiveSessionSearches(8)
+		, LastLANResponseTime(0.0)
+		, LANResponseInterval(0.1f)
+		, MaxLANResponsesPerInterval(32)
 		, EOSSubsystem(InSubsystem)
+		, SessionInviteAcceptedId(EOS_INVALID_NOTIFICATIONID)
+		, SessionInviteAcceptedCallback(nullptr)
 	{
 	}
 
+	/**
+	 * Cancels one search without touching any others that are running, e.g. the slower queries of a fan out
+	 *
+	 * @return true if the search was in progress
+	 */
+	bool CancelFindSessions(const TSharedRef<FOnlineSessionSearch>& SearchSettings);
+
+	/**
+	 * Measures the latency to every P2P hosted result of a search, OnPingSearchResultsComplete fires once they all finish
+	 *
+	 * @return false if there was nothing to ping
+	 */
+	bool PingSearchResults(const TSharedRef<FOnlineSessionSearch>& SearchSettings);
+
+	/**
+	 * Same as above but reports to the caller instead of the OnPingSearchResultsComplete delegates
+	 *
+	 * @return false if there was nothing to ping, OnComplete is not called
+	 */
+	bool PingSearchResults(const TSharedRef<FOnlineSessionSearch>& SearchSettings, TFunction<void(bool bAnyAnswered)>&& OnComplete);
+
+	/** Orders results by measured ping, lowest first, keeping the backend order for equal pings */
+	static void SortSearchResultsByPing(FOnlineSessionSearch& SearchSettings);
+
 	/**
 	 * Session tick for various background tasks
 	 */
@@ -166,14 +313,26 @@ PACKAGE_SCOPE:
 	// IOnlineSession
 	class FNamedOnlineSession* AddNamedSession(FName SessionName, const FOnlineSessionSettings& SessionSettings) override
 	{
-		FScopeLock ScopeLock(&SessionLock);
-		return new (Sessions) FNamedOnlineSession(SessionName, SessionSettings);
+		return AddNamedSession(MakeUnique<FNamedOnlineSessionEOS>(SessionName, SessionSettings));
 	}
 
 	class FNamedOnlineSession* AddNamedSession(FName SessionName, const FOnlineSession& Session) override
+	{
+		return AddNamedSession(MakeUnique<FNamedOnlineSessionEOS>(SessionName, Session));
+	}
+
+	/** Takes ownership of a new session, callers check the name is free first */
+	class FNamedOnlineSession* AddNamedSession(TUniquePtr<FNamedOnlineSessionEOS>&& NewSession)
 	{
 		FScopeLock ScopeLock(&SessionLock);
-		return new (Sessions) FNamedOnlineSession(SessionName, Session);
+		const FName SessionName = NewSession->SessionName;
+		if (const int32* ExistingIndex = SessionIndices.Find(SessionName))
+		{
+			ensureMsgf(false, TEXT("Session (%s) already exists"), *SessionName.ToString());
+			return Sessions[*ExistingIndex].Get();
+		}
+		SessionIndices.Add(SessionName, Sessions.Num());
+		return Sessions.Add_GetRef(MoveTemp(NewSession)).Get();
 	}
 
 	void CheckPendingSessionInvite();
@@ -182,6 +341,9 @@ PACKAGE_SCOPE:
 
 	void Init(const char* InBucketId);
 
+	/** Releases anything that has to go before the EOS platform does */
+	void Shutdown();
+
 private:
 	uint32 CreateEOSSession(int32 HostingPlayerNum, FNamedOnlineSession* Session);
 	uint32 JoinEOSSession(int32 PlayerNum, FNamedOnlineSession* Session, const FOnlineSession* SearchSession);
@@ -189,7 +351,8 @@ private:
 	uint32 UpdateEOSSession(FNamedOnlineSession* Session, FOnlineSessionSettings& UpdatedSessionSettings);
 	uint32 EndEOSSession(FNamedOnlineSession* Session);
 	uint32 DestroyEOSSession(FNamedOnlineSession* Session, const FOnDestroySessionCompleteDelegate& CompletionDelegate);
-	uint32 FindEOSSession(int32 SearchingPlayerNum, const TSharedRef<FOnlineSessionSearch>& SearchSettings);
+	uint32 FindCachedEOSSession(int32 SearchingPlayerNum, const TSharedRef<FOnlineSessionSearch>& SearchSettings);
+	uint32 FindEOSSession(int32 SearchingPlayerNum, const TSharedRef<FOnlineSessionSearch>& SearchSettings, const FString& CacheKey, bool bIsCacheRefresh);
 	bool SendSessionInvite(FName SessionName, EOS_ProductUserId SenderId, EOS_ProductUserId ReceiverId);
 
 	void BeginSessionAnalytics(FNamedOnlineSession* Session);
@@ -202,32 +365,61 @@ private:
 
 	void SetPermissionLevel(EOS_HSessionModification SessionModHandle, FNamedOnlineSession* Session);
 	void SetJoinInProgress(EOS_HSessionModification SessionModHandle, FNamedOnlineSession* Session);
-	void AddAttribute(EOS_HSessionModification SessionModHandle, const EOS_Sessions_AttributeData* Attribute);
+	bool AddAttribute(EOS_HSessionModification SessionModHandle, const EOS_Sessions_AttributeData* Attribute);
+	bool RemoveAttribute(EOS_HSessionModification SessionModHandle, const char* Key);
 	void SetAttributes(EOS_HSessionModification SessionModHandle, FNamedOnlineSession* Session);
 	uint32 SharedSessionUpdate(EOS_HSessionModification SessionModHandle, FNamedOnlineSession* Session, FUpdateSessionCallback* Callback);
 
 	void TickLanTasks(float DeltaTime);
+	/** Advances matchmaking and fires OnMatchmakingComplete for any that finished */
+	void TickMatchmaking(float DeltaTime);
+	/** Queues a player for the next register or unregister batch of a session we host */
+	void QueuePlayerRegistration(FNamedOnlineSessionEOS& Session, const FUniqueNetId& PlayerId, bool bIsRegistering);
+	/** Sends every session's queued players to EOS, one call per session and direction */
+	void FlushPlayerRegistrations();
 	uint32 CreateLANSession(int32 HostingPlayerNum, FNamedOnlineSession* Session);
 	uint32 JoinLANSession(int32 PlayerNum, class FNamedOnlineSession* Session, const class FOnlineSession* SearchSession);
 	uint32 FindLANSession();
 
-	void AppendSessionToPacket(class FNboSerializeToBufferEOS& Packet, class FOnlineSession* Session);
-	void AppendSessionSettingsToPacket(class FNboSerializeToBufferEOS& Packet, FOnlineSessionSettings* SessionSettings);
-	void ReadSessionFromPacket(class FNboSerializeFromBufferEOS& Packet, class FOnlineSession* Session);
-	void ReadSettingsFromPacket(class FNboSerializeFromBufferEOS& Packet, FOnlineSessionSettings& SessionSettings);
 	void OnValidQueryPacketReceived(uint8* PacketData, int32 PacketLength, uint64 ClientNonce);
+	/** Answers the queued LAN queries, re-encoding only the sessions that changed since the last time */
+	void SendLANQueryResponses();
 	void OnValidResponsePacketReceived(uint8* PacketData, int32 PacketLength);
 	void OnLANSearchTimeout();
 	static void SetPortFromNetDriver(const FOnlineSubsystemEOS& Subsystem, const TSharedPtr<FOnlineSessionInfo>& SessionInfo);
 	bool IsHost(const FNamedOnlineSession& Session) const;
+	/** @return the host's game address if the result is hosted over P2P */
+	const FInternetAddrEOS* GetP2PHostAddress(const FOnlineSessionSearchResult& SearchResult) const;
+	/** @return the host's product user id if the result can be pinged over P2P */
+	EOS_ProductUserId GetPingableHostId(const FOnlineSessionSearchResult& SearchResult) const;
+	/** Remembers a search that has results so PingSearchResults can write back to it */
+	void AddPingableSearch(const TSharedRef<FOnlineSessionSearch>& SearchSettings);
+	/** Gets the top results of a finished search ready to join, if prefetching is on */
+	void PrefetchSearchResults(FOnlineSessionSearch& SearchSettings);
 
 	/** Reference to the main EOS subsystem */
 	FOnlineSubsystemEOS* EOSSubsystem;
 
 	/** Handles advertising sessions over LAN and client searches */
 	TSharedPtr<FLANSession> LANSession;
-	/** EOS handle wrapper to hold onto it for scope of the search */
-	TSharedPtr<FSessionSearchEOS> CurrentSearchHandle;
+	/** Encodes our LAN sessions into beacon responses and reads other hosts' back */
+	FLANSessionFormatEOS LANSessionFormat;
+	/** Maps attribute keys to session fields when reading results and builds the keys for game settings */
+	FSessionAttributeSchemaEOS AttributeSchema;
+	/** Last attributes sent per named session, cleared when an update fails so the next one resends everything */
+	TMap<FName, FPublishedSessionAttributesEOS> PublishedAttributes;
+	/** Recent online search results so repeated searches don't always go to the backend */
+	FSessionSearchCacheEOS SearchCache;
+	/** Answers latency probes for sessions we host and sends our own, null when there is no EOS socket subsystem */
+	TUniquePtr<FSessionPingEOS> SessionPing;
+	/** Searches that handed out results, so a single result can be found again to write its ping */
+	TArray<TWeakPtr<FOnlineSessionSearch>> PingableSessionSearches;
+	/** Prepares joins for the top search results, null when there is no EOS socket subsystem */
+	TUniquePtr<FSessionPrefetchEOS> SessionPrefetch;
+	/** Matchmaking tunables shared by every StartMatchmaking call */
+	FMatchmakingSettingsEOS MatchmakingSettings;
+	/** StartMatchmaking calls in progress by session name, finished ones are removed from Tick */
+	TMap<FName, TUniquePtr<FMatchmakingEOS>> ActiveMatchmaking;
 
 	/** Notification state for SDK events */
 	EOS_NotificationId SessionInviteAcceptedId;
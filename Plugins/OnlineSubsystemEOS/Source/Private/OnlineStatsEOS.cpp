@@ -130,7 +130,7 @@ void FOnlineStatsEOS::QueryStats(const TSharedRef<const FUniqueNetId> LocalUserI
 	for (TSharedRef<const FUniqueNetId> StatUserId : StatUsers)
 	{
 		FUniqueNetIdEOS EOSId(*StatUserId);
-		EOS_ProductUserId UserId = EOS_ProductUserId_FromString(TCHAR_TO_UTF8(*EOSId.ProductUserIdStr));
+		EOS_ProductUserId UserId = EOSId.GetProductUserId();
 		if (UserId == nullptr)
 		{
 			continue;
@@ -144,7 +144,7 @@ void FOnlineStatsEOS::QueryStats(const TSharedRef<const FUniqueNetId> LocalUserI
 	for (TSharedRef<const FUniqueNetId> StatUserId : StatUsers)
 	{
 		FUniqueNetIdEOS EOSId(*StatUserId);
-		EOS_ProductUserId UserId = EOS_ProductUserId_FromString(TCHAR_TO_UTF8(*EOSId.ProductUserIdStr));
+		EOS_ProductUserId UserId = EOSId.GetProductUserId();
 		if (UserId == nullptr)
 		{
 			continue;
@@ -322,11 +322,11 @@ void FOnlineStatsEOS::WriteStats(EOS_ProductUserId UserId, const FOnlineStatsUse
 void FOnlineStatsEOS::UpdateStats(const TSharedRef<const FUniqueNetId> LocalUserId, const TArray<FOnlineStatsUserUpdatedStats>& UpdatedUserStats, const FOnlineStatsUpdateStatsComplete& Delegate)
 {
 	FUniqueNetIdEOS EOSId(*LocalUserId);
-	// The code may be writing stats from a dedicated server, so rebuild the ID from a string
-	EOS_ProductUserId UserId = EOS_ProductUserId_FromString(TCHAR_TO_UTF8(*EOSId.ProductUserIdStr));
+	// The code may be writing stats from a dedicated server, so use the id parsed from the string
+	EOS_ProductUserId UserId = EOSId.GetProductUserId();
 	if (UserId == NULL)
 	{
-		UE_LOG_ONLINE_STATS(Error, TEXT("UpdateStats() failed for unknown player (%s)"), *EOSId.UniqueNetIdStr);
+		UE_LOG_ONLINE_STATS(Error, TEXT("UpdateStats() failed for unknown player (%s)"), *EOSId.GetNetIdStr());
 		Delegate.ExecuteIfBound(FOnlineError(EOnlineErrorResult::InvalidCreds));
 		return;
 	}
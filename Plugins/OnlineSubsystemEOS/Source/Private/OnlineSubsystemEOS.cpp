@@ -9,6 +9,9 @@
 #include "OnlineStoreEOS.h"
 #include "Interfaces/IPluginManager.h"
 #include "Misc/NetworkVersion.h"
+#include "Misc/ScopeLock.h"
+#include "P2PLoopbackEOS.h"
+#include "BenchEOS.h"
 
 #if PLATFORM_ANDROID
 #include "Android/eos_android.h"
@@ -19,6 +22,35 @@
 
 
 DECLARE_CYCLE_STAT(TEXT("Tick"), STAT_EOS_Tick, STATGROUP_EOS);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Callbacks Live"), STAT_EOS_CallbacksLive, STATGROUP_EOS);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Callback Pool Hits"), STAT_EOS_CallbackPoolHits, STATGROUP_EOS);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Callback Pool Misses"), STAT_EOS_CallbackPoolMisses, STATGROUP_EOS);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Callback Captures On Heap"), STAT_EOS_CallbackCapturesOnHeap, STATGROUP_EOS);
+
+#if WITH_EOS_SDK
+void FEOSCallbackPoolStats::OnAllocate(bool bWasPoolHit)
+{
+    INC_DWORD_STAT(STAT_EOS_CallbacksLive);
+    if (bWasPoolHit)
+    {
+        INC_DWORD_STAT(STAT_EOS_CallbackPoolHits);
+    }
+    else
+    {
+        INC_DWORD_STAT(STAT_EOS_CallbackPoolMisses);
+    }
+}
+
+void FEOSCallbackPoolStats::OnFree()
+{
+    DEC_DWORD_STAT(STAT_EOS_CallbacksLive);
+}
+
+void FEOSCallbackPoolStats::OnCaptureSpilled()
+{
+    INC_DWORD_STAT(STAT_EOS_CallbackCapturesOnHeap);
+}
+#endif
 
 
 #if WITH_EOS_SDK
@@ -371,6 +403,16 @@ bool FOnlineSubsystemEOS::Shutdown()
 
     FOnlineSubsystemImpl::Shutdown();
 
+    // The P2P I/O thread must not outlive the platform it is calling into
+    if (SessionInterfacePtr.IsValid())
+    {
+        SessionInterfacePtr->Shutdown();
+    }
+    if (SocketSubsystem.IsValid())
+    {
+        SocketSubsystem->StopP2PIoThread();
+    }
+
 #if !WITH_EDITOR
 	EOS_EResult ShutdownResult = EOS_Shutdown();
 	if (ShutdownResult != EOS_EResult::EOS_Success)
@@ -407,13 +449,23 @@ bool FOnlineSubsystemEOS::Tick(float DeltaTime)
     }
     {
         FScopeCycleCounter Scope(GET_STATID(STAT_EOS_Tick), true);
+        // P2P notifications fired from in here take the P2P lock for themselves, so the I/O thread isn't held up by the rest
         EOS_Platform_Tick(EOSPlatformHandle);
+        if (FP2PLoopbackEOS* Loopback = FP2PLoopbackEOS::Get())
+        {
+            // The loopback transport delivers its packets here, which the I/O thread can't be receiving at the same time
+            FScopeLock P2PScopeLock(&SocketSubsystem->GetP2PLock());
+            Loopback->Tick(DeltaTime);
+        }
     }
+    // Let anyone blocked on a socket know that data arrived during the tick
+    SocketSubsystem->SignalReadableSockets();
     if (!FOnlineSubsystemImpl::Tick(DeltaTime))
     {
         return false;
     }
     SessionInterfacePtr->Tick(DeltaTime);
+    UserManager->Tick(DeltaTime);
 
     return true;
 }
@@ -432,6 +484,12 @@ bool FOnlineSubsystemEOS::Exec(UWorld* InWorld, const TCHAR* Cmd, FOutputDevice&
         {
             bWasHandled = StoreInterfacePtr->HandleEcomExec(InWorld, Cmd, Ar);
         }
+#if !UE_BUILD_SHIPPING
+        else if (SocketSubsystem.IsValid() && FParse::Command(&Cmd, TEXT("BENCH")))
+        {
+            bWasHandled = FBenchEOS::HandleExec(*SocketSubsystem, Cmd, Ar);
+        }
+#endif
     }
     return bWasHandled;
 }
@@ -0,0 +1,246 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "OnlineSubsystemEOSTypes.h"
+#include "OnlineSubsystemEOS.h"
+#include "Misc/ScopeLock.h"
+
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Net Ids Interned"), STAT_EOS_NetIdsInterned, STATGROUP_EOS);
+
+/** Each account id is 32 hex digits */
+#define EOS_ACCOUNT_ID_HEX_LENGTH (EOS_NET_ID_BYTE_SIZE)
+#define EOS_ACCOUNT_ID_BYTE_SIZE (EOS_NET_ID_BYTE_SIZE / 2)
+
+namespace
+{
+	/** Case sensitive string keys, so every entry keeps the exact string it was made from for ToString() */
+	struct FNetIdEntryKeyFuncs :
+		public TDefaultMapKeyFuncs<FString, TWeakPtr<const FUniqueNetIdEOSEntry, ESPMode::ThreadSafe>, false>
+	{
+		static FORCEINLINE bool Matches(const FString& A, const FString& B)
+		{
+			return A.Equals(B, ESearchCase::CaseSensitive);
+		}
+
+		static FORCEINLINE uint32 GetKeyHash(const FString& Key)
+		{
+			return FCrc::StrCrc32(*Key);
+		}
+	};
+
+	typedef TMap<FString, TWeakPtr<const FUniqueNetIdEOSEntry, ESPMode::ThreadSafe>, FDefaultSetAllocator, FNetIdEntryKeyFuncs> FNetIdEntryMap;
+
+	/** Fewest entries before the map is checked for expired ones */
+	const int32 MinPruneThreshold = 256;
+
+	struct FNetIdRegistryState
+	{
+		FCriticalSection Lock;
+		FNetIdEntryMap Entries;
+		/** Expired entries are removed when the map grows past this */
+		int32 PruneThreshold;
+
+		FNetIdRegistryState()
+			: PruneThreshold(MinPruneThreshold)
+		{
+		}
+	};
+
+	FNetIdRegistryState& GetRegistryState()
+	{
+		static FNetIdRegistryState State;
+		return State;
+	}
+
+	int32 HexDigitValue(TCHAR Char)
+	{
+		if (Char >= TEXT('0') && Char <= TEXT('9'))
+		{
+			return Char - TEXT('0');
+		}
+		if (Char >= TEXT('a') && Char <= TEXT('f'))
+		{
+			return Char - TEXT('a') + 10;
+		}
+		// Ids differing only by case are the same id, so they have to pack to the same bytes
+		if (Char >= TEXT('A') && Char <= TEXT('F'))
+		{
+			return Char - TEXT('A') + 10;
+		}
+		return INDEX_NONE;
+	}
+
+	/** @return true if the string is an account id and was packed, an empty string packs as zeros */
+	bool PackAccountId(const FString& IdStr, uint8* OutBytes)
+	{
+		FMemory::Memzero(OutBytes, EOS_ACCOUNT_ID_BYTE_SIZE);
+		if (IdStr.IsEmpty())
+		{
+			return true;
+		}
+		if (IdStr.Len() != EOS_ACCOUNT_ID_HEX_LENGTH)
+		{
+			return false;
+		}
+		bool bAnyNonZero = false;
+		for (int32 Index = 0; Index < EOS_ACCOUNT_ID_BYTE_SIZE; Index++)
+		{
+			const int32 High = HexDigitValue(IdStr[Index * 2]);
+			const int32 Low = HexDigitValue(IdStr[Index * 2 + 1]);
+			if (High == INDEX_NONE || Low == INDEX_NONE)
+			{
+				return false;
+			}
+			OutBytes[Index] = (uint8)((High << 4) | Low);
+			bAnyNonZero |= OutBytes[Index] != 0;
+		}
+		// All zeros means a missing id in the binary form
+		return bAnyNonZero;
+	}
+
+	/** @return the hex string of a packed account id, empty for zeros */
+	FString UnpackAccountId(const uint8* Bytes)
+	{
+		static const TCHAR HexDigits[] = TEXT("0123456789abcdef");
+
+		bool bAnyNonZero = false;
+		for (int32 Index = 0; Index < EOS_ACCOUNT_ID_BYTE_SIZE && !bAnyNonZero; Index++)
+		{
+			bAnyNonZero = Bytes[Index] != 0;
+		}
+		FString IdStr;
+		if (bAnyNonZero)
+		{
+			IdStr.Reserve(EOS_ACCOUNT_ID_HEX_LENGTH);
+			for (int32 Index = 0; Index < EOS_ACCOUNT_ID_BYTE_SIZE; Index++)
+			{
+				IdStr.AppendChar(HexDigits[Bytes[Index] >> 4]);
+				IdStr.AppendChar(HexDigits[Bytes[Index] & 0xF]);
+			}
+		}
+		return IdStr;
+	}
+
+	/** Builds the net id string the way MakeNetIdStringFromIds() does */
+	FString MakeNetIdStr(const FString& EpicAccountIdStr, const FString& ProductUserIdStr)
+	{
+		FString NetIdStr = EpicAccountIdStr;
+		if (!ProductUserIdStr.IsEmpty())
+		{
+			NetIdStr += EOS_ID_SEPARATOR;
+			NetIdStr += ProductUserIdStr;
+		}
+		return NetIdStr;
+	}
+
+	FUniqueNetIdEOSEntry* CreateEntry(const FString& NetIdStr)
+	{
+		FUniqueNetIdEOSEntry* Entry = new FUniqueNetIdEOSEntry();
+		Entry->NetIdStr = NetIdStr;
+		// Ids differing only by case compare equal, so they have to hash the same
+		Entry->Hash = FCrc::StrCrc32(*NetIdStr.ToLower());
+		Entry->bHasBinaryForm = false;
+		FMemory::Memzero(Entry->Bytes, EOS_NET_ID_BYTE_SIZE);
+#if WITH_EOS_SDK
+		Entry->EpicAccountId = nullptr;
+		Entry->ProductUserId = nullptr;
+#endif
+
+		// Session ids and the like are plain strings, they keep both parts empty
+		if (!NetIdStr.Split(EOS_ID_SEPARATOR, &Entry->EpicAccountIdStr, &Entry->ProductUserIdStr))
+		{
+			Entry->EpicAccountIdStr = NetIdStr;
+		}
+
+		if (!NetIdStr.IsEmpty()
+			&& PackAccountId(Entry->EpicAccountIdStr, Entry->Bytes)
+			&& PackAccountId(Entry->ProductUserIdStr, Entry->Bytes + EOS_ACCOUNT_ID_BYTE_SIZE))
+		{
+			// Only ids that come back out of the bytes unchanged, apart from case, get a binary form
+			Entry->bHasBinaryForm = MakeNetIdStr(Entry->EpicAccountIdStr, Entry->ProductUserIdStr).Equals(NetIdStr, ESearchCase::IgnoreCase);
+		}
+		if (!Entry->bHasBinaryForm)
+		{
+			Entry->BytesStr = NetIdStr.ToLower();
+		}
+
+#if WITH_EOS_SDK
+		if (Entry->bHasBinaryForm)
+		{
+			if (!Entry->EpicAccountIdStr.IsEmpty())
+			{
+				Entry->EpicAccountId = EOS_EpicAccountId_FromString(TCHAR_TO_UTF8(*Entry->EpicAccountIdStr));
+			}
+			if (!Entry->ProductUserIdStr.IsEmpty())
+			{
+				Entry->ProductUserId = EOS_ProductUserId_FromString(TCHAR_TO_UTF8(*Entry->ProductUserIdStr));
+			}
+		}
+#endif
+		INC_DWORD_STAT(STAT_EOS_NetIdsInterned);
+		return Entry;
+	}
+}
+
+FUniqueNetIdEOSEntryRef FUniqueNetIdEOSRegistry::FindOrAdd(const FString& NetIdStr)
+{
+	if (NetIdStr.IsEmpty())
+	{
+		return GetEmpty();
+	}
+
+	FNetIdRegistryState& State = GetRegistryState();
+	FScopeLock ScopeLock(&State.Lock);
+
+	TWeakPtr<const FUniqueNetIdEOSEntry, ESPMode::ThreadSafe>& WeakEntry = State.Entries.FindOrAdd(NetIdStr);
+	FUniqueNetIdEOSEntryPtr Entry = WeakEntry.Pin();
+	if (Entry.IsValid())
+	{
+		return Entry.ToSharedRef();
+	}
+
+	FUniqueNetIdEOSEntryRef NewEntry = MakeShareable(CreateEntry(NetIdStr));
+	WeakEntry = NewEntry;
+
+	if (State.Entries.Num() > State.PruneThreshold)
+	{
+		for (FNetIdEntryMap::TIterator It(State.Entries); It; ++It)
+		{
+			if (!It.Value().IsValid())
+			{
+				It.RemoveCurrent();
+			}
+		}
+		State.Entries.Compact();
+		State.PruneThreshold = FMath::Max(State.Entries.Num() * 2, MinPruneThreshold);
+	}
+	return NewEntry;
+}
+
+FUniqueNetIdEOSEntryPtr FUniqueNetIdEOSRegistry::FindOrAdd(const uint8* Bytes, int32 Size)
+{
+	if (Bytes == nullptr || Size != EOS_NET_ID_BYTE_SIZE)
+	{
+		return nullptr;
+	}
+
+	const FString NetIdStr = MakeNetIdStr(UnpackAccountId(Bytes), UnpackAccountId(Bytes + EOS_ACCOUNT_ID_BYTE_SIZE));
+	if (NetIdStr.IsEmpty())
+	{
+		return nullptr;
+	}
+	FUniqueNetIdEOSEntryRef Entry = FindOrAdd(NetIdStr);
+	return Entry->bHasBinaryForm ? FUniqueNetIdEOSEntryPtr(Entry) : nullptr;
+}
+
+const FUniqueNetIdEOSEntryRef& FUniqueNetIdEOSRegistry::GetEmpty()
+{
+	static const FUniqueNetIdEOSEntryRef EmptyEntry = MakeShareable(CreateEntry(FString()));
+	return EmptyEntry;
+}
+
+int32 FUniqueNetIdEOSRegistry::Num()
+{
+	FNetIdRegistryState& State = GetRegistryState();
+	FScopeLock ScopeLock(&State.Lock);
+	return State.Entries.Num();
+}
@@ -11,6 +11,8 @@
 #include "Interfaces/OnlineUserInterface.h"
 
 #include "OnlineSubsystemEOSPackage.h"
+#include "Containers/LockFreeFixedSizeAllocator.h"
+#include "HAL/ThreadSafeCounter.h"
 
 #if WITH_EOS_SDK
 	#include "eos_common.h"
@@ -28,40 +30,91 @@ typedef TSharedRef<const FUniqueNetId> FUniqueNetIdRef;
 
 #define EOS_ID_SEPARATOR TEXT("|")
 
+/** Size of the binary form of an EOS net id, both account ids as 16 raw bytes each */
+#define EOS_NET_ID_BYTE_SIZE 32
+
+/**
+ * One interned net id string. Every FUniqueNetIdEOS with the same string shares the entry, and entries don't
+ * change once created, so ids hash with the value stored here and mostly compare by entry. Strings that differ
+ * only by case get their own entries but are still the same id
+ */
+struct FUniqueNetIdEOSEntry
+{
+	FString NetIdStr;
+	FString EpicAccountIdStr;
+	FString ProductUserIdStr;
+	/** Case insensitive hash of NetIdStr */
+	uint32 Hash;
+	/** Whether the account ids are hex and packed into Bytes, other ids use BytesStr as their bytes */
+	bool bHasBinaryForm;
+	/** Both account ids packed from their hex digits, zeros for a missing one */
+	uint8 Bytes[EOS_NET_ID_BYTE_SIZE];
+	/** Lower case NetIdStr for ids without a binary form, so ids differing only by case have the same bytes */
+	FString BytesStr;
+#if WITH_EOS_SDK
+	/** Parsed from the strings when the entry has a binary form, null otherwise */
+	EOS_EpicAccountId EpicAccountId;
+	EOS_ProductUserId ProductUserId;
+#endif
+};
+
+typedef TSharedRef<const FUniqueNetIdEOSEntry, ESPMode::ThreadSafe> FUniqueNetIdEOSEntryRef;
+typedef TSharedPtr<const FUniqueNetIdEOSEntry, ESPMode::ThreadSafe> FUniqueNetIdEOSEntryPtr;
+
+/**
+ * The global table of net id entries. Entries go away with the last id using them, safe to use from any thread
+ */
+class FUniqueNetIdEOSRegistry
+{
+public:
+	/** @return the entry for a net id string, created the first time the string is seen */
+	static FUniqueNetIdEOSEntryRef FindOrAdd(const FString& NetIdStr);
+	/** @return the entry for the binary form of an id, or null if the bytes aren't one */
+	static FUniqueNetIdEOSEntryPtr FindOrAdd(const uint8* Bytes, int32 Size);
+	/** @return the entry of the empty id */
+	static const FUniqueNetIdEOSEntryRef& GetEmpty();
+	/** @return the number of entries, including ones waiting to be pruned */
+	static int32 Num();
+};
+
 /**
  * Unique net id wrapper for a EOS account ids. The underlying string is a combination
  * of both account ids concatenated. "<EOS_EpicAccountId>|<EOS_ProductAccountId>"
+ *
+ * The id points at an interned entry, so copying, comparing and hashing ids never touches the strings
  */
 class FUniqueNetIdEOS :
-	public FUniqueNetIdString
+	public FUniqueNetId
 {
 public:
 	FUniqueNetIdEOS()
-		: FUniqueNetIdString()
+		: Entry(FUniqueNetIdEOSRegistry::GetEmpty())
 	{
 	}
 
 	explicit FUniqueNetIdEOS(const FString& InUniqueNetId)
-		: FUniqueNetIdString(InUniqueNetId)
+		: Entry(FUniqueNetIdEOSRegistry::FindOrAdd(InUniqueNetId))
 	{
-		ParseAccountIds();
 	}
 
 	explicit FUniqueNetIdEOS(FString&& InUniqueNetId)
-		: FUniqueNetIdString(MoveTemp(InUniqueNetId))
+		: Entry(FUniqueNetIdEOSRegistry::FindOrAdd(InUniqueNetId))
 	{
-		ParseAccountIds();
 	}
 
 	explicit FUniqueNetIdEOS(const FUniqueNetId& Src)
-		: FUniqueNetIdString(Src)
+		: Entry(Src.GetType() == GetTypeName() ? static_cast<const FUniqueNetIdEOS&>(Src).Entry : FUniqueNetIdEOSRegistry::FindOrAdd(Src.ToString()))
+	{
+	}
+
+	explicit FUniqueNetIdEOS(const FUniqueNetIdEOSEntryRef& InEntry)
+		: Entry(InEntry)
 	{
-		ParseAccountIds();
 	}
 
 	friend uint32 GetTypeHash(const FUniqueNetIdEOS& A)
 	{
-		return ::GetTypeHash(A.UniqueNetIdStr);
+		return A.Entry->Hash;
 	}
 
 	/** global static instance of invalid (zero) id */
@@ -71,35 +124,102 @@ public:
 		return EmptyId;
 	}
 
+// FUniqueNetId
 	virtual FName GetType() const override
 	{
-		static FName NAME_Eos(TEXT("EOS"));
-		return NAME_Eos;
+		return GetTypeName();
 	}
 
-PACKAGE_SCOPE:
-	void UpdateNetIdStr(const FString& InNetIdStr)
+	/** @return the packed account ids if the id has them, the lower case string's characters otherwise */
+	virtual const uint8* GetBytes() const override
 	{
-		UniqueNetIdStr = InNetIdStr;
-		ParseAccountIds();
+		return Entry->bHasBinaryForm ? Entry->Bytes : (const uint8*)*Entry->BytesStr;
 	}
 
-	void ParseAccountIds()
+	virtual int32 GetSize() const override
 	{
-		TArray<FString> AccountIds;
-		UniqueNetIdStr.ParseIntoArray(AccountIds, EOS_ID_SEPARATOR, false);
-		if (AccountIds.Num() > 0)
+		return Entry->bHasBinaryForm ? EOS_NET_ID_BYTE_SIZE : Entry->BytesStr.Len() * sizeof(TCHAR);
+	}
+
+	virtual bool IsValid() const override
+	{
+		return !Entry->NetIdStr.IsEmpty();
+	}
+
+	virtual FString ToString() const override
+	{
+		return Entry->NetIdStr;
+	}
+
+	virtual FString ToDebugString() const override
+	{
+		if (IsValid())
 		{
-			EpicAccountIdStr = AccountIds[0];
+			return OSS_UNIQUEID_REDACT(*this, Entry->NetIdStr);
 		}
-		if (AccountIds.Num() > 1)
+		return TEXT("INVALID");
+	}
+
+protected:
+	virtual bool Compare(const FUniqueNetId& Other) const override
+	{
+		if (Other.GetType() == GetTypeName())
 		{
-			ProductUserIdStr = AccountIds[1];
+			const FUniqueNetIdEOSEntryRef& OtherEntry = static_cast<const FUniqueNetIdEOS&>(Other).Entry;
+			return Entry == OtherEntry || (Entry->Hash == OtherEntry->Hash && Entry->NetIdStr.Equals(OtherEntry->NetIdStr, ESearchCase::IgnoreCase));
 		}
+		return FUniqueNetId::Compare(Other);
 	}
+// ~FUniqueNetId
 
-	FString EpicAccountIdStr;
-	FString ProductUserIdStr;
+PACKAGE_SCOPE:
+	/** Points the id at another string, used when a user's product user id becomes known */
+	void UpdateNetIdStr(const FString& InNetIdStr)
+	{
+		Entry = FUniqueNetIdEOSRegistry::FindOrAdd(InNetIdStr);
+	}
+
+	/** The whole id string, without the copy ToString() makes */
+	const FString& GetNetIdStr() const
+	{
+		return Entry->NetIdStr;
+	}
+
+	const FString& GetEpicAccountIdStr() const
+	{
+		return Entry->EpicAccountIdStr;
+	}
+
+	const FString& GetProductUserIdStr() const
+	{
+		return Entry->ProductUserIdStr;
+	}
+
+#if WITH_EOS_SDK
+	EOS_EpicAccountId GetEpicAccountId() const
+	{
+		return Entry->EpicAccountId;
+	}
+
+	EOS_ProductUserId GetProductUserId() const
+	{
+		return Entry->ProductUserId;
+	}
+#endif
+
+	const FUniqueNetIdEOSEntryRef& GetEntry() const
+	{
+		return Entry;
+	}
+
+private:
+	static FName GetTypeName()
+	{
+		static FName NAME_Eos(TEXT("EOS"));
+		return NAME_Eos;
+	}
+
+	FUniqueNetIdEOSEntryRef Entry;
 };
 
 typedef TSharedPtr<FUniqueNetIdEOS> FUniqueNetIdEOSPtr;
@@ -396,6 +516,135 @@ static inline FString MakeNetIdStringFromIds(EOS_EpicAccountId AccountId, EOS_Pr
 	return NetId;
 }
 
+/** Stat hooks for the callback pools, defined next to the EOS stat group */
+struct FEOSCallbackPoolStats
+{
+	static void OnAllocate(bool bWasPoolHit);
+	static void OnFree();
+	static void OnCaptureSpilled();
+};
+
+/**
+ * Per callback type free list. Async calls come in bursts of the same kind, so once a burst has
+ * been seen the following ones are served without touching the general allocator. Only used for
+ * one shot callbacks, notification callbacks live for the whole session and gain nothing from it
+ */
+template<typename CallbackObjectType>
+class TEOSCallbackPool
+{
+public:
+	static void* Allocate()
+	{
+		FEOSCallbackPoolStats::OnAllocate(GetAllocator().GetNumFree() > 0);
+		return GetAllocator().Allocate();
+	}
+
+	static void Free(void* Ptr)
+	{
+		FEOSCallbackPoolStats::OnFree();
+		GetAllocator().Free(Ptr);
+	}
+
+private:
+	typedef TLockFreeFixedSizeAllocator<sizeof(CallbackObjectType), PLATFORM_CACHE_LINE_SIZE, FThreadSafeCounter> FAllocator;
+
+	static FAllocator& GetAllocator()
+	{
+		// Never destroyed: requests still in flight when the SDK shuts down never call back to free their
+		// callback, and the allocator checks that everything was returned when it is destroyed
+		static FAllocator* Allocator = new FAllocator();
+		return *Allocator;
+	}
+};
+
+/** Size of the in-place storage for callback captures, larger captures go to the heap */
+#define EOS_CALLBACK_INLINE_SIZE 96
+
+/**
+ * Move-only stand-in for TFunction that keeps small lambda captures inside the callback object,
+ * so a pooled callback usually needs no allocation at all
+ */
+template<typename FuncType>
+class TEOSCallbackFunction;
+
+template<typename ParamType>
+class TEOSCallbackFunction<void(ParamType)>
+{
+public:
+	TEOSCallbackFunction()
+		: Callable(nullptr)
+		, Invoker(nullptr)
+		, Destroyer(nullptr)
+	{
+	}
+
+	~TEOSCallbackFunction()
+	{
+		Reset();
+	}
+
+	TEOSCallbackFunction(const TEOSCallbackFunction&) = delete;
+	TEOSCallbackFunction& operator=(const TEOSCallbackFunction&) = delete;
+
+	template<typename FunctorType, typename = typename TEnableIf<!TIsSame<typename TDecay<FunctorType>::Type, TEOSCallbackFunction>::Value>::Type>
+	TEOSCallbackFunction& operator=(FunctorType&& Functor)
+	{
+		typedef typename TDecay<FunctorType>::Type FStoredType;
+
+		Reset();
+
+		void* Storage = &InlineStorage;
+		if (sizeof(FStoredType) > EOS_CALLBACK_INLINE_SIZE || alignof(FStoredType) > alignof(FInlineStorage))
+		{
+			FEOSCallbackPoolStats::OnCaptureSpilled();
+			Storage = FMemory::Malloc(sizeof(FStoredType), alignof(FStoredType));
+		}
+		Callable = new (Storage) FStoredType(Forward<FunctorType>(Functor));
+		Invoker = [](void* InCallable, ParamType Param)
+		{
+			(*(FStoredType*)InCallable)(Param);
+		};
+		Destroyer = [](void* InCallable)
+		{
+			((FStoredType*)InCallable)->~FStoredType();
+		};
+		return *this;
+	}
+
+	void operator()(ParamType Param) const
+	{
+		Invoker(Callable, Param);
+	}
+
+	explicit operator bool() const
+	{
+		return Callable != nullptr;
+	}
+
+	void Reset()
+	{
+		if (Callable != nullptr)
+		{
+			Destroyer(Callable);
+			if (Callable != (void*)&InlineStorage)
+			{
+				FMemory::Free(Callable);
+			}
+			Callable = nullptr;
+			Invoker = nullptr;
+			Destroyer = nullptr;
+		}
+	}
+
+private:
+	typedef TAlignedBytes<EOS_CALLBACK_INLINE_SIZE, 16> FInlineStorage;
+
+	FInlineStorage InlineStorage;
+	void* Callable;
+	void (*Invoker)(void*, ParamType);
+	void (*Destroyer)(void*);
+};
+
 /** Used to store a pointer to the EOS callback object without knowing type */
 class FCallbackBase
 {
@@ -409,7 +658,7 @@ class TEOSCallback :
 	public FCallbackBase
 {
 public:
-	TFunction<void(const CallbackType*)> CallbackLambda;
+	TEOSCallbackFunction<void(const CallbackType*)> CallbackLambda;
 
 	TEOSCallback()
 	{
@@ -417,6 +666,16 @@ public:
 	}
 	virtual ~TEOSCallback() = default;
 
+	void* operator new(size_t Size)
+	{
+		check(Size == sizeof(TEOSCallback));
+		return TEOSCallbackPool<TEOSCallback>::Allocate();
+	}
+
+	void operator delete(void* Ptr)
+	{
+		TEOSCallbackPool<TEOSCallback>::Free(Ptr);
+	}
 
 	CallbackFuncType GetCallbackPtr()
 	{
@@ -449,12 +708,11 @@ class TEOSGlobalCallback :
 	public FCallbackBase
 {
 public:
-	TFunction<void(const CallbackType*)> CallbackLambda;
+	TEOSCallbackFunction<void(const CallbackType*)> CallbackLambda;
 
 	TEOSGlobalCallback() = default;
 	virtual ~TEOSGlobalCallback() = default;
 
-
 	CallbackFuncType GetCallbackPtr()
 	{
 		return &CallbackImpl;
@@ -498,6 +756,9 @@ PACKAGE_SCOPE:
 		, SessionId(Src.SessionId)
 		, SessionHandle(Src.SessionHandle)
 		, bIsFromClone(true)
+		, PrefetchedConnectString(Src.PrefetchedConnectString)
+		, PrefetchedBeaconConnectString(Src.PrefetchedBeaconConnectString)
+		, PrefetchedBeaconPort(Src.PrefetchedBeaconPort)
 	{
 	}
 
@@ -517,6 +778,12 @@ PACKAGE_SCOPE:
 	EOS_HSessionDetails SessionHandle;
 	/** Whether we should delete this handle or not */
 	bool bIsFromClone;
+	/** Connect strings built ahead of a join by FSessionPrefetchEOS, empty if the result wasn't prefetched */
+	FString PrefetchedConnectString;
+	FString PrefetchedBeaconConnectString;
+	int32 PrefetchedBeaconPort;
+	/** Copy of HostAddr made ahead of time for the session that joins this result, handed over by the first join */
+	mutable TSharedPtr<class FInternetAddr> PrefetchedHostAddr;
 
 public:
 	virtual ~FOnlineSessionInfoEOS();
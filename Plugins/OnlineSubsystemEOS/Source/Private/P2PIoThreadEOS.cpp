@@ -0,0 +1,211 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "P2PIoThreadEOS.h"
+#include "SocketSubsystemEOS.h"
+#include "OnlineSubsystemEOS.h"
+#include "HAL/RunnableThread.h"
+#include "Misc/ScopeLock.h"
+
+#if WITH_EOS_SDK
+	#include "P2PLoopbackEOS.h"
+#endif
+
+DECLARE_CYCLE_STAT(TEXT("P2P I/O Pump"), STAT_EOS_P2PIoPump, STATGROUP_EOS);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("P2P I/O Packets Sent"), STAT_EOS_P2PIoSent, STATGROUP_EOS);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("P2P I/O Packets Received"), STAT_EOS_P2PIoReceived, STATGROUP_EOS);
+
+/** How long the worker sleeps when there was nothing to do */
+#define P2P_IO_IDLE_WAIT_MS 1
+
+FP2PIoThreadEOS::FP2PIoThreadEOS(FSocketSubsystemEOS& InSocketSubsystem, uint32 InRingSize)
+	: SocketSubsystem(InSocketSubsystem)
+	, RingSize(FMath::Max<uint32>(InRingSize, 2))
+	, Thread(nullptr)
+	, WakeEvent(nullptr)
+	, bStopRequested(false)
+{
+}
+
+FP2PIoThreadEOS::~FP2PIoThreadEOS()
+{
+	StopAndWait();
+}
+
+bool FP2PIoThreadEOS::Start()
+{
+	check(Thread == nullptr);
+
+	WakeEvent = FPlatformProcess::GetSynchEventFromPool(false);
+	Thread = FRunnableThread::Create(this, TEXT("EOSP2PIoThread"), 0, TPri_AboveNormal);
+	if (Thread == nullptr)
+	{
+		FPlatformProcess::ReturnSynchEventToPool(WakeEvent);
+		WakeEvent = nullptr;
+		return false;
+	}
+	return true;
+}
+
+void FP2PIoThreadEOS::StopAndWait()
+{
+	if (Thread != nullptr)
+	{
+		Thread->Kill(true);
+		delete Thread;
+		Thread = nullptr;
+	}
+	if (WakeEvent != nullptr)
+	{
+		FPlatformProcess::ReturnSynchEventToPool(WakeEvent);
+		WakeEvent = nullptr;
+	}
+
+	FScopeLock ScopeLock(&SocketsLock);
+	Sockets.Empty();
+}
+
+FP2PIoQueuesEOSPtr FP2PIoThreadEOS::RegisterSocket(const FInternetAddrEOS& LocalAddress)
+{
+	FP2PIoQueuesEOSPtr Queues = MakeShareable(new FP2PIoQueuesEOS(LocalAddress, RingSize));
+
+	FScopeLock ScopeLock(&SocketsLock);
+	Sockets.Add(Queues);
+	return Queues;
+}
+
+void FP2PIoThreadEOS::UnregisterSocket(const FP2PIoQueuesEOSPtr& Queues)
+{
+	FScopeLock ScopeLock(&SocketsLock);
+	Sockets.Remove(Queues);
+}
+
+void FP2PIoThreadEOS::WakeUp()
+{
+	if (WakeEvent != nullptr)
+	{
+		WakeEvent->Trigger();
+	}
+}
+
+uint32 FP2PIoThreadEOS::Run()
+{
+	while (!bStopRequested)
+	{
+		if (!Pump())
+		{
+			WakeEvent->Wait(P2P_IO_IDLE_WAIT_MS);
+		}
+	}
+	return 0;
+}
+
+void FP2PIoThreadEOS::Stop()
+{
+	bStopRequested = true;
+	WakeUp();
+}
+
+bool FP2PIoThreadEOS::Pump()
+{
+	SCOPE_CYCLE_COUNTER(STAT_EOS_P2PIoPump);
+
+	// Take our own references so sockets can unregister while we work
+	TArray<FP2PIoQueuesEOSPtr, TInlineAllocator<8>> LocalSockets;
+	{
+		FScopeLock ScopeLock(&SocketsLock);
+		LocalSockets.Append(Sockets);
+	}
+	if (LocalSockets.Num() == 0)
+	{
+		return false;
+	}
+
+	bool bDidWork = false;
+#if WITH_EOS_SDK
+	FScopeLock P2PScopeLock(&SocketSubsystem.GetP2PLock());
+
+	EOS_HP2P P2PHandle = SocketSubsystem.GetP2PHandle();
+	for (const FP2PIoQueuesEOSPtr& Queues : LocalSockets)
+	{
+		const FInternetAddrEOS& LocalAddress = Queues->LocalAddress;
+
+		// Send everything the game thread has queued
+		EOS_P2P_SocketId SocketId = { };
+		SocketId.ApiVersion = EOS_P2P_SOCKETID_API_LATEST;
+		FCStringAnsi::Strcpy(SocketId.SocketName, LocalAddress.GetSocketName());
+
+		EOS_P2P_SendPacketOptions SendOptions = { };
+		SendOptions.ApiVersion = EOS_P2P_SENDPACKET_API_LATEST;
+		SendOptions.LocalUserId = LocalAddress.GetLocalUserId();
+		SendOptions.SocketId = &SocketId;
+
+		int32 NumSent = 0;
+		while (const FP2PIoPacketEOS* Packet = Queues->Egress.Peek())
+		{
+			// Peers almost always share our socket name, so only copy it when it changes
+			if (FCStringAnsi::Stricmp(SocketId.SocketName, Packet->Address.GetSocketName()) != 0)
+			{
+				FCStringAnsi::Strcpy(SocketId.SocketName, Packet->Address.GetSocketName());
+			}
+			SendOptions.RemoteUserId = Packet->Address.GetRemoteUserId();
+			SendOptions.Channel = Packet->Address.GetChannel();
+			SendOptions.DataLengthBytes = Packet->Count;
+			SendOptions.Data = Packet->Data;
+			EOS_EResult Result = FP2PTransportEOS::SendPacket(P2PHandle, &SendOptions);
+			if (Result != EOS_EResult::EOS_Success)
+			{
+				UE_LOG(LogSocketSubsystemEOS, Error, TEXT("I/O thread unable to send data to (%s) result code = (%s)"), *Packet->Address.ToString(true), ANSI_TO_TCHAR(EOS_EResult_ToString(Result)));
+			}
+			Queues->Egress.Dequeue();
+			NumSent++;
+		}
+
+		// Receive until the SDK queue is empty or we have no room left, anything else stays queued in the SDK
+		EOS_P2P_ReceivePacketOptions RecvOptions = { };
+		RecvOptions.ApiVersion = EOS_P2P_RECEIVEPACKET_API_LATEST;
+		RecvOptions.LocalUserId = LocalAddress.GetLocalUserId();
+		RecvOptions.MaxDataSizeBytes = EOS_SOCKET_PACKET_BUFFER_SIZE;
+		const uint8 RequestedChannel = LocalAddress.GetChannel();
+		RecvOptions.RequestedChannel = &RequestedChannel;
+
+		int32 NumReceived = 0;
+		FP2PIoPacketEOS Packet;
+		while (!Queues->Ingress.IsFull())
+		{
+			EOS_ProductUserId RemoteUserId = nullptr;
+			EOS_P2P_SocketId RecvSocketId;
+			uint8 Channel = RequestedChannel;
+			uint32 BytesRead = 0;
+
+			EOS_EResult Result = FP2PTransportEOS::ReceivePacket(P2PHandle, &RecvOptions, &RemoteUserId, &RecvSocketId, &Channel, Packet.Data, &BytesRead);
+			if (Result != EOS_EResult::EOS_Success)
+			{
+				if (Result != EOS_EResult::EOS_NotFound)
+				{
+					UE_LOG(LogSocketSubsystemEOS, Error, TEXT("I/O thread unable to receive data result code = (%s)"), ANSI_TO_TCHAR(EOS_EResult_ToString(Result)));
+				}
+				break;
+			}
+
+			Packet.Count = (int32)BytesRead;
+			Packet.Address.SetLocalUserId(LocalAddress.GetLocalUserId());
+			Packet.Address.SetRemoteUserId(RemoteUserId);
+			Packet.Address.SetSocketName(RecvSocketId.SocketName);
+			Packet.Address.SetChannel(Channel);
+			// We are the only producer so there is always room after the IsFull() check
+			verify(Queues->Ingress.Enqueue(Packet));
+			NumReceived++;
+		}
+
+		if (NumReceived > 0)
+		{
+			Queues->ReadableEvent->Trigger();
+		}
+
+		INC_DWORD_STAT_BY(STAT_EOS_P2PIoSent, NumSent);
+		INC_DWORD_STAT_BY(STAT_EOS_P2PIoReceived, NumReceived);
+		bDidWork |= NumSent > 0 || NumReceived > 0;
+	}
+#endif
+	return bDidWork;
+}
@@ -0,0 +1,121 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HAL/Runnable.h"
+#include "HAL/ThreadSafeBool.h"
+#include "HAL/PlatformProcess.h"
+#include "HAL/Event.h"
+#include "Containers/CircularQueue.h"
+#include "InternetAddrEOS.h"
+
+#if WITH_EOS_SDK
+	#include "eos_p2p_types.h"
+
+	#define EOS_SOCKET_PACKET_BUFFER_SIZE EOS_P2P_MAX_PACKET_SIZE
+#else
+	#define EOS_SOCKET_PACKET_BUFFER_SIZE 1170
+#endif
+
+class FSocketSubsystemEOS;
+class FRunnableThread;
+
+/** A datagram handed between the game thread and the P2P I/O thread */
+struct FP2PIoPacketEOS
+{
+	/** The packet payload, only the first Count bytes are valid */
+	uint8 Data[EOS_SOCKET_PACKET_BUFFER_SIZE];
+	/** The number of bytes in Data */
+	int32 Count;
+	/** Destination for outgoing packets, source for incoming ones */
+	FInternetAddrEOS Address;
+
+	FP2PIoPacketEOS()
+		: Count(0)
+	{
+	}
+};
+
+/**
+ * The pair of rings a single socket uses to talk to the I/O thread. The game thread is the only
+ * producer of Egress and the only consumer of Ingress, the I/O thread is the other side of each
+ */
+class FP2PIoQueuesEOS
+{
+public:
+	FP2PIoQueuesEOS(const FInternetAddrEOS& InLocalAddress, uint32 RingSize)
+		: LocalAddress(InLocalAddress)
+		, Ingress(RingSize)
+		, Egress(RingSize)
+		, ReadableEvent(FPlatformProcess::GetSynchEventFromPool(false))
+	{
+	}
+
+	~FP2PIoQueuesEOS()
+	{
+		FPlatformProcess::ReturnSynchEventToPool(ReadableEvent);
+	}
+
+	/** Our bound address, which is fixed for the lifetime of the queues */
+	const FInternetAddrEOS LocalAddress;
+	/** Packets received by the I/O thread waiting for the game thread */
+	TCircularQueue<FP2PIoPacketEOS> Ingress;
+	/** Packets queued by the game thread waiting to be sent by the I/O thread */
+	TCircularQueue<FP2PIoPacketEOS> Egress;
+	/** Triggered by the I/O thread whenever it adds packets to Ingress */
+	FEvent* ReadableEvent;
+};
+
+typedef TSharedPtr<FP2PIoQueuesEOS, ESPMode::ThreadSafe> FP2PIoQueuesEOSPtr;
+
+/**
+ * Optional worker that owns the EOS_P2P send/receive calls for every registered socket so the
+ * game thread only touches the rings. All other P2P calls, including those made by P2P notifications, are serialized against it
+ * using the socket subsystem's P2P lock
+ */
+class FP2PIoThreadEOS
+	: public FRunnable
+{
+public:
+	FP2PIoThreadEOS(FSocketSubsystemEOS& InSocketSubsystem, uint32 InRingSize);
+	virtual ~FP2PIoThreadEOS();
+
+	/** Starts the worker thread */
+	bool Start();
+
+	/** Stops and joins the worker thread */
+	void StopAndWait();
+
+	/** Creates the rings for a bound socket and starts servicing them */
+	FP2PIoQueuesEOSPtr RegisterSocket(const FInternetAddrEOS& LocalAddress);
+
+	/** Stops servicing a socket's rings, anything left in them is discarded */
+	void UnregisterSocket(const FP2PIoQueuesEOSPtr& Queues);
+
+	/** Wakes the worker so queued sends go out without waiting for the next poll */
+	void WakeUp();
+
+	//~ Begin FRunnable Interface
+	virtual uint32 Run() override;
+	virtual void Stop() override;
+	//~ End FRunnable Interface
+
+private:
+	/** Sends and receives for every registered socket, returns true if any packets moved */
+	bool Pump();
+
+	/** Reference to our subsystem */
+	FSocketSubsystemEOS& SocketSubsystem;
+
+	/** How many packets each ring holds */
+	const uint32 RingSize;
+
+	/** The sockets we service, guarded by SocketsLock */
+	TArray<FP2PIoQueuesEOSPtr> Sockets;
+	FCriticalSection SocketsLock;
+
+	FRunnableThread* Thread;
+	FEvent* WakeEvent;
+	FThreadSafeBool bStopRequested;
+};
@@ -0,0 +1,570 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "P2PLoopbackEOS.h"
+#include "InternetAddrEOS.h"
+#include "Misc/ScopeLock.h"
+#include "Misc/CommandLine.h"
+#include "Misc/ConfigCacheIni.h"
+
+#if WITH_EOS_SDK
+
+FP2PLoopbackEOS* FP2PLoopbackEOS::Instance = nullptr;
+
+/** Orders the in flight heap so the packet due first is on top */
+struct FLoopbackPacketOrder
+{
+	template <typename PacketType>
+	bool operator()(const PacketType& A, const PacketType& B) const
+	{
+		return A.DeliverAt < B.DeliverAt || (A.DeliverAt == B.DeliverAt && A.Sequence < B.Sequence);
+	}
+};
+
+void FP2PLoopbackEOS::StartupFromConfig()
+{
+	bool bUseLoopbackP2P = FParse::Param(FCommandLine::Get(), TEXT("EOSP2PLoopback"));
+	if (!bUseLoopbackP2P)
+	{
+		GConfig->GetBool(TEXT("/Script/OnlineSubsystemEOS.NetDriverEOS"), TEXT("bUseLoopbackP2P"), bUseLoopbackP2P, GEngineIni);
+	}
+	if (!bUseLoopbackP2P)
+	{
+		return;
+	}
+
+	float LatencyMs = 0.f;
+	float LossPercent = 0.f;
+	float ReorderPercent = 0.f;
+	FP2PLoopbackSettingsEOS NewSettings;
+	GConfig->GetFloat(TEXT("/Script/OnlineSubsystemEOS.NetDriverEOS"), TEXT("LoopbackP2PLatencyMs"), LatencyMs, GEngineIni);
+	GConfig->GetFloat(TEXT("/Script/OnlineSubsystemEOS.NetDriverEOS"), TEXT("LoopbackP2PLossPercent"), LossPercent, GEngineIni);
+	GConfig->GetFloat(TEXT("/Script/OnlineSubsystemEOS.NetDriverEOS"), TEXT("LoopbackP2PReorderPercent"), ReorderPercent, GEngineIni);
+	GConfig->GetInt(TEXT("/Script/OnlineSubsystemEOS.NetDriverEOS"), TEXT("LoopbackP2PSeed"), NewSettings.Seed, GEngineIni);
+	NewSettings.Latency = LatencyMs / 1000.f;
+	NewSettings.Loss = LossPercent / 100.f;
+	NewSettings.Reorder = ReorderPercent / 100.f;
+
+	Startup(NewSettings);
+}
+
+void FP2PLoopbackEOS::Startup(const FP2PLoopbackSettingsEOS& InSettings)
+{
+	if (Instance != nullptr)
+	{
+		Instance->SetSettings(InSettings);
+		return;
+	}
+
+	// Never freed, addresses and net ids may hold our user ids until the process exits
+	Instance = new FP2PLoopbackEOS(InSettings);
+
+	UE_LOG(LogSocketSubsystemEOS, Log, TEXT("Using the loopback P2P transport. Latency=(%.1fms) Loss=(%.1f%%) Reorder=(%.1f%%)"), InSettings.Latency * 1000.f, InSettings.Loss * 100.f, InSettings.Reorder * 100.f);
+}
+
+FP2PLoopbackEOS::FP2PLoopbackEOS(const FP2PLoopbackSettingsEOS& InSettings)
+	: Settings(InSettings)
+	, Random(InSettings.Seed)
+	, Now(0.0)
+	, NextSequence(0)
+	, NextNotificationId(EOS_INVALID_NOTIFICATIONID)
+	, DefaultLocalUserId(nullptr)
+{
+}
+
+void FP2PLoopbackEOS::SetSettings(const FP2PLoopbackSettingsEOS& InSettings)
+{
+	FScopeLock ScopeLock(&Lock);
+
+	Settings = InSettings;
+	Settings.Latency = FMath::Max(Settings.Latency, 0.f);
+	Settings.Loss = FMath::Clamp(Settings.Loss, 0.f, 1.f);
+	Settings.Reorder = FMath::Clamp(Settings.Reorder, 0.f, 1.f);
+	Random.Initialize(Settings.Seed);
+}
+
+FP2PLoopbackStatsEOS FP2PLoopbackEOS::GetStats() const
+{
+	FScopeLock ScopeLock(&Lock);
+	return Stats;
+}
+
+void FP2PLoopbackEOS::ResetStats()
+{
+	FScopeLock ScopeLock(&Lock);
+	Stats = FP2PLoopbackStatsEOS();
+}
+
+EOS_ProductUserId FP2PLoopbackEOS::CreateUser()
+{
+	FScopeLock ScopeLock(&Lock);
+
+	// Look like a real product user id so anything that parses them keeps working
+	char UserIdString[33];
+	FCStringAnsi::Snprintf(UserIdString, sizeof(UserIdString), "%08x%08x%08x%08x", 0x100fb00c, (uint32)Users.Num(), (uint32)Random.GetUnsignedInt(), (uint32)Random.GetUnsignedInt());
+	return AddUser(UserIdString);
+}
+
+EOS_ProductUserId FP2PLoopbackEOS::GetDefaultLocalUserId()
+{
+	FScopeLock ScopeLock(&Lock);
+
+	if (DefaultLocalUserId == nullptr)
+	{
+		DefaultLocalUserId = CreateUser();
+	}
+	return DefaultLocalUserId;
+}
+
+EOS_ProductUserId FP2PLoopbackEOS::AddUser(const char* UserIdString)
+{
+	FUser* User = Users.Emplace_GetRef(MakeUnique<FUser>()).Get();
+	FCStringAnsi::Strncpy(User->UserIdString, UserIdString, UE_ARRAY_COUNT(User->UserIdString));
+
+	EOS_ProductUserId UserId = (EOS_ProductUserId)User;
+	ValidUserIds.Add(UserId);
+	UsersByString.Add(FString(ANSI_TO_TCHAR(User->UserIdString)), UserId);
+	return UserId;
+}
+
+void FP2PLoopbackEOS::Tick(float DeltaTime)
+{
+	TArray<FPendingNotify> PendingNotifies;
+	{
+		FScopeLock ScopeLock(&Lock);
+
+		Now += FMath::Max(DeltaTime, 0.f);
+		while (InFlight.Num() > 0 && InFlight.HeapTop().DeliverAt <= Now)
+		{
+			FPacket Packet;
+			InFlight.HeapPop(Packet, FLoopbackPacketOrder(), false);
+			Deliver(MoveTemp(Packet), PendingNotifies);
+		}
+	}
+	FireNotifies(PendingNotifies);
+}
+
+bool FP2PLoopbackEOS::HasPacketsInFlight() const
+{
+	FScopeLock ScopeLock(&Lock);
+	return InFlight.Num() > 0;
+}
+
+FP2PLoopbackEOS::FConnection& FP2PLoopbackEOS::FindOrAddConnection(EOS_ProductUserId LocalUserId, EOS_ProductUserId RemoteUserId, const char* SocketName)
+{
+	return Connections.FindOrAdd(FConnectionKey(LocalUserId, RemoteUserId, SocketName));
+}
+
+void FP2PLoopbackEOS::Deliver(FPacket&& Packet, TArray<FPendingNotify>& OutNotifies)
+{
+	FConnection& Connection = FindOrAddConnection(Packet.ToUserId, Packet.FromUserId, Packet.SocketName);
+	if (!Connection.bAccepted)
+	{
+		// Like the SDK, the first packet from a new peer turns into a connection request
+		if (!Connection.bRequestNotified)
+		{
+			Connection.bRequestNotified = true;
+			QueueNotifies(true, Packet.ToUserId, Packet.FromUserId, Packet.SocketName, OutNotifies);
+		}
+		if (Packet.bAllowDelayedDelivery)
+		{
+			Connection.Held.Add(MoveTemp(Packet));
+		}
+		else
+		{
+			Stats.PacketsRefused++;
+		}
+		return;
+	}
+
+	ReceiveQueues.FindOrAdd(MakeQueueKey(Packet.ToUserId, Packet.Channel)).Packets.Add(MoveTemp(Packet));
+	Stats.PacketsDelivered++;
+}
+
+FP2PLoopbackEOS::FReceiveQueue* FP2PLoopbackEOS::FindReceiveQueue(EOS_ProductUserId LocalUserId, const uint8_t* RequestedChannel)
+{
+	if (RequestedChannel != nullptr)
+	{
+		FReceiveQueue* Queue = ReceiveQueues.Find(MakeQueueKey(LocalUserId, *RequestedChannel));
+		return Queue != nullptr && Queue->Head < Queue->Packets.Num() ? Queue : nullptr;
+	}
+
+	// Any channel, so hand back whichever packet arrived first
+	FReceiveQueue* Oldest = nullptr;
+	for (TPair<uint64, FReceiveQueue>& Pair : ReceiveQueues)
+	{
+		FReceiveQueue& Queue = Pair.Value;
+		if ((Pair.Key >> 8) == (uint64)(UPTRINT)LocalUserId && Queue.Head < Queue.Packets.Num())
+		{
+			if (Oldest == nullptr || Queue.Packets[Queue.Head].Sequence < Oldest->Packets[Oldest->Head].Sequence)
+			{
+				Oldest = &Queue;
+			}
+		}
+	}
+	return Oldest;
+}
+
+EOS_EResult FP2PLoopbackEOS::SendPacket(const EOS_P2P_SendPacketOptions* Options)
+{
+	if (Options == nullptr || Options->SocketId == nullptr || Options->DataLengthBytes > EOS_P2P_MAX_PACKET_SIZE || (Options->Data == nullptr && Options->DataLengthBytes > 0))
+	{
+		return EOS_EResult::EOS_InvalidParameters;
+	}
+
+	FScopeLock ScopeLock(&Lock);
+
+	if (!ValidUserIds.Contains(Options->LocalUserId) || !ValidUserIds.Contains(Options->RemoteUserId))
+	{
+		return EOS_EResult::EOS_InvalidUser;
+	}
+
+	// Sending to someone opens our side of the connection
+	FindOrAddConnection(Options->LocalUserId, Options->RemoteUserId, Options->SocketId->SocketName).bAccepted = true;
+	Stats.PacketsSent++;
+
+	if (Settings.Loss > 0.f && Random.GetFraction() < Settings.Loss)
+	{
+		Stats.PacketsLost++;
+		return EOS_EResult::EOS_Success;
+	}
+
+	FPacket Packet;
+	Packet.FromUserId = Options->LocalUserId;
+	Packet.ToUserId = Options->RemoteUserId;
+	FCStringAnsi::Strncpy(Packet.SocketName, Options->SocketId->SocketName, EOS_LOOPBACK_SOCKETNAME_SIZE);
+	Packet.Channel = Options->Channel;
+	Packet.Sequence = NextSequence++;
+	Packet.DeliverAt = Now + Settings.Latency;
+	Packet.bAllowDelayedDelivery = Options->bAllowDelayedDelivery == EOS_TRUE;
+	if (Settings.Reorder > 0.f && Random.GetFraction() < Settings.Reorder)
+	{
+		// Hold it back long enough that at least the next tick's packets get there first
+		Packet.DeliverAt += FMath::Max(Settings.Latency, 0.001f);
+		Stats.PacketsReordered++;
+	}
+	Packet.Data.Append((const uint8*)Options->Data, Options->DataLengthBytes);
+	InFlight.HeapPush(MoveTemp(Packet), FLoopbackPacketOrder());
+
+	return EOS_EResult::EOS_Success;
+}
+
+EOS_EResult FP2PLoopbackEOS::GetNextReceivedPacketSize(const EOS_P2P_GetNextReceivedPacketSizeOptions* Options, uint32_t* OutPacketSizeBytes)
+{
+	if (Options == nullptr || OutPacketSizeBytes == nullptr)
+	{
+		return EOS_EResult::EOS_InvalidParameters;
+	}
+
+	FScopeLock ScopeLock(&Lock);
+
+	FReceiveQueue* Queue = FindReceiveQueue(Options->LocalUserId, Options->RequestedChannel);
+	if (Queue == nullptr)
+	{
+		return EOS_EResult::EOS_NotFound;
+	}
+	*OutPacketSizeBytes = (uint32_t)Queue->Packets[Queue->Head].Data.Num();
+	return EOS_EResult::EOS_Success;
+}
+
+EOS_EResult FP2PLoopbackEOS::ReceivePacket(const EOS_P2P_ReceivePacketOptions* Options, EOS_ProductUserId* OutPeerId, EOS_P2P_SocketId* OutSocketId, uint8_t* OutChannel, void* OutData, uint32_t* OutBytesWritten)
+{
+	if (Options == nullptr || OutPeerId == nullptr || OutSocketId == nullptr || OutChannel == nullptr || OutData == nullptr || OutBytesWritten == nullptr)
+	{
+		return EOS_EResult::EOS_InvalidParameters;
+	}
+
+	FScopeLock ScopeLock(&Lock);
+
+	FReceiveQueue* Queue = FindReceiveQueue(Options->LocalUserId, Options->RequestedChannel);
+	if (Queue == nullptr)
+	{
+		return EOS_EResult::EOS_NotFound;
+	}
+
+	const FPacket& Packet = Queue->Packets[Queue->Head];
+	const uint32 BytesWritten = FMath::Min<uint32>(Options->MaxDataSizeBytes, (uint32)Packet.Data.Num());
+	FMemory::Memcpy(OutData, Packet.Data.GetData(), BytesWritten);
+	*OutBytesWritten = BytesWritten;
+	*OutPeerId = Packet.FromUserId;
+	OutSocketId->ApiVersion = EOS_P2P_SOCKETID_API_LATEST;
+	FCStringAnsi::Strcpy(OutSocketId->SocketName, Packet.SocketName);
+	*OutChannel = Packet.Channel;
+
+	Queue->Head++;
+	if (Queue->Head == Queue->Packets.Num())
+	{
+		Queue->Packets.Reset();
+		Queue->Head = 0;
+	}
+	else if (Queue->Head >= 64 && Queue->Head * 2 >= Queue->Packets.Num())
+	{
+		// Compact once the consumed part dominates so the array does not grow forever
+		Queue->Packets.RemoveAt(0, Queue->Head, false);
+		Queue->Head = 0;
+	}
+	return EOS_EResult::EOS_Success;
+}
+
+EOS_NotificationId FP2PLoopbackEOS::AddNotifyPeerConnectionRequest(const EOS_P2P_AddNotifyPeerConnectionRequestOptions* Options, void* ClientData, EOS_P2P_OnIncomingConnectionRequestCallback Callback)
+{
+	if (Options == nullptr || Callback == nullptr)
+	{
+		return EOS_INVALID_NOTIFICATIONID;
+	}
+
+	FScopeLock ScopeLock(&Lock);
+
+	FNotify Notify;
+	Notify.LocalUserId = Options->LocalUserId;
+	FCStringAnsi::Strncpy(Notify.SocketName, Options->SocketId != nullptr ? Options->SocketId->SocketName : "", EOS_LOOPBACK_SOCKETNAME_SIZE);
+	Notify.ClientData = ClientData;
+	Notify.RequestCallback = Callback;
+	Notify.ClosedCallback = nullptr;
+
+	const EOS_NotificationId NotificationId = ++NextNotificationId;
+	Notifies.Add(NotificationId, Notify);
+	return NotificationId;
+}
+
+void FP2PLoopbackEOS::RemoveNotifyPeerConnectionRequest(EOS_NotificationId NotificationId)
+{
+	FScopeLock ScopeLock(&Lock);
+	Notifies.Remove(NotificationId);
+}
+
+EOS_NotificationId FP2PLoopbackEOS::AddNotifyPeerConnectionClosed(const EOS_P2P_AddNotifyPeerConnectionClosedOptions* Options, void* ClientData, EOS_P2P_OnRemoteConnectionClosedCallback Callback)
+{
+	if (Options == nullptr || Callback == nullptr)
+	{
+		return EOS_INVALID_NOTIFICATIONID;
+	}
+
+	FScopeLock ScopeLock(&Lock);
+
+	FNotify Notify;
+	Notify.LocalUserId = Options->LocalUserId;
+	FCStringAnsi::Strncpy(Notify.SocketName, Options->SocketId != nullptr ? Options->SocketId->SocketName : "", EOS_LOOPBACK_SOCKETNAME_SIZE);
+	Notify.ClientData = ClientData;
+	Notify.RequestCallback = nullptr;
+	Notify.ClosedCallback = Callback;
+
+	const EOS_NotificationId NotificationId = ++NextNotificationId;
+	Notifies.Add(NotificationId, Notify);
+	return NotificationId;
+}
+
+void FP2PLoopbackEOS::RemoveNotifyPeerConnectionClosed(EOS_NotificationId NotificationId)
+{
+	FScopeLock ScopeLock(&Lock);
+	Notifies.Remove(NotificationId);
+}
+
+EOS_EResult FP2PLoopbackEOS::AcceptConnection(const EOS_P2P_AcceptConnectionOptions* Options)
+{
+	if (Options == nullptr || Options->SocketId == nullptr)
+	{
+		return EOS_EResult::EOS_InvalidParameters;
+	}
+
+	FScopeLock ScopeLock(&Lock);
+
+	if (!ValidUserIds.Contains(Options->LocalUserId) || !ValidUserIds.Contains(Options->RemoteUserId))
+	{
+		return EOS_EResult::EOS_InvalidUser;
+	}
+
+	FConnection& Connection = FindOrAddConnection(Options->LocalUserId, Options->RemoteUserId, Options->SocketId->SocketName);
+	Connection.bAccepted = true;
+
+	// Anything that was allowed to wait for us gets delivered now
+	TArray<FPacket> Held = MoveTemp(Connection.Held);
+	TArray<FPendingNotify> Unused;
+	for (FPacket& Packet : Held)
+	{
+		Deliver(MoveTemp(Packet), Unused);
+	}
+	return EOS_EResult::EOS_Success;
+}
+
+void FP2PLoopbackEOS::CloseConnectionInternal(EOS_ProductUserId LocalUserId, EOS_ProductUserId RemoteUserId, const char* SocketName, TArray<FPendingNotify>& OutNotifies)
+{
+	Connections.Remove(FConnectionKey(LocalUserId, RemoteUserId, SocketName));
+
+	// If they had the connection open, tell them we went away
+	const FConnectionKey PeerKey(RemoteUserId, LocalUserId, SocketName);
+	const FConnection* PeerConnection = Connections.Find(PeerKey);
+	if (PeerConnection != nullptr)
+	{
+		const bool bWasOpen = PeerConnection->bAccepted;
+		Connections.Remove(PeerKey);
+		if (bWasOpen)
+		{
+			QueueNotifies(false, RemoteUserId, LocalUserId, SocketName, OutNotifies);
+		}
+	}
+}
+
+EOS_EResult FP2PLoopbackEOS::CloseConnection(const EOS_P2P_CloseConnectionOptions* Options)
+{
+	if (Options == nullptr || Options->SocketId == nullptr)
+	{
+		return EOS_EResult::EOS_InvalidParameters;
+	}
+
+	TArray<FPendingNotify> PendingNotifies;
+	{
+		FScopeLock ScopeLock(&Lock);
+
+		if (!ValidUserIds.Contains(Options->LocalUserId) || !ValidUserIds.Contains(Options->RemoteUserId))
+		{
+			return EOS_EResult::EOS_InvalidUser;
+		}
+		CloseConnectionInternal(Options->LocalUserId, Options->RemoteUserId, Options->SocketId->SocketName, PendingNotifies);
+	}
+	FireNotifies(PendingNotifies);
+	return EOS_EResult::EOS_Success;
+}
+
+EOS_EResult FP2PLoopbackEOS::CloseConnections(const EOS_P2P_CloseConnectionsOptions* Options)
+{
+	if (Options == nullptr || Options->SocketId == nullptr)
+	{
+		return EOS_EResult::EOS_InvalidParameters;
+	}
+
+	TArray<FPendingNotify> PendingNotifies;
+	{
+		FScopeLock ScopeLock(&Lock);
+
+		if (!ValidUserIds.Contains(Options->LocalUserId))
+		{
+			return EOS_EResult::EOS_InvalidUser;
+		}
+
+		TArray<FConnectionKey> ToClose;
+		for (const TPair<FConnectionKey, FConnection>& Pair : Connections)
+		{
+			if (Pair.Key.LocalUserId == Options->LocalUserId && FCStringAnsi::Strcmp(Pair.Key.SocketName, Options->SocketId->SocketName) == 0)
+			{
+				ToClose.Add(Pair.Key);
+			}
+		}
+		for (const FConnectionKey& Key : ToClose)
+		{
+			CloseConnectionInternal(Key.LocalUserId, Key.RemoteUserId, Key.SocketName, PendingNotifies);
+		}
+	}
+	FireNotifies(PendingNotifies);
+	return EOS_EResult::EOS_Success;
+}
+
+void FP2PLoopbackEOS::QueueNotifies(bool bIsRequest, EOS_ProductUserId LocalUserId, EOS_ProductUserId RemoteUserId, const char* SocketName, TArray<FPendingNotify>& OutNotifies) const
+{
+	for (const TPair<EOS_NotificationId, FNotify>& Pair : Notifies)
+	{
+		const FNotify& Notify = Pair.Value;
+		const bool bIsRightType = bIsRequest ? Notify.RequestCallback != nullptr : Notify.ClosedCallback != nullptr;
+		if (bIsRightType && Notify.LocalUserId == LocalUserId && (Notify.SocketName[0] == '\0' || FCStringAnsi::Strcmp(Notify.SocketName, SocketName) == 0))
+		{
+			FPendingNotify& Pending = OutNotifies.AddDefaulted_GetRef();
+			Pending.NotificationId = Pair.Key;
+			Pending.LocalUserId = LocalUserId;
+			Pending.RemoteUserId = RemoteUserId;
+			FCStringAnsi::Strncpy(Pending.SocketName, SocketName, EOS_LOOPBACK_SOCKETNAME_SIZE);
+		}
+	}
+}
+
+void FP2PLoopbackEOS::FireNotifies(const TArray<FPendingNotify>& PendingNotifies)
+{
+	for (const FPendingNotify& Pending : PendingNotifies)
+	{
+		// Earlier callbacks may have removed this one, and the callbacks call back into us so we can't hold the lock
+		FNotify Notify;
+		{
+			FScopeLock ScopeLock(&Lock);
+			const FNotify* Found = Notifies.Find(Pending.NotificationId);
+			if (Found == nullptr)
+			{
+				continue;
+			}
+			Notify = *Found;
+		}
+
+		EOS_P2P_SocketId SocketId = { };
+		SocketId.ApiVersion = EOS_P2P_SOCKETID_API_LATEST;
+		FCStringAnsi::Strcpy(SocketId.SocketName, Pending.SocketName);
+
+		if (Notify.RequestCallback != nullptr)
+		{
+			EOS_P2P_OnIncomingConnectionRequestInfo Info = { };
+			Info.ClientData = Notify.ClientData;
+			Info.LocalUserId = Pending.LocalUserId;
+			Info.RemoteUserId = Pending.RemoteUserId;
+			Info.SocketId = &SocketId;
+			Notify.RequestCallback(&Info);
+		}
+		else
+		{
+			EOS_P2P_OnRemoteConnectionClosedInfo Info = { };
+			Info.ClientData = Notify.ClientData;
+			Info.LocalUserId = Pending.LocalUserId;
+			Info.RemoteUserId = Pending.RemoteUserId;
+			Info.SocketId = &SocketId;
+			Info.Reason = EOS_EConnectionClosedReason::EOS_CCR_ClosedByPeer;
+			Notify.ClosedCallback(&Info);
+		}
+	}
+}
+
+EOS_Bool FP2PLoopbackEOS::ProductUserIdIsValid(EOS_ProductUserId UserId) const
+{
+	FScopeLock ScopeLock(&Lock);
+	return ValidUserIds.Contains(UserId) ? EOS_TRUE : EOS_FALSE;
+}
+
+EOS_EResult FP2PLoopbackEOS::ProductUserIdToString(EOS_ProductUserId UserId, char* OutBuffer, int32_t* InOutBufferLength) const
+{
+	if (OutBuffer == nullptr || InOutBufferLength == nullptr)
+	{
+		return EOS_EResult::EOS_InvalidParameters;
+	}
+
+	FScopeLock ScopeLock(&Lock);
+
+	// Never dereference an id we did not hand out
+	if (!ValidUserIds.Contains(UserId))
+	{
+		return EOS_EResult::EOS_InvalidUser;
+	}
+
+	const FUser* User = (const FUser*)UserId;
+	const int32 RequiredLength = FCStringAnsi::Strlen(User->UserIdString) + 1;
+	if (*InOutBufferLength < RequiredLength)
+	{
+		*InOutBufferLength = RequiredLength;
+		return EOS_EResult::EOS_LimitExceeded;
+	}
+	FCStringAnsi::Strncpy(OutBuffer, User->UserIdString, RequiredLength);
+	*InOutBufferLength = RequiredLength;
+	return EOS_EResult::EOS_Success;
+}
+
+EOS_ProductUserId FP2PLoopbackEOS::ProductUserIdFromString(const char* UserIdString)
+{
+	if (UserIdString == nullptr || UserIdString[0] == '\0' || FCStringAnsi::Strlen(UserIdString) >= (int32)sizeof(FUser::UserIdString))
+	{
+		return nullptr;
+	}
+
+	FScopeLock ScopeLock(&Lock);
+
+	// Ids we have not seen yet are addresses of peers that will show up later, so mint them on demand
+	if (const EOS_ProductUserId* Existing = UsersByString.Find(FString(ANSI_TO_TCHAR(UserIdString))))
+	{
+		return *Existing;
+	}
+	return AddUser(UserIdString);
+}
+
+#endif
@@ -0,0 +1,350 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HAL/CriticalSection.h"
+#include "Math/RandomStream.h"
+
+#if WITH_EOS_SDK
+	#include "eos_p2p.h"
+
+	/** Matches the size of EOS_P2P_SocketId::SocketName */
+	#define EOS_LOOPBACK_SOCKETNAME_SIZE 33
+
+/** How the loopback transport mistreats packets */
+struct FP2PLoopbackSettingsEOS
+{
+	/** One way delay applied to every packet, in seconds */
+	float Latency;
+	/** Chance in [0,1] that a packet is silently dropped */
+	float Loss;
+	/** Chance in [0,1] that a packet is held back an extra latency period so later packets overtake it */
+	float Reorder;
+	/** Seed for the loss/reorder rolls so runs are repeatable */
+	int32 Seed;
+
+	FP2PLoopbackSettingsEOS()
+		: Latency(0.f)
+		, Loss(0.f)
+		, Reorder(0.f)
+		, Seed(0)
+	{
+	}
+};
+
+/** Counters for everything the loopback transport has done since the last reset */
+struct FP2PLoopbackStatsEOS
+{
+	/** Packets accepted by SendPacket */
+	uint64 PacketsSent;
+	/** Packets moved into a receive queue */
+	uint64 PacketsDelivered;
+	/** Packets dropped by the simulated loss */
+	uint64 PacketsLost;
+	/** Packets dropped because the receiver had not accepted the connection */
+	uint64 PacketsRefused;
+	/** Packets that were delayed so later ones overtake them */
+	uint64 PacketsReordered;
+
+	FP2PLoopbackStatsEOS()
+		: PacketsSent(0)
+		, PacketsDelivered(0)
+		, PacketsLost(0)
+		, PacketsRefused(0)
+		, PacketsReordered(0)
+	{
+	}
+};
+
+/**
+ * In-process stand-in for the EOS_P2P interface that the socket layer uses. Every user it mints lives in
+ * this process and packets between them never leave it, so sockets, net drivers and connections can be
+ * exercised without the EOS services. Packets are delivered when Tick is called, like the SDK does
+ * during EOS_Platform_Tick
+ */
+class FP2PLoopbackEOS
+{
+public:
+	/** @return the loopback transport when it is enabled, otherwise null and the SDK is used */
+	static FP2PLoopbackEOS* Get()
+	{
+		return Instance;
+	}
+
+	/** Enables the loopback transport if config or the command line asks for it */
+	static void StartupFromConfig();
+
+	/** Enables the loopback transport, it lives until the module is unloaded as its ids may still be referenced */
+	static void Startup(const FP2PLoopbackSettingsEOS& InSettings);
+
+	const FP2PLoopbackSettingsEOS& GetSettings() const
+	{
+		return Settings;
+	}
+	void SetSettings(const FP2PLoopbackSettingsEOS& InSettings);
+
+	FP2PLoopbackStatsEOS GetStats() const;
+	void ResetStats();
+
+	/** @return a new user that can own sockets */
+	EOS_ProductUserId CreateUser();
+
+	/** @return the user to bind with when nobody has logged in */
+	EOS_ProductUserId GetDefaultLocalUserId();
+
+	/** Advances the simulated clock, delivering due packets and firing connection notifications */
+	void Tick(float DeltaTime);
+
+	/** @return true if any packets are still in flight */
+	bool HasPacketsInFlight() const;
+
+	//~ Begin EOS_P2P equivalents
+	EOS_EResult SendPacket(const EOS_P2P_SendPacketOptions* Options);
+	EOS_EResult GetNextReceivedPacketSize(const EOS_P2P_GetNextReceivedPacketSizeOptions* Options, uint32_t* OutPacketSizeBytes);
+	EOS_EResult ReceivePacket(const EOS_P2P_ReceivePacketOptions* Options, EOS_ProductUserId* OutPeerId, EOS_P2P_SocketId* OutSocketId, uint8_t* OutChannel, void* OutData, uint32_t* OutBytesWritten);
+	EOS_NotificationId AddNotifyPeerConnectionRequest(const EOS_P2P_AddNotifyPeerConnectionRequestOptions* Options, void* ClientData, EOS_P2P_OnIncomingConnectionRequestCallback Callback);
+	void RemoveNotifyPeerConnectionRequest(EOS_NotificationId NotificationId);
+	EOS_NotificationId AddNotifyPeerConnectionClosed(const EOS_P2P_AddNotifyPeerConnectionClosedOptions* Options, void* ClientData, EOS_P2P_OnRemoteConnectionClosedCallback Callback);
+	void RemoveNotifyPeerConnectionClosed(EOS_NotificationId NotificationId);
+	EOS_EResult AcceptConnection(const EOS_P2P_AcceptConnectionOptions* Options);
+	EOS_EResult CloseConnection(const EOS_P2P_CloseConnectionOptions* Options);
+	EOS_EResult CloseConnections(const EOS_P2P_CloseConnectionsOptions* Options);
+	EOS_Bool ProductUserIdIsValid(EOS_ProductUserId UserId) const;
+	EOS_EResult ProductUserIdToString(EOS_ProductUserId UserId, char* OutBuffer, int32_t* InOutBufferLength) const;
+	EOS_ProductUserId ProductUserIdFromString(const char* UserIdString);
+	//~ End EOS_P2P equivalents
+
+private:
+	FP2PLoopbackEOS(const FP2PLoopbackSettingsEOS& InSettings);
+
+	/** Users are only ever referenced through the address of their entry */
+	struct FUser
+	{
+		char UserIdString[33];
+	};
+
+	/** One direction of a peer to peer connection */
+	struct FConnectionKey
+	{
+		EOS_ProductUserId LocalUserId;
+		EOS_ProductUserId RemoteUserId;
+		char SocketName[EOS_LOOPBACK_SOCKETNAME_SIZE];
+
+		FConnectionKey(EOS_ProductUserId InLocalUserId, EOS_ProductUserId InRemoteUserId, const char* InSocketName)
+			: LocalUserId(InLocalUserId)
+			, RemoteUserId(InRemoteUserId)
+		{
+			FCStringAnsi::Strncpy(SocketName, InSocketName, EOS_LOOPBACK_SOCKETNAME_SIZE);
+		}
+
+		friend bool operator==(const FConnectionKey& A, const FConnectionKey& B)
+		{
+			return A.LocalUserId == B.LocalUserId && A.RemoteUserId == B.RemoteUserId && FCStringAnsi::Strcmp(A.SocketName, B.SocketName) == 0;
+		}
+		friend uint32 GetTypeHash(const FConnectionKey& Key)
+		{
+			return HashCombine(HashCombine(::GetTypeHash((void*)Key.LocalUserId), ::GetTypeHash((void*)Key.RemoteUserId)), FCrc::StrCrc32(Key.SocketName));
+		}
+	};
+
+	struct FPacket
+	{
+		EOS_ProductUserId FromUserId;
+		EOS_ProductUserId ToUserId;
+		char SocketName[EOS_LOOPBACK_SOCKETNAME_SIZE];
+		uint8 Channel;
+		/** Orders packets that become due on the same tick */
+		uint64 Sequence;
+		/** Simulated time the packet arrives */
+		double DeliverAt;
+		/** Whether the packet may wait for the receiver to accept the connection */
+		bool bAllowDelayedDelivery;
+		TArray<uint8> Data;
+	};
+
+	struct FConnection
+	{
+		/** Whether the local user accepted or sent to the remote user */
+		bool bAccepted;
+		/** Whether we have told the local user about this connection request */
+		bool bRequestNotified;
+		/** Delayed delivery packets that arrived before the connection was accepted */
+		TArray<FPacket> Held;
+
+		FConnection()
+			: bAccepted(false)
+			, bRequestNotified(false)
+		{
+		}
+	};
+
+	/** Delivered packets for one user and channel, consumed from Head */
+	struct FReceiveQueue
+	{
+		TArray<FPacket> Packets;
+		int32 Head;
+
+		FReceiveQueue()
+			: Head(0)
+		{
+		}
+	};
+
+	struct FNotify
+	{
+		EOS_ProductUserId LocalUserId;
+		/** Empty to listen on every socket */
+		char SocketName[EOS_LOOPBACK_SOCKETNAME_SIZE];
+		void* ClientData;
+		EOS_P2P_OnIncomingConnectionRequestCallback RequestCallback;
+		EOS_P2P_OnRemoteConnectionClosedCallback ClosedCallback;
+	};
+
+	/** A notification to fire once the lock is released */
+	struct FPendingNotify
+	{
+		EOS_NotificationId NotificationId;
+		EOS_ProductUserId LocalUserId;
+		EOS_ProductUserId RemoteUserId;
+		char SocketName[EOS_LOOPBACK_SOCKETNAME_SIZE];
+	};
+
+	static uint64 MakeQueueKey(EOS_ProductUserId UserId, uint8 Channel)
+	{
+		return ((uint64)(UPTRINT)UserId << 8) | Channel;
+	}
+
+	EOS_ProductUserId AddUser(const char* UserIdString);
+	FConnection& FindOrAddConnection(EOS_ProductUserId LocalUserId, EOS_ProductUserId RemoteUserId, const char* SocketName);
+	void Deliver(FPacket&& Packet, TArray<FPendingNotify>& OutNotifies);
+	void CloseConnectionInternal(EOS_ProductUserId LocalUserId, EOS_ProductUserId RemoteUserId, const char* SocketName, TArray<FPendingNotify>& OutNotifies);
+	void QueueNotifies(bool bIsRequest, EOS_ProductUserId LocalUserId, EOS_ProductUserId RemoteUserId, const char* SocketName, TArray<FPendingNotify>& OutNotifies) const;
+	void FireNotifies(const TArray<FPendingNotify>& Notifies);
+	FReceiveQueue* FindReceiveQueue(EOS_ProductUserId LocalUserId, const uint8_t* RequestedChannel);
+
+	static FP2PLoopbackEOS* Instance;
+
+	/** Guards everything below, the game thread and the P2P I/O thread both call in */
+	mutable FCriticalSection Lock;
+
+	FP2PLoopbackSettingsEOS Settings;
+	FP2PLoopbackStatsEOS Stats;
+	FRandomStream Random;
+
+	/** Simulated time, advanced by Tick */
+	double Now;
+	uint64 NextSequence;
+	EOS_NotificationId NextNotificationId;
+	EOS_ProductUserId DefaultLocalUserId;
+
+	TArray<TUniquePtr<FUser>> Users;
+	TSet<EOS_ProductUserId> ValidUserIds;
+	TMap<FString, EOS_ProductUserId> UsersByString;
+
+	TMap<FConnectionKey, FConnection> Connections;
+	/** Packets not yet delivered, kept as a min heap on DeliverAt then Sequence */
+	TArray<FPacket> InFlight;
+	TMap<uint64, FReceiveQueue> ReceiveQueues;
+	TMap<EOS_NotificationId, FNotify> Notifies;
+};
+
+/**
+ * Thin dispatch over the EOS_P2P and product user id calls the socket layer makes, routing them to the
+ * loopback transport when it is enabled
+ */
+class FP2PTransportEOS
+{
+public:
+	static FORCEINLINE EOS_EResult SendPacket(EOS_HP2P Handle, const EOS_P2P_SendPacketOptions* Options)
+	{
+		FP2PLoopbackEOS* Loopback = FP2PLoopbackEOS::Get();
+		return Loopback != nullptr ? Loopback->SendPacket(Options) : EOS_P2P_SendPacket(Handle, Options);
+	}
+
+	static FORCEINLINE EOS_EResult GetNextReceivedPacketSize(EOS_HP2P Handle, const EOS_P2P_GetNextReceivedPacketSizeOptions* Options, uint32_t* OutPacketSizeBytes)
+	{
+		FP2PLoopbackEOS* Loopback = FP2PLoopbackEOS::Get();
+		return Loopback != nullptr ? Loopback->GetNextReceivedPacketSize(Options, OutPacketSizeBytes) : EOS_P2P_GetNextReceivedPacketSize(Handle, Options, OutPacketSizeBytes);
+	}
+
+	static FORCEINLINE EOS_EResult ReceivePacket(EOS_HP2P Handle, const EOS_P2P_ReceivePacketOptions* Options, EOS_ProductUserId* OutPeerId, EOS_P2P_SocketId* OutSocketId, uint8_t* OutChannel, void* OutData, uint32_t* OutBytesWritten)
+	{
+		FP2PLoopbackEOS* Loopback = FP2PLoopbackEOS::Get();
+		return Loopback != nullptr ? Loopback->ReceivePacket(Options, OutPeerId, OutSocketId, OutChannel, OutData, OutBytesWritten) : EOS_P2P_ReceivePacket(Handle, Options, OutPeerId, OutSocketId, OutChannel, OutData, OutBytesWritten);
+	}
+
+	static FORCEINLINE EOS_NotificationId AddNotifyPeerConnectionRequest(EOS_HP2P Handle, const EOS_P2P_AddNotifyPeerConnectionRequestOptions* Options, void* ClientData, EOS_P2P_OnIncomingConnectionRequestCallback Callback)
+	{
+		FP2PLoopbackEOS* Loopback = FP2PLoopbackEOS::Get();
+		return Loopback != nullptr ? Loopback->AddNotifyPeerConnectionRequest(Options, ClientData, Callback) : EOS_P2P_AddNotifyPeerConnectionRequest(Handle, Options, ClientData, Callback);
+	}
+
+	static FORCEINLINE void RemoveNotifyPeerConnectionRequest(EOS_HP2P Handle, EOS_NotificationId NotificationId)
+	{
+		if (FP2PLoopbackEOS* Loopback = FP2PLoopbackEOS::Get())
+		{
+			Loopback->RemoveNotifyPeerConnectionRequest(NotificationId);
+		}
+		else
+		{
+			EOS_P2P_RemoveNotifyPeerConnectionRequest(Handle, NotificationId);
+		}
+	}
+
+	static FORCEINLINE EOS_NotificationId AddNotifyPeerConnectionClosed(EOS_HP2P Handle, const EOS_P2P_AddNotifyPeerConnectionClosedOptions* Options, void* ClientData, EOS_P2P_OnRemoteConnectionClosedCallback Callback)
+	{
+		FP2PLoopbackEOS* Loopback = FP2PLoopbackEOS::Get();
+		return Loopback != nullptr ? Loopback->AddNotifyPeerConnectionClosed(Options, ClientData, Callback) : EOS_P2P_AddNotifyPeerConnectionClosed(Handle, Options, ClientData, Callback);
+	}
+
+	static FORCEINLINE void RemoveNotifyPeerConnectionClosed(EOS_HP2P Handle, EOS_NotificationId NotificationId)
+	{
+		if (FP2PLoopbackEOS* Loopback = FP2PLoopbackEOS::Get())
+		{
+			Loopback->RemoveNotifyPeerConnectionClosed(NotificationId);
+		}
+		else
+		{
+			EOS_P2P_RemoveNotifyPeerConnectionClosed(Handle, NotificationId);
+		}
+	}
+
+	static FORCEINLINE EOS_EResult AcceptConnection(EOS_HP2P Handle, const EOS_P2P_AcceptConnectionOptions* Options)
+	{
+		FP2PLoopbackEOS* Loopback = FP2PLoopbackEOS::Get();
+		return Loopback != nullptr ? Loopback->AcceptConnection(Options) : EOS_P2P_AcceptConnection(Handle, Options);
+	}
+
+	static FORCEINLINE EOS_EResult CloseConnection(EOS_HP2P Handle, const EOS_P2P_CloseConnectionOptions* Options)
+	{
+		FP2PLoopbackEOS* Loopback = FP2PLoopbackEOS::Get();
+		return Loopback != nullptr ? Loopback->CloseConnection(Options) : EOS_P2P_CloseConnection(Handle, Options);
+	}
+
+	static FORCEINLINE EOS_EResult CloseConnections(EOS_HP2P Handle, const EOS_P2P_CloseConnectionsOptions* Options)
+	{
+		FP2PLoopbackEOS* Loopback = FP2PLoopbackEOS::Get();
+		return Loopback != nullptr ? Loopback->CloseConnections(Options) : EOS_P2P_CloseConnections(Handle, Options);
+	}
+
+	static FORCEINLINE EOS_Bool ProductUserIdIsValid(EOS_ProductUserId UserId)
+	{
+		FP2PLoopbackEOS* Loopback = FP2PLoopbackEOS::Get();
+		return Loopback != nullptr ? Loopback->ProductUserIdIsValid(UserId) : EOS_ProductUserId_IsValid(UserId);
+	}
+
+	static FORCEINLINE EOS_EResult ProductUserIdToString(EOS_ProductUserId UserId, char* OutBuffer, int32_t* InOutBufferLength)
+	{
+		FP2PLoopbackEOS* Loopback = FP2PLoopbackEOS::Get();
+		return Loopback != nullptr ? Loopback->ProductUserIdToString(UserId, OutBuffer, InOutBufferLength) : EOS_ProductUserId_ToString(UserId, OutBuffer, InOutBufferLength);
+	}
+
+	static FORCEINLINE EOS_ProductUserId ProductUserIdFromString(const char* UserIdString)
+	{
+		FP2PLoopbackEOS* Loopback = FP2PLoopbackEOS::Get();
+		return Loopback != nullptr ? Loopback->ProductUserIdFromString(UserIdString) : EOS_ProductUserId_FromString(UserIdString);
+	}
+};
+
+#endif
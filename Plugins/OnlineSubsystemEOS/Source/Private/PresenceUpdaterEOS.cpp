@@ -0,0 +1,274 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "PresenceUpdaterEOS.h"
+#include "OnlineSubsystemEOS.h"
+#include "Misc/ConfigCacheIni.h"
+
+#if WITH_EOS_SDK
+
+#include "eos_presence_types.h"
+
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Presence Updates Requested"), STAT_EOS_PresenceUpdatesRequested, STATGROUP_EOS);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Presence Updates Dropped"), STAT_EOS_PresenceUpdatesDropped, STATGROUP_EOS);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Presence Updates Collapsed"), STAT_EOS_PresenceUpdatesCollapsed, STATGROUP_EOS);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Presence Writes"), STAT_EOS_PresenceWrites, STATGROUP_EOS);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Presence Fields Written"), STAT_EOS_PresenceFieldsWritten, STATGROUP_EOS);
+
+FPresenceRecordEOS FPresenceRecordEOS::FromStatus(const FOnlineUserPresenceStatus& Status)
+{
+	FPresenceRecordEOS Record;
+	Record.State = Status.State;
+	Record.RichText = Status.StatusStr;
+	Record.Properties.Reserve(FMath::Min(Status.Properties.Num(), EOS_PRESENCE_DATA_MAX_KEYS));
+	for (FPresenceProperties::TConstIterator It(Status.Properties); It && Record.Properties.Num() < EOS_PRESENCE_DATA_MAX_KEYS; ++It)
+	{
+		Record.Properties.Add(It.Key(), It.Value().ToString());
+	}
+	return Record;
+}
+
+bool FPresenceRecordEOS::operator==(const FPresenceRecordEOS& Other) const
+{
+	if (State != Other.State || !RichText.Equals(Other.RichText, ESearchCase::CaseSensitive) || Properties.Num() != Other.Properties.Num())
+	{
+		return false;
+	}
+	for (const TPair<FString, FString>& Property : Properties)
+	{
+		const FString* OtherValue = Other.Properties.Find(Property.Key);
+		if (OtherValue == nullptr || !OtherValue->Equals(Property.Value, ESearchCase::CaseSensitive))
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+FPresenceDeltaEOS FPresenceDeltaEOS::Diff(const FPresenceRecordEOS* From, const FPresenceRecordEOS& To)
+{
+	FPresenceDeltaEOS Delta;
+	Delta.State = To.State;
+	Delta.RichText = To.RichText;
+	Delta.bSetStatus = From == nullptr || From->State != To.State;
+	Delta.bSetRichText = From == nullptr || !From->RichText.Equals(To.RichText, ESearchCase::CaseSensitive);
+	for (const TPair<FString, FString>& Property : To.Properties)
+	{
+		const FString* FromValue = From != nullptr ? From->Properties.Find(Property.Key) : nullptr;
+		if (FromValue == nullptr || !FromValue->Equals(Property.Value, ESearchCase::CaseSensitive))
+		{
+			Delta.SetProperties.Emplace(Property.Key, Property.Value);
+		}
+	}
+	if (From != nullptr)
+	{
+		for (const TPair<FString, FString>& Property : From->Properties)
+		{
+			if (!To.Properties.Contains(Property.Key))
+			{
+				Delta.RemovedProperties.Add(Property.Key);
+			}
+		}
+	}
+	return Delta;
+}
+
+FPresenceUpdaterEOS::FPresenceUpdaterEOS(TUniquePtr<IPresenceWriterEOS>&& InWriter)
+	: Writer(MoveTemp(InWriter))
+	, State(MakeShared<FUpdaterState>())
+	, Interval(1.f)
+{
+}
+
+void FPresenceUpdaterEOS::LoadConfig()
+{
+	GConfig->GetFloat(TEXT("/Script/OnlineSubsystemEOS.NetDriverEOS"), TEXT("PresenceUpdateInterval"), Interval, GEngineIni);
+	Interval = FMath::Max(Interval, 0.f);
+}
+
+void FPresenceUpdaterEOS::SetPresence(EOS_EpicAccountId LocalUserId, const FOnlineUserPresenceStatus& Status, FOnPresenceWriteCompleteEOS&& OnComplete)
+{
+	INC_DWORD_STAT(STAT_EOS_PresenceUpdatesRequested);
+	FPresenceRecordEOS Record = FPresenceRecordEOS::FromStatus(Status);
+	FUserPresence& User = State->Users.FindOrAdd(LocalUserId);
+
+	// Compare against what EOS will have once the write in flight lands
+	const FPresenceRecordEOS* Expected = User.bIsSending ? &User.Sending : (User.bHasAcked ? &User.Acked : nullptr);
+	if (Expected != nullptr && *Expected == Record)
+	{
+		INC_DWORD_STAT(STAT_EOS_PresenceUpdatesDropped);
+		// An update still waiting would only change it back, so that one is superseded as well
+		if (User.bHasWanted)
+		{
+			User.bHasWanted = false;
+			User.WantedWaiters.Add(MoveTemp(OnComplete));
+			if (User.bIsSending)
+			{
+				User.SendingWaiters.Append(MoveTemp(User.WantedWaiters));
+				User.WantedWaiters.Reset();
+				return;
+			}
+			TArray<FOnPresenceWriteCompleteEOS> Waiters = MoveTemp(User.WantedWaiters);
+			User.WantedWaiters.Reset();
+			for (FOnPresenceWriteCompleteEOS& Waiter : Waiters)
+			{
+				if (Waiter)
+				{
+					Waiter(true);
+				}
+			}
+		}
+		else if (User.bIsSending)
+		{
+			User.SendingWaiters.Add(MoveTemp(OnComplete));
+		}
+		else if (OnComplete)
+		{
+			OnComplete(true);
+		}
+		return;
+	}
+
+	if (User.bHasWanted)
+	{
+		INC_DWORD_STAT(STAT_EOS_PresenceUpdatesCollapsed);
+	}
+	User.Wanted = MoveTemp(Record);
+	User.bHasWanted = true;
+	User.WantedWaiters.Add(MoveTemp(OnComplete));
+	if (!User.bIsSending && State->Now - User.LastWriteTime >= Interval)
+	{
+		Write(LocalUserId, User);
+	}
+}
+
+void FPresenceUpdaterEOS::Write(EOS_EpicAccountId LocalUserId, FUserPresence& User)
+{
+	check(User.bHasWanted && !User.bIsSending);
+
+	FPresenceDeltaEOS Delta = FPresenceDeltaEOS::Diff(User.bHasAcked ? &User.Acked : nullptr, User.Wanted);
+	User.bHasWanted = false;
+	TArray<FOnPresenceWriteCompleteEOS> Waiters = MoveTemp(User.WantedWaiters);
+	User.WantedWaiters.Reset();
+	if (Delta.IsEmpty())
+	{
+		// Changed back to what EOS already has while a write was in flight
+		INC_DWORD_STAT(STAT_EOS_PresenceUpdatesDropped);
+		for (FOnPresenceWriteCompleteEOS& Waiter : Waiters)
+		{
+			if (Waiter)
+			{
+				Waiter(true);
+			}
+		}
+		return;
+	}
+
+	User.Sending = MoveTemp(User.Wanted);
+	User.bIsSending = true;
+	User.SendingWaiters = MoveTemp(Waiters);
+	User.LastWriteTime = State->Now;
+	INC_DWORD_STAT(STAT_EOS_PresenceWrites);
+	INC_DWORD_STAT_BY(STAT_EOS_PresenceFieldsWritten, Delta.NumFields());
+
+	TWeakPtr<FUpdaterState> WeakState = State;
+	const bool bStarted = Writer->WritePresence(LocalUserId, Delta, [WeakState, LocalUserId](bool bWasSuccessful)
+	{
+		TSharedPtr<FUpdaterState> PinnedState = WeakState.Pin();
+		if (!PinnedState.IsValid())
+		{
+			return;
+		}
+		FUserPresence* WrittenUser = PinnedState->Users.Find(LocalUserId);
+		if (WrittenUser == nullptr)
+		{
+			// Signed out while writing, their waiters were already failed
+			return;
+		}
+		WrittenUser->bIsSending = false;
+		if (bWasSuccessful)
+		{
+			WrittenUser->Acked = MoveTemp(WrittenUser->Sending);
+			WrittenUser->bHasAcked = true;
+		}
+		else
+		{
+			// No telling how much of it EOS kept, so the next write sends everything
+			WrittenUser->bHasAcked = false;
+		}
+		// Waiters may set presence again, which can add to the map, so take them out first
+		TArray<FOnPresenceWriteCompleteEOS> Waiters = MoveTemp(WrittenUser->SendingWaiters);
+		WrittenUser->SendingWaiters.Reset();
+		for (FOnPresenceWriteCompleteEOS& Waiter : Waiters)
+		{
+			if (Waiter)
+			{
+				Waiter(bWasSuccessful);
+			}
+		}
+	});
+
+	if (!bStarted)
+	{
+		UE_LOG_ONLINE(Warning, TEXT("Failed to start a presence write"));
+		User.bIsSending = false;
+		Waiters = MoveTemp(User.SendingWaiters);
+		User.SendingWaiters.Reset();
+		for (FOnPresenceWriteCompleteEOS& Waiter : Waiters)
+		{
+			if (Waiter)
+			{
+				Waiter(false);
+			}
+		}
+	}
+}
+
+void FPresenceUpdaterEOS::RemoveUser(EOS_EpicAccountId LocalUserId)
+{
+	FUserPresence User;
+	if (!State->Users.RemoveAndCopyValue(LocalUserId, User))
+	{
+		return;
+	}
+	for (FOnPresenceWriteCompleteEOS& Waiter : User.SendingWaiters)
+	{
+		if (Waiter)
+		{
+			Waiter(false);
+		}
+	}
+	for (FOnPresenceWriteCompleteEOS& Waiter : User.WantedWaiters)
+	{
+		if (Waiter)
+		{
+			Waiter(false);
+		}
+	}
+}
+
+void FPresenceUpdaterEOS::Tick(float DeltaTime)
+{
+	State->Now += DeltaTime;
+	Writer->Tick(DeltaTime);
+
+	// Writes can complete right away and set presence again, so find who is due before writing
+	TArray<EOS_EpicAccountId, TInlineAllocator<4>> DueUsers;
+	for (const TPair<EOS_EpicAccountId, FUserPresence>& Pair : State->Users)
+	{
+		const FUserPresence& User = Pair.Value;
+		if (User.bHasWanted && !User.bIsSending && State->Now - User.LastWriteTime >= Interval)
+		{
+			DueUsers.Add(Pair.Key);
+		}
+	}
+	for (EOS_EpicAccountId LocalUserId : DueUsers)
+	{
+		FUserPresence* User = State->Users.Find(LocalUserId);
+		if (User != nullptr && User->bHasWanted && !User->bIsSending)
+		{
+			Write(LocalUserId, *User);
+		}
+	}
+}
+
+#endif
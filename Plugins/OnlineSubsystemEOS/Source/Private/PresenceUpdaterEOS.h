@@ -0,0 +1,171 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Interfaces/OnlinePresenceInterface.h"
+
+#if WITH_EOS_SDK
+	#include "eos_common.h"
+
+/** A presence the way it is sent to EOS, property values already turned into the strings written */
+struct FPresenceRecordEOS
+{
+	EOnlinePresenceState::Type State;
+	FString RichText;
+	TMap<FString, FString> Properties;
+
+	FPresenceRecordEOS()
+		: State(EOnlinePresenceState::Offline)
+	{
+	}
+
+	/** Builds the record for a status, keeping as many properties as EOS takes */
+	static FPresenceRecordEOS FromStatus(const FOnlineUserPresenceStatus& Status);
+
+	bool operator==(const FPresenceRecordEOS& Other) const;
+	bool operator!=(const FPresenceRecordEOS& Other) const
+	{
+		return !(*this == Other);
+	}
+};
+
+/** The parts of a presence that changed and have to be written */
+struct FPresenceDeltaEOS
+{
+	bool bSetStatus;
+	EOnlinePresenceState::Type State;
+	bool bSetRichText;
+	FString RichText;
+	/** Properties that are new or have a new value */
+	TArray<TPair<FString, FString>> SetProperties;
+	TArray<FString> RemovedProperties;
+
+	FPresenceDeltaEOS()
+		: bSetStatus(false)
+		, State(EOnlinePresenceState::Offline)
+		, bSetRichText(false)
+	{
+	}
+
+	/**
+	 * Works out what has to be written to go from one presence to another
+	 *
+	 * @param From what EOS has, null if that isn't known and everything has to be written
+	 * @param To the presence wanted
+	 */
+	static FPresenceDeltaEOS Diff(const FPresenceRecordEOS* From, const FPresenceRecordEOS& To);
+
+	bool IsEmpty() const
+	{
+		return NumFields() == 0;
+	}
+
+	/** @return the number of fields written, the status and rich text count as one each */
+	int32 NumFields() const
+	{
+		return (bSetStatus ? 1 : 0) + (bSetRichText ? 1 : 0) + SetProperties.Num() + RemovedProperties.Num();
+	}
+};
+
+/** Called once a presence write finished */
+typedef TFunction<void(bool bWasSuccessful)> FOnPresenceWriteCompleteEOS;
+
+/** Writes presence changes, so throttling can be driven by a mock as well as by EOS */
+class IPresenceWriterEOS
+{
+public:
+	virtual ~IPresenceWriterEOS() {}
+
+	/** @return false if the write could not be started, OnComplete is not called */
+	virtual bool WritePresence(EOS_EpicAccountId LocalUserId, const FPresenceDeltaEOS& Delta, FOnPresenceWriteCompleteEOS&& OnComplete) = 0;
+	/** Advances writers that simulate time */
+	virtual void Tick(float DeltaTime) {}
+};
+
+/**
+ * Sends local users' presence to EOS with as little traffic as possible. Each update is diffed against the
+ * presence EOS last acknowledged and only the changed fields are written, updates arriving faster than the
+ * interval collapse into the latest one, and updates that change nothing aren't sent at all. One write per
+ * user is in flight at a time. Driven by Tick on the game thread
+ */
+class FPresenceUpdaterEOS
+{
+public:
+	FPresenceUpdaterEOS(TUniquePtr<IPresenceWriterEOS>&& InWriter);
+
+	/** Reads the interval between writes from the engine ini */
+	void LoadConfig();
+
+	void SetInterval(float InInterval)
+	{
+		Interval = FMath::Max(InInterval, 0.f);
+	}
+
+	/**
+	 * Asks for a user's presence to become Status. It is written right away when the user's last write was
+	 * longer ago than the interval, otherwise on the first tick after it
+	 *
+	 * @param LocalUserId the local user whose presence to set
+	 * @param Status the presence wanted
+	 * @param OnComplete called once the presence is in place or the write failed, right away when nothing changes
+	 */
+	void SetPresence(EOS_EpicAccountId LocalUserId, const FOnlineUserPresenceStatus& Status, FOnPresenceWriteCompleteEOS&& OnComplete);
+
+	/** Forgets a user that signed out, updates still waiting are failed */
+	void RemoveUser(EOS_EpicAccountId LocalUserId);
+
+	/** Writes the updates whose interval has passed */
+	void Tick(float DeltaTime);
+
+private:
+	struct FUserPresence
+	{
+		/** What EOS has, as of the last successful write */
+		FPresenceRecordEOS Acked;
+		bool bHasAcked;
+		/** What the write in flight is setting */
+		FPresenceRecordEOS Sending;
+		bool bIsSending;
+		/** The latest update not written yet */
+		FPresenceRecordEOS Wanted;
+		bool bHasWanted;
+		/** Waiting on the update not written yet, and on the write in flight */
+		TArray<FOnPresenceWriteCompleteEOS> WantedWaiters;
+		TArray<FOnPresenceWriteCompleteEOS> SendingWaiters;
+		/** When the last write started */
+		double LastWriteTime;
+
+		FUserPresence()
+			: bHasAcked(false)
+			, bIsSending(false)
+			, bHasWanted(false)
+			, LastWriteTime(-MAX_dbl)
+		{
+		}
+	};
+
+	/** Shared with write callbacks so they can tell if we are gone */
+	struct FUpdaterState
+	{
+		TMap<EOS_EpicAccountId, FUserPresence> Users;
+		/** Accumulated tick time */
+		double Now;
+
+		FUpdaterState()
+			: Now(0.0)
+		{
+		}
+	};
+
+	/** Writes the user's wanted presence if it still differs from what EOS will have */
+	void Write(EOS_EpicAccountId LocalUserId, FUserPresence& User);
+
+	TUniquePtr<IPresenceWriterEOS> Writer;
+	TSharedRef<FUpdaterState> State;
+
+	/** Seconds between writes for a user, faster updates collapse into the latest */
+	float Interval;
+};
+
+#endif
@@ -0,0 +1,105 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "SessionAttributeSchemaEOS.h"
+
+#if WITH_EOS_SDK
+
+/** Upper bound on game settings we intern, search results come from other hosts so their keys are not trusted */
+#define EOS_MAX_INTERNED_SESSION_SETTINGS 1024
+
+FSessionAttributeSchemaEOS::FSessionAttributeSchemaEOS()
+{
+	OverflowEntry.Field = ESessionAttributeFieldEOS::Setting;
+
+	Add("NumPublicConnections", ESessionAttributeFieldEOS::NumPublicConnections, NAME_None);
+	Add("NumPrivateConnections", ESessionAttributeFieldEOS::NumPrivateConnections, NAME_None);
+	Add("bAntiCheatProtected", ESessionAttributeFieldEOS::bAntiCheatProtected, NAME_None);
+	Add("bUsesStats", ESessionAttributeFieldEOS::bUsesStats, NAME_None);
+	Add("bIsDedicated", ESessionAttributeFieldEOS::bIsDedicated, NAME_None);
+	Add("BuildUniqueId", ESessionAttributeFieldEOS::BuildUniqueId, NAME_None);
+	Add("OwningPlayerName", ESessionAttributeFieldEOS::OwningPlayerName, NAME_None);
+	Add("OwningNetId", ESessionAttributeFieldEOS::OwningNetId, NAME_None);
+}
+
+int32 FSessionAttributeSchemaEOS::FindIndex(const char* Key, uint32 Hash) const
+{
+	const int32* FirstIndex = Buckets.Find(Hash);
+	for (int32 Index = FirstIndex != nullptr ? *FirstIndex : INDEX_NONE; Index != INDEX_NONE; Index = Entries[Index].NextInBucket)
+	{
+		if (FCStringAnsi::Stricmp(Entries[Index].Key.GetData(), Key) == 0)
+		{
+			return Index;
+		}
+	}
+	return INDEX_NONE;
+}
+
+int32 FSessionAttributeSchemaEOS::Add(const char* Key, ESessionAttributeFieldEOS Field, FName SettingName)
+{
+	const uint32 Hash = FCrc::Strihash_DEPRECATED(Key);
+
+	const int32 Index = Entries.AddDefaulted();
+	FKeyedEntry& NewEntry = Entries[Index];
+	NewEntry.Entry.Field = Field;
+	NewEntry.Entry.SettingName = SettingName;
+	NewEntry.Key.Append(Key, FCStringAnsi::Strlen(Key) + 1);
+	NewEntry.Hash = Hash;
+
+	int32& FirstIndex = Buckets.FindOrAdd(Hash, INDEX_NONE);
+	NewEntry.NextInBucket = FirstIndex;
+	FirstIndex = Index;
+
+	if (Field == ESessionAttributeFieldEOS::Setting)
+	{
+		SettingIndices.Add(SettingName, Index);
+	}
+	return Index;
+}
+
+const FSessionAttributeSchemaEOS::FEntry* FSessionAttributeSchemaEOS::Find(const char* Key)
+{
+	if (Key == nullptr)
+	{
+		return nullptr;
+	}
+
+	const int32 Index = FindIndex(Key, FCrc::Strihash_DEPRECATED(Key));
+	if (Index != INDEX_NONE)
+	{
+		return &Entries[Index].Entry;
+	}
+
+	// First time we have seen this game setting
+	const int32 PrefixLen = UE_ARRAY_COUNT(EOS_SESSION_SETTING_PREFIX) - 1;
+	if (FCStringAnsi::Strnicmp(Key, EOS_SESSION_SETTING_PREFIX, PrefixLen) != 0 || Key[PrefixLen] == '\0')
+	{
+		return nullptr;
+	}
+
+	const FName SettingName(Key + PrefixLen);
+	if (const int32* SettingIndex = SettingIndices.Find(SettingName))
+	{
+		// Same setting with different casing
+		return &Entries[*SettingIndex].Entry;
+	}
+	if (SettingIndices.Num() >= EOS_MAX_INTERNED_SESSION_SETTINGS)
+	{
+		OverflowEntry.SettingName = SettingName;
+		return &OverflowEntry;
+	}
+	return &Entries[Add(Key, ESessionAttributeFieldEOS::Setting, SettingName)].Entry;
+}
+
+const char* FSessionAttributeSchemaEOS::GetSettingKey(FName SettingName)
+{
+	if (const int32* SettingIndex = SettingIndices.Find(SettingName))
+	{
+		return Entries[*SettingIndex].Key.GetData();
+	}
+
+	FString Key(TEXT(EOS_SESSION_SETTING_PREFIX) + SettingName.ToString());
+	const int32 Index = Add(TCHAR_TO_UTF8(*Key), ESessionAttributeFieldEOS::Setting, SettingName);
+	return Entries[Index].Key.GetData();
+}
+
+#endif
@@ -0,0 +1,78 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+#if WITH_EOS_SDK
+
+/** Prefix we put on FOnlineSessionSettings::Settings entries so they don't collide with our own attributes */
+#define EOS_SESSION_SETTING_PREFIX "FOSS="
+
+/** Which part of an FOnlineSession a session attribute is read into */
+enum class ESessionAttributeFieldEOS : uint8
+{
+	NumPublicConnections,
+	NumPrivateConnections,
+	bAntiCheatProtected,
+	bUsesStats,
+	bIsDedicated,
+	BuildUniqueId,
+	OwningPlayerName,
+	OwningNetId,
+	/** A game defined FOnlineSessionSettings::Settings entry */
+	Setting
+};
+
+/**
+ * Hashed table of every session attribute key we know how to read back, so copying search results costs
+ * a hash and a compare per attribute instead of a chain of string compares and a parse. Game settings are
+ * interned the first time they are seen along with their pre-converted attribute key for the write side
+ */
+class FSessionAttributeSchemaEOS
+{
+public:
+	struct FEntry
+	{
+		/** Where the value goes */
+		ESessionAttributeFieldEOS Field;
+		/** The FOnlineSessionSettings::Settings key, only set for ESessionAttributeFieldEOS::Setting */
+		FName SettingName;
+	};
+
+	FSessionAttributeSchemaEOS();
+
+	/**
+	 * @param Key the attribute key as returned by EOS, compared case insensitively like the SDK does
+	 *
+	 * @return how to read the attribute or null if it is not one of ours
+	 */
+	const FEntry* Find(const char* Key);
+
+	/** @return the attribute key to advertise a game setting under, owned by the schema */
+	const char* GetSettingKey(FName SettingName);
+
+private:
+	struct FKeyedEntry
+	{
+		FEntry Entry;
+		/** Null terminated attribute key */
+		TArray<ANSICHAR> Key;
+		uint32 Hash;
+		/** Next entry in the same hash bucket */
+		int32 NextInBucket;
+	};
+
+	int32 FindIndex(const char* Key, uint32 Hash) const;
+	int32 Add(const char* Key, ESessionAttributeFieldEOS Field, FName SettingName);
+
+	TArray<FKeyedEntry> Entries;
+	/** First entry for each hash */
+	TMap<uint32, int32> Buckets;
+	/** Game settings we have already built keys for */
+	TMap<FName, int32> SettingIndices;
+	/** Used once the table is full so remote hosts can't grow it forever */
+	FEntry OverflowEntry;
+};
+
+#endif
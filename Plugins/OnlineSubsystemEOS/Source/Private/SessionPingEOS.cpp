@@ -0,0 +1,375 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "SessionPingEOS.h"
+#include "SocketSubsystemEOS.h"
+#include "OnlineSessionSettings.h"
+#include "Misc/ConfigCacheIni.h"
+#include "Misc/ScopeLock.h"
+
+#if WITH_EOS_SDK
+	#include "P2PLoopbackEOS.h"
+	#include "BenchEOS.h"
+
+/** Probe layout: 4 byte magic, type, attempt, 2 reserved bytes, then the little endian probe id */
+#define EOS_SESSION_PING_PACKET_SIZE 12
+
+static const uint8 PingPacketMagic[4] = { 'E', 'P', 'N', 'G' };
+
+enum class EPingPacketTypeEOS : uint8
+{
+	Request,
+	Reply
+};
+
+static void WritePingPacket(uint8* Packet, EPingPacketTypeEOS Type, uint8 Attempt, uint32 ProbeId)
+{
+	FMemory::Memcpy(Packet, PingPacketMagic, sizeof(PingPacketMagic));
+	Packet[4] = (uint8)Type;
+	Packet[5] = Attempt;
+	Packet[6] = 0;
+	Packet[7] = 0;
+	Packet[8] = (uint8)(ProbeId & 0xFF);
+	Packet[9] = (uint8)((ProbeId >> 8) & 0xFF);
+	Packet[10] = (uint8)((ProbeId >> 16) & 0xFF);
+	Packet[11] = (uint8)((ProbeId >> 24) & 0xFF);
+}
+
+static bool ReadPingPacket(const uint8* Packet, int32 Count, EPingPacketTypeEOS& OutType, uint8& OutAttempt, uint32& OutProbeId)
+{
+	if (Count != EOS_SESSION_PING_PACKET_SIZE || FMemory::Memcmp(Packet, PingPacketMagic, sizeof(PingPacketMagic)) != 0 || Packet[4] > (uint8)EPingPacketTypeEOS::Reply)
+	{
+		return false;
+	}
+	OutType = (EPingPacketTypeEOS)Packet[4];
+	OutAttempt = Packet[5];
+	OutProbeId = (uint32)Packet[8] | ((uint32)Packet[9] << 8) | ((uint32)Packet[10] << 16) | ((uint32)Packet[11] << 24);
+	return true;
+}
+
+FSessionPingEOS::FSessionPingEOS(FSocketSubsystemEOS& InSocketSubsystem)
+	: SocketSubsystem(InSocketSubsystem)
+	, NextProbeId(1)
+	, TickTime(0.0)
+	, RetryInterval(0.1f)
+	, Timeout(2.f)
+{
+	RecvPackets.SetNum(8);
+}
+
+FSessionPingEOS::~FSessionPingEOS()
+{
+	Shutdown();
+}
+
+void FSessionPingEOS::LoadConfig()
+{
+	GConfig->GetFloat(TEXT("/Script/OnlineSubsystemEOS.NetDriverEOS"), TEXT("SessionPingRetryInterval"), RetryInterval, GEngineIni);
+	GConfig->GetFloat(TEXT("/Script/OnlineSubsystemEOS.NetDriverEOS"), TEXT("SessionPingTimeout"), Timeout, GEngineIni);
+	RetryInterval = FMath::Max(RetryInterval, 0.01f);
+	Timeout = FMath::Max(Timeout, RetryInterval);
+}
+
+void FSessionPingEOS::Shutdown()
+{
+	// Nobody is left to tell
+	Probes.Empty();
+	Responders.Empty();
+	for (TPair<EOS_ProductUserId, FUserSocket>& Pair : UserSockets)
+	{
+		SocketSubsystem.DestroySocket(Pair.Value.Socket);
+	}
+	UserSockets.Empty();
+}
+
+double FSessionPingEOS::GetTime() const
+{
+	return FP2PLoopbackEOS::Get() != nullptr ? TickTime : FPlatformTime::Seconds();
+}
+
+FSessionPingEOS::FUserSocket* FSessionPingEOS::FindOrAddUserSocket(EOS_ProductUserId LocalUserId)
+{
+	if (FUserSocket* UserSocket = UserSockets.Find(LocalUserId))
+	{
+		return UserSocket;
+	}
+	if (FP2PTransportEOS::ProductUserIdIsValid(LocalUserId) != EOS_TRUE)
+	{
+		return nullptr;
+	}
+
+	FInternetAddrEOS LocalAddress;
+	LocalAddress.SetLocalUserId(LocalUserId);
+	LocalAddress.SetSocketName(EOS_SESSION_PING_SOCKET_NAME);
+	LocalAddress.SetChannel(EOS_SESSION_PING_CHANNEL);
+
+	// Set the address directly since every local user has its own ping socket on the same name and channel
+	FSocketEOS* Socket = static_cast<FSocketEOS*>(SocketSubsystem.CreateSocket(NAME_DGram, TEXT("EOSSessionPing"), NAME_None));
+	if (Socket == nullptr)
+	{
+		return nullptr;
+	}
+	Socket->SetLocalAddress(LocalAddress);
+
+	FUserSocket& UserSocket = UserSockets.Add(LocalUserId);
+	UserSocket.Socket = Socket;
+	return &UserSocket;
+}
+
+void FSessionPingEOS::ReleaseUserSocketIfIdle(EOS_ProductUserId LocalUserId)
+{
+	FUserSocket* UserSocket = UserSockets.Find(LocalUserId);
+	if (UserSocket == nullptr || UserSocket->NumResponders > 0)
+	{
+		return;
+	}
+	for (const TPair<uint32, FProbe>& Pair : Probes)
+	{
+		if (Pair.Value.LocalUserId == LocalUserId)
+		{
+			return;
+		}
+	}
+	SocketSubsystem.DestroySocket(UserSocket->Socket);
+	UserSockets.Remove(LocalUserId);
+}
+
+void FSessionPingEOS::AddResponder(FName SessionName, EOS_ProductUserId LocalUserId)
+{
+	RemoveResponder(SessionName);
+
+	FUserSocket* UserSocket = FindOrAddUserSocket(LocalUserId);
+	if (UserSocket == nullptr)
+	{
+		UE_LOG(LogSocketSubsystemEOS, Warning, TEXT("Unable to answer latency probes for session (%s)"), *SessionName.ToString());
+		return;
+	}
+
+	// Listening accepts the connections clients open with their first probe
+	if (UserSocket->NumResponders++ == 0)
+	{
+		UserSocket->Socket->Listen(0);
+	}
+	Responders.Add(SessionName, LocalUserId);
+}
+
+void FSessionPingEOS::RemoveResponder(FName SessionName)
+{
+	EOS_ProductUserId LocalUserId = nullptr;
+	if (!Responders.RemoveAndCopyValue(SessionName, LocalUserId))
+	{
+		return;
+	}
+	FUserSocket* UserSocket = UserSockets.Find(LocalUserId);
+	if (UserSocket != nullptr && --UserSocket->NumResponders == 0)
+	{
+		// Close the listener, our own probes reopen the socket on their next retry if they need it
+		SocketSubsystem.DestroySocket(UserSocket->Socket);
+		UserSockets.Remove(LocalUserId);
+	}
+}
+
+bool FSessionPingEOS::Ping(EOS_ProductUserId LocalUserId, EOS_ProductUserId HostUserId, FOnSessionPingCompleteEOS&& OnComplete, const FString& HostSocketName)
+{
+	if (FP2PTransportEOS::ProductUserIdIsValid(HostUserId) != EOS_TRUE || FindOrAddUserSocket(LocalUserId) == nullptr)
+	{
+		return false;
+	}
+
+	const double Now = GetTime();
+	const uint32 ProbeId = NextProbeId++;
+	FProbe& Probe = Probes.Add(ProbeId);
+	Probe.LocalUserId = LocalUserId;
+	Probe.Destination = FInternetAddrEOS(HostUserId, HostSocketName, EOS_SESSION_PING_CHANNEL);
+	Probe.NumSent = 0;
+	Probe.Deadline = Now + Timeout;
+	Probe.OnComplete = MoveTemp(OnComplete);
+	SendProbe(ProbeId, Probe, Now);
+	return true;
+}
+
+void FSessionPingEOS::SendProbe(uint32 ProbeId, FProbe& Probe, double Now)
+{
+	FUserSocket* UserSocket = FindOrAddUserSocket(Probe.LocalUserId);
+	if (UserSocket == nullptr)
+	{
+		return;
+	}
+
+	uint8 Packet[EOS_SESSION_PING_PACKET_SIZE];
+	WritePingPacket(Packet, EPingPacketTypeEOS::Request, (uint8)Probe.NumSent, ProbeId);
+
+	int32 BytesSent = 0;
+	UserSocket->Socket->SendTo(Packet, EOS_SESSION_PING_PACKET_SIZE, BytesSent, Probe.Destination);
+
+	Probe.SendTimes[Probe.NumSent++] = Now;
+	Probe.NextSendTime = Now + RetryInterval;
+}
+
+void FSessionPingEOS::ReceivePackets(EOS_ProductUserId LocalUserId, FUserSocket& UserSocket, double Now, TArray<TPair<uint32, int32>>& OutCompleted)
+{
+	int32 NumReceived = 0;
+	while (UserSocket.Socket->RecvFromBatch(RecvPackets, NumReceived) && NumReceived > 0)
+	{
+		for (int32 Index = 0; Index < NumReceived; Index++)
+		{
+			FSocketEOSRecvPacket& Packet = RecvPackets[Index];
+
+			EPingPacketTypeEOS Type;
+			uint8 Attempt = 0;
+			uint32 ProbeId = 0;
+			if (!ReadPingPacket(Packet.Data, Packet.BytesRead, Type, Attempt, ProbeId))
+			{
+				continue;
+			}
+
+			if (Type == EPingPacketTypeEOS::Request)
+			{
+				if (UserSocket.NumResponders > 0)
+				{
+					WritePingPacket(Packet.Data, EPingPacketTypeEOS::Reply, Attempt, ProbeId);
+					int32 BytesSent = 0;
+					UserSocket.Socket->SendTo(Packet.Data, EOS_SESSION_PING_PACKET_SIZE, BytesSent, Packet.Source);
+				}
+				continue;
+			}
+
+			// Ignore replies to probes that already finished or that belong to another user
+			const FProbe* Probe = Probes.Find(ProbeId);
+			if (Probe == nullptr || Probe->LocalUserId != LocalUserId || Attempt >= Probe->NumSent || Packet.Source.GetRemoteUserId() != Probe->Destination.GetRemoteUserId())
+			{
+				continue;
+			}
+			const int32 PingInMs = FMath::Clamp(FMath::RoundToInt((Now - Probe->SendTimes[Attempt]) * 1000.0), 0, MAX_QUERY_PING - 1);
+			OutCompleted.Emplace(ProbeId, PingInMs);
+			// Don't let a second reply complete it again
+			Probes[ProbeId].NumSent = 0;
+		}
+	}
+}
+
+void FSessionPingEOS::Tick(float DeltaTime)
+{
+	TickTime += DeltaTime;
+	if (UserSockets.Num() == 0 && Probes.Num() == 0)
+	{
+		return;
+	}
+
+	const double Now = GetTime();
+	TArray<TPair<uint32, int32>> Completed;
+	for (TPair<EOS_ProductUserId, FUserSocket>& Pair : UserSockets)
+	{
+		ReceivePackets(Pair.Key, Pair.Value, Now, Completed);
+	}
+
+	for (TPair<uint32, FProbe>& Pair : Probes)
+	{
+		FProbe& Probe = Pair.Value;
+		if (Probe.NumSent == 0)
+		{
+			// Answered above
+			continue;
+		}
+		if (Now >= Probe.Deadline)
+		{
+			Completed.Emplace(Pair.Key, MAX_QUERY_PING);
+		}
+		else if (Now >= Probe.NextSendTime && Probe.NumSent < EOS_SESSION_PING_MAX_ATTEMPTS)
+		{
+			SendProbe(Pair.Key, Probe, Now);
+		}
+	}
+
+	// Callbacks may start new pings so take the probes out of the table first
+	for (const TPair<uint32, int32>& Result : Completed)
+	{
+		FProbe Probe;
+		if (Probes.RemoveAndCopyValue(Result.Key, Probe))
+		{
+			ReleaseUserSocketIfIdle(Probe.LocalUserId);
+			Probe.OnComplete(Result.Value);
+		}
+	}
+}
+
+#if !UE_BUILD_SHIPPING
+bool FSessionPingEOS::HandleBenchExec(FSocketSubsystemEOS& SocketSubsystem, const TCHAR* Cmd, FOutputDevice& Ar)
+{
+	FP2PLoopbackEOS* Loopback = FBenchEOS::GetLoopback(Ar);
+	if (Loopback == nullptr)
+	{
+		return true;
+	}
+
+	int32 NumHosts = 4;
+	float LatencyMs = 20.f;
+	float LossPercent = 0.f;
+	FParse::Value(Cmd, TEXT("Hosts="), NumHosts);
+	FParse::Value(Cmd, TEXT("Latency="), LatencyMs);
+	FParse::Value(Cmd, TEXT("Loss="), LossPercent);
+	NumHosts = FMath::Clamp(NumHosts, 1, 32);
+	LatencyMs = FMath::Max(LatencyMs, 0.f);
+
+	const FP2PLoopbackSettingsEOS PreviousSettings = Loopback->GetSettings();
+	FP2PLoopbackSettingsEOS BenchSettings = PreviousSettings;
+	BenchSettings.Loss = LossPercent / 100.f;
+	BenchSettings.Reorder = 0.f;
+
+	FSessionPingEOS Pinger(SocketSubsystem);
+	const EOS_ProductUserId ClientUserId = Loopback->CreateUser();
+	TArray<EOS_ProductUserId, TInlineAllocator<32>> HostUserIds;
+	for (int32 HostIndex = 0; HostIndex < NumHosts; HostIndex++)
+	{
+		HostUserIds.Add(Loopback->CreateUser());
+		Pinger.AddResponder(*FString::Printf(TEXT("EOSPingBench%d"), HostIndex), HostUserIds.Last());
+	}
+
+	// Hosts are given decreasing latency so sorting has something to do
+	const float TickDelta = 0.001f;
+	TArray<int32, TInlineAllocator<32>> Expected;
+	TArray<int32, TInlineAllocator<32>> Measured;
+	for (int32 HostIndex = 0; HostIndex < NumHosts; HostIndex++)
+	{
+		BenchSettings.Latency = LatencyMs * (NumHosts - HostIndex) / 1000.f;
+		Loopback->SetSettings(BenchSettings);
+		Expected.Add(FMath::RoundToInt(BenchSettings.Latency * 2000.f));
+
+		int32 Result = INDEX_NONE;
+		Pinger.Ping(ClientUserId, HostUserIds[HostIndex], [&Result](int32 PingInMs)
+		{
+			Result = PingInMs;
+		});
+		while (Result == INDEX_NONE && Pinger.HasPendingPings())
+		{
+			FBenchEOS::TickLoopback(SocketSubsystem, *Loopback, TickDelta);
+			Pinger.Tick(TickDelta);
+		}
+		Measured.Add(Result);
+	}
+
+	Loopback->SetSettings(PreviousSettings);
+	Pinger.Shutdown();
+
+	TArray<int32, TInlineAllocator<32>> Order;
+	for (int32 HostIndex = 0; HostIndex < NumHosts; HostIndex++)
+	{
+		Order.Add(HostIndex);
+	}
+	Order.StableSort([&Measured](int32 A, int32 B)
+	{
+		return Measured[A] < Measured[B];
+	});
+
+	bool bIsSorted = true;
+	for (int32 Rank = 0; Rank < NumHosts; Rank++)
+	{
+		const int32 HostIndex = Order[Rank];
+		bIsSorted &= Rank == 0 || Expected[Order[Rank - 1]] <= Expected[HostIndex];
+		Ar.Logf(TEXT("Host %d: expected %d ms, measured %d ms"), HostIndex, Expected[HostIndex], Measured[HostIndex]);
+	}
+	Ar.Logf(TEXT("Sorted by measured ping the hosts are %s"), bIsSorted ? TEXT("in latency order") : TEXT("OUT of latency order"));
+	return true;
+}
+#endif
+
+#endif
@@ -0,0 +1,134 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "SocketEOS.h"
+
+class FSocketSubsystemEOS;
+
+#if WITH_EOS_SDK
+
+/** Socket name latency probes are sent on, kept apart from session sockets so closing it never drops game connections */
+#define EOS_SESSION_PING_SOCKET_NAME TEXT("EOSPing")
+/** Channel latency probes are sent on */
+#define EOS_SESSION_PING_CHANNEL 254
+/** Most probes sent per ping, the first usually only opens the connection */
+#define EOS_SESSION_PING_MAX_ATTEMPTS 8
+
+/** Called with the round trip time in milliseconds, or MAX_QUERY_PING if the host never answered */
+typedef TFunction<void(int32 PingInMs)> FOnSessionPingCompleteEOS;
+
+/**
+ * Measures round trip times to session hosts over P2P. Hosts echo probes back on a dedicated socket name
+ * and channel; clients send a probe per retry interval until one comes back and time that attempt.
+ * Everything happens on the game thread from Tick
+ */
+class FSessionPingEOS
+{
+public:
+	FSessionPingEOS(FSocketSubsystemEOS& InSocketSubsystem);
+	~FSessionPingEOS();
+
+	/** Reads the timeout and retry interval from the engine ini */
+	void LoadConfig();
+
+	/** Starts answering probes for a session we host as this user */
+	void AddResponder(FName SessionName, EOS_ProductUserId LocalUserId);
+	/** Stops answering probes for a session, the user's socket stays open while it hosts others */
+	void RemoveResponder(FName SessionName);
+
+	/**
+	 * Starts measuring the round trip time to a host
+	 *
+	 * @param LocalUserId who we are probing as
+	 * @param HostUserId the product user id of the session host
+	 * @param OnComplete called from Tick once the host answers or the ping times out
+	 * @param HostSocketName the socket name the probes are sent on, EOS opens the connection for it if needed.
+	 *		Probes and replies stay on the ping channel whatever the name, so the host's ping socket still answers
+	 *
+	 * @return false if the probe could not be started, OnComplete is not called
+	 */
+	bool Ping(EOS_ProductUserId LocalUserId, EOS_ProductUserId HostUserId, FOnSessionPingCompleteEOS&& OnComplete, const FString& HostSocketName = EOS_SESSION_PING_SOCKET_NAME);
+
+	/** Answers probes, matches replies and sends retries */
+	void Tick(float DeltaTime);
+
+	/** @return true if any pings have not completed yet */
+	bool HasPendingPings() const
+	{
+		return Probes.Num() > 0;
+	}
+
+	/** Closes every socket, must be called before the EOS platform is released */
+	void Shutdown();
+
+#if !UE_BUILD_SHIPPING
+	/**
+	 * Pings loopback hosts that each have a different injected latency and reports what was measured
+	 *
+	 * @param Cmd the rest of the command, Hosts= Latency= (ms, hosts get multiples of it) Loss= (%)
+	 * @param Ar where to write the results
+	 * @return true if the command was handled
+	 */
+	static bool HandleBenchExec(FSocketSubsystemEOS& SocketSubsystem, const TCHAR* Cmd, FOutputDevice& Ar);
+#endif
+
+private:
+	/** One socket per local user that both sends our probes and answers everyone else's */
+	struct FUserSocket
+	{
+		FSocketEOS* Socket;
+		/** Sessions we host as this user, we only listen for probes while there are some */
+		int32 NumResponders;
+
+		FUserSocket()
+			: Socket(nullptr)
+			, NumResponders(0)
+		{
+		}
+	};
+
+	struct FProbe
+	{
+		EOS_ProductUserId LocalUserId;
+		FInternetAddrEOS Destination;
+		/** When each attempt went out, replies echo the attempt index */
+		double SendTimes[EOS_SESSION_PING_MAX_ATTEMPTS];
+		int32 NumSent;
+		double NextSendTime;
+		double Deadline;
+		FOnSessionPingCompleteEOS OnComplete;
+	};
+
+	/** @return the socket for a user, opening it if needed */
+	FUserSocket* FindOrAddUserSocket(EOS_ProductUserId LocalUserId);
+	/** Closes the socket for a user once nothing needs it */
+	void ReleaseUserSocketIfIdle(EOS_ProductUserId LocalUserId);
+
+	void SendProbe(uint32 ProbeId, FProbe& Probe, double Now);
+	void ReceivePackets(EOS_ProductUserId LocalUserId, FUserSocket& UserSocket, double Now, TArray<TPair<uint32, int32>>& OutCompleted);
+
+	/** @return seconds on the same clock the transport uses, simulated time when running over the loopback */
+	double GetTime() const;
+
+	FSocketSubsystemEOS& SocketSubsystem;
+
+	TMap<EOS_ProductUserId, FUserSocket> UserSockets;
+	TMap<FName, EOS_ProductUserId> Responders;
+	TMap<uint32, FProbe> Probes;
+	uint32 NextProbeId;
+
+	/** Reused receive buffers */
+	TArray<FSocketEOSRecvPacket> RecvPackets;
+
+	/** Accumulated tick time, used as the clock over the loopback transport */
+	double TickTime;
+
+	/** Seconds between probes to the same host */
+	float RetryInterval;
+	/** Seconds before a host that hasn't answered is given MAX_QUERY_PING */
+	float Timeout;
+};
+
+#endif
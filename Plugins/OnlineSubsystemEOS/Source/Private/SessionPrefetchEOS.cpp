@@ -0,0 +1,278 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "SessionPrefetchEOS.h"
+#include "OnlineSubsystemEOS.h"
+#include "Misc/ConfigCacheIni.h"
+#include "Math/RandomStream.h"
+#include "OnlineSubsystemUtils.h"
+#include "OnlineSubsystemEOSTypes.h"
+#include "SocketSubsystem.h"
+#include "IPAddress.h"
+#include "SessionPingEOS.h"
+#include "BenchEOS.h"
+
+#if WITH_EOS_SDK
+
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Session Results Prefetched"), STAT_EOS_SessionResultsPrefetched, STATGROUP_EOS);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Session Hosts Warmed"), STAT_EOS_SessionHostsWarmed, STATGROUP_EOS);
+
+bool FSessionPingWarmBackendEOS::StartWarm(EOS_ProductUserId LocalUserId, const FInternetAddrEOS& HostAddress, FOnSessionWarmCompleteEOS&& OnComplete)
+{
+	return SessionPing.Ping(LocalUserId, HostAddress.GetRemoteUserId(), [OnComplete = MoveTemp(OnComplete)](int32 PingInMs)
+	{
+		OnComplete(PingInMs != MAX_QUERY_PING);
+	}, UTF8_TO_TCHAR(HostAddress.GetSocketName()));
+}
+
+FSessionPrefetchEOS::FSessionPrefetchEOS(TUniquePtr<ISessionWarmBackendEOS>&& InBackend)
+	: Backend(MoveTemp(InBackend))
+	, State(MakeShared<FWarmState>())
+	, NumToPrefetch(0)
+	, WarmTime(20.f)
+{
+}
+
+void FSessionPrefetchEOS::LoadConfig()
+{
+	GConfig->GetInt(TEXT("/Script/OnlineSubsystemEOS.NetDriverEOS"), TEXT("SessionPrefetchCount"), NumToPrefetch, GEngineIni);
+	GConfig->GetFloat(TEXT("/Script/OnlineSubsystemEOS.NetDriverEOS"), TEXT("SessionPrefetchWarmTime"), WarmTime, GEngineIni);
+	NumToPrefetch = FMath::Max(NumToPrefetch, 0);
+	WarmTime = FMath::Max(WarmTime, 0.f);
+}
+
+void FSessionPrefetchEOS::PrefetchSessionInfo(FOnlineSessionInfoEOS& SessionInfo, int32 BeaconPort)
+{
+	if (!SessionInfo.HostAddr.IsValid())
+	{
+		return;
+	}
+
+	// The same strings GetResolvedConnectString() would build
+	SessionInfo.PrefetchedConnectString = SessionInfo.EOSAddress.Len() > 0 ? SessionInfo.EOSAddress : SessionInfo.HostAddr->ToString(true);
+	SessionInfo.PrefetchedBeaconPort = BeaconPort;
+	SessionInfo.PrefetchedBeaconConnectString = BeaconPort != 0 ? FString::Printf(TEXT("%s:%d"), *SessionInfo.HostAddr->ToString(false), BeaconPort) : FString();
+	if (!SessionInfo.PrefetchedHostAddr.IsValid())
+	{
+		SessionInfo.PrefetchedHostAddr = SessionInfo.HostAddr->Clone();
+	}
+}
+
+int32 FSessionPrefetchEOS::Prefetch(FOnlineSessionSearch& Search, EOS_ProductUserId LocalUserId, TFunctionRef<const FInternetAddrEOS*(const FOnlineSessionSearchResult&)> GetHostAddress)
+{
+	const int32 NumResults = FMath::Min(Search.SearchResults.Num(), NumToPrefetch);
+	for (int32 Index = 0; Index < NumResults; Index++)
+	{
+		FOnlineSessionSearchResult& Result = Search.SearchResults[Index];
+		if (!Result.Session.SessionInfo.IsValid())
+		{
+			continue;
+		}
+		FOnlineSessionInfoEOS& SessionInfo = *StaticCastSharedPtr<FOnlineSessionInfoEOS>(Result.Session.SessionInfo);
+		PrefetchSessionInfo(SessionInfo, GetBeaconPortFromSessionSettings(Result.Session.SessionSettings));
+
+		// Hosts that are already warm or warming don't need another round
+		const FInternetAddrEOS* HostAddress = GetHostAddress(Result);
+		EOS_ProductUserId HostUserId = HostAddress != nullptr ? HostAddress->GetRemoteUserId() : nullptr;
+		if (LocalUserId == nullptr || HostUserId == nullptr || IsHostWarm(HostUserId) || State->PendingHosts.Contains(HostUserId))
+		{
+			continue;
+		}
+		TWeakPtr<FWarmState> WeakState = State;
+		const bool bStarted = Backend->StartWarm(LocalUserId, *HostAddress, [WeakState, HostUserId](bool bWasSuccessful)
+		{
+			TSharedPtr<FWarmState> PinnedState = WeakState.Pin();
+			if (PinnedState.IsValid())
+			{
+				PinnedState->PendingHosts.Remove(HostUserId);
+				if (bWasSuccessful)
+				{
+					PinnedState->WarmHosts.Add(HostUserId, PinnedState->Now);
+					INC_DWORD_STAT(STAT_EOS_SessionHostsWarmed);
+				}
+			}
+		});
+		if (bStarted)
+		{
+			State->PendingHosts.Add(HostUserId);
+		}
+	}
+	INC_DWORD_STAT_BY(STAT_EOS_SessionResultsPrefetched, NumResults);
+	return NumResults;
+}
+
+bool FSessionPrefetchEOS::IsHostWarm(EOS_ProductUserId HostUserId) const
+{
+	const double* WarmedAt = State->WarmHosts.Find(HostUserId);
+	return WarmedAt != nullptr && State->Now - *WarmedAt <= WarmTime;
+}
+
+void FSessionPrefetchEOS::Tick(float DeltaTime)
+{
+	State->Now += DeltaTime;
+	Backend->Tick(DeltaTime);
+
+	// Forget hosts whose connection has most likely been closed for being idle
+	if (State->WarmHosts.Num() > 0)
+	{
+		const double OldestWarm = State->Now - WarmTime;
+		for (TMap<EOS_ProductUserId, double>::TIterator It(State->WarmHosts); It; ++It)
+		{
+			if (It.Value() < OldestWarm)
+			{
+				It.RemoveCurrent();
+			}
+		}
+	}
+}
+
+#if !UE_BUILD_SHIPPING
+/** Warms hosts after a fixed number of round trips, the way setting up an EOS P2P connection would */
+class FMockSessionWarmBackendEOS :
+	public ISessionWarmBackendEOS
+{
+public:
+	FMockSessionWarmBackendEOS(double InWarmDelay)
+		: WarmDelay(InWarmDelay)
+		, Time(0.0)
+		, NumWarms(0)
+	{
+	}
+
+	virtual bool StartWarm(EOS_ProductUserId LocalUserId, const FInternetAddrEOS& HostAddress, FOnSessionWarmCompleteEOS&& OnComplete) override
+	{
+		Pending.Emplace(Time + WarmDelay, MoveTemp(OnComplete));
+		NumWarms++;
+		return true;
+	}
+
+	virtual void Tick(float DeltaTime) override
+	{
+		Time += DeltaTime;
+		// Completions can start more warms so take the due ones out first
+		TArray<FOnSessionWarmCompleteEOS> Due;
+		for (int32 Index = Pending.Num() - 1; Index >= 0; Index--)
+		{
+			if (Pending[Index].Key <= Time)
+			{
+				Due.Add(MoveTemp(Pending[Index].Value));
+				Pending.RemoveAtSwap(Index);
+			}
+		}
+		for (FOnSessionWarmCompleteEOS& OnComplete : Due)
+		{
+			OnComplete(true);
+		}
+	}
+
+	int32 GetNumWarms() const
+	{
+		return NumWarms;
+	}
+
+private:
+	double WarmDelay;
+	double Time;
+	int32 NumWarms;
+	TArray<TPair<double, FOnSessionWarmCompleteEOS>> Pending;
+};
+
+bool FSessionPrefetchEOS::HandleBenchExec(const TCHAR* Cmd, FOutputDevice& Ar)
+{
+	int32 NumRuns = 200;
+	int32 NumSessions = 50;
+	int32 NumTop = 5;
+	float LatencyMs = 80.f;
+	int32 HandshakeRoundTrips = 3;
+	float ThinkMs = 1500.f;
+	int32 Seed = 1;
+	FParse::Value(Cmd, TEXT("Runs="), NumRuns);
+	FParse::Value(Cmd, TEXT("Sessions="), NumSessions);
+	FParse::Value(Cmd, TEXT("Top="), NumTop);
+	FParse::Value(Cmd, TEXT("Latency="), LatencyMs);
+	FParse::Value(Cmd, TEXT("Handshake="), HandshakeRoundTrips);
+	FParse::Value(Cmd, TEXT("Think="), ThinkMs);
+	FParse::Value(Cmd, TEXT("Seed="), Seed);
+	NumRuns = FMath::Clamp(NumRuns, 1, 10000);
+	NumSessions = FMath::Clamp(NumSessions, 1, 1000);
+	NumTop = FMath::Clamp(NumTop, 0, NumSessions);
+	HandshakeRoundTrips = FMath::Max(HandshakeRoundTrips, 1);
+
+	ISocketSubsystem* PlatformSockets = ISocketSubsystem::Get(PLATFORM_SOCKETSUBSYSTEM);
+	if (PlatformSockets == nullptr)
+	{
+		Ar.Logf(TEXT("No platform socket subsystem to build host addresses with"));
+		return true;
+	}
+
+	const double RoundTrip = LatencyMs / 1000.0;
+	const float TickDelta = 0.01f;
+	// Only used as map keys, never handed to the SDK
+	EOS_ProductUserId LocalUserId = reinterpret_cast<EOS_ProductUserId>(UPTRINT(1));
+
+	for (int32 Pass = 0; Pass < 2; Pass++)
+	{
+		const bool bUsePrefetch = Pass == 1;
+		FRandomStream Random(Seed);
+		FMockSessionWarmBackendEOS* MockBackend = new FMockSessionWarmBackendEOS(RoundTrip * HandshakeRoundTrips);
+		FSessionPrefetchEOS Prefetcher((TUniquePtr<ISessionWarmBackendEOS>(MockBackend)));
+		Prefetcher.SetNumToPrefetch(bUsePrefetch ? NumTop : 0);
+
+		TArray<double> ClickToConnected;
+		double PrepTime = 0.0;
+		int32 NumPrefetchedJoins = 0;
+		int32 NumWarmJoins = 0;
+		for (int32 Run = 0; Run < NumRuns; Run++)
+		{
+			// A fresh page of results from hosts we haven't seen before
+			FOnlineSessionSearch Search;
+			TMap<const FOnlineSessionInfo*, FInternetAddrEOS> HostAddresses;
+			for (int32 SessionIndex = 0; SessionIndex < NumSessions; SessionIndex++)
+			{
+				FOnlineSessionInfoEOS* SessionInfo = new FOnlineSessionInfoEOS();
+				SessionInfo->HostAddr = PlatformSockets->CreateInternetAddr();
+				SessionInfo->HostAddr->SetIp((10u << 24) | (uint32)(Run * NumSessions + SessionIndex + 1));
+				SessionInfo->HostAddr->SetPort(7777);
+				FOnlineSessionSearchResult& Result = Search.SearchResults.AddDefaulted_GetRef();
+				Result.Session.SessionInfo = MakeShareable(SessionInfo);
+				HostAddresses.Add(SessionInfo, FInternetAddrEOS(reinterpret_cast<EOS_ProductUserId>(UPTRINT(2 + Run * NumSessions + SessionIndex)), TEXT("GameSession"), 7777));
+			}
+
+			Prefetcher.Prefetch(Search, LocalUserId, [&HostAddresses](const FOnlineSessionSearchResult& Result)
+			{
+				return HostAddresses.Find(Result.Session.SessionInfo.Get());
+			});
+			for (double Think = 0.0; Think < ThinkMs / 1000.0; Think += TickDelta)
+			{
+				Prefetcher.Tick(TickDelta);
+			}
+
+			// Players mostly pick from the top of a server list
+			const int32 TopCount = FMath::Max(NumTop, 1);
+			const int32 Picked = Random.GetFraction() < 0.8f ? Random.RandRange(0, TopCount - 1) : Random.RandRange(0, NumSessions - 1);
+			const FOnlineSessionInfoEOS& PickedInfo = static_cast<const FOnlineSessionInfoEOS&>(*Search.SearchResults[Picked].Session.SessionInfo);
+
+			// What joining and GetResolvedConnectString() do locally, timed for real
+			const double PrepStart = FPlatformTime::Seconds();
+			TSharedPtr<FInternetAddr> JoinAddr = PickedInfo.PrefetchedHostAddr.IsValid() ? PickedInfo.PrefetchedHostAddr : PickedInfo.HostAddr->Clone();
+			const FString ConnectString = PickedInfo.PrefetchedConnectString.Len() > 0 ? PickedInfo.PrefetchedConnectString : PickedInfo.HostAddr->ToString(true);
+			const double Prep = FPlatformTime::Seconds() - PrepStart;
+			PrepTime += Prep;
+
+			const bool bIsWarm = Prefetcher.IsHostWarm(HostAddresses.FindChecked(&PickedInfo).GetRemoteUserId());
+			NumPrefetchedJoins += PickedInfo.PrefetchedConnectString.Len() > 0 ? 1 : 0;
+			NumWarmJoins += bIsWarm ? 1 : 0;
+			ClickToConnected.Add(Prep + RoundTrip * (bIsWarm ? 1 : HandshakeRoundTrips));
+		}
+
+		const FBenchSummaryEOS Summary(ClickToConnected);
+		Ar.Logf(TEXT("Prefetch %s: click to connected mean %.1f ms, p50 %.1f ms, p95 %.1f ms, local prep mean %.2f us"),
+			bUsePrefetch ? *FString::Printf(TEXT("top %d"), NumTop) : TEXT("off"),
+			1000.0 * Summary.Mean, 1000.0 * Summary.P50, 1000.0 * Summary.P95, 1000000.0 * PrepTime / NumRuns);
+		Ar.Logf(TEXT("  %d joins: %d prefetched (%.1f%%), %d to warm hosts (%.1f%%), %d warms started"),
+			NumRuns, NumPrefetchedJoins, 100.f * NumPrefetchedJoins / NumRuns, NumWarmJoins, 100.f * NumWarmJoins / NumRuns, MockBackend->GetNumWarms());
+	}
+	return true;
+}
+#endif
+
+#endif
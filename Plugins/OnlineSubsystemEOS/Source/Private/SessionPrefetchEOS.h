@@ -0,0 +1,145 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "OnlineSessionSettings.h"
+
+class FSessionPingEOS;
+class FOnlineSessionInfoEOS;
+class FInternetAddrEOS;
+
+#if WITH_EOS_SDK
+	#include "eos_common.h"
+
+/** Called once a host has been warmed, bWasSuccessful is false if it never answered */
+typedef TFunction<void(bool bWasSuccessful)> FOnSessionWarmCompleteEOS;
+
+/** Opens the P2P route to a session host ahead of a join, so prefetching can be driven by a mock as well as by EOS */
+class ISessionWarmBackendEOS
+{
+public:
+	virtual ~ISessionWarmBackendEOS() {}
+
+	/**
+	 * Opens the connection a join to the host would use
+	 *
+	 * @param LocalUserId who to connect as
+	 * @param HostAddress the host's game address, its socket name is the connection to open
+	 *
+	 * @return false if the warm could not be started, OnComplete is not called
+	 */
+	virtual bool StartWarm(EOS_ProductUserId LocalUserId, const FInternetAddrEOS& HostAddress, FOnSessionWarmCompleteEOS&& OnComplete) = 0;
+	/** Advances backends that simulate time */
+	virtual void Tick(float DeltaTime) {}
+};
+
+/**
+ * Warms hosts by pinging them on their game socket name, so the probes make EOS set up the same connection
+ * the net driver joins over. The host's listening net driver accepts it and its ping socket answers
+ */
+class FSessionPingWarmBackendEOS :
+	public ISessionWarmBackendEOS
+{
+public:
+	FSessionPingWarmBackendEOS(FSessionPingEOS& InSessionPing)
+		: SessionPing(InSessionPing)
+	{
+	}
+
+// ISessionWarmBackendEOS
+	virtual bool StartWarm(EOS_ProductUserId LocalUserId, const FInternetAddrEOS& HostAddress, FOnSessionWarmCompleteEOS&& OnComplete) override;
+// ~ISessionWarmBackendEOS
+
+private:
+	FSessionPingEOS& SessionPing;
+};
+
+/**
+ * Gets the most likely joins of a search ready ahead of time: for the first results it builds the connect
+ * strings and the host address copy that joining needs, and warms the P2P connection to their hosts so a
+ * server browser click doesn't pay for it. Opt in, driven by Tick on the game thread
+ */
+class FSessionPrefetchEOS
+{
+public:
+	FSessionPrefetchEOS(TUniquePtr<ISessionWarmBackendEOS>&& InBackend);
+
+	/** Reads how many results to prefetch and how long a warm lasts from the engine ini */
+	void LoadConfig();
+
+	/** @return true if results are prefetched at all */
+	bool IsEnabled() const
+	{
+		return NumToPrefetch > 0;
+	}
+
+	void SetNumToPrefetch(int32 InNumToPrefetch)
+	{
+		NumToPrefetch = FMath::Max(InNumToPrefetch, 0);
+	}
+
+	/**
+	 * Prefetches the first results of a finished search, call it once the results are in the order they'll be shown
+	 *
+	 * @param Search the search whose results to prefetch
+	 * @param LocalUserId who to warm connections as, may be null to skip warming
+	 * @param GetHostAddress returns the game address of a result's P2P host or null if it isn't P2P hosted
+	 *
+	 * @return the number of results prefetched
+	 */
+	int32 Prefetch(FOnlineSessionSearch& Search, EOS_ProductUserId LocalUserId, TFunctionRef<const FInternetAddrEOS*(const FOnlineSessionSearchResult&)> GetHostAddress);
+
+	/**
+	 * Builds what joining a session needs from its session info and stores it there
+	 *
+	 * @param SessionInfo the search result's session info
+	 * @param BeaconPort the port beacons connect on, 0 if the session doesn't advertise one
+	 */
+	static void PrefetchSessionInfo(FOnlineSessionInfoEOS& SessionInfo, int32 BeaconPort);
+
+	/** @return true if the host was warmed recently enough that its connection should still be up */
+	bool IsHostWarm(EOS_ProductUserId HostUserId) const;
+
+	/** Advances the clock and the backend */
+	void Tick(float DeltaTime);
+
+#if !UE_BUILD_SHIPPING
+	/**
+	 * Simulates server browser joins with and without prefetching and reports the click to connected time.
+	 * A warm host is modelled as costing one round trip to connect to and a cold one Handshake round trips
+	 *
+	 * @param Cmd the rest of the command, Runs= Sessions= Top= (results prefetched) Latency= (round trip ms)
+	 *		Handshake= (round trips) Think= (ms between results and click) Seed=
+	 * @param Ar where to write the results
+	 * @return true if the command was handled
+	 */
+	static bool HandleBenchExec(const TCHAR* Cmd, FOutputDevice& Ar);
+#endif
+
+private:
+	/** Shared with warm callbacks so they can tell if we are gone */
+	struct FWarmState
+	{
+		/** When each host finished warming */
+		TMap<EOS_ProductUserId, double> WarmHosts;
+		TSet<EOS_ProductUserId> PendingHosts;
+		/** Accumulated tick time */
+		double Now;
+
+		FWarmState()
+			: Now(0.0)
+		{
+		}
+	};
+
+	TUniquePtr<ISessionWarmBackendEOS> Backend;
+	TSharedRef<FWarmState> State;
+
+	/** How many results from the top of each search are prefetched, 0 disables prefetching */
+	int32 NumToPrefetch;
+	/** Seconds a warmed host is considered connected, EOS closes idle connections after a while */
+	float WarmTime;
+};
+
+#endif
@@ -0,0 +1,134 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "SessionSearchCacheEOS.h"
+#include "Misc/ConfigCacheIni.h"
+
+#if WITH_EOS_SDK
+
+FSessionSearchCacheEOS::FSessionSearchCacheEOS()
+	: TimeToLive(0.f)
+	, MaxStaleTime(0.f)
+	, MaxEntries(16)
+{
+}
+
+void FSessionSearchCacheEOS::LoadConfig()
+{
+	GConfig->GetFloat(TEXT("/Script/OnlineSubsystemEOS.NetDriverEOS"), TEXT("SessionSearchCacheTTL"), TimeToLive, GEngineIni);
+	GConfig->GetFloat(TEXT("/Script/OnlineSubsystemEOS.NetDriverEOS"), TEXT("SessionSearchCacheMaxStale"), MaxStaleTime, GEngineIni);
+	GConfig->GetInt(TEXT("/Script/OnlineSubsystemEOS.NetDriverEOS"), TEXT("SessionSearchCacheMaxEntries"), MaxEntries, GEngineIni);
+	TimeToLive = FMath::Max(TimeToLive, 0.f);
+	MaxStaleTime = FMath::Max(MaxStaleTime, 0.f);
+	MaxEntries = FMath::Max(MaxEntries, 1);
+}
+
+FString FSessionSearchCacheEOS::MakeKey(const char* BucketId, const FOnlineSessionSearch& Search)
+{
+	// Names are case insensitive so sort and store them lower cased
+	TArray<TPair<FString, const FOnlineSessionSearchParam*>, TInlineAllocator<16>> Params;
+	for (FSearchParams::TConstIterator It(Search.QuerySettings.SearchParams); It; ++It)
+	{
+		Params.Emplace(It.Key().ToString().ToLower(), &It.Value());
+	}
+	Params.Sort([](const TPair<FString, const FOnlineSessionSearchParam*>& A, const TPair<FString, const FOnlineSessionSearchParam*>& B)
+	{
+		return A.Key < B.Key;
+	});
+
+	FString Key(UTF8_TO_TCHAR(BucketId));
+	Key += FString::Printf(TEXT("|%d"), Search.MaxSearchResults);
+	for (const TPair<FString, const FOnlineSessionSearchParam*>& Param : Params)
+	{
+		Key += FString::Printf(TEXT("|%s:%d:%d:%s"),
+			*Param.Key,
+			(int32)Param.Value->ComparisonOp,
+			(int32)Param.Value->Data.GetType(),
+			*Param.Value->Data.ToString());
+	}
+	return Key;
+}
+
+ESessionSearchCacheStateEOS FSessionSearchCacheEOS::Find(const FString& Key, double Now, TArray<FOnlineSessionSearchResult>& OutResults)
+{
+	PurgeExpired(Now);
+
+	FEntry* Entry = Entries.Find(Key);
+	if (Entry == nullptr || Entry->FetchTime == 0.0)
+	{
+		return ESessionSearchCacheStateEOS::Miss;
+	}
+
+	const double Age = Now - Entry->FetchTime;
+
+	Entry->LastUsedTime = Now;
+	OutResults = Entry->Results;
+	return Age <= TimeToLive ? ESessionSearchCacheStateEOS::Fresh : ESessionSearchCacheStateEOS::Stale;
+}
+
+void FSessionSearchCacheEOS::Store(const FString& Key, const TArray<FOnlineSessionSearchResult>& Results, double Now)
+{
+	PurgeExpired(Now);
+
+	FEntry* Entry = Entries.Find(Key);
+	if (Entry == nullptr)
+	{
+		if (Entries.Num() >= MaxEntries)
+		{
+			// Evict whatever the browser looked at longest ago
+			const FString* OldestKey = nullptr;
+			double OldestTime = MAX_dbl;
+			for (const TPair<FString, FEntry>& Pair : Entries)
+			{
+				if (!Pair.Value.bIsRefreshing && Pair.Value.LastUsedTime < OldestTime)
+				{
+					OldestKey = &Pair.Key;
+					OldestTime = Pair.Value.LastUsedTime;
+				}
+			}
+			if (OldestKey == nullptr)
+			{
+				return;
+			}
+			Entries.Remove(FString(*OldestKey));
+		}
+		Entry = &Entries.Add(Key);
+	}
+
+	Entry->Results = Results;
+	Entry->FetchTime = Now;
+	Entry->LastUsedTime = Now;
+}
+
+void FSessionSearchCacheEOS::PurgeExpired(double Now)
+{
+	const double MaxAge = TimeToLive + MaxStaleTime;
+	for (TMap<FString, FEntry>::TIterator It(Entries); It; ++It)
+	{
+		// A refresh in flight stores its results again when it finishes
+		if (It.Value().FetchTime != 0.0 && Now - It.Value().FetchTime > MaxAge)
+		{
+			It.RemoveCurrent();
+		}
+	}
+}
+
+bool FSessionSearchCacheEOS::BeginRefresh(const FString& Key)
+{
+	FEntry* Entry = Entries.Find(Key);
+	if (Entry == nullptr || Entry->bIsRefreshing)
+	{
+		return false;
+	}
+	Entry->bIsRefreshing = true;
+	return true;
+}
+
+void FSessionSearchCacheEOS::EndRefresh(const FString& Key)
+{
+	if (FEntry* Entry = Entries.Find(Key))
+	{
+		Entry->bIsRefreshing = false;
+	}
+}
+
+#endif
@@ -0,0 +1,102 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "OnlineSessionSettings.h"
+
+#if WITH_EOS_SDK
+
+/** How usable a cached search is */
+enum class ESessionSearchCacheStateEOS : uint8
+{
+	/** Nothing cached or too old to show */
+	Miss,
+	/** Within the time to live, no query needed */
+	Fresh,
+	/** Past the time to live but still ok to show while a refresh runs */
+	Stale
+};
+
+/**
+ * Recent online session search results keyed by the normalized query, so a server browser can show
+ * results straight away and only pay for a backend round trip once they are old
+ */
+class FSessionSearchCacheEOS
+{
+public:
+	FSessionSearchCacheEOS();
+
+	/** Reads the time to live and limits from the engine ini */
+	void LoadConfig();
+
+	/** @return true if results are cached at all */
+	bool IsEnabled() const
+	{
+		return TimeToLive > 0.f;
+	}
+
+	/**
+	 * Builds the key for a search, independent of the order the game added its search params in
+	 *
+	 * @param BucketId the bucket the query is restricted to
+	 * @param Search the search to build the key for
+	 */
+	static FString MakeKey(const char* BucketId, const FOnlineSessionSearch& Search);
+
+	/**
+	 * Copies cached results for a key
+	 *
+	 * @param Key the key from MakeKey()
+	 * @param Now current time in seconds
+	 * @param OutResults receives the results unless this is a miss
+	 *
+	 * Expired entries are dropped first
+	 *
+	 * @return how old the results are
+	 */
+	ESessionSearchCacheStateEOS Find(const FString& Key, double Now, TArray<FOnlineSessionSearchResult>& OutResults);
+
+	/** Replaces the results for a key, evicting the least recently used key when still full after dropping expired ones */
+	void Store(const FString& Key, const TArray<FOnlineSessionSearchResult>& Results, double Now);
+
+	/**
+	 * Marks that a background refresh is running so stale hits don't start another one
+	 *
+	 * @return false if one was already running
+	 */
+	bool BeginRefresh(const FString& Key);
+	/** Clears the refresh flag for a key whether or not it succeeded */
+	void EndRefresh(const FString& Key);
+
+private:
+	struct FEntry
+	{
+		TArray<FOnlineSessionSearchResult> Results;
+		/** When the results came back from the backend */
+		double FetchTime;
+		double LastUsedTime;
+		bool bIsRefreshing;
+
+		FEntry()
+			: FetchTime(0.0)
+			, LastUsedTime(0.0)
+			, bIsRefreshing(false)
+		{
+		}
+	};
+
+	/** Drops entries too old to show, which releases the session details their results hold */
+	void PurgeExpired(double Now);
+
+	TMap<FString, FEntry> Entries;
+
+	/** Seconds results are returned without querying, 0 disables the cache */
+	float TimeToLive;
+	/** Seconds past the time to live that results are still shown while they are refreshed */
+	float MaxStaleTime;
+	/** How many different queries we remember */
+	int32 MaxEntries;
+};
+
+#endif
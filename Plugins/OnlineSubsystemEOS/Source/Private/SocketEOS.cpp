@@ -3,9 +3,11 @@
 #include "SocketEOS.h"
 #include "SocketTypes.h"
 #include "SocketSubsystemEOS.h"
+#include "Misc/ScopeLock.h"
+#include "Misc/ConfigCacheIni.h"
 
 #if WITH_EOS_SDK
-	#include "eos_p2p.h"
+	#include "P2PLoopbackEOS.h"
 #endif
 
 #if WANTS_NP_LOGGING
@@ -57,7 +59,14 @@ void NpLog(const TCHAR* Msg)
 FSocketEOS::FSocketEOS(FSocketSubsystemEOS& InSocketSubsystem, const FString& InSocketDescription)
 	: FSocket(ESocketType::SOCKTYPE_Datagram, InSocketDescription, NAME_None)
 	, SocketSubsystem(InSocketSubsystem)
+	, bIsChannelBound(false)
 	, bIsListening(false)
+	, bIsBatchingSends(false)
+	, NumPendingConnections(0)
+	, PendingConnectionEvent(FPlatformProcess::GetSynchEventFromPool(false))
+	, ReadableEvent(FPlatformProcess::GetSynchEventFromPool(false))
+	, ClosedRemoteTimeout(300.f)
+	, MaxClosedRemotes(1024)
 #if WITH_EOS_SDK
 	, ConnectNotifyCallback(nullptr)
 	, ConnectNotifyId(EOS_INVALID_NOTIFICATIONID)
@@ -65,17 +74,29 @@ FSocketEOS::FSocketEOS(FSocketSubsystemEOS& InSocketSubsystem, const FString& In
 	, ClosedNotifyId(EOS_INVALID_NOTIFICATIONID)
 #endif
 {
+	GConfig->GetFloat(TEXT("/Script/OnlineSubsystemEOS.NetDriverEOS"), TEXT("ClosedRemoteTimeout"), ClosedRemoteTimeout, GEngineIni);
+	GConfig->GetInt(TEXT("/Script/OnlineSubsystemEOS.NetDriverEOS"), TEXT("MaxClosedRemotes"), MaxClosedRemotes, GEngineIni);
+	MaxClosedRemotes = FMath::Max(MaxClosedRemotes, 1);
+
+	UpdateBoundOptions();
 }
 
 FSocketEOS::~FSocketEOS()
 {
 	Close();
 
-	if (LocalAddress.IsValid())
+	// Only release the channel if we claimed it, as several sockets may share an address set directly
+	if (bIsChannelBound)
 	{
 		SocketSubsystem.UnbindChannel(LocalAddress);
-		LocalAddress = FInternetAddrEOS();
+		bIsChannelBound = false;
 	}
+	LocalAddress = FInternetAddrEOS();
+
+	FPlatformProcess::ReturnSynchEventToPool(ReadableEvent);
+	ReadableEvent = nullptr;
+	FPlatformProcess::ReturnSynchEventToPool(PendingConnectionEvent);
+	PendingConnectionEvent = nullptr;
 }
 
 bool FSocketEOS::Shutdown(ESocketShutdownMode Mode)
@@ -88,37 +109,43 @@ bool FSocketEOS::Close()
 {
 	check(IsInGameThread() && "p2p does not support multithreading");
 
+	// Whatever the net driver queued before closing, like its close bunches, still goes out
+	FlushQueuedSends();
+	bIsBatchingSends = false;
+
+	UnregisterFromP2PIoThread();
+
 #if WITH_EOS_SDK
+	FScopeLock P2PScopeLock(&SocketSubsystem.GetP2PLock());
+
 	if (ConnectNotifyId != EOS_INVALID_NOTIFICATIONID)
 	{
-		EOS_P2P_RemoveNotifyPeerConnectionRequest(SocketSubsystem.GetP2PHandle(), ConnectNotifyId);
+		FP2PTransportEOS::RemoveNotifyPeerConnectionRequest(SocketSubsystem.GetP2PHandle(), ConnectNotifyId);
 	}
 	delete ConnectNotifyCallback;
 	ConnectNotifyCallback = nullptr;
+	FPlatformAtomics::InterlockedExchange(&NumPendingConnections, 0);
 	if (ClosedNotifyId != EOS_INVALID_NOTIFICATIONID)
 	{
-		EOS_P2P_RemoveNotifyPeerConnectionClosed(SocketSubsystem.GetP2PHandle(), ClosedNotifyId);
+		FP2PTransportEOS::RemoveNotifyPeerConnectionClosed(SocketSubsystem.GetP2PHandle(), ClosedNotifyId);
 	}
 	delete ClosedNotifyCallback;
 	ClosedNotifyCallback = nullptr;
 
 	if (LocalAddress.IsValid())
 	{
-		EOS_P2P_SocketId SocketId = { };
-		SocketId.ApiVersion = EOS_P2P_SOCKETID_API_LATEST;
-		FCStringAnsi::Strcpy(SocketId.SocketName, LocalAddress.GetSocketName());
-
 		EOS_P2P_CloseConnectionsOptions Options = { };
 		Options.ApiVersion = EOS_P2P_CLOSECONNECTIONS_API_LATEST;
 		Options.LocalUserId = SocketSubsystem.GetLocalUserId();
-		Options.SocketId = &SocketId;
+		Options.SocketId = &BoundSocketId;
 
-		EOS_EResult Result = EOS_P2P_CloseConnections(SocketSubsystem.GetP2PHandle(), &Options);
+		EOS_EResult Result = FP2PTransportEOS::CloseConnections(SocketSubsystem.GetP2PHandle(), &Options);
 
 		UE_LOG(LogSocketSubsystemEOS, Log, TEXT("Closing socket (%s) with result (%s)"), *LocalAddress.ToString(true), ANSI_TO_TCHAR(EOS_EResult_ToString(Result)));
 		NP_LOG(TEXT("[%s] - Closing socket (%s) with result (%s)\r\n"), GetLogPrefix(), *LocalAddress.ToString(true), ANSI_TO_TCHAR(EOS_EResult_ToString(Result)));
 
 		ClosedRemotes.Empty();
+		ClosedRemoteOrder.Empty();
 	}
 #endif
 	return true;
@@ -166,6 +193,10 @@ bool FSocketEOS::Bind(const FInternetAddr& Addr)
 #endif
 	LocalAddress = EOSAddr;
 	LocalAddress.SetLocalUserId(LocalUserId);
+	bIsChannelBound = true;
+	UpdateBoundOptions();
+
+	RegisterWithP2PIoThread();
 
 	UE_LOG(LogSocketSubsystemEOS, Verbose, TEXT("Successfully bound socket to address (%s)"), *LocalAddress.ToString(true));
 	NP_LOG(TEXT("[%s] - Successfully bound socket to address (%s)\r\n"), GetLogPrefix(), *LocalAddress.ToString(true));
@@ -190,23 +221,26 @@ bool FSocketEOS::Listen(int32)
 		return false;
 	}
 
+	RegisterWithP2PIoThread();
+
 #if WITH_EOS_SDK
-	// Add listener for inbound connections
-	EOS_P2P_SocketId SocketId = { };
-	SocketId.ApiVersion = EOS_P2P_SOCKETID_API_LATEST;
-	FCStringAnsi::Strcpy(SocketId.SocketName, LocalAddress.GetSocketName());
+	FScopeLock P2PScopeLock(&SocketSubsystem.GetP2PLock());
 
+	// Add listener for inbound connections
 	EOS_P2P_AddNotifyPeerConnectionRequestOptions Options = { };
 	Options.ApiVersion = EOS_P2P_ADDNOTIFYPEERCONNECTIONREQUEST_API_LATEST;
 	Options.LocalUserId = LocalAddress.GetLocalUserId();
-	Options.SocketId = &SocketId;
+	Options.SocketId = &BoundSocketId;
 
 	ConnectNotifyCallback = new FConnectNotifyCallback();
 	ConnectNotifyCallback->CallbackLambda = [this](const EOS_P2P_OnIncomingConnectionRequestInfo* Info)
 	{
+		// The platform tick runs without the P2P lock, so keep the I/O thread out while we accept
+		FScopeLock P2PScopeLock(&SocketSubsystem.GetP2PLock());
+
 		char PuidBuffer[64];
 		int32 BufferLen = 64;
-		if (EOS_ProductUserId_ToString(Info->RemoteUserId, PuidBuffer, &BufferLen) != EOS_EResult::EOS_Success)
+		if (FP2PTransportEOS::ProductUserIdToString(Info->RemoteUserId, PuidBuffer, &BufferLen) != EOS_EResult::EOS_Success)
 		{
 			PuidBuffer[0] = '\0';
 		}
@@ -217,7 +251,7 @@ bool FSocketEOS::Listen(int32)
 			// In case they disconnected and then reconnected, remove them from our closed list
 			FInternetAddrEOS RemoteAddress(Info->RemoteUserId, Info->SocketId->SocketName, LocalAddress.GetChannel());
 			RemoteAddress.SetLocalUserId(LocalAddress.GetLocalUserId());
-			ClosedRemotes.Remove(RemoteAddress);
+			RemoveClosedRemote(RemoteAddress);
 
 			EOS_P2P_SocketId SocketId = { };
 			SocketId.ApiVersion = EOS_P2P_SOCKETID_API_LATEST;
@@ -228,11 +262,14 @@ bool FSocketEOS::Listen(int32)
 			Options.LocalUserId = LocalAddress.GetLocalUserId();
 			Options.RemoteUserId = Info->RemoteUserId;
 			Options.SocketId = &SocketId;
-			EOS_EResult AcceptResult = EOS_P2P_AcceptConnection(SocketSubsystem.GetP2PHandle(), &Options);
+			EOS_EResult AcceptResult = FP2PTransportEOS::AcceptConnection(SocketSubsystem.GetP2PHandle(), &Options);
 			if (AcceptResult == EOS_EResult::EOS_Success)
 			{
 				UE_LOG(LogSocketSubsystemEOS, Verbose, TEXT("Accepting connection request from (%s) on socket (%s)"), *RemoteUser, UTF8_TO_TCHAR(Info->SocketId->SocketName));
 				NP_LOG(TEXT("[%s] - Accepting connection request from (%s) on socket (%s)\r\n"), GetLogPrefix(), *RemoteUser, UTF8_TO_TCHAR(Info->SocketId->SocketName));
+
+				FPlatformAtomics::InterlockedIncrement(&NumPendingConnections);
+				PendingConnectionEvent->Trigger();
 			}
 			else
 			{
@@ -245,7 +282,7 @@ bool FSocketEOS::Listen(int32)
 			UE_LOG(LogSocketSubsystemEOS, Warning, TEXT("Ignoring connection request from (%s) on socket (%s)"), *RemoteUser, UTF8_TO_TCHAR(Info->SocketId->SocketName));
 		}
 	};
-	ConnectNotifyId = EOS_P2P_AddNotifyPeerConnectionRequest(SocketSubsystem.GetP2PHandle(), &Options, ConnectNotifyCallback, ConnectNotifyCallback->GetCallbackPtr());
+	ConnectNotifyId = FP2PTransportEOS::AddNotifyPeerConnectionRequest(SocketSubsystem.GetP2PHandle(), &Options, ConnectNotifyCallback, ConnectNotifyCallback->GetCallbackPtr());
 
 	// Need to handle closures too
 	RegisterClosedNotification();
@@ -258,8 +295,38 @@ bool FSocketEOS::Listen(int32)
 
 bool FSocketEOS::WaitForPendingConnection(bool& bHasPendingConnection, const FTimespan& WaitTime)
 {
-	/** Not supported - connectionless (UDP) only */
-	SocketSubsystem.SetLastSocketError(ESocketErrors::SE_EOPNOTSUPP);
+	bHasPendingConnection = false;
+
+	if (!bIsListening)
+	{
+		SocketSubsystem.SetLastSocketError(ESocketErrors::SE_EINVAL);
+		return false;
+	}
+
+	// Only accepted connection requests count, packets from peers that are already connected don't
+	bHasPendingConnection = TakePendingConnection();
+
+	// Requests are only accepted during the platform tick, so blocking the game thread would never see any
+	if (!bHasPendingConnection && !IsInGameThread() && WaitTime > FTimespan::Zero())
+	{
+		PendingConnectionEvent->Wait(WaitTime);
+		bHasPendingConnection = TakePendingConnection();
+	}
+	return true;
+}
+
+bool FSocketEOS::TakePendingConnection()
+{
+	int32 Count = NumPendingConnections;
+	while (Count > 0)
+	{
+		const int32 PreviousCount = FPlatformAtomics::InterlockedCompareExchange(&NumPendingConnections, Count - 1, Count);
+		if (PreviousCount == Count)
+		{
+			return true;
+		}
+		Count = PreviousCount;
+	}
 	return false;
 }
 
@@ -269,14 +336,23 @@ bool FSocketEOS::HasPendingData(uint32& PendingDataSize)
 
 	PendingDataSize = 0;
 
-#if WITH_EOS_SDK
-	EOS_P2P_GetNextReceivedPacketSizeOptions Options = { };
-	Options.ApiVersion = EOS_P2P_GETNEXTRECEIVEDPACKETSIZE_API_LATEST;
-	Options.LocalUserId = LocalAddress.GetLocalUserId();
-	uint8 Channel = LocalAddress.GetChannel();
-	Options.RequestedChannel = &Channel;
+	if (P2PIoQueues.IsValid())
+	{
+		const FP2PIoPacketEOS* Packet = P2PIoQueues->Ingress.Peek();
+		if (Packet == nullptr)
+		{
+			return false;
+		}
+		PendingDataSize = Packet->Count;
+		return true;
+	}
 
-	EOS_EResult Result = EOS_P2P_GetNextReceivedPacketSize(SocketSubsystem.GetP2PHandle(), &Options, &PendingDataSize);
+#if WITH_EOS_SDK
+	EOS_EResult Result;
+	{
+		FScopeLock P2PScopeLock(&SocketSubsystem.GetP2PLock());
+		Result = FP2PTransportEOS::GetNextReceivedPacketSize(SocketSubsystem.GetP2PHandle(), &BoundPacketSizeOptions, &PendingDataSize);
+	}
 	if (Result != EOS_EResult::EOS_Success)
 	{
 		UE_LOG(LogSocketSubsystemEOS, Warning, TEXT("Unable to check for data on address (%s) result code = (%s)"), *LocalAddress.ToString(true), ANSI_TO_TCHAR(EOS_EResult_ToString(Result)));
@@ -320,44 +396,265 @@ bool FSocketEOS::SendTo(const uint8* Data, int32 Count, int32& OutBytesSent, con
 		return false;
 	}
 
+	const FInternetAddrEOS& DestinationAddress = static_cast<const FInternetAddrEOS&>(Destination);
+	if (!IsValidSendData(Data, Count, DestinationAddress))
+	{
+		return false;
+	}
+
 #if WITH_EOS_SDK
-	if (Count > EOS_P2P_MAX_PACKET_SIZE)
+	if (bIsBatchingSends)
 	{
-		UE_LOG(LogSocketSubsystemEOS, Warning, TEXT("Unable to send data, data over maximum size. Amount=[%d/%d] DestinationAddress = (%s)"), Count, EOS_P2P_MAX_PACKET_SIZE, *Destination.ToString(true));
+		// The destination is checked once per batch when the queue is flushed
+		// Packets for the same remote are usually sent back to back, so only compare with the last destination
+		if (QueuedSendDestinations.Num() == 0 || QueuedSendDestinations.Last() != DestinationAddress)
+		{
+			QueuedSendDestinations.Add(DestinationAddress);
+		}
+		FQueuedSend& QueuedSend = QueuedSends.AddDefaulted_GetRef();
+		QueuedSend.DataOffset = QueuedSendData.Num();
+		QueuedSend.Count = Count;
+		QueuedSend.DestinationIndex = QueuedSendDestinations.Num() - 1;
+		QueuedSendData.Append(Data, Count);
+		OutBytesSent = Count;
+		return true;
+	}
 
-		SocketSubsystem.SetLastSocketError(ESocketErrors::SE_EMSGSIZE);
+	if (!CanSendTo(DestinationAddress))
+	{
 		return false;
 	}
 
-	if (Count < 0)
+	// Need to handle closures if we are a client and the server closes down on us
+	RegisterClosedNotification();
+
+	if (P2PIoQueues.IsValid())
 	{
-		UE_LOG(LogSocketSubsystemEOS, Warning, TEXT("Unable to send data, data invalid. Amount=[%d/%d] DestinationAddress = (%s)"), Count, EOS_P2P_MAX_PACKET_SIZE, *Destination.ToString(true));
+		if (!EnqueueSend(Data, Count, DestinationAddress))
+		{
+			return false;
+		}
+		if (FP2PIoThreadEOS* P2PIoThread = SocketSubsystem.GetP2PIoThread())
+		{
+			P2PIoThread->WakeUp();
+		}
+		OutBytesSent = Count;
+		return true;
+	}
 
+	EOS_P2P_SocketId ScratchSocketId;
+	EOS_P2P_SendPacketOptions Options = BoundSendOptions;
+	Options.RemoteUserId = DestinationAddress.GetRemoteUserId();
+	Options.SocketId = GetSocketIdFor(DestinationAddress, ScratchSocketId);
+	Options.Channel = DestinationAddress.GetChannel();
+	Options.DataLengthBytes = Count;
+	Options.Data = Data;
+	EOS_EResult Result;
+	{
+		FScopeLock P2PScopeLock(&SocketSubsystem.GetP2PLock());
+		Result = FP2PTransportEOS::SendPacket(SocketSubsystem.GetP2PHandle(), &Options);
+	}
+	NP_LOG(TEXT("[%s] - EOS_P2P_SendPacket() to (%s) result code = (%s)\r\n"), GetLogPrefix(), *Destination.ToString(true), ANSI_TO_TCHAR(EOS_EResult_ToString(Result)));
+	if (Result != EOS_EResult::EOS_Success)
+	{
+		UE_LOG(LogSocketSubsystemEOS, Error, TEXT("Unable to send data to (%s) result code = (%s)"), *Destination.ToString(true), ANSI_TO_TCHAR(EOS_EResult_ToString(Result)));
+
+		// @todo joeg - map EOS codes to UE4's
 		SocketSubsystem.SetLastSocketError(ESocketErrors::SE_EINVAL);
 		return false;
 	}
-#endif 
+	OutBytesSent = Count;
+	return true;
+#else
+	return false;
+#endif
+}
 
-	if (Data == nullptr && Count != 0)
+bool FSocketEOS::SendToBatch(TArrayView<FSocketEOSSendEntry> Entries, int32& OutNumSent)
+{
+	check(IsInGameThread() && "p2p does not support multithreading");
+
+	OutNumSent = 0;
+
+	for (FSocketEOSSendEntry& Entry : Entries)
 	{
-		UE_LOG(LogSocketSubsystemEOS, Warning, TEXT("Unable to send data, data invalid. DestinationAddress = (%s)"), *Destination.ToString(true));
+		Entry.BytesSent = -1;
+	}
 
-		SocketSubsystem.SetLastSocketError(ESocketErrors::SE_EINVAL);
-		return false;
+	if (!LocalAddress.IsValid())
+	{
+		UE_LOG(LogSocketSubsystemEOS, Warning, TEXT("Unable to send batch of (%d) packets, socket was not initialized"), Entries.Num());
+
+		SocketSubsystem.SetLastSocketError(ESocketErrors::SE_NOTINITIALISED);
+		return Entries.Num() == 0;
+	}
+
+#if WITH_EOS_SDK
+	// Need to handle closures if we are a client and the server closes down on us
+	RegisterClosedNotification();
+
+	/** Send state that is built once per destination and shared by every packet going there */
+	struct FBatchDestination
+	{
+		const FInternetAddrEOS* Address;
+		bool bCanSend;
+		bool bUsesBoundSocketId;
+		EOS_P2P_SocketId SocketId;
+		EOS_P2P_SendPacketOptions Options;
+	};
+	TArray<FBatchDestination, TInlineAllocator<32>> Destinations;
+	TMap<FInternetAddrEOS, int32, TInlineSetAllocator<32>> DestinationIndices;
+	int32 CurrentIndex = INDEX_NONE;
+
+	bool bAllSent = true;
+	for (FSocketEOSSendEntry& Entry : Entries)
+	{
+		if (Entry.Destination == nullptr || !Entry.Destination->IsValid())
+		{
+			UE_LOG(LogSocketSubsystemEOS, Warning, TEXT("Unable to send batched data, invalid destination address"));
+
+			SocketSubsystem.SetLastSocketError(ESocketErrors::SE_EADDRNOTAVAIL);
+			bAllSent = false;
+			continue;
+		}
+
+		// Packets for the same remote are usually queued back to back, so check the last one used first
+		const FInternetAddrEOS& DestinationAddress = *Entry.Destination;
+		if (CurrentIndex == INDEX_NONE || (Destinations[CurrentIndex].Address != &DestinationAddress && !(*Destinations[CurrentIndex].Address == DestinationAddress)))
+		{
+			if (const int32* ExistingIndex = DestinationIndices.Find(DestinationAddress))
+			{
+				CurrentIndex = *ExistingIndex;
+			}
+			else
+			{
+				CurrentIndex = Destinations.AddUninitialized();
+				DestinationIndices.Add(DestinationAddress, CurrentIndex);
+				FBatchDestination& NewDestination = Destinations[CurrentIndex];
+				NewDestination.Address = &DestinationAddress;
+				NewDestination.bCanSend = CanSendTo(DestinationAddress);
+
+				NewDestination.bUsesBoundSocketId = GetSocketIdFor(DestinationAddress, NewDestination.SocketId) == &BoundSocketId;
+
+				NewDestination.Options = BoundSendOptions;
+				NewDestination.Options.RemoteUserId = DestinationAddress.GetRemoteUserId();
+				NewDestination.Options.Channel = DestinationAddress.GetChannel();
+			}
+		}
+
+		FBatchDestination& Destination = Destinations[CurrentIndex];
+		if (!Destination.bCanSend)
+		{
+			// CanSendTo already logged and set the socket error
+			bAllSent = false;
+			continue;
+		}
+
+		if (!IsValidSendData(Entry.Data, Entry.Count, DestinationAddress))
+		{
+			bAllSent = false;
+			continue;
+		}
+
+		if (P2PIoQueues.IsValid())
+		{
+			if (!EnqueueSend(Entry.Data, Entry.Count, DestinationAddress))
+			{
+				bAllSent = false;
+				continue;
+			}
+			Entry.BytesSent = Entry.Count;
+			OutNumSent++;
+			continue;
+		}
+
+		// The array may have grown since the options were built, so always point at the current copy
+		Destination.Options.SocketId = Destination.bUsesBoundSocketId ? &BoundSocketId : &Destination.SocketId;
+		Destination.Options.DataLengthBytes = Entry.Count;
+		Destination.Options.Data = Entry.Data;
+		EOS_EResult Result;
+		{
+			FScopeLock P2PScopeLock(&SocketSubsystem.GetP2PLock());
+			Result = FP2PTransportEOS::SendPacket(SocketSubsystem.GetP2PHandle(), &Destination.Options);
+		}
+		NP_LOG(TEXT("[%s] - EOS_P2P_SendPacket() batched to (%s) result code = (%s)\r\n"), GetLogPrefix(), *DestinationAddress.ToString(true), ANSI_TO_TCHAR(EOS_EResult_ToString(Result)));
+		if (Result != EOS_EResult::EOS_Success)
+		{
+			UE_LOG(LogSocketSubsystemEOS, Error, TEXT("Unable to send batched data to (%s) result code = (%s)"), *DestinationAddress.ToString(true), ANSI_TO_TCHAR(EOS_EResult_ToString(Result)));
+
+			// @todo joeg - map EOS codes to UE4's
+			SocketSubsystem.SetLastSocketError(ESocketErrors::SE_EINVAL);
+			bAllSent = false;
+			continue;
+		}
+
+		Entry.BytesSent = Entry.Count;
+		OutNumSent++;
 	}
 
+	FP2PIoThreadEOS* P2PIoThread = SocketSubsystem.GetP2PIoThread();
+	if (P2PIoQueues.IsValid() && P2PIoThread != nullptr && OutNumSent > 0)
+	{
+		P2PIoThread->WakeUp();
+	}
+
+	return bAllSent;
+#else
+	return false;
+#endif
+}
+
+void FSocketEOS::BeginSendBatch()
+{
+	check(IsInGameThread() && "p2p does not support multithreading");
+
+	bIsBatchingSends = true;
+}
+
+int32 FSocketEOS::EndSendBatch()
+{
+	check(IsInGameThread() && "p2p does not support multithreading");
+
+	bIsBatchingSends = false;
+	return FlushQueuedSends();
+}
+
+int32 FSocketEOS::FlushQueuedSends()
+{
+	if (QueuedSends.Num() == 0)
+	{
+		return 0;
+	}
+
+	// The buffers are done growing, so the entries can point into them now
+	QueuedSendEntries.Reset(QueuedSends.Num());
+	for (const FQueuedSend& QueuedSend : QueuedSends)
+	{
+		QueuedSendEntries.Emplace(QueuedSendData.GetData() + QueuedSend.DataOffset, QueuedSend.Count, QueuedSendDestinations[QueuedSend.DestinationIndex]);
+	}
+
+	int32 NumSent = 0;
+	SendToBatch(QueuedSendEntries, NumSent);
+
+	QueuedSends.Reset();
+	QueuedSendData.Reset();
+	QueuedSendDestinations.Reset();
+	return NumSent;
+}
+
+bool FSocketEOS::CanSendTo(const FInternetAddrEOS& DestinationAddress)
+{
 	if (!LocalAddress.IsValid())
 	{
-		UE_LOG(LogSocketSubsystemEOS, Warning, TEXT("Unable to send data, socket was not initialized. DestinationAddress = (%s)"), *Destination.ToString(true));
+		UE_LOG(LogSocketSubsystemEOS, Warning, TEXT("Unable to send data, socket was not initialized. DestinationAddress = (%s)"), *DestinationAddress.ToString(true));
 
 		SocketSubsystem.SetLastSocketError(ESocketErrors::SE_NOTINITIALISED);
 		return false;
 	}
 
-	const FInternetAddrEOS& DestinationAddress = static_cast<const FInternetAddrEOS&>(Destination);
 	if (LocalAddress == DestinationAddress)
 	{
-		UE_LOG(LogSocketSubsystemEOS, Warning, TEXT("Unable to send data, unable to send data to ourselves. DestinationAddress = (%s)"), *Destination.ToString(true));
+		UE_LOG(LogSocketSubsystemEOS, Warning, TEXT("Unable to send data, unable to send data to ourselves. DestinationAddress = (%s)"), *DestinationAddress.ToString(true));
 
 		SocketSubsystem.SetLastSocketError(ESocketErrors::SE_ECONNREFUSED);
 		return false;
@@ -366,43 +663,44 @@ bool FSocketEOS::SendTo(const uint8* Data, int32 Count, int32& OutBytesSent, con
 	// Check for sending to an address we explicitly closed
 	if (WasClosed(DestinationAddress))
 	{
-		UE_LOG(LogSocketSubsystemEOS, Warning, TEXT("Unable to send data to closed connection. DestinationAddress = (%s)"), *Destination.ToString(true));
+		UE_LOG(LogSocketSubsystemEOS, Warning, TEXT("Unable to send data to closed connection. DestinationAddress = (%s)"), *DestinationAddress.ToString(true));
 
 		SocketSubsystem.SetLastSocketError(ESocketErrors::SE_ECONNREFUSED);
 		return false;
 	}
 
+	return true;
+}
+
+bool FSocketEOS::IsValidSendData(const uint8* Data, int32 Count, const FInternetAddrEOS& DestinationAddress)
+{
 #if WITH_EOS_SDK
-	// Need to handle closures if we are a client and the server closes down on us
-	RegisterClosedNotification();
+	if (Count > EOS_P2P_MAX_PACKET_SIZE)
+	{
+		UE_LOG(LogSocketSubsystemEOS, Warning, TEXT("Unable to send data, data over maximum size. Amount=[%d/%d] DestinationAddress = (%s)"), Count, EOS_P2P_MAX_PACKET_SIZE, *DestinationAddress.ToString(true));
 
-	EOS_P2P_SocketId SocketId = { };
-	SocketId.ApiVersion = EOS_P2P_SOCKETID_API_LATEST;
-	FCStringAnsi::Strcpy(SocketId.SocketName, DestinationAddress.GetSocketName());
+		SocketSubsystem.SetLastSocketError(ESocketErrors::SE_EMSGSIZE);
+		return false;
+	}
 
-	EOS_P2P_SendPacketOptions Options = { };
-	Options.ApiVersion = EOS_P2P_SENDPACKET_API_LATEST;
-	Options.LocalUserId = LocalAddress.GetLocalUserId();
-	Options.RemoteUserId = DestinationAddress.GetRemoteUserId();
-	Options.SocketId = &SocketId;
-	Options.Channel = DestinationAddress.GetChannel();
-	Options.DataLengthBytes = Count;
-	Options.Data = Data;
-	EOS_EResult Result = EOS_P2P_SendPacket(SocketSubsystem.GetP2PHandle(), &Options);
-	NP_LOG(TEXT("[%s] - EOS_P2P_SendPacket() to (%s) result code = (%s)\r\n"), GetLogPrefix(), *Destination.ToString(true), ANSI_TO_TCHAR(EOS_EResult_ToString(Result)));
-	if (Result != EOS_EResult::EOS_Success)
+	if (Count < 0)
 	{
-		UE_LOG(LogSocketSubsystemEOS, Error, TEXT("Unable to send data to (%s) result code = (%s)"), *Destination.ToString(true), ANSI_TO_TCHAR(EOS_EResult_ToString(Result)));
+		UE_LOG(LogSocketSubsystemEOS, Warning, TEXT("Unable to send data, data invalid. Amount=[%d/%d] DestinationAddress = (%s)"), Count, EOS_P2P_MAX_PACKET_SIZE, *DestinationAddress.ToString(true));
 
-		// @todo joeg - map EOS codes to UE4's
 		SocketSubsystem.SetLastSocketError(ESocketErrors::SE_EINVAL);
 		return false;
 	}
-	OutBytesSent = Count;
+#endif 
+
+	if (Data == nullptr && Count != 0)
+	{
+		UE_LOG(LogSocketSubsystemEOS, Warning, TEXT("Unable to send data, data invalid. DestinationAddress = (%s)"), *DestinationAddress.ToString(true));
+
+		SocketSubsystem.SetLastSocketError(ESocketErrors::SE_EINVAL);
+		return false;
+	}
+
 	return true;
-#else
-	return false;
-#endif
 }
 
 bool FSocketEOS::Send(const uint8* Data, int32 Count, int32& BytesSent)
@@ -435,18 +733,36 @@ bool FSocketEOS::RecvFrom(uint8* Data, int32 BufferSize, int32& BytesRead, FInte
 		return false;
 	}
 
+	if (P2PIoQueues.IsValid())
+	{
+		const FP2PIoPacketEOS* Packet = P2PIoQueues->Ingress.Peek();
+		if (Packet == nullptr)
+		{
+			// No data to read
+			SocketSubsystem.SetLastSocketError(ESocketErrors::SE_EWOULDBLOCK);
+			return false;
+		}
+
+		// Like UDP, anything that does not fit in the caller's buffer is discarded
+		BytesRead = FMath::Min(BufferSize, Packet->Count);
+		FMemory::Memcpy(Data, Packet->Data, BytesRead);
+		static_cast<FInternetAddrEOS&>(Source) = Packet->Address;
+		P2PIoQueues->Ingress.Dequeue();
+		return true;
+	}
+
 #if WITH_EOS_SDK
-	EOS_P2P_ReceivePacketOptions Options = { };
-	Options.ApiVersion = EOS_P2P_RECEIVEPACKET_API_LATEST;
-	Options.LocalUserId = LocalAddress.GetLocalUserId();
-	Options.MaxDataSizeBytes = BufferSize;
-	uint8 Channel = LocalAddress.GetChannel();
-	Options.RequestedChannel = &Channel;
+	BoundReceiveOptions.MaxDataSizeBytes = BufferSize;
+	uint8 Channel = BoundChannel;
 
 	EOS_ProductUserId RemoteUserId = nullptr;
 	EOS_P2P_SocketId SocketId;
 	
-	EOS_EResult Result = EOS_P2P_ReceivePacket(SocketSubsystem.GetP2PHandle(), &Options, &RemoteUserId, &SocketId, &Channel, Data, (uint32*)&BytesRead);
+	EOS_EResult Result;
+	{
+		FScopeLock P2PScopeLock(&SocketSubsystem.GetP2PLock());
+		Result = FP2PTransportEOS::ReceivePacket(SocketSubsystem.GetP2PHandle(), &BoundReceiveOptions, &RemoteUserId, &SocketId, &Channel, Data, (uint32*)&BytesRead);
+	}
 	NP_LOG(TEXT("[%s] - EOS_P2P_ReceivePacket() for user (%s) and channel (%d) with result code = (%s)\r\n"), GetLogPrefix(), *MakeStringFromProductUserId(LocalAddress.GetLocalUserId()), Channel, ANSI_TO_TCHAR(EOS_EResult_ToString(Result)));
 	if (Result == EOS_EResult::EOS_NotFound)
 	{
@@ -476,6 +792,88 @@ bool FSocketEOS::RecvFrom(uint8* Data, int32 BufferSize, int32& BytesRead, FInte
 #endif
 }
 
+bool FSocketEOS::RecvFromBatch(TArrayView<FSocketEOSRecvPacket> Packets, int32& OutNumReceived)
+{
+	check(IsInGameThread() && "p2p does not support multithreading");
+
+	OutNumReceived = 0;
+
+	if (P2PIoQueues.IsValid())
+	{
+		for (FSocketEOSRecvPacket& Packet : Packets)
+		{
+			const FP2PIoPacketEOS* Queued = P2PIoQueues->Ingress.Peek();
+			if (Queued == nullptr)
+			{
+				break;
+			}
+			Packet.BytesRead = Queued->Count;
+			FMemory::Memcpy(Packet.Data, Queued->Data, Queued->Count);
+			Packet.Source = Queued->Address;
+			P2PIoQueues->Ingress.Dequeue();
+			OutNumReceived++;
+		}
+
+		if (OutNumReceived == 0 && Packets.Num() > 0)
+		{
+			// No data to read
+			SocketSubsystem.SetLastSocketError(ESocketErrors::SE_EWOULDBLOCK);
+			return false;
+		}
+		return true;
+	}
+
+#if WITH_EOS_SDK
+	BoundReceiveOptions.MaxDataSizeBytes = EOS_SOCKET_PACKET_BUFFER_SIZE;
+	const uint8 RequestedChannel = BoundChannel;
+
+	// Held for the whole drain rather than per packet
+	FScopeLock P2PScopeLock(&SocketSubsystem.GetP2PLock());
+
+	EOS_HP2P P2PHandle = SocketSubsystem.GetP2PHandle();
+	for (FSocketEOSRecvPacket& Packet : Packets)
+	{
+		EOS_ProductUserId RemoteUserId = nullptr;
+		EOS_P2P_SocketId SocketId;
+		uint8 Channel = RequestedChannel;
+		uint32 BytesRead = 0;
+
+		EOS_EResult Result = FP2PTransportEOS::ReceivePacket(P2PHandle, &BoundReceiveOptions, &RemoteUserId, &SocketId, &Channel, Packet.Data, &BytesRead);
+		if (Result == EOS_EResult::EOS_NotFound)
+		{
+			// Queue is drained
+			break;
+		}
+		else if (Result != EOS_EResult::EOS_Success)
+		{
+			UE_LOG(LogSocketSubsystemEOS, Error, TEXT("Unable to receive batched data result code = (%s)"), ANSI_TO_TCHAR(EOS_EResult_ToString(Result)));
+
+			// @todo joeg - map EOS codes to UE4's
+			SocketSubsystem.SetLastSocketError(ESocketErrors::SE_EINVAL);
+			return false;
+		}
+
+		Packet.BytesRead = (int32)BytesRead;
+		Packet.Source.SetLocalUserId(LocalAddress.GetLocalUserId());
+		Packet.Source.SetRemoteUserId(RemoteUserId);
+		Packet.Source.SetSocketName(SocketId.SocketName);
+		Packet.Source.SetChannel(Channel);
+		OutNumReceived++;
+	}
+
+	NP_LOG(TEXT("[%s] - EOS_P2P_ReceivePacket() drained (%d) packets for user (%s) and channel (%d)\r\n"), GetLogPrefix(), OutNumReceived, *MakeStringFromProductUserId(LocalAddress.GetLocalUserId()), RequestedChannel);
+	if (OutNumReceived == 0 && Packets.Num() > 0)
+	{
+		// No data to read
+		SocketSubsystem.SetLastSocketError(ESocketErrors::SE_EWOULDBLOCK);
+		return false;
+	}
+	return true;
+#else
+	return false;
+#endif
+}
+
 bool FSocketEOS::Recv(uint8* Data, int32 BufferSize, int32& BytesRead, ESocketReceiveFlags::Type Flags)
 {
 	BytesRead = 0;
@@ -485,8 +883,32 @@ bool FSocketEOS::Recv(uint8* Data, int32 BufferSize, int32& BytesRead, ESocketRe
 
 bool FSocketEOS::Wait(ESocketWaitConditions::Type Condition, FTimespan WaitTime)
 {
-	SocketSubsystem.SetLastSocketError(ESocketErrors::SE_EOPNOTSUPP);
-	return false;
+	// Datagram sends never block, so we are always writable
+	if (Condition != ESocketWaitConditions::WaitForRead)
+	{
+		return true;
+	}
+
+	if (HasReadableData())
+	{
+		return true;
+	}
+
+	// Our own reference keeps the rings and their event alive if the game thread unbinds us meanwhile
+	const FP2PIoQueuesEOSPtr Queues = GetP2PIoQueues();
+
+	// Without the I/O thread packets only arrive during the platform tick, so blocking the game thread would never see any
+	if (!Queues.IsValid() && IsInGameThread())
+	{
+		return false;
+	}
+
+	FEvent* Event = Queues.IsValid() ? Queues->ReadableEvent : ReadableEvent;
+	NumWaiters.Increment();
+	const bool bWasSignalled = Event->Wait(WaitTime);
+	NumWaiters.Decrement();
+
+	return bWasSignalled || HasReadableData();
 }
 
 ESocketConnectionState FSocketEOS::GetConnectionState()
@@ -594,7 +1016,22 @@ int32 FSocketEOS::GetPortNo()
 
 void FSocketEOS::SetLocalAddress(const FInternetAddrEOS& InLocalAddress)
 {
+	check(IsInGameThread() && "p2p does not support multithreading");
+
+	// The worker's rings are keyed by our address, so move them over to the new one
+	UnregisterFromP2PIoThread();
+
+	// The new address isn't claimed, so give back anything Bind() claimed for the old one
+	if (bIsChannelBound)
+	{
+		SocketSubsystem.UnbindChannel(LocalAddress);
+		bIsChannelBound = false;
+	}
+
 	LocalAddress = InLocalAddress;
+	UpdateBoundOptions();
+
+	RegisterWithP2PIoThread();
 }
 
 bool FSocketEOS::Close(const FInternetAddrEOS& RemoteAddress)
@@ -609,20 +1046,22 @@ bool FSocketEOS::Close(const FInternetAddrEOS& RemoteAddress)
 	}
 
 #if WITH_EOS_SDK
-	// So we don't reopen a connection by sending to it
-	ClosedRemotes.Add(RemoteAddress);
+	// Whatever was sent before closing, e.g. the connection's close bunch, still has to go out
+	FlushQueuedSends();
 
-	EOS_P2P_SocketId SocketId = { };
-	SocketId.ApiVersion = EOS_P2P_SOCKETID_API_LATEST;
-	FCStringAnsi::Strcpy(SocketId.SocketName, RemoteAddress.GetSocketName());
+	FScopeLock P2PScopeLock(&SocketSubsystem.GetP2PLock());
 
+	// So we don't reopen a connection by sending to it
+	AddClosedRemote(RemoteAddress);
+
+	EOS_P2P_SocketId ScratchSocketId;
 	EOS_P2P_CloseConnectionOptions Options = { };
 	Options.ApiVersion = EOS_P2P_CLOSECONNECTION_API_LATEST;
 	Options.LocalUserId = LocalAddress.GetLocalUserId();
 	Options.RemoteUserId = RemoteAddress.GetRemoteUserId();
-	Options.SocketId = &SocketId;
+	Options.SocketId = GetSocketIdFor(RemoteAddress, ScratchSocketId);
 
-	EOS_EResult Result = EOS_P2P_CloseConnection(SocketSubsystem.GetP2PHandle(), &Options);
+	EOS_EResult Result = FP2PTransportEOS::CloseConnection(SocketSubsystem.GetP2PHandle(), &Options);
 	NP_LOG(TEXT("[%s] - EOS_P2P_CloseConnection() with remote address RemoteAddress (%s) result code (%s)\r\n"), GetLogPrefix(), *RemoteAddress.ToString(true), ANSI_TO_TCHAR(EOS_EResult_ToString(Result)));
 	if (Result != EOS_EResult::EOS_Success)
 	{
@@ -646,15 +1085,13 @@ void FSocketEOS::RegisterClosedNotification()
 		// Already listening for these events so ignore
 		return;
 	}
-	
-	EOS_P2P_SocketId SocketId = { };
-	SocketId.ApiVersion = EOS_P2P_SOCKETID_API_LATEST;
-	FCStringAnsi::Strcpy(SocketId.SocketName, LocalAddress.GetSocketName());
+
+	FScopeLock P2PScopeLock(&SocketSubsystem.GetP2PLock());
 
 	EOS_P2P_AddNotifyPeerConnectionClosedOptions Options = { };
 	Options.ApiVersion = EOS_P2P_ADDNOTIFYPEERCONNECTIONCLOSED_API_LATEST;
 	Options.LocalUserId = LocalAddress.GetLocalUserId();
-	Options.SocketId = &SocketId;
+	Options.SocketId = &BoundSocketId;
 
 	ClosedNotifyCallback = new FClosedNotifyCallback();
 	ClosedNotifyCallback->CallbackLambda = [this](const EOS_P2P_OnRemoteConnectionClosedInfo* Info)
@@ -662,9 +1099,195 @@ void FSocketEOS::RegisterClosedNotification()
 		// Add this connection to the list of closed ones
 		FInternetAddrEOS RemoteAddress(Info->RemoteUserId, Info->SocketId->SocketName, LocalAddress.GetChannel());
 		RemoteAddress.SetLocalUserId(LocalAddress.GetLocalUserId());
-		ClosedRemotes.Add(RemoteAddress);
+		AddClosedRemote(RemoteAddress);
 		NP_LOG(TEXT("[%s] - Close connection received for remote address (%s)\r\n"), GetLogPrefix(), *RemoteAddress.ToString(true));
 	};
-	ClosedNotifyId = EOS_P2P_AddNotifyPeerConnectionClosed(SocketSubsystem.GetP2PHandle(), &Options, ClosedNotifyCallback, ClosedNotifyCallback->GetCallbackPtr());
+	ClosedNotifyId = FP2PTransportEOS::AddNotifyPeerConnectionClosed(SocketSubsystem.GetP2PHandle(), &Options, ClosedNotifyCallback, ClosedNotifyCallback->GetCallbackPtr());
+#endif
+}
+
+void FSocketEOS::RegisterWithP2PIoThread()
+{
+	if (P2PIoQueues.IsValid() || !LocalAddress.IsValid())
+	{
+		return;
+	}
+
+	if (FP2PIoThreadEOS* P2PIoThread = SocketSubsystem.GetP2PIoThread())
+	{
+		FP2PIoQueuesEOSPtr Queues = P2PIoThread->RegisterSocket(LocalAddress);
+		FScopeLock ScopeLock(&P2PIoQueuesLock);
+		P2PIoQueues = MoveTemp(Queues);
+		UE_LOG(LogSocketSubsystemEOS, Verbose, TEXT("Socket (%s) is using the P2P I/O thread"), *LocalAddress.ToString(true));
+	}
+}
+
+void FSocketEOS::UnregisterFromP2PIoThread()
+{
+	if (!P2PIoQueues.IsValid())
+	{
+		return;
+	}
+
+	if (FP2PIoThreadEOS* P2PIoThread = SocketSubsystem.GetP2PIoThread())
+	{
+		P2PIoThread->UnregisterSocket(P2PIoQueues);
+	}
+	FScopeLock ScopeLock(&P2PIoQueuesLock);
+	P2PIoQueues.Reset();
+}
+
+FP2PIoQueuesEOSPtr FSocketEOS::GetP2PIoQueues() const
+{
+	// Only the game thread changes the pointer, so it can read it without the lock
+	if (IsInGameThread())
+	{
+		return P2PIoQueues;
+	}
+	FScopeLock ScopeLock(&P2PIoQueuesLock);
+	return P2PIoQueues;
+}
+
+bool FSocketEOS::EnqueueSend(const uint8* Data, int32 Count, const FInternetAddrEOS& DestinationAddress)
+{
+	FP2PIoPacketEOS Packet;
+	if (Count > 0)
+	{
+		FMemory::Memcpy(Packet.Data, Data, Count);
+	}
+	Packet.Count = Count;
+	Packet.Address = DestinationAddress;
+	if (!P2PIoQueues->Egress.Enqueue(Packet))
+	{
+		UE_LOG(LogSocketSubsystemEOS, Verbose, TEXT("Unable to send data, P2P I/O send ring is full. DestinationAddress = (%s)"), *DestinationAddress.ToString(true));
+
+		SocketSubsystem.SetLastSocketError(ESocketErrors::SE_ENOBUFS);
+		return false;
+	}
+	return true;
+}
+
+bool FSocketEOS::HasReadableData()
+{
+	const FP2PIoQueuesEOSPtr Queues = GetP2PIoQueues();
+	if (Queues.IsValid())
+	{
+		return !Queues->Ingress.IsEmpty();
+	}
+
+#if WITH_EOS_SDK
+	// The SDK can only be polled from the game thread, other threads rely on SignalIfReadable
+	if (!IsInGameThread() || !LocalAddress.IsValid())
+	{
+		return false;
+	}
+
+	FScopeLock P2PScopeLock(&SocketSubsystem.GetP2PLock());
+
+	uint32 PendingDataSize = 0;
+	return FP2PTransportEOS::GetNextReceivedPacketSize(SocketSubsystem.GetP2PHandle(), &BoundPacketSizeOptions, &PendingDataSize) == EOS_EResult::EOS_Success;
+#else
+	return false;
 #endif
 }
+
+void FSocketEOS::SignalIfReadable()
+{
+	check(IsInGameThread() && "p2p does not support multithreading");
+
+	// The I/O thread signals its own waiters
+	if (NumWaiters.GetValue() > 0 && !P2PIoQueues.IsValid() && HasReadableData())
+	{
+		ReadableEvent->Trigger();
+	}
+}
+
+bool FSocketEOS::WasClosed(const FInternetAddrEOS& RemoteAddress)
+{
+	FClosedRemoteList::TDoubleLinkedListNode* const* Node = ClosedRemotes.Find(RemoteAddress);
+	if (Node == nullptr)
+	{
+		return false;
+	}
+
+	if (FPlatformTime::Seconds() - (*Node)->GetValue().ClosedTime > ClosedRemoteTimeout)
+	{
+		RemoveClosedRemote(RemoteAddress);
+		return false;
+	}
+	return true;
+}
+
+void FSocketEOS::AddClosedRemote(const FInternetAddrEOS& RemoteAddress)
+{
+	// Closing it again starts its timeout over at the back of the list
+	RemoveClosedRemote(RemoteAddress);
+
+	// Entries are in closing order, so the expired ones are all at the head
+	const double Now = FPlatformTime::Seconds();
+	while (FClosedRemoteList::TDoubleLinkedListNode* Oldest = ClosedRemoteOrder.GetHead())
+	{
+		if (Now - Oldest->GetValue().ClosedTime <= ClosedRemoteTimeout && ClosedRemotes.Num() < MaxClosedRemotes)
+		{
+			break;
+		}
+		ClosedRemotes.Remove(Oldest->GetValue().Address);
+		ClosedRemoteOrder.RemoveNode(Oldest);
+	}
+
+	ClosedRemoteOrder.AddTail(FClosedRemote(RemoteAddress, Now));
+	ClosedRemotes.Add(RemoteAddress, ClosedRemoteOrder.GetTail());
+}
+
+void FSocketEOS::RemoveClosedRemote(const FInternetAddrEOS& RemoteAddress)
+{
+	FClosedRemoteList::TDoubleLinkedListNode* Node = nullptr;
+	if (ClosedRemotes.RemoveAndCopyValue(RemoteAddress, Node))
+	{
+		ClosedRemoteOrder.RemoveNode(Node);
+	}
+}
+
+void FSocketEOS::UpdateBoundOptions()
+{
+#if WITH_EOS_SDK
+	BoundSocketId = { };
+	BoundSocketId.ApiVersion = EOS_P2P_SOCKETID_API_LATEST;
+	FCStringAnsi::Strcpy(BoundSocketId.SocketName, LocalAddress.GetSocketName());
+
+	BoundChannel = LocalAddress.GetChannel();
+
+	BoundSendOptions = { };
+	BoundSendOptions.ApiVersion = EOS_P2P_SENDPACKET_API_LATEST;
+	BoundSendOptions.LocalUserId = LocalAddress.GetLocalUserId();
+	BoundSendOptions.SocketId = &BoundSocketId;
+
+	BoundReceiveOptions = { };
+	BoundReceiveOptions.ApiVersion = EOS_P2P_RECEIVEPACKET_API_LATEST;
+	BoundReceiveOptions.LocalUserId = LocalAddress.GetLocalUserId();
+	BoundReceiveOptions.MaxDataSizeBytes = EOS_SOCKET_PACKET_BUFFER_SIZE;
+	BoundReceiveOptions.RequestedChannel = &BoundChannel;
+
+	BoundPacketSizeOptions = { };
+	BoundPacketSizeOptions.ApiVersion = EOS_P2P_GETNEXTRECEIVEDPACKETSIZE_API_LATEST;
+	BoundPacketSizeOptions.LocalUserId = LocalAddress.GetLocalUserId();
+	BoundPacketSizeOptions.RequestedChannel = &BoundChannel;
+#endif
+}
+
+#if WITH_EOS_SDK
+const EOS_P2P_SocketId* FSocketEOS::GetSocketIdFor(const FInternetAddrEOS& RemoteAddress, EOS_P2P_SocketId& ScratchSocketId) const
+{
+	// Peers almost always use the same socket name as us, so only copy the name when they don't. Names match case
+	// insensitively, as in FInternetAddrEOS::operator==
+	if (FCStringAnsi::Stricmp(RemoteAddress.GetSocketName(), BoundSocketId.SocketName) == 0)
+	{
+		return &BoundSocketId;
+	}
+
+	ScratchSocketId = { };
+	ScratchSocketId.ApiVersion = EOS_P2P_SOCKETID_API_LATEST;
+	FCStringAnsi::Strcpy(ScratchSocketId.SocketName, RemoteAddress.GetSocketName());
+	return &ScratchSocketId;
+}
+#endif
@@ -6,7 +6,11 @@
 #include "Sockets.h"
 #include "InternetAddrEOS.h"
 #include "Engine/World.h"
+#include "HAL/ThreadSafeCounter.h"
+#include "HAL/CriticalSection.h"
+#include "Containers/List.h"
 #include "OnlineSubsystemEOSTypes.h"
+#include "P2PIoThreadEOS.h"
 
 class FOnlineSubsystemEOS;
 class FSocketSubsystemEOS;
@@ -28,6 +32,51 @@ class FSocketSubsystemEOS;
 	typedef TEOSGlobalCallback<EOS_P2P_OnRemoteConnectionClosedCallback, EOS_P2P_OnRemoteConnectionClosedInfo> FClosedNotifyCallback;
 #endif
 
+/** A single datagram to be sent as part of a batch */
+struct FSocketEOSSendEntry
+{
+	/** The data to send */
+	const uint8* Data;
+	/** The number of bytes to send */
+	int32 Count;
+	/** Who to send it to */
+	const FInternetAddrEOS* Destination;
+	/** Set to the number of bytes sent, or -1 if this entry failed to send */
+	int32 BytesSent;
+
+	FSocketEOSSendEntry()
+		: Data(nullptr)
+		, Count(0)
+		, Destination(nullptr)
+		, BytesSent(0)
+	{
+	}
+
+	FSocketEOSSendEntry(const uint8* InData, int32 InCount, const FInternetAddrEOS& InDestination)
+		: Data(InData)
+		, Count(InCount)
+		, Destination(&InDestination)
+		, BytesSent(0)
+	{
+	}
+};
+
+/** A reusable receive buffer large enough to hold any P2P packet */
+struct FSocketEOSRecvPacket
+{
+	/** The packet payload, only the first BytesRead bytes are valid */
+	uint8 Data[EOS_SOCKET_PACKET_BUFFER_SIZE];
+	/** The number of bytes received into Data */
+	int32 BytesRead;
+	/** Who sent the packet */
+	FInternetAddrEOS Source;
+
+	FSocketEOSRecvPacket()
+		: BytesRead(0)
+	{
+	}
+};
+
 class FSocketEOS
 	: public FSocket
 {
@@ -71,29 +120,167 @@ public:
 	virtual int32 GetPortNo() override;
 	//~ End FSocket Interface
 
+	/** Uses the address as is, without claiming its socket name and channel the way Bind() does */
 	void SetLocalAddress(const FInternetAddrEOS& InLocalAddress);
 
+	/**
+	 * Sends many datagrams to any number of remotes in one call. Destination validation and
+	 * packet option setup are done once per distinct destination instead of once per packet
+	 *
+	 * @param Entries the datagrams to send, BytesSent is filled in per entry
+	 * @param OutNumSent the number of entries that were sent successfully
+	 *
+	 * @return true if every entry was sent, false if any failed (last socket error is from the last failure)
+	 */
+	bool SendToBatch(TArrayView<FSocketEOSSendEntry> Entries, int32& OutNumSent);
+
+	/**
+	 * Makes SendTo queue its datagrams until EndSendBatch, so a whole net driver flush goes out as one batch.
+	 * Like a datagram handed to the OS, a queued one counts as sent, failures sending it are only logged.
+	 * Closing the socket sends what is queued and ends the batch
+	 */
+	void BeginSendBatch();
+
+	/**
+	 * Sends everything SendTo queued since BeginSendBatch through SendToBatch
+	 *
+	 * @return the number of datagrams sent
+	 */
+	int32 EndSendBatch();
+
+	/**
+	 * Drains pending packets for our channel into the caller's buffers until either the queue
+	 * is empty or every buffer is used. No size probe is made per packet
+	 *
+	 * @param Packets the buffers to receive into, which can be reused from call to call
+	 * @param OutNumReceived the number of buffers that were filled, starting at index 0
+	 *
+	 * @return true if the queue was read without error, false otherwise (SE_EWOULDBLOCK if nothing was pending)
+	 */
+	bool RecvFromBatch(TArrayView<FSocketEOSRecvPacket> Packets, int32& OutNumReceived);
+
 	bool Close(const FInternetAddrEOS& RemoteAddress);
 
-	bool WasClosed(const FInternetAddrEOS& RemoteAddress)
-	{
-		int32 Index = -1;
-		return ClosedRemotes.Find(RemoteAddress, Index);
-	}
+	/** @return true if the remote was closed recently enough that we should not reopen it by sending */
+	bool WasClosed(const FInternetAddrEOS& RemoteAddress);
 
 	void RegisterClosedNotification();
 
+	/** Wakes any threads blocked in Wait if data is queued for us. Called after each platform tick */
+	void SignalIfReadable();
+
 private:
+	/** @return true if there is a packet ready for RecvFrom, without logging or setting errors */
+	bool HasReadableData();
+
+	/** Rebuilds the SDK option blocks that only depend on our local address, called whenever it changes */
+	void UpdateBoundOptions();
+
+#if WITH_EOS_SDK
+	/** @return our cached socket id if the remote uses the same socket name, otherwise ScratchSocketId filled in for it */
+	const EOS_P2P_SocketId* GetSocketIdFor(const FInternetAddrEOS& RemoteAddress, EOS_P2P_SocketId& ScratchSocketId) const;
+#endif
+
+	/** Hands our rings to the P2P I/O worker once we have a bound address, if the worker is enabled */
+	void RegisterWithP2PIoThread();
+
+	/** Stops the P2P I/O worker from servicing our rings */
+	void UnregisterFromP2PIoThread();
+
+	/** @return our rings, safe to call from any thread */
+	FP2PIoQueuesEOSPtr GetP2PIoQueues() const;
+
+	/** Queues a validated datagram for the P2P I/O worker to send */
+	bool EnqueueSend(const uint8* Data, int32 Count, const FInternetAddrEOS& DestinationAddress);
+
+	/** Checks that we are able to send to the remote address, setting the last socket error if not */
+	bool CanSendTo(const FInternetAddrEOS& DestinationAddress);
+
+	/** Checks that a datagram is sendable, setting the last socket error if not */
+	bool IsValidSendData(const uint8* Data, int32 Count, const FInternetAddrEOS& DestinationAddress);
+
 	/** Reference to our subsystem */
 	FSocketSubsystemEOS& SocketSubsystem;
 
 	/** Our local address; session/port will be invalid when not bound */
 	FInternetAddrEOS LocalAddress;
 
+	/** Did Bind() claim our socket name and channel? Sockets given an address through SetLocalAddress() never do */
+	bool bIsChannelBound;
+
 	/** Are we currently listening? */
 	bool bIsListening;
 
-	TArray<FInternetAddrEOS> ClosedRemotes;
+	/** A datagram SendTo queued while batching, pointing into the batch buffers */
+	struct FQueuedSend
+	{
+		int32 DataOffset;
+		int32 Count;
+		int32 DestinationIndex;
+	};
+
+	/** Sends what SendTo queued so far, @return the number of datagrams sent */
+	int32 FlushQueuedSends();
+
+	/** Is SendTo queueing datagrams for EndSendBatch? */
+	bool bIsBatchingSends;
+	TArray<FQueuedSend> QueuedSends;
+	TArray<uint8> QueuedSendData;
+	TArray<FInternetAddrEOS> QueuedSendDestinations;
+	/** Reused by EndSendBatch to hand the queue to SendToBatch */
+	TArray<FSocketEOSSendEntry> QueuedSendEntries;
+
+	/** Takes one accepted connection request off the count, @return false if there were none */
+	bool TakePendingConnection();
+
+	/** Connection requests accepted since WaitForPendingConnection last reported one */
+	volatile int32 NumPendingConnections;
+
+	/** Triggered when a connection request is accepted, for threads blocked in WaitForPendingConnection */
+	FEvent* PendingConnectionEvent;
+
+	/** Remembers a closed remote so sends to it are refused, dropping expired entries and then the oldest when over budget */
+	void AddClosedRemote(const FInternetAddrEOS& RemoteAddress);
+
+	/** Forgets a closed remote, e.g. when it reconnects */
+	void RemoveClosedRemote(const FInternetAddrEOS& RemoteAddress);
+
+	/** A remote that we closed or that closed on us, and when that happened */
+	struct FClosedRemote
+	{
+		FInternetAddrEOS Address;
+		double ClosedTime;
+
+		FClosedRemote(const FInternetAddrEOS& InAddress, double InClosedTime)
+			: Address(InAddress)
+			, ClosedTime(InClosedTime)
+		{
+		}
+	};
+	typedef TDoubleLinkedList<FClosedRemote> FClosedRemoteList;
+
+	/** Closed remotes oldest first, so expiry and eviction only ever look at the head */
+	FClosedRemoteList ClosedRemoteOrder;
+
+	/** Closed remotes by address, pointing at their entry in ClosedRemoteOrder */
+	TMap<FInternetAddrEOS, FClosedRemoteList::TDoubleLinkedListNode*> ClosedRemotes;
+
+	/** How long a closed remote is remembered for, in seconds */
+	float ClosedRemoteTimeout;
+
+	/** The most closed remotes remembered at once */
+	int32 MaxClosedRemotes;
+
+	/** Rings shared with the P2P I/O worker, only valid when the worker is enabled and we are bound */
+	FP2PIoQueuesEOSPtr P2PIoQueues;
+	/** Guards changing P2PIoQueues on the game thread against other threads reading it in Wait */
+	mutable FCriticalSection P2PIoQueuesLock;
+
+	/** Triggered after a platform tick leaves data queued for us, when not using the I/O worker */
+	FEvent* ReadableEvent;
+
+	/** How many threads are blocked in Wait, so we only poll the SDK on their behalf */
+	FThreadSafeCounter NumWaiters;
 
 #if WITH_EOS_SDK
 	FConnectNotifyCallback* ConnectNotifyCallback;
@@ -101,5 +288,12 @@ private:
 
 	FClosedNotifyCallback* ClosedNotifyCallback;
 	EOS_NotificationId ClosedNotifyId;
+
+	/** Option blocks for our bound address and channel, reused by every send and receive */
+	EOS_P2P_SocketId BoundSocketId;
+	uint8 BoundChannel;
+	EOS_P2P_SendPacketOptions BoundSendOptions;
+	EOS_P2P_ReceivePacketOptions BoundReceiveOptions;
+	EOS_P2P_GetNextReceivedPacketSizeOptions BoundPacketSizeOptions;
 #endif
 };
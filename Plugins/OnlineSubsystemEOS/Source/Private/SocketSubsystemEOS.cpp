@@ -10,10 +10,14 @@
 #include "Interfaces/OnlineIdentityInterface.h"
 #include "OnlineSessionSettings.h"
 #include "Misc/ConfigCacheIni.h"
+#include "Misc/ScopeLock.h"
 #include "OnlineSubsystemUtils.h"
 #include "OnlineSubsystemEOS.h"
 #include "UserManagerEOS.h"
 #include "SocketSubsystemModule.h"
+#include "P2PIoThreadEOS.h"
+#include "P2PLoopbackEOS.h"
+#include "BenchEOS.h"
 
 FSocketSubsystemEOS::FSocketSubsystemEOS(FOnlineSubsystemEOS* InSubsystemEOS)
 	: SubsystemEOS(InSubsystemEOS)
@@ -21,13 +25,39 @@ FSocketSubsystemEOS::FSocketSubsystemEOS(FOnlineSubsystemEOS* InSubsystemEOS)
 {
 }
 
-FSocketSubsystemEOS::~FSocketSubsystemEOS() = default;
+FSocketSubsystemEOS::~FSocketSubsystemEOS()
+{
+	StopP2PIoThread();
+}
 
 bool FSocketSubsystemEOS::Init(FString& Error)
 {
 	FSocketSubsystemModule& SocketSubsystem = FModuleManager::LoadModuleChecked<FSocketSubsystemModule>("Sockets");
 	SocketSubsystem.RegisterSocketSubsystem(EOS_SUBSYSTEM, this, false);
 
+#if WITH_EOS_SDK
+	FP2PLoopbackEOS::StartupFromConfig();
+#endif
+
+	bool bUseP2PIoThread = false;
+	GConfig->GetBool(TEXT("/Script/OnlineSubsystemEOS.NetDriverEOS"), TEXT("bUseP2PIoThread"), bUseP2PIoThread, GEngineIni);
+	if (bUseP2PIoThread && FPlatformProcess::SupportsMultithreading())
+	{
+		int32 RingSize = 512;
+		GConfig->GetInt(TEXT("/Script/OnlineSubsystemEOS.NetDriverEOS"), TEXT("P2PIoRingSize"), RingSize, GEngineIni);
+
+		P2PIoThread = MakeUnique<FP2PIoThreadEOS>(*this, (uint32)FMath::Max(RingSize, 2));
+		if (!P2PIoThread->Start())
+		{
+			UE_LOG(LogSocketSubsystemEOS, Warning, TEXT("Failed to start the P2P I/O thread, falling back to game thread sends and receives"));
+			P2PIoThread.Reset();
+		}
+		else
+		{
+			UE_LOG(LogSocketSubsystemEOS, Log, TEXT("Started the P2P I/O thread with ring size (%d)"), RingSize);
+		}
+	}
+
 	return true;
 }
 
@@ -35,6 +65,17 @@ void FSocketSubsystemEOS::Shutdown()
 {
 	// Destruct our sockets before we finish destructing, as they maintain a reference to us
 	TrackedSockets.Reset();
+
+	StopP2PIoThread();
+}
+
+void FSocketSubsystemEOS::StopP2PIoThread()
+{
+	if (P2PIoThread.IsValid())
+	{
+		P2PIoThread->StopAndWait();
+		P2PIoThread.Reset();
+	}
 }
 
 FSocket* FSocketSubsystemEOS::CreateSocket(const FName& SocketTypeName, const FString& SocketDescription, const FName& /*unused*/)
@@ -140,6 +181,11 @@ EOS_HP2P FSocketSubsystemEOS::GetP2PHandle()
 
 EOS_ProductUserId FSocketSubsystemEOS::GetLocalUserId()
 {
+	// Real ids mean nothing to the loopback transport, so everything local binds as its user
+	if (FP2PLoopbackEOS* Loopback = FP2PLoopbackEOS::Get())
+	{
+		return Loopback->GetDefaultLocalUserId();
+	}
 	if (SubsystemEOS != nullptr)
 	{
 		return SubsystemEOS->UserManager->GetLocalProductUserId();
@@ -190,8 +236,226 @@ TSharedRef<FInternetAddr> FSocketSubsystemEOS::GetLocalBindAddr(const UWorld* co
 
 bool FSocketSubsystemEOS::IsSocketWaitSupported() const
 {
-	return false;
+	return true;
+}
+
+void FSocketSubsystemEOS::SignalReadableSockets()
+{
+	for (const TUniquePtr<FSocketEOS>& Socket : TrackedSockets)
+	{
+		if (Socket.IsValid())
+		{
+			Socket->SignalIfReadable();
+		}
+	}
+}
+
+#if WITH_EOS_SDK && !UE_BUILD_SHIPPING
+bool FSocketSubsystemEOS::HandleP2PBenchExec(const TCHAR* Cmd, FOutputDevice& Ar)
+{
+	FP2PLoopbackEOS* Loopback = FBenchEOS::GetLoopback(Ar);
+	if (Loopback == nullptr)
+	{
+		return true;
+	}
+
+	int32 NumPeers = 8;
+	int32 PacketsPerPeer = 10000;
+	int32 PacketSize = 512;
+	float LatencyMs = 0.f;
+	float LossPercent = 0.f;
+	float ReorderPercent = 0.f;
+	FP2PLoopbackSettingsEOS BenchSettings;
+	FParse::Value(Cmd, TEXT("Peers="), NumPeers);
+	FParse::Value(Cmd, TEXT("Packets="), PacketsPerPeer);
+	FParse::Value(Cmd, TEXT("Size="), PacketSize);
+	FParse::Value(Cmd, TEXT("Latency="), LatencyMs);
+	FParse::Value(Cmd, TEXT("Loss="), LossPercent);
+	FParse::Value(Cmd, TEXT("Reorder="), ReorderPercent);
+	FParse::Value(Cmd, TEXT("Seed="), BenchSettings.Seed);
+	NumPeers = FMath::Clamp(NumPeers, 1, 32);
+	PacketsPerPeer = FMath::Max(PacketsPerPeer, 1);
+	// Every packet carries its sequence number so we can spot reordering
+	PacketSize = FMath::Clamp<int32>(PacketSize, sizeof(uint32), EOS_P2P_MAX_PACKET_SIZE);
+	BenchSettings.Latency = LatencyMs / 1000.f;
+	BenchSettings.Loss = LossPercent / 100.f;
+	BenchSettings.Reorder = ReorderPercent / 100.f;
+
+	const FP2PLoopbackSettingsEOS PreviousSettings = Loopback->GetSettings();
+	Loopback->SetSettings(BenchSettings);
+
+	// Simulated time per iteration, long enough that a reordered packet is overtaken by the next batch
+	const float TickDelta = FMath::Max(BenchSettings.Latency, 0.001f);
+	const TCHAR* const BenchSocketName = TEXT("EOSP2PBench");
+	const uint8 BenchChannel = 7;
+
+	FInternetAddrEOS ServerAddress;
+	ServerAddress.SetLocalUserId(Loopback->CreateUser());
+	ServerAddress.SetSocketName(BenchSocketName);
+	ServerAddress.SetChannel(BenchChannel);
+	FSocketEOS* ServerSocket = static_cast<FSocketEOS*>(CreateSocket(NAME_DGram, TEXT("EOSP2PBenchServer"), NAME_None));
+	ServerSocket->SetLocalAddress(ServerAddress);
+	ServerSocket->Listen(0);
+
+	const FInternetAddrEOS ServerDestination(ServerAddress.GetLocalUserId(), BenchSocketName, BenchChannel);
+
+	TArray<FSocketEOS*, TInlineAllocator<32>> ClientSockets;
+	for (int32 PeerIndex = 0; PeerIndex < NumPeers; PeerIndex++)
+	{
+		FInternetAddrEOS ClientAddress;
+		ClientAddress.SetLocalUserId(Loopback->CreateUser());
+		ClientAddress.SetSocketName(BenchSocketName);
+		ClientAddress.SetChannel(BenchChannel);
+		FSocketEOS* ClientSocket = static_cast<FSocketEOS*>(CreateSocket(NAME_DGram, TEXT("EOSP2PBenchClient"), NAME_None));
+		ClientSocket->SetLocalAddress(ClientAddress);
+		ClientSockets.Add(ClientSocket);
+	}
+
+	const int32 MaxBatch = 32;
+	TArray<FSocketEOSRecvPacket> RecvPackets;
+	RecvPackets.SetNum(MaxBatch);
+	TArray<uint8> Payloads;
+	Payloads.SetNumZeroed(PacketSize * MaxBatch);
+	TArray<FSocketEOSSendEntry, TInlineAllocator<MaxBatch>> SendEntries;
+
+	auto TickTransport = [this, Loopback](float DeltaTime)
+	{
+		FBenchEOS::TickLoopback(*this, *Loopback, DeltaTime);
+	};
+	auto DrainServer = [ServerSocket, &RecvPackets]()
+	{
+		int32 NumDrained = 0;
+		int32 NumReceived = 0;
+		while (ServerSocket->RecvFromBatch(RecvPackets, NumReceived) && NumReceived > 0)
+		{
+			NumDrained += NumReceived;
+		}
+		return NumDrained;
+	};
+
+	// The first packet from each peer becomes a connection request, so get every connection accepted before we measure
+	for (int32 Round = 0; Round < 2; Round++)
+	{
+		for (FSocketEOS* ClientSocket : ClientSockets)
+		{
+			int32 BytesSent = 0;
+			ClientSocket->SendTo(Payloads.GetData(), PacketSize, BytesSent, ServerDestination);
+		}
+		TickTransport(TickDelta * 3.f);
+		DrainServer();
+	}
+	Loopback->ResetStats();
+
+	uint64 SendCycles = 0;
+	uint64 TransportCycles = 0;
+	uint64 RecvCycles = 0;
+	int64 NumReceived = 0;
+	int64 NumBytesReceived = 0;
+	int32 NumOutOfOrder = 0;
+	TArray<uint32, TInlineAllocator<32>> NextSequences;
+	NextSequences.SetNumZeroed(NumPeers);
+	TMap<EOS_ProductUserId, int32> PeerIndices;
+	for (int32 PeerIndex = 0; PeerIndex < NumPeers; PeerIndex++)
+	{
+		FInternetAddrEOS ClientAddress;
+		ClientSockets[PeerIndex]->GetAddress(ClientAddress);
+		PeerIndices.Add(ClientAddress.GetLocalUserId(), PeerIndex);
+	}
+
+	// Reordered packets are due at most two ticks after they were sent, anything still in flight after that belongs to someone else
+	int32 NumFlushTicks = 0;
+	const uint64 StartCycles = FPlatformTime::Cycles64();
+	for (int32 NumSentPerPeer = 0; NumSentPerPeer < PacketsPerPeer || (Loopback->HasPacketsInFlight() && NumFlushTicks++ < 3); )
+	{
+		const int32 BatchSize = FMath::Min(MaxBatch, PacketsPerPeer - NumSentPerPeer);
+		if (BatchSize > 0)
+		{
+			const uint64 SendStart = FPlatformTime::Cycles64();
+			for (FSocketEOS* ClientSocket : ClientSockets)
+			{
+				SendEntries.Reset();
+				for (int32 Index = 0; Index < BatchSize; Index++)
+				{
+					uint8* Payload = Payloads.GetData() + Index * PacketSize;
+					const uint32 Sequence = (uint32)(NumSentPerPeer + Index);
+					FMemory::Memcpy(Payload, &Sequence, sizeof(Sequence));
+					SendEntries.Emplace(Payload, PacketSize, ServerDestination);
+				}
+				int32 NumSent = 0;
+				ClientSocket->SendToBatch(SendEntries, NumSent);
+			}
+			SendCycles += FPlatformTime::Cycles64() - SendStart;
+			NumSentPerPeer += BatchSize;
+		}
+
+		const uint64 TransportStart = FPlatformTime::Cycles64();
+		TickTransport(TickDelta);
+		TransportCycles += FPlatformTime::Cycles64() - TransportStart;
+
+		const uint64 RecvStart = FPlatformTime::Cycles64();
+		int32 NumBatchReceived = 0;
+		while (ServerSocket->RecvFromBatch(RecvPackets, NumBatchReceived) && NumBatchReceived > 0)
+		{
+			for (int32 Index = 0; Index < NumBatchReceived; Index++)
+			{
+				const FSocketEOSRecvPacket& Packet = RecvPackets[Index];
+				NumBytesReceived += Packet.BytesRead;
+				if (const int32* PeerIndex = PeerIndices.Find(Packet.Source.GetRemoteUserId()))
+				{
+					uint32 Sequence = 0;
+					FMemory::Memcpy(&Sequence, Packet.Data, sizeof(Sequence));
+					if (Sequence < NextSequences[*PeerIndex])
+					{
+						NumOutOfOrder++;
+					}
+					NextSequences[*PeerIndex] = FMath::Max(NextSequences[*PeerIndex], Sequence + 1);
+				}
+			}
+			NumReceived += NumBatchReceived;
+		}
+		RecvCycles += FPlatformTime::Cycles64() - RecvStart;
+	}
+
+	// With the I/O thread the last packets may still be on their way into the ring
+	const FP2PLoopbackStatsEOS Stats = Loopback->GetStats();
+	const double DrainDeadline = FPlatformTime::Seconds() + 1.0;
+	while (NumReceived < (int64)Stats.PacketsDelivered && FPlatformTime::Seconds() < DrainDeadline)
+	{
+		const uint64 RecvStart = FPlatformTime::Cycles64();
+		const int32 NumDrained = DrainServer();
+		RecvCycles += FPlatformTime::Cycles64() - RecvStart;
+		NumReceived += NumDrained;
+		NumBytesReceived += (int64)NumDrained * PacketSize;
+		if (NumDrained == 0)
+		{
+			FPlatformProcess::Sleep(0.f);
+		}
+	}
+	const double ElapsedSeconds = FMath::Max(FPlatformTime::ToSeconds64(FPlatformTime::Cycles64() - StartCycles), SMALL_NUMBER);
+
+	const double NumSentTotal = FMath::Max<double>((double)Stats.PacketsSent, 1.0);
+	const double MicrosecondsPerCycle = FPlatformTime::GetSecondsPerCycle64() * 1000000.0;
+	Ar.Logf(TEXT("EOS P2P bench: Peers=(%d) Packets=(%d) Size=(%d) Latency=(%.1fms) Loss=(%.1f%%) Reorder=(%.1f%%) IoThread=(%s)"),
+		NumPeers, PacketsPerPeer, PacketSize, LatencyMs, LossPercent, ReorderPercent, P2PIoThread.IsValid() ? TEXT("true") : TEXT("false"));
+	Ar.Logf(TEXT("  Sent=(%llu) Received=(%lld) Lost=(%llu) Refused=(%llu) Reordered=(%llu) OutOfOrder=(%d)"),
+		Stats.PacketsSent, NumReceived, Stats.PacketsLost, Stats.PacketsRefused, Stats.PacketsReordered, NumOutOfOrder);
+	Ar.Logf(TEXT("  %.0f packets/sec, %.2f MB/sec over %.3f sec"),
+		NumReceived / ElapsedSeconds, NumBytesReceived / ElapsedSeconds / (1024.0 * 1024.0), ElapsedSeconds);
+	Ar.Logf(TEXT("  CPU per packet: send %.3fus, transport %.3fus, receive %.3fus"),
+		SendCycles * MicrosecondsPerCycle / NumSentTotal, TransportCycles * MicrosecondsPerCycle / NumSentTotal, RecvCycles * MicrosecondsPerCycle / NumSentTotal);
+
+	for (FSocketEOS* ClientSocket : ClientSockets)
+	{
+		DestroySocket(ClientSocket);
+	}
+	DestroySocket(ServerSocket);
+	TickTransport(TickDelta);
+
+	Loopback->SetSettings(PreviousSettings);
+	Loopback->ResetStats();
+	return true;
 }
+#endif
 
 void FSocketSubsystemEOS::SetLastSocketError(const ESocketErrors NewSocketError)
 {
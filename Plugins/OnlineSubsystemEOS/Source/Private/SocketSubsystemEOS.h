@@ -4,6 +4,7 @@
 
 #include "CoreMinimal.h"
 #include "SocketSubsystem.h"
+#include "HAL/CriticalSection.h"
 
 #if WITH_EOS_SDK
 	#include "eos_p2p_types.h"
@@ -17,6 +18,7 @@ class FInternetAddr;
 class FInternetAddrEOS;
 class FSocketEOS;
 class FOnlineSubsystemEOS;
+class FP2PIoThreadEOS;
 
 typedef TSet<uint8> FChannelSet;
 
@@ -73,9 +75,44 @@ public:
 	 */
 	bool UnbindChannel(const FInternetAddrEOS& Address);
 
+	/** @return the P2P I/O worker if one was enabled via config, otherwise null */
+	FP2PIoThreadEOS* GetP2PIoThread() const
+	{
+		return P2PIoThread.Get();
+	}
+
+	/** Lock that serializes EOS_P2P calls between the game thread, P2P notifications and the P2P I/O worker */
+	FCriticalSection& GetP2PLock()
+	{
+		return P2PLock;
+	}
+
+	/** Wakes threads waiting on any of our sockets that now have data, called after each platform tick */
+	void SignalReadableSockets();
+
+	/** Stops the P2P I/O worker, must be called before the EOS platform is released */
+	void StopP2PIoThread();
+
+#if WITH_EOS_SDK && !UE_BUILD_SHIPPING
+	/**
+	 * Pushes packets from simulated peers to a listen socket over the loopback transport and reports throughput
+	 *
+	 * @param Cmd the rest of the command, Peers= Packets= Size= Latency= (ms) Loss= (%) Reorder= (%) Seed=
+	 * @param Ar where to write the results
+	 * @return true if the command was handled
+	 */
+	bool HandleP2PBenchExec(const TCHAR* Cmd, FOutputDevice& Ar);
+#endif
+
 private:
 	FOnlineSubsystemEOS* SubsystemEOS;
 
+	/** Optional worker that does the P2P send/receive calls off of the game thread */
+	TUniquePtr<FP2PIoThreadEOS> P2PIoThread;
+
+	/** Guards P2P SDK access when the I/O worker is running */
+	FCriticalSection P2PLock;
+
 	/** All sockets allocated by this subsystem */
 	TArray<TUniquePtr<FSocketEOS>> TrackedSockets;
 
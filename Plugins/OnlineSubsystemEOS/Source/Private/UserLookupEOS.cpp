@@ -0,0 +1,266 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "UserLookupEOS.h"
+#include "OnlineSubsystemEOS.h"
+#include "Misc/ConfigCacheIni.h"
+
+#if WITH_EOS_SDK
+
+#include "eos_connect_types.h"
+
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("User Lookups Requested"), STAT_EOS_UserLookupsRequested, STATGROUP_EOS);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("User Lookup Requests Issued"), STAT_EOS_UserLookupRequestsIssued, STATGROUP_EOS);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("User Lookup Requests In Flight"), STAT_EOS_UserLookupRequestsInFlight, STATGROUP_EOS);
+DECLARE_FLOAT_COUNTER_STAT(TEXT("User Lookup Coalescing Ratio"), STAT_EOS_UserLookupCoalescingRatio, STATGROUP_EOS);
+
+/** The kinds of lookup in the order they are checked */
+static const EUserLookupEOS LookupKinds[] = { EUserLookupEOS::Info, EUserLookupEOS::Presence, EUserLookupEOS::Mapping };
+
+FUserLookupCoalescerEOS::FUserLookupCoalescerEOS(TUniquePtr<IUserLookupBackendEOS>&& InBackend)
+	: Backend(MoveTemp(InBackend))
+	, State(MakeShared<FLookupState>())
+	, Window(0.05f)
+	, MaxInFlight(16)
+	, CacheTime(30.f)
+{
+}
+
+FUserLookupCoalescerEOS::~FUserLookupCoalescerEOS()
+{
+	// Callbacks still out can't reach the state anymore, so they won't count themselves down
+	DEC_DWORD_STAT_BY(STAT_EOS_UserLookupRequestsInFlight, State->NumInFlight);
+}
+
+void FUserLookupCoalescerEOS::LoadConfig()
+{
+	GConfig->GetFloat(TEXT("/Script/OnlineSubsystemEOS.NetDriverEOS"), TEXT("UserLookupWindow"), Window, GEngineIni);
+	GConfig->GetInt(TEXT("/Script/OnlineSubsystemEOS.NetDriverEOS"), TEXT("UserLookupMaxInFlight"), MaxInFlight, GEngineIni);
+	GConfig->GetFloat(TEXT("/Script/OnlineSubsystemEOS.NetDriverEOS"), TEXT("UserLookupCacheTime"), CacheTime, GEngineIni);
+	Window = FMath::Max(Window, 0.f);
+	MaxInFlight = FMath::Max(MaxInFlight, 1);
+	CacheTime = FMath::Max(CacheTime, 0.f);
+}
+
+bool FUserLookupCoalescerEOS::IsFresh(EOS_EpicAccountId AccountId, EUserLookupEOS Lookup) const
+{
+	const FLookupTimes* Times = State->Completed.Find(AccountId);
+	if (Times == nullptr)
+	{
+		return false;
+	}
+	const double CompletedAt = Times->Get(Lookup);
+	return CompletedAt >= 0.0 && State->Now - CompletedAt <= CacheTime;
+}
+
+EUserLookupEOS FUserLookupCoalescerEOS::Request(EOS_EpicAccountId AccountId, EUserLookupEOS Lookups)
+{
+	if (AccountId == nullptr)
+	{
+		return EUserLookupEOS::None;
+	}
+
+	const EUserLookupEOS* QueuedLookups = State->Queued.Find(AccountId);
+	const EUserLookupEOS* InFlightLookups = State->InFlight.Find(AccountId);
+	EUserLookupEOS Wanted = EUserLookupEOS::None;
+	uint32 NumAsked = 0;
+	for (EUserLookupEOS Lookup : LookupKinds)
+	{
+		if (!EnumHasAnyFlags(Lookups, Lookup))
+		{
+			continue;
+		}
+		NumAsked++;
+		if ((QueuedLookups != nullptr && EnumHasAnyFlags(*QueuedLookups, Lookup))
+			|| (InFlightLookups != nullptr && EnumHasAnyFlags(*InFlightLookups, Lookup))
+			|| IsFresh(AccountId, Lookup)
+			|| Backend->IsCached(AccountId, Lookup))
+		{
+			continue;
+		}
+		Wanted |= Lookup;
+	}
+	State->NumRequested += NumAsked;
+	INC_DWORD_STAT_BY(STAT_EOS_UserLookupsRequested, NumAsked);
+	SET_FLOAT_STAT(STAT_EOS_UserLookupCoalescingRatio, GetCoalescingRatio());
+
+	if (Wanted != EUserLookupEOS::None)
+	{
+		if (State->Queued.Num() == 0)
+		{
+			State->QueuedSince = State->Now;
+		}
+		State->Queued.FindOrAdd(AccountId) |= Wanted;
+	}
+	return Wanted;
+}
+
+bool FUserLookupCoalescerEOS::Issue(const TArray<EOS_EpicAccountId>& AccountIds, EUserLookupEOS Lookup)
+{
+	for (EOS_EpicAccountId AccountId : AccountIds)
+	{
+		State->InFlight.FindOrAdd(AccountId) |= Lookup;
+	}
+	State->NumInFlight++;
+	State->NumIssued++;
+	INC_DWORD_STAT(STAT_EOS_UserLookupRequestsIssued);
+	INC_DWORD_STAT(STAT_EOS_UserLookupRequestsInFlight);
+
+	TWeakPtr<FLookupState> WeakState = State;
+	FOnUserLookupCompleteEOS OnComplete = [WeakState, AccountIds, Lookup](bool bWasSuccessful)
+	{
+		TSharedPtr<FLookupState> PinnedState = WeakState.Pin();
+		if (!PinnedState.IsValid())
+		{
+			return;
+		}
+		for (EOS_EpicAccountId AccountId : AccountIds)
+		{
+			EUserLookupEOS* InFlightLookups = PinnedState->InFlight.Find(AccountId);
+			if (InFlightLookups != nullptr)
+			{
+				*InFlightLookups &= ~Lookup;
+				if (*InFlightLookups == EUserLookupEOS::None)
+				{
+					PinnedState->InFlight.Remove(AccountId);
+				}
+			}
+			// Failed lookups aren't remembered so the next request tries again
+			if (bWasSuccessful)
+			{
+				PinnedState->Completed.FindOrAdd(AccountId).Set(Lookup, PinnedState->Now);
+			}
+		}
+		PinnedState->NumInFlight--;
+		DEC_DWORD_STAT(STAT_EOS_UserLookupRequestsInFlight);
+	};
+
+	bool bStarted = false;
+	if (Lookup == EUserLookupEOS::Mapping)
+	{
+		bStarted = Backend->QueryMappings(AccountIds, MoveTemp(OnComplete));
+	}
+	else if (Lookup == EUserLookupEOS::Presence)
+	{
+		bStarted = Backend->QueryPresence(AccountIds[0], MoveTemp(OnComplete));
+	}
+	else
+	{
+		bStarted = Backend->QueryUserInfo(AccountIds[0], MoveTemp(OnComplete));
+	}
+
+	if (!bStarted)
+	{
+		// Dropped rather than queued again, whatever stopped it (no signed in user) won't clear up by the next tick
+		for (EOS_EpicAccountId AccountId : AccountIds)
+		{
+			EUserLookupEOS* InFlightLookups = State->InFlight.Find(AccountId);
+			if (InFlightLookups != nullptr)
+			{
+				*InFlightLookups &= ~Lookup;
+				if (*InFlightLookups == EUserLookupEOS::None)
+				{
+					State->InFlight.Remove(AccountId);
+				}
+			}
+		}
+		State->NumInFlight--;
+		DEC_DWORD_STAT(STAT_EOS_UserLookupRequestsInFlight);
+		UE_LOG_ONLINE(Verbose, TEXT("User lookup for %d player(s) could not be started"), AccountIds.Num());
+	}
+	return bStarted;
+}
+
+void FUserLookupCoalescerEOS::Flush()
+{
+	// Mappings first, one request covers a whole batch of players
+	TArray<EOS_EpicAccountId> Batch;
+	while (State->NumInFlight < MaxInFlight)
+	{
+		Batch.Reset();
+		for (TPair<EOS_EpicAccountId, EUserLookupEOS>& Queued : State->Queued)
+		{
+			if (EnumHasAnyFlags(Queued.Value, EUserLookupEOS::Mapping))
+			{
+				Queued.Value &= ~EUserLookupEOS::Mapping;
+				Batch.Add(Queued.Key);
+				if (Batch.Num() == EOS_CONNECT_QUERYEXTERNALACCOUNTMAPPINGS_MAX_ACCOUNT_IDS)
+				{
+					break;
+				}
+			}
+		}
+		if (Batch.Num() == 0)
+		{
+			break;
+		}
+		Issue(Batch, EUserLookupEOS::Mapping);
+	}
+
+	// Info and presence are one player per request, so those are what the cap holds back
+	for (TMap<EOS_EpicAccountId, EUserLookupEOS>::TIterator It(State->Queued); It && State->NumInFlight < MaxInFlight; ++It)
+	{
+		for (EUserLookupEOS Lookup : { EUserLookupEOS::Info, EUserLookupEOS::Presence })
+		{
+			if (EnumHasAnyFlags(It.Value(), Lookup) && State->NumInFlight < MaxInFlight)
+			{
+				It.Value() &= ~Lookup;
+				Batch.Reset();
+				Batch.Add(It.Key());
+				Issue(Batch, Lookup);
+			}
+		}
+	}
+
+	for (TMap<EOS_EpicAccountId, EUserLookupEOS>::TIterator It(State->Queued); It; ++It)
+	{
+		if (It.Value() == EUserLookupEOS::None)
+		{
+			It.RemoveCurrent();
+		}
+	}
+	SET_FLOAT_STAT(STAT_EOS_UserLookupCoalescingRatio, GetCoalescingRatio());
+}
+
+void FUserLookupCoalescerEOS::Tick(float DeltaTime)
+{
+	State->Now += DeltaTime;
+	Backend->Tick(DeltaTime);
+
+	// Whatever the cap held back goes out as soon as there is room, without waiting for another window
+	if (State->Queued.Num() > 0 && State->Now - State->QueuedSince >= Window)
+	{
+		Flush();
+	}
+
+	// Forget players whose lookups have all gone stale
+	if (State->Now - State->PrunedAt > CacheTime && State->Completed.Num() > 0)
+	{
+		State->PrunedAt = State->Now;
+		const double OldestFresh = State->Now - CacheTime;
+		for (TMap<EOS_EpicAccountId, FLookupTimes>::TIterator It(State->Completed); It; ++It)
+		{
+			if (It.Value().Info < OldestFresh && It.Value().Presence < OldestFresh && It.Value().Mapping < OldestFresh)
+			{
+				It.RemoveCurrent();
+			}
+		}
+	}
+}
+
+void FUserLookupCoalescerEOS::Reset()
+{
+	State->Queued.Empty();
+	State->Completed.Empty();
+}
+
+int32 FUserLookupCoalescerEOS::GetNumInFlight() const
+{
+	return State->NumInFlight;
+}
+
+float FUserLookupCoalescerEOS::GetCoalescingRatio() const
+{
+	return State->NumIssued > 0 ? (float)((double)State->NumRequested / (double)State->NumIssued) : 1.f;
+}
+
+#endif
@@ -0,0 +1,167 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+#if WITH_EOS_SDK
+	#include "eos_common.h"
+
+/** What we can look up about a remote player */
+enum class EUserLookupEOS : uint8
+{
+	None = 0,
+	/** Display name and the rest of the user info */
+	Info = 1 << 0,
+	Presence = 1 << 1,
+	/** The product user id the epic account maps to */
+	Mapping = 1 << 2,
+	All = Info | Presence | Mapping
+};
+ENUM_CLASS_FLAGS(EUserLookupEOS);
+
+/** Called once a lookup request finished, bWasSuccessful is false if the data wasn't read */
+typedef TFunction<void(bool bWasSuccessful)> FOnUserLookupCompleteEOS;
+
+/** Issues the requests behind player lookups, so coalescing can be driven by a mock as well as by EOS */
+class IUserLookupBackendEOS
+{
+public:
+	virtual ~IUserLookupBackendEOS() {}
+
+	/** @return false if the request could not be started, OnComplete is not called */
+	virtual bool QueryUserInfo(EOS_EpicAccountId AccountId, FOnUserLookupCompleteEOS&& OnComplete) = 0;
+	/** @return false if the request could not be started, OnComplete is not called */
+	virtual bool QueryPresence(EOS_EpicAccountId AccountId, FOnUserLookupCompleteEOS&& OnComplete) = 0;
+	/**
+	 * Maps a batch of accounts to product user ids with a single request
+	 *
+	 * @return false if the request could not be started, OnComplete is not called
+	 */
+	virtual bool QueryMappings(const TArray<EOS_EpicAccountId>& AccountIds, FOnUserLookupCompleteEOS&& OnComplete) = 0;
+	/** @return true if the data is already held locally and needs no request */
+	virtual bool IsCached(EOS_EpicAccountId AccountId, EUserLookupEOS Lookup) const { return false; }
+	/** Advances backends that simulate time */
+	virtual void Tick(float DeltaTime) {}
+};
+
+/**
+ * Gathers remote player lookups for a short window and issues them together. Lookups already in flight, queued
+ * or recently done are dropped, mapping lookups go out in batches, and info and presence requests are capped
+ * so a full session arriving at once doesn't flood the SDK. Driven by Tick on the game thread
+ */
+class FUserLookupCoalescerEOS
+{
+public:
+	FUserLookupCoalescerEOS(TUniquePtr<IUserLookupBackendEOS>&& InBackend);
+	~FUserLookupCoalescerEOS();
+
+	/** Reads the window, concurrency cap and cache time from the engine ini */
+	void LoadConfig();
+
+	void SetWindow(float InWindow)
+	{
+		Window = FMath::Max(InWindow, 0.f);
+	}
+
+	void SetMaxInFlight(int32 InMaxInFlight)
+	{
+		MaxInFlight = FMath::Max(InMaxInFlight, 1);
+	}
+
+	/**
+	 * Queues lookups for a player, they go out on the first tick after the window
+	 *
+	 * @param AccountId the player to look up
+	 * @param Lookups what to look up about them
+	 *
+	 * @return the lookups that were queued, the rest were already in flight, queued or cached
+	 */
+	EUserLookupEOS Request(EOS_EpicAccountId AccountId, EUserLookupEOS Lookups);
+
+	/** Issues what it can once the window has passed */
+	void Tick(float DeltaTime);
+
+	/** Drops everything queued and what is known to be cached, requests in flight still complete */
+	void Reset();
+
+	/** @return the number of requests waiting on the backend */
+	int32 GetNumInFlight() const;
+
+	/** @return lookups asked for per request issued, 1 when nothing was coalesced */
+	float GetCoalescingRatio() const;
+
+private:
+	/** When each kind of lookup last completed for a player */
+	struct FLookupTimes
+	{
+		double Info;
+		double Presence;
+		double Mapping;
+
+		FLookupTimes()
+			: Info(-1.0)
+			, Presence(-1.0)
+			, Mapping(-1.0)
+		{
+		}
+
+		double Get(EUserLookupEOS Lookup) const
+		{
+			return Lookup == EUserLookupEOS::Info ? Info : (Lookup == EUserLookupEOS::Presence ? Presence : Mapping);
+		}
+
+		void Set(EUserLookupEOS Lookup, double Time)
+		{
+			(Lookup == EUserLookupEOS::Info ? Info : (Lookup == EUserLookupEOS::Presence ? Presence : Mapping)) = Time;
+		}
+	};
+
+	/** Shared with request callbacks so they can tell if we are gone */
+	struct FLookupState
+	{
+		/** Lookups waiting for the window, in the order they were asked for */
+		TMap<EOS_EpicAccountId, EUserLookupEOS> Queued;
+		TMap<EOS_EpicAccountId, EUserLookupEOS> InFlight;
+		TMap<EOS_EpicAccountId, FLookupTimes> Completed;
+		int32 NumInFlight;
+		/** When the oldest queued lookup was asked for */
+		double QueuedSince;
+		/** Accumulated tick time */
+		double Now;
+		/** When stale completed lookups were last forgotten */
+		double PrunedAt;
+		/** Lookups asked for, one per kind per player */
+		uint64 NumRequested;
+		/** Requests handed to the backend */
+		uint64 NumIssued;
+
+		FLookupState()
+			: NumInFlight(0)
+			, QueuedSince(0.0)
+			, Now(0.0)
+			, PrunedAt(0.0)
+			, NumRequested(0)
+			, NumIssued(0)
+		{
+		}
+	};
+
+	/** @return true if the lookup finished recently enough to reuse */
+	bool IsFresh(EOS_EpicAccountId AccountId, EUserLookupEOS Lookup) const;
+	/** Hands a request to the backend, bookkeeping is done before the call since it may complete right away */
+	bool Issue(const TArray<EOS_EpicAccountId>& AccountIds, EUserLookupEOS Lookup);
+	void Flush();
+
+	TUniquePtr<IUserLookupBackendEOS> Backend;
+	TSharedRef<FLookupState> State;
+
+	/** Seconds lookups are gathered before they are issued */
+	float Window;
+	/** Most info, presence and mapping requests waiting on the backend at once */
+	int32 MaxInFlight;
+	/** Seconds a finished lookup is reused for */
+	float CacheTime;
+};
+
+#endif
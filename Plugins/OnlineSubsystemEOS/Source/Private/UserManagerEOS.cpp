@@ -8,6 +8,7 @@
 #include "IPAddress.h"
 #include "SocketSubsystem.h"
 #include "OnlineError.h"
+#include "Algo/BinarySearch.h"
 
 #if WITH_EOS_SDK
 
@@ -86,8 +87,370 @@ static inline EOS_Presence_EStatus ToEOS_Presence_EStatus(EOnlinePresenceState::
 
 /** Delegates that are used for internal calls and are meant to be ignored */
 FOnReadFriendsListComplete IgnoredFriendsDelegate;
-IOnlinePresence::FOnPresenceTaskCompleteDelegate IgnoredPresenceDelegate;
-IOnlineUser::FOnQueryExternalIdMappingsComplete IgnoredMappingDelegate;
+
+FUserHandleEOS FUserRecordStoreEOS::Add(const FString& NetIdStr, EOS_EpicAccountId AccountId, EOS_ProductUserId ProductUserId)
+{
+	const FUserHandleEOS Handle = Records.Add(FUserRecordEOS());
+	FUserRecordEOS& Record = Records[Handle];
+	Record.NetIdStr = NetIdStr;
+	Record.AccountId = AccountId;
+	Record.ProductUserId = ProductUserId;
+
+	NetIdStrToHandle.Add(NetIdStr, Handle);
+	AccountIdToHandle.Add(AccountId, Handle);
+	if (ProductUserId != nullptr)
+	{
+		ProductUserIdToHandle.Add(ProductUserId, Handle);
+	}
+	return Handle;
+}
+
+void FUserRecordStoreEOS::Remove(FUserHandleEOS Handle)
+{
+	if (!Records.IsValidIndex(Handle))
+	{
+		return;
+	}
+	const FUserRecordEOS& Record = Records[Handle];
+	NetIdStrToHandle.Remove(Record.NetIdStr);
+	AccountIdToHandle.Remove(Record.AccountId);
+	if (Record.ProductUserId != nullptr)
+	{
+		ProductUserIdToHandle.Remove(Record.ProductUserId);
+	}
+	Records.RemoveAt(Handle);
+}
+
+void FUserRecordStoreEOS::SetProductUserId(FUserHandleEOS Handle, EOS_ProductUserId ProductUserId, const FString& NetIdStr)
+{
+	FUserRecordEOS& Record = Records[Handle];
+	if (Record.ProductUserId != nullptr)
+	{
+		ProductUserIdToHandle.Remove(Record.ProductUserId);
+	}
+	NetIdStrToHandle.Remove(Record.NetIdStr);
+
+	Record.ProductUserId = ProductUserId;
+	Record.NetIdStr = NetIdStr;
+	ProductUserIdToHandle.Add(ProductUserId, Handle);
+	NetIdStrToHandle.Add(NetIdStr, Handle);
+}
+
+FUserHandleEOS FUserRecordStoreEOS::FindHandle(const FString& NetIdStr) const
+{
+	const FUserHandleEOS* Found = NetIdStrToHandle.Find(NetIdStr);
+	return Found != nullptr ? *Found : INDEX_NONE;
+}
+
+FUserHandleEOS FUserRecordStoreEOS::FindHandle(EOS_EpicAccountId AccountId) const
+{
+	const FUserHandleEOS* Found = AccountIdToHandle.Find(AccountId);
+	return Found != nullptr ? *Found : INDEX_NONE;
+}
+
+FUserHandleEOS FUserRecordStoreEOS::FindHandle(EOS_ProductUserId ProductUserId) const
+{
+	const FUserHandleEOS* Found = ProductUserIdToHandle.Find(ProductUserId);
+	return Found != nullptr ? *Found : INDEX_NONE;
+}
+
+void FFriendsListEOS::Add(EOS_EpicAccountId InAccountId, FOnlineFriendEOSRef InListEntry)
+{
+	if (SortStates.Contains(InAccountId))
+	{
+		// Already a friend, adding them again would leave them in the view twice
+		UpdateSortOrder(InAccountId);
+		return;
+	}
+	TOnlinePlayerList<FOnlineFriendEOSRef, FOnlineFriendEOSPtr>::Add(InAccountId, InListEntry);
+
+	FSortState& SortState = SortStates.Add(InAccountId);
+	SortState.Key.Sequence = NextSequence++;
+	SortState.bIsSorted = false;
+	UpdateSortOrder(InAccountId);
+}
+
+FFriendSortKeyEOS FFriendsListEOS::MakeSortKey(const FOnlineFriendEOS& Friend)
+{
+	const FOnlineUserPresence& Presence = Friend.GetPresence();
+	FFriendSortKeyEOS Key;
+	Key.Rank = Presence.bIsOnline ? (Presence.bIsPlayingThisGame ? 0 : 1) : 2;
+	Key.bIsPending = Friend.GetInviteStatus() != EInviteStatus::Accepted;
+	Key.DisplayName = Friend.GetDisplayName();
+	return Key;
+}
+
+int32 FFriendsListEOS::LowerBound(const FFriendSortKeyEOS& Key) const
+{
+	return Algo::LowerBoundBy(SortedFriends, Key, [](const TPair<FFriendSortKeyEOS, FOnlineFriendEOSRef>& Entry) -> const FFriendSortKeyEOS& { return Entry.Key; });
+}
+
+void FFriendsListEOS::UpdateSortOrder(EOS_EpicAccountId AccountId)
+{
+	FSortState* SortState = SortStates.Find(AccountId);
+	FOnlineFriendEOSPtr Friend = GetByAccountId(AccountId);
+	if (SortState == nullptr || !Friend.IsValid())
+	{
+		return;
+	}
+
+	FFriendSortKeyEOS NewKey = MakeSortKey(*Friend);
+	NewKey.Sequence = SortState->Key.Sequence;
+	// The service hasn't returned their info yet, they show up once it has
+	const bool bShouldBeSorted = !NewKey.DisplayName.IsEmpty();
+	if (SortState->bIsSorted == bShouldBeSorted && SortState->Key == NewKey)
+	{
+		return;
+	}
+
+	if (SortState->bIsSorted)
+	{
+		// Found with the key it was sorted by, the friend's presence may already have changed in place
+		const int32 OldIndex = LowerBound(SortState->Key);
+		if (ensure(SortedFriends.IsValidIndex(OldIndex) && SortedFriends[OldIndex].Value == Friend))
+		{
+			SortedFriends.RemoveAt(OldIndex, 1, false);
+		}
+	}
+	if (bShouldBeSorted)
+	{
+		SortedFriends.Insert(TPair<FFriendSortKeyEOS, FOnlineFriendEOSRef>(NewKey, Friend.ToSharedRef()), LowerBound(NewKey));
+	}
+	SortState->Key = MoveTemp(NewKey);
+	SortState->bIsSorted = bShouldBeSorted;
+}
+
+int32 FFriendsListEOS::GetNumSorted(EFriendsLists::Type List) const
+{
+	// The ranks are in list order, so each list ends where the next rank starts
+	uint8 LastRank = 2;
+	if (List == EFriendsLists::OnlinePlayers)
+	{
+		LastRank = 1;
+	}
+	else if (List == EFriendsLists::InGamePlayers)
+	{
+		LastRank = 0;
+	}
+	return Algo::UpperBoundBy(SortedFriends, LastRank, [](const TPair<FFriendSortKeyEOS, FOnlineFriendEOSRef>& Entry) { return Entry.Key.Rank; });
+}
+
+struct FPresenceStrings
+{
+	char Key[EOS_PRESENCE_DATA_MAX_KEY_LENGTH];
+	char Value[EOS_PRESENCE_DATA_MAX_VALUE_LENGTH];
+};
+
+struct FRichTextOptions :
+	public EOS_PresenceModification_SetRawRichTextOptions
+{
+	FRichTextOptions() :
+		EOS_PresenceModification_SetRawRichTextOptions()
+	{
+		ApiVersion = EOS_PRESENCE_SETRAWRICHTEXT_API_LATEST;
+		RichText = RichTextAnsi;
+	}
+	char RichTextAnsi[EOS_PRESENCE_RICH_TEXT_MAX_VALUE_LENGTH];
+};
+
+typedef TEOSCallback<EOS_Presence_SetPresenceCompleteCallback, EOS_Presence_SetPresenceCallbackInfo> FSetPresenceCallback;
+
+/** Writes presence changes with a presence modification holding only the changed fields */
+class FUserManagerPresenceWriterEOS :
+	public IPresenceWriterEOS
+{
+public:
+	FUserManagerPresenceWriterEOS(FOnlineSubsystemEOS* InSubsystem)
+		: EOSSubsystem(InSubsystem)
+	{
+	}
+
+// IPresenceWriterEOS
+	virtual bool WritePresence(EOS_EpicAccountId LocalUserId, const FPresenceDeltaEOS& Delta, FOnPresenceWriteCompleteEOS&& OnComplete) override
+	{
+		EOS_HPresenceModification ChangeHandle = nullptr;
+		EOS_Presence_CreatePresenceModificationOptions Options = { };
+		Options.ApiVersion = EOS_PRESENCE_CREATEPRESENCEMODIFICATION_API_LATEST;
+		Options.LocalUserId = LocalUserId;
+		EOS_Presence_CreatePresenceModification(EOSSubsystem->PresenceHandle, &Options, &ChangeHandle);
+		if (ChangeHandle == nullptr)
+		{
+			UE_LOG_ONLINE(Error, TEXT("Failed to create a modification handle for setting presence"));
+			return false;
+		}
+
+		if (Delta.bSetStatus)
+		{
+			EOS_PresenceModification_SetStatusOptions StatusOptions = { };
+			StatusOptions.ApiVersion = EOS_PRESENCE_SETSTATUS_API_LATEST;
+			StatusOptions.Status = ToEOS_Presence_EStatus(Delta.State);
+			EOS_EResult SetStatusResult = EOS_PresenceModification_SetStatus(ChangeHandle, &StatusOptions);
+			if (SetStatusResult != EOS_EResult::EOS_Success)
+			{
+				UE_LOG_ONLINE(Error, TEXT("EOS_PresenceModification_SetStatus() failed with result code (%d)"), (int32)SetStatusResult);
+			}
+		}
+
+		if (Delta.bSetRichText)
+		{
+			// Convert the status string as the rich text string
+			FRichTextOptions TextOptions;
+			FCStringAnsi::Strncpy(TextOptions.RichTextAnsi, TCHAR_TO_UTF8(*Delta.RichText), EOS_PRESENCE_RICH_TEXT_MAX_VALUE_LENGTH);
+			EOS_EResult SetRichTextResult = EOS_PresenceModification_SetRawRichText(ChangeHandle, &TextOptions);
+			if (SetRichTextResult != EOS_EResult::EOS_Success)
+			{
+				UE_LOG_ONLINE(Error, TEXT("EOS_PresenceModification_SetRawRichText() failed with result code (%s)"), ANSI_TO_TCHAR(EOS_EResult_ToString(SetRichTextResult)));
+			}
+		}
+
+		if (Delta.SetProperties.Num() > 0)
+		{
+			FPresenceStrings RawStrings[EOS_PRESENCE_DATA_MAX_KEYS];
+			TArray<EOS_Presence_DataRecord, TInlineAllocator<EOS_PRESENCE_DATA_MAX_KEYS>> Records;
+			for (int32 Index = 0; Index < Delta.SetProperties.Num() && Index < EOS_PRESENCE_DATA_MAX_KEYS; Index++)
+			{
+				// Since the TCHAR_TO_UTF8 macros are scoped, we need to copy to a chunk of memory while building the data up
+				FCStringAnsi::Strncpy(RawStrings[Index].Key, TCHAR_TO_UTF8(*Delta.SetProperties[Index].Key), EOS_PRESENCE_DATA_MAX_KEY_LENGTH);
+				FCStringAnsi::Strncpy(RawStrings[Index].Value, TCHAR_TO_UTF8(*Delta.SetProperties[Index].Value), EOS_PRESENCE_DATA_MAX_VALUE_LENGTH);
+
+				EOS_Presence_DataRecord Record;
+				Record.ApiVersion = EOS_PRESENCE_DATARECORD_API_LATEST;
+				Record.Key = RawStrings[Index].Key;
+				Record.Value = RawStrings[Index].Value;
+				Records.Add(Record);
+			}
+			EOS_PresenceModification_SetDataOptions DataOptions = { };
+			DataOptions.ApiVersion = EOS_PRESENCE_SETDATA_API_LATEST;
+			DataOptions.RecordsCount = Records.Num();
+			DataOptions.Records = Records.GetData();
+			EOS_EResult SetDataResult = EOS_PresenceModification_SetData(ChangeHandle, &DataOptions);
+			if (SetDataResult != EOS_EResult::EOS_Success)
+			{
+				UE_LOG_ONLINE(Error, TEXT("EOS_PresenceModification_SetData() failed with result code (%s)"), ANSI_TO_TCHAR(EOS_EResult_ToString(SetDataResult)));
+			}
+		}
+
+		if (Delta.RemovedProperties.Num() > 0)
+		{
+			FPresenceStrings RawStrings[EOS_PRESENCE_DATA_MAX_KEYS];
+			TArray<EOS_PresenceModification_DataRecordId, TInlineAllocator<EOS_PRESENCE_DATA_MAX_KEYS>> RecordIds;
+			for (int32 Index = 0; Index < Delta.RemovedProperties.Num() && Index < EOS_PRESENCE_DATA_MAX_KEYS; Index++)
+			{
+				FCStringAnsi::Strncpy(RawStrings[Index].Key, TCHAR_TO_UTF8(*Delta.RemovedProperties[Index]), EOS_PRESENCE_DATA_MAX_KEY_LENGTH);
+
+				EOS_PresenceModification_DataRecordId RecordId;
+				RecordId.ApiVersion = EOS_PRESENCEMODIFICATION_DATARECORDID_API_LATEST;
+				RecordId.Key = RawStrings[Index].Key;
+				RecordIds.Add(RecordId);
+			}
+			EOS_PresenceModification_DeleteDataOptions DeleteOptions = { };
+			DeleteOptions.ApiVersion = EOS_PRESENCEMODIFICATION_DELETEDATA_API_LATEST;
+			DeleteOptions.RecordsCount = RecordIds.Num();
+			DeleteOptions.Records = RecordIds.GetData();
+			EOS_EResult DeleteDataResult = EOS_PresenceModification_DeleteData(ChangeHandle, &DeleteOptions);
+			if (DeleteDataResult != EOS_EResult::EOS_Success)
+			{
+				UE_LOG_ONLINE(Error, TEXT("EOS_PresenceModification_DeleteData() failed with result code (%s)"), ANSI_TO_TCHAR(EOS_EResult_ToString(DeleteDataResult)));
+			}
+		}
+
+		FSetPresenceCallback* CallbackObj = new FSetPresenceCallback();
+		CallbackObj->CallbackLambda = [OnComplete = MoveTemp(OnComplete)](const EOS_Presence_SetPresenceCallbackInfo* Data)
+		{
+			if (Data->ResultCode != EOS_EResult::EOS_Success)
+			{
+				UE_LOG_ONLINE(Error, TEXT("SetPresence() failed with result code (%s)"), ANSI_TO_TCHAR(EOS_EResult_ToString(Data->ResultCode)));
+			}
+			OnComplete(Data->ResultCode == EOS_EResult::EOS_Success);
+		};
+
+		EOS_Presence_SetPresenceOptions PresOptions = { };
+		PresOptions.ApiVersion = EOS_PRESENCE_SETPRESENCE_API_LATEST;
+		PresOptions.LocalUserId = LocalUserId;
+		PresOptions.PresenceModificationHandle = ChangeHandle;
+		// Last step commit the changes
+		EOS_Presence_SetPresence(EOSSubsystem->PresenceHandle, &PresOptions, CallbackObj, CallbackObj->GetCallbackPtr());
+		EOS_PresenceModification_Release(ChangeHandle);
+		return true;
+	}
+// ~IPresenceWriterEOS
+
+private:
+	FOnlineSubsystemEOS* EOSSubsystem;
+};
+
+/** Issues coalesced player lookups through the user manager's SDK calls, as the default local user */
+class FUserManagerLookupBackendEOS :
+	public IUserLookupBackendEOS
+{
+public:
+	FUserManagerLookupBackendEOS(FUserManagerEOS& InUserManager)
+		: UserManager(InUserManager)
+	{
+	}
+
+// IUserLookupBackendEOS
+	virtual bool QueryUserInfo(EOS_EpicAccountId AccountId, FOnUserLookupCompleteEOS&& OnComplete) override
+	{
+		if (UserManager.DefaultLocalUser < 0)
+		{
+			return false;
+		}
+		UserManager.ReadUserInfo(AccountId, MoveTemp(OnComplete));
+		return true;
+	}
+
+	virtual bool QueryPresence(EOS_EpicAccountId AccountId, FOnUserLookupCompleteEOS&& OnComplete) override
+	{
+		const FUserRecordEOS* Record = UserManager.UserRecords.Find(AccountId);
+		if (UserManager.DefaultLocalUser < 0 || Record == nullptr || !Record->NetId.IsValid())
+		{
+			return false;
+		}
+		// Completes right away when the SDK already has their presence
+		UserManager.QueryPresence(*Record->NetId, IOnlinePresence::FOnPresenceTaskCompleteDelegate::CreateLambda([OnComplete = MoveTemp(OnComplete)](const FUniqueNetId&, bool bWasSuccessful)
+		{
+			OnComplete(bWasSuccessful);
+		}));
+		return true;
+	}
+
+	virtual bool QueryMappings(const TArray<EOS_EpicAccountId>& AccountIds, FOnUserLookupCompleteEOS&& OnComplete) override
+	{
+		FUniqueNetIdEOSPtr LocalNetId = UserManager.GetLocalUniqueNetIdEOS(UserManager.DefaultLocalUser);
+		if (!LocalNetId.IsValid())
+		{
+			return false;
+		}
+		TArray<FString> ExternalIds;
+		ExternalIds.Reserve(AccountIds.Num());
+		for (EOS_EpicAccountId AccountId : AccountIds)
+		{
+			ExternalIds.Add(MakeStringFromEpicAccountId(AccountId));
+		}
+		// The coalescer never asks for more than one batch, so this completes once
+		UserManager.QueryExternalIdMappings(*LocalNetId, FExternalIdQueryOptions(), ExternalIds, IOnlineUser::FOnQueryExternalIdMappingsComplete::CreateLambda([OnComplete = MoveTemp(OnComplete)](bool bWasSuccessful, const FUniqueNetId&, const FExternalIdQueryOptions&, const TArray<FString>&, const FString&)
+		{
+			OnComplete(bWasSuccessful);
+		}));
+		return true;
+	}
+
+	virtual bool IsCached(EOS_EpicAccountId AccountId, EUserLookupEOS Lookup) const override
+	{
+		// Presence always goes through QueryPresence(), which copies what the SDK has cached into the user
+		if (Lookup == EUserLookupEOS::Mapping)
+		{
+			const FUserRecordEOS* Record = UserManager.UserRecords.Find(AccountId);
+			return Record != nullptr && Record->ProductUserId != nullptr;
+		}
+		return false;
+	}
+// ~IUserLookupBackendEOS
+
+private:
+	FUserManagerEOS& UserManager;
+};
 
 FUserManagerEOS::FUserManagerEOS(FOnlineSubsystemEOS* InSubsystem)
 	: EOSSubsystem(InSubsystem)
@@ -98,27 +461,38 @@ FUserManagerEOS::FUserManagerEOS(FOnlineSubsystemEOS* InSubsystem)
 	, FriendsNotificationCallback(nullptr)
 	, PresenceNotificationId(0)
 	, PresenceNotificationCallback(nullptr)
+	, UserLookups(MakeUnique<FUserLookupCoalescerEOS>(MakeUnique<FUserManagerLookupBackendEOS>(*this)))
+	, PresenceUpdater(MakeUnique<FPresenceUpdaterEOS>(MakeUnique<FUserManagerPresenceWriterEOS>(InSubsystem)))
 {
+	UserLookups->LoadConfig();
+	PresenceUpdater->LoadConfig();
 }
 
 FUserManagerEOS::~FUserManagerEOS()
 {
 }
 
+void FUserManagerEOS::Tick(float DeltaTime)
+{
+	UserLookups->Tick(DeltaTime);
+	PresenceUpdater->Tick(DeltaTime);
+}
+
 void FUserManagerEOS::LoginStatusChanged(const EOS_Auth_LoginStatusChangedCallbackInfo* Data)
 {
 	if (Data->CurrentStatus == EOS_ELoginStatus::EOS_LS_NotLoggedIn)
 	{
-		if (AccountIdToUserNumMap.Contains(Data->LocalUserId))
+		const FUserRecordEOS* Record = UserRecords.Find(Data->LocalUserId);
+		if (Record != nullptr && Record->IsLocal())
 		{
-			int32 LocalUserNum = AccountIdToUserNumMap[Data->LocalUserId];
-			FUniqueNetIdEOSPtr UserNetId = UserNumToNetIdMap[LocalUserNum];
+			int32 LocalUserNum = Record->LocalUserNum;
+			FUniqueNetIdEOSPtr UserNetId = Record->NetId;
 			TriggerOnLoginStatusChangedDelegates(LocalUserNum, ELoginStatus::LoggedIn, ELoginStatus::NotLoggedIn, *UserNetId);
 			// Need to remove the local user
 			RemoveLocalUser(LocalUserNum);
 
 			// Clean up user based notifies if we have no logged in users
-			if (UserNumToNetIdMap.Num() == 0)
+			if (LocalUserHandles.Num() == 0)
 			{
 				if (LoginNotificationId > 0)
 				{
@@ -295,13 +669,13 @@ void FUserManagerEOS::ConnectLogin(int32 LocalUserNum, EOS_EpicAccountId Account
 
 void FUserManagerEOS::RefreshConnectLogin(int32 LocalUserNum)
 {
-	if (!UserNumToAccountIdMap.Contains(LocalUserNum))
+	EOS_EpicAccountId AccountId = GetLocalEpicAccountId(LocalUserNum);
+	if (AccountId == nullptr)
 	{
 		UE_LOG_ONLINE(Error, TEXT("Can't refresh ConnectLogin(%d) since (%d) is not logged in"), LocalUserNum, LocalUserNum);
 		return;
 	}
 
-	EOS_EpicAccountId AccountId = UserNumToAccountIdMap[LocalUserNum];
 	EOS_Auth_Token* AuthToken = nullptr;
 	EOS_Auth_CopyUserAuthTokenOptions CopyOptions = { };
 	CopyOptions.ApiVersion = EOS_AUTH_COPYUSERAUTHTOKEN_API_LATEST;
@@ -406,7 +780,8 @@ void FUserManagerEOS::FullLoginCallback(int32 LocalUserNum, EOS_EpicAccountId Ac
 		PresenceNotificationCallback = CallbackObj;
 		CallbackObj->CallbackLambda = [LocalUserNum, this](const EOS_Presence_PresenceChangedCallbackInfo* Data)
 		{
-			if (EpicAccountIdToOnlineUserMap.Contains(Data->PresenceUserId))
+			const FUserRecordEOS* Record = UserRecords.Find(Data->PresenceUserId);
+			if (Record != nullptr && !Record->IsLocal())
 			{
 				// Update the presence data to the most recent
 				UpdatePresence(Data->PresenceUserId);
@@ -474,7 +849,7 @@ bool FUserManagerEOS::Logout(int32 LocalUserNum)
 
 	EOS_Auth_LogoutOptions LogoutOptions = { };
 	LogoutOptions.ApiVersion = EOS_AUTH_LOGOUT_API_LATEST;
-	LogoutOptions.LocalUserId = StringToAccountIdMap[UserId->UniqueNetIdStr];
+	LogoutOptions.LocalUserId = GetLocalEpicAccountId(LocalUserNum);
 
 	EOS_Auth_Logout(EOSSubsystem->AuthHandle, &LogoutOptions, CallbackObj, CallbackObj->GetCallbackPtr());
 
@@ -512,30 +887,22 @@ void FUserManagerEOS::AddLocalUser(int32 LocalUserNum, EOS_EpicAccountId EpicAcc
 	FUniqueNetIdEOSRef UserNetId(new FUniqueNetIdEOS(NetId));
 	FUserOnlineAccountEOSRef UserAccountRef(new FUserOnlineAccountEOS(UserNetId));
 
-	UserNumToNetIdMap.Add(LocalUserNum, UserNetId);
-	UserNumToAccountIdMap.Add(LocalUserNum, EpicAccountId);
-	AccountIdToUserNumMap.Add(EpicAccountId, LocalUserNum);
-	NetIdStringToOnlineUserMap.Add(*NetId, UserAccountRef);
-	StringToUserAccountMap.Add(NetId, UserAccountRef);
-	AccountIdToStringMap.Add(EpicAccountId, NetId);
-	ProductUserIdToStringMap.Add(UserId, *NetId);
-	StringToAccountIdMap.Add(NetId, EpicAccountId);
-	EpicAccountIdToAttributeAccessMap.Add(EpicAccountId, UserAccountRef);
-	UserNumToProductUserIdMap.Add(LocalUserNum, UserId);
-	ProductUserIdToUserNumMap.Add(UserId, LocalUserNum);
-	StringToProductUserIdMap.Add(NetId, UserId);
+	// Replace the record from when they were only known as a remote user, if any
+	UserRecords.Remove(UserRecords.FindHandle(EpicAccountId));
 
-	// Init player lists
-	FFriendsListEOSRef FriendsList = MakeShareable(new FFriendsListEOS(LocalUserNum, UserNetId));
-	FBlockedPlayersListEOSRef BlockedPlayersList = MakeShareable(new FBlockedPlayersListEOS(LocalUserNum, UserNetId));
-	FRecentPlayersListEOSRef RecentPlayersList = MakeShareable(new FRecentPlayersListEOS(LocalUserNum, UserNetId));
+	const FUserHandleEOS Handle = UserRecords.Add(NetId, EpicAccountId, UserId);
+	FUserRecordEOS& Record = *UserRecords.Get(Handle);
+	Record.LocalUserNum = LocalUserNum;
+	Record.NetId = UserNetId;
+	Record.OnlineUser = UserAccountRef;
+	Record.AttributeAccess = UserAccountRef;
+	Record.UserAccount = UserAccountRef;
+	LocalUserHandles.Add(LocalUserNum, Handle);
 
-	LocalUserNumToFriendsListMap.Add(LocalUserNum, FriendsList);
-	NetIdStringToFriendsListMap.Add(NetId, FriendsList);
-	LocalUserNumToBlockedPlayerListMap.Add(LocalUserNum, BlockedPlayersList);
-	NetIdStringToBlockedPlayerListMap.Add(NetId, BlockedPlayersList);
-	LocalUserNumToRecentPlayerListMap.Add(LocalUserNum, RecentPlayersList);
-	NetIdStringToRecentPlayerListMap.Add(NetId, RecentPlayersList);
+	// Init player lists
+	Record.FriendsList = MakeShareable(new FFriendsListEOS(LocalUserNum, UserNetId));
+	Record.BlockedPlayersList = MakeShareable(new FBlockedPlayersListEOS(LocalUserNum, UserNetId));
+	Record.RecentPlayersList = MakeShareable(new FRecentPlayersListEOS(LocalUserNum, UserNetId));
 
 	// Get auth token info
 	EOS_Auth_Token* AuthToken = nullptr;
@@ -573,18 +940,17 @@ void FUserManagerEOS::UpdateUserInfo(IAttributeAccessInterfaceRef AttributeAcces
 		AttributeAccessRef->SetInternalAttribute(USER_ATTR_COUNTRY, UserInfo->Country);
 		AttributeAccessRef->SetInternalAttribute(USER_ATTR_LANG, UserInfo->PreferredLanguage);
 		EOS_UserInfo_Release(UserInfo);
+		// Friends are sorted by name and left out of the lists until they have one
+		UpdateFriendSortOrder(AccountId);
 	}
 }
 
 TSharedPtr<FUserOnlineAccount> FUserManagerEOS::GetUserAccount(const FUniqueNetId& UserId) const
 {
-	TSharedPtr<FUserOnlineAccount> Result;
-
-	FUniqueNetIdEOS EOSID(UserId);
-	const FUserOnlineAccountEOSRef* FoundUserAccount = StringToUserAccountMap.Find(EOSID.UniqueNetIdStr);
-	if (FoundUserAccount != nullptr)
+	const FUserRecordEOS* Record = FindUserRecord(UserId);
+	if (Record != nullptr)
 	{
-		return *FoundUserAccount;
+		return Record->UserAccount;
 	}
 	return nullptr;
 }
@@ -593,9 +959,12 @@ TArray<TSharedPtr<FUserOnlineAccount>> FUserManagerEOS::GetAllUserAccounts() con
 {
 	TArray<TSharedPtr<FUserOnlineAccount>> Result;
 
-	for (TMap<FString, FUserOnlineAccountEOSRef>::TConstIterator It(StringToUserAccountMap); It; ++It)
+	for (const FUserRecordEOS& Record : UserRecords.GetRecords())
 	{
-		Result.Add(It.Value());
+		if (Record.UserAccount.IsValid())
+		{
+			Result.Add(Record.UserAccount);
+		}
 	}
 	return Result;
 }
@@ -607,52 +976,78 @@ TSharedPtr<const FUniqueNetId> FUserManagerEOS::GetUniquePlayerId(int32 LocalUse
 
 int32 FUserManagerEOS::GetLocalUserNumFromUniqueNetId(const FUniqueNetId& NetId) const
 {
-	FUniqueNetIdEOS EosId(NetId);
-	if (StringToAccountIdMap.Contains(EosId.UniqueNetIdStr))
+	const FUserRecordEOS* Record = FindUserRecord(NetId);
+	if (Record != nullptr && Record->IsLocal())
 	{
-		EOS_EpicAccountId AccountId = StringToAccountIdMap[EosId.UniqueNetIdStr];
-		if (AccountIdToUserNumMap.Contains(AccountId))
-		{
-			return AccountIdToUserNumMap[AccountId];
-		}
+		return Record->LocalUserNum;
 	}
 	// Use the default user if we can't find the person that they want
 	return DefaultLocalUser;
 }
 
+FUserRecordEOS* FUserManagerEOS::GetLocalUserRecord(int32 LocalUserNum)
+{
+	const FUserHandleEOS* Handle = LocalUserHandles.Find(LocalUserNum);
+	return Handle != nullptr ? UserRecords.Get(*Handle) : nullptr;
+}
+
+const FUserRecordEOS* FUserManagerEOS::GetLocalUserRecord(int32 LocalUserNum) const
+{
+	const FUserHandleEOS* Handle = LocalUserHandles.Find(LocalUserNum);
+	return Handle != nullptr ? UserRecords.Get(*Handle) : nullptr;
+}
+
+FUserRecordEOS* FUserManagerEOS::FindUserRecord(const FUniqueNetId& NetId)
+{
+	return const_cast<FUserRecordEOS*>(static_cast<const FUserManagerEOS*>(this)->FindUserRecord(NetId));
+}
+
+const FUserRecordEOS* FUserManagerEOS::FindUserRecord(const FUniqueNetId& NetId) const
+{
+	// EOS ids hand out their interned string, others have to be converted
+	if (NetId.GetType() == EOS_SUBSYSTEM)
+	{
+		return UserRecords.Find(static_cast<const FUniqueNetIdEOS&>(NetId).GetNetIdStr());
+	}
+	return UserRecords.Find(NetId.ToString());
+}
+
 FUniqueNetIdEOSPtr FUserManagerEOS::GetLocalUniqueNetIdEOS(int32 LocalUserNum) const
 {
-	const FUniqueNetIdEOSPtr* FoundId = UserNumToNetIdMap.Find(LocalUserNum);
-	if (FoundId != nullptr)
+	const FUserRecordEOS* Record = GetLocalUserRecord(LocalUserNum);
+	if (Record != nullptr)
 	{
-		return *FoundId;
+		return Record->NetId;
 	}
 	return nullptr;
 }
 
 FUniqueNetIdEOSPtr FUserManagerEOS::GetLocalUniqueNetIdEOS(EOS_ProductUserId UserId) const
 {
-	if (ProductUserIdToUserNumMap.Contains(UserId))
+	const FUserRecordEOS* Record = UserRecords.Find(UserId);
+	if (Record != nullptr && Record->IsLocal())
 	{
-		return GetLocalUniqueNetIdEOS(ProductUserIdToUserNumMap[UserId]);
+		return Record->NetId;
 	}
 	return nullptr;
 }
 
 FUniqueNetIdEOSPtr FUserManagerEOS::GetLocalUniqueNetIdEOS(EOS_EpicAccountId AccountId) const
 {
-	if (AccountIdToUserNumMap.Contains(AccountId))
+	const FUserRecordEOS* Record = UserRecords.Find(AccountId);
+	if (Record != nullptr && Record->IsLocal())
 	{
-		return GetLocalUniqueNetIdEOS(AccountIdToUserNumMap[AccountId]);
+		return Record->NetId;
 	}
 	return nullptr;
 }
 
 EOS_EpicAccountId FUserManagerEOS::GetLocalEpicAccountId(int32 LocalUserNum) const
 {
-	if (UserNumToAccountIdMap.Contains(LocalUserNum))
+	const FUserRecordEOS* Record = GetLocalUserRecord(LocalUserNum);
+	if (Record != nullptr)
 	{
-		return UserNumToAccountIdMap[LocalUserNum];
+		return Record->AccountId;
 	}
 	return nullptr;
 }
@@ -664,9 +1059,10 @@ EOS_EpicAccountId FUserManagerEOS::GetLocalEpicAccountId() const
 
 EOS_ProductUserId FUserManagerEOS::GetLocalProductUserId(int32 LocalUserNum) const
 {
-	if (UserNumToProductUserIdMap.Contains(LocalUserNum))
+	const FUserRecordEOS* Record = GetLocalUserRecord(LocalUserNum);
+	if (Record != nullptr)
 	{
-		return UserNumToProductUserIdMap[LocalUserNum];
+		return Record->ProductUserId;
 	}
 	return nullptr;
 }
@@ -678,40 +1074,40 @@ EOS_ProductUserId FUserManagerEOS::GetLocalProductUserId() const
 
 EOS_EpicAccountId FUserManagerEOS::GetLocalEpicAccountId(EOS_ProductUserId UserId) const
 {
-	if (ProductUserIdToUserNumMap.Contains(UserId))
+	const FUserRecordEOS* Record = UserRecords.Find(UserId);
+	if (Record != nullptr && Record->IsLocal())
 	{
-		return GetLocalEpicAccountId(ProductUserIdToUserNumMap[UserId]);
+		return Record->AccountId;
 	}
 	return nullptr;
 }
 
 EOS_ProductUserId FUserManagerEOS::GetLocalProductUserId(EOS_EpicAccountId AccountId) const
 {
-	if (AccountIdToUserNumMap.Contains(AccountId))
+	const FUserRecordEOS* Record = UserRecords.Find(AccountId);
+	if (Record != nullptr && Record->IsLocal())
 	{
-		return GetLocalProductUserId(AccountIdToUserNumMap[AccountId]);
+		return Record->ProductUserId;
 	}
 	return nullptr;
 }
 
 EOS_EpicAccountId FUserManagerEOS::GetEpicAccountId(const FUniqueNetId& NetId) const
 {
-	FUniqueNetIdEOS EOSId(NetId);
-
-	if (StringToAccountIdMap.Contains(EOSId.UniqueNetIdStr))
+	const FUserRecordEOS* Record = FindUserRecord(NetId);
+	if (Record != nullptr)
 	{
-		return StringToAccountIdMap[EOSId.UniqueNetIdStr];
+		return Record->AccountId;
 	}
 	return nullptr;
 }
 
 EOS_ProductUserId FUserManagerEOS::GetProductUserId(const FUniqueNetId& NetId) const
 {
-	FUniqueNetIdEOS EOSId(NetId);
-
-	if (StringToProductUserIdMap.Contains(EOSId.UniqueNetIdStr))
+	const FUserRecordEOS* Record = FindUserRecord(NetId);
+	if (Record != nullptr)
 	{
-		return StringToProductUserIdMap[EOSId.UniqueNetIdStr];
+		return Record->ProductUserId;
 	}
 	return nullptr;
 }
@@ -719,13 +1115,10 @@ EOS_ProductUserId FUserManagerEOS::GetProductUserId(const FUniqueNetId& NetId) c
 FOnlineUserPtr FUserManagerEOS::GetLocalOnlineUser(int32 LocalUserNum) const
 {
 	FOnlineUserPtr OnlineUser;
-	if (UserNumToNetIdMap.Contains(LocalUserNum))
+	const FUserRecordEOS* Record = GetLocalUserRecord(LocalUserNum);
+	if (Record != nullptr)
 	{
-		const FUniqueNetIdEOSPtr NetId = UserNumToNetIdMap.FindRef(LocalUserNum);
-		if (NetIdStringToOnlineUserMap.Contains(*NetId->UniqueNetIdStr))
-		{
-			OnlineUser = NetIdStringToOnlineUserMap.FindRef(*NetId->UniqueNetIdStr);
-		}
+		OnlineUser = Record->OnlineUser;
 	}
 	return OnlineUser;
 }
@@ -733,13 +1126,10 @@ FOnlineUserPtr FUserManagerEOS::GetLocalOnlineUser(int32 LocalUserNum) const
 FOnlineUserPtr FUserManagerEOS::GetOnlineUser(EOS_ProductUserId UserId) const
 {
 	FOnlineUserPtr OnlineUser;
-	if (ProductUserIdToStringMap.Contains(UserId))
+	const FUserRecordEOS* Record = UserRecords.Find(UserId);
+	if (Record != nullptr)
 	{
-		const FString& NetId = ProductUserIdToStringMap.FindRef(UserId);
-		if (NetIdStringToOnlineUserMap.Contains(*NetId))
-		{
-			OnlineUser = NetIdStringToOnlineUserMap.FindRef(*NetId);
-		}
+		OnlineUser = Record->OnlineUser;
 	}
 	return OnlineUser;
 }
@@ -747,41 +1137,34 @@ FOnlineUserPtr FUserManagerEOS::GetOnlineUser(EOS_ProductUserId UserId) const
 FOnlineUserPtr FUserManagerEOS::GetOnlineUser(EOS_EpicAccountId AccountId) const
 {
 	FOnlineUserPtr OnlineUser;
-	if (AccountIdToStringMap.Contains(AccountId))
+	const FUserRecordEOS* Record = UserRecords.Find(AccountId);
+	if (Record != nullptr)
 	{
-		const FString& NetId = AccountIdToStringMap.FindRef(AccountId);
-		if (NetIdStringToOnlineUserMap.Contains(*NetId))
-		{
-			OnlineUser = NetIdStringToOnlineUserMap.FindRef(*NetId);
-		}
+		OnlineUser = Record->OnlineUser;
 	}
 	return OnlineUser;
 }
 
 void FUserManagerEOS::RemoveLocalUser(int32 LocalUserNum)
 {
-	const FUniqueNetIdEOSPtr* FoundId = UserNumToNetIdMap.Find(LocalUserNum);
-	if (FoundId != nullptr)
-	{
-		LocalUserNumToFriendsListMap.Remove(LocalUserNum);
-		const FString& NetId = (*FoundId)->UniqueNetIdStr;
-		EOS_EpicAccountId AccountId = StringToAccountIdMap[NetId];
-		AccountIdToStringMap.Remove(AccountId);
-		AccountIdToUserNumMap.Remove(AccountId);
-		NetIdStringToOnlineUserMap.Remove(NetId);
-		StringToAccountIdMap.Remove(NetId);
-		StringToUserAccountMap.Remove(NetId);
-		UserNumToNetIdMap.Remove(LocalUserNum);
-		UserNumToAccountIdMap.Remove(LocalUserNum);
-		EOS_ProductUserId UserId = UserNumToProductUserIdMap[LocalUserNum];
-		ProductUserIdToUserNumMap.Remove(UserId);
-		ProductUserIdToStringMap.Remove(UserId);
-		UserNumToProductUserIdMap.Remove(LocalUserNum);
+	const FUserHandleEOS* Handle = LocalUserHandles.Find(LocalUserNum);
+	if (Handle != nullptr)
+	{
+		const FUserRecordEOS* Record = UserRecords.Get(*Handle);
+		if (Record != nullptr)
+		{
+			PresenceUpdater->RemoveUser(Record->AccountId);
+		}
+		// Takes the user's ids and player lists with it
+		UserRecords.Remove(*Handle);
+		LocalUserHandles.Remove(LocalUserNum);
 	}
 	// Reset this for the next user login
 	if (LocalUserNum == DefaultLocalUser)
 	{
 		DefaultLocalUser = -1;
+		// What was looked up is as seen by this user
+		UserLookups->Reset();
 	}
 }
 
@@ -789,6 +1172,12 @@ TSharedPtr<const FUniqueNetId> FUserManagerEOS::CreateUniquePlayerId(uint8* Byte
 {
 	if (Bytes != nullptr && Size > 0)
 	{
+		// Account ids come in their binary form, anything else is the id string's characters
+		FUniqueNetIdEOSEntryPtr Entry = FUniqueNetIdEOSRegistry::FindOrAdd(Bytes, Size);
+		if (Entry.IsValid())
+		{
+			return MakeShareable(new FUniqueNetIdEOS(Entry.ToSharedRef()));
+		}
 		FString StrId(Size, (TCHAR*)Bytes);
 		return MakeShareable(new FUniqueNetIdEOS(StrId));
 	}
@@ -812,16 +1201,13 @@ ELoginStatus::Type FUserManagerEOS::GetLoginStatus(int32 LocalUserNum) const
 
 ELoginStatus::Type FUserManagerEOS::GetLoginStatus(const FUniqueNetIdEOS& UserId) const
 {
-	if (!StringToAccountIdMap.Contains(UserId.UniqueNetIdStr))
+	const FUserRecordEOS* Record = UserRecords.Find(UserId.GetNetIdStr());
+	if (Record == nullptr || Record->AccountId == nullptr)
 	{
 		return ELoginStatus::NotLoggedIn;
 	}
 
-	EOS_EpicAccountId AccountId = StringToAccountIdMap[UserId.UniqueNetIdStr];
-	if (AccountId == nullptr)
-	{
-		return ELoginStatus::NotLoggedIn;
-	}
+	EOS_EpicAccountId AccountId = Record->AccountId;
 
 	EOS_ELoginStatus LoginStatus = EOS_Auth_GetLoginStatus(EOSSubsystem->AuthHandle, AccountId);
 	switch (LoginStatus)
@@ -906,7 +1292,8 @@ typedef TEOSCallback<EOS_Friends_OnQueryFriendsCallback, EOS_Friends_QueryFriend
 
 bool FUserManagerEOS::ReadFriendsList(int32 LocalUserNum, const FString& ListName, const FOnReadFriendsListComplete& Delegate)
 {
-	if (!UserNumToNetIdMap.Contains(LocalUserNum))
+	EOS_EpicAccountId LocalAccountId = GetLocalEpicAccountId(LocalUserNum);
+	if (LocalAccountId == nullptr)
 	{
 		UE_LOG_ONLINE(Warning, TEXT("Can't ReadFriendsList() for user (%d) since they are not logged in"), LocalUserNum);
 		Delegate.ExecuteIfBound(LocalUserNum, false, ListName, FString(TEXT("Can't ReadFriendsList() for user (%d) since they are not logged in"), LocalUserNum));
@@ -915,7 +1302,7 @@ bool FUserManagerEOS::ReadFriendsList(int32 LocalUserNum, const FString& ListNam
 
 	EOS_Friends_QueryFriendsOptions Options = { };
 	Options.ApiVersion = EOS_FRIENDS_QUERYFRIENDS_API_LATEST;
-	Options.LocalUserId = UserNumToAccountIdMap[LocalUserNum];
+	Options.LocalUserId = LocalAccountId;
 
 	FReadFriendsCallback* CallbackObj = new FReadFriendsCallback();
 	CallbackObj->CallbackLambda = [LocalUserNum, ListName, this, Delegate](const EOS_Friends_QueryFriendsCallbackInfo* Data)
@@ -933,7 +1320,7 @@ bool FUserManagerEOS::ReadFriendsList(int32 LocalUserNum, const FString& ListNam
 		{
 			EOS_Friends_GetFriendsCountOptions Options = { };
 			Options.ApiVersion = EOS_FRIENDS_GETFRIENDSCOUNT_API_LATEST;
-			Options.LocalUserId = UserNumToAccountIdMap[LocalUserNum];
+			Options.LocalUserId = GetLocalEpicAccountId(LocalUserNum);
 			int32 FriendCount = EOS_Friends_GetFriendsCount(EOSSubsystem->FriendsHandle, &Options);
 
 			// Process each friend returned
@@ -947,7 +1334,7 @@ bool FUserManagerEOS::ReadFriendsList(int32 LocalUserNum, const FString& ListNam
 				if (FriendEpicAccountId != nullptr)
 				{
 					// Make sure this friend wasn't added via friend status change
-					if (!AccountIdToStringMap.Contains(FriendEpicAccountId))
+					if (UserRecords.FindHandle(FriendEpicAccountId) == INDEX_NONE)
 					{
 						AddFriend(LocalUserNum, FriendEpicAccountId);
 					}
@@ -976,18 +1363,20 @@ void FUserManagerEOS::FriendStatusChanged(const EOS_Friends_OnFriendsUpdateInfo*
 	}
 
 	// Get the local user information
-	if (AccountIdToUserNumMap.Contains(Data->LocalUserId))
+	const FUserRecordEOS* LocalRecord = UserRecords.Find(Data->LocalUserId);
+	if (LocalRecord != nullptr && LocalRecord->IsLocal())
 	{
-		int32 LocalUserNum = AccountIdToUserNumMap[Data->LocalUserId];
-		FUniqueNetIdEOSPtr LocalEOSID = UserNumToNetIdMap[LocalUserNum];
+		int32 LocalUserNum = LocalRecord->LocalUserNum;
+		FUniqueNetIdEOSPtr LocalEOSID = LocalRecord->NetId;
+		TSharedPtr<FFriendsListEOS> FriendsList = LocalRecord->FriendsList;
 		// If we don't know them yet, then add them to kick off the reads
-		if (!AccountIdToStringMap.Contains(Data->TargetUserId))
+		if (UserRecords.FindHandle(Data->TargetUserId) == INDEX_NONE)
 		{
 			AddFriend(LocalUserNum, Data->TargetUserId);
 		}
 		// They are in our list now
-		FOnlineUserPtr OnlineUser = EpicAccountIdToOnlineUserMap[Data->TargetUserId];
-		FOnlineFriendEOSPtr Friend = LocalUserNumToFriendsListMap[LocalUserNum]->GetByNetIdString(AccountIdToStringMap[Data->TargetUserId]);
+		FOnlineUserPtr OnlineUser = UserRecords.Find(Data->TargetUserId)->OnlineUser;
+		FOnlineFriendEOSPtr Friend = FriendsList->GetByAccountId(Data->TargetUserId);
 		// Figure out which notification to fire
 		if (Data->CurrentStatus == EOS_EFriendsStatus::EOS_FS_Friends)
 		{
@@ -1009,6 +1398,7 @@ void FUserManagerEOS::FriendStatusChanged(const EOS_Friends_OnFriendsUpdateInfo*
 			Friend->SetInviteStatus(EInviteStatus::PendingInbound);
 			TriggerOnInviteReceivedDelegates(*LocalEOSID, *OnlineUser->GetUserId());
 		}
+		FriendsList->UpdateSortOrder(Data->TargetUserId);
 	}
 }
 
@@ -1017,15 +1407,16 @@ void FUserManagerEOS::AddFriend(int32 LocalUserNum, EOS_EpicAccountId EpicAccoun
 	const FString& NetId = MakeStringFromEpicAccountId(EpicAccountId);
 	FUniqueNetIdEOSRef FriendNetId(new FUniqueNetIdEOS(NetId));
 	FOnlineFriendEOSRef FriendRef = MakeShareable(new FOnlineFriendEOS(FriendNetId));
-	LocalUserNumToFriendsListMap[LocalUserNum]->Add(NetId, FriendRef);
 
 	EOS_Friends_GetStatusOptions Options = { };
 	Options.ApiVersion = EOS_FRIENDS_GETSTATUS_API_LATEST;
-	Options.LocalUserId = UserNumToAccountIdMap[LocalUserNum];
+	Options.LocalUserId = GetLocalEpicAccountId(LocalUserNum);
 	Options.TargetUserId = EpicAccountId;
 	EOS_EFriendsStatus Status = EOS_Friends_GetStatus(EOSSubsystem->FriendsHandle, &Options);
 	
 	FriendRef->SetInviteStatus(ToEInviteStatus(Status));
+	// Added once the status is known so they are sorted in the right place from the start
+	GetLocalUserRecord(LocalUserNum)->FriendsList->Add(EpicAccountId, FriendRef);
 
 	// Add this friend as a remote (this will grab presence & user info)
 	AddRemotePlayer(NetId, EpicAccountId, FriendNetId, FriendRef, FriendRef);
@@ -1041,79 +1432,43 @@ void FUserManagerEOS::AddRemotePlayer(const FString& NetId, EOS_EpicAccountId Ep
 
 void FUserManagerEOS::AddRemotePlayer(const FString& NetId, EOS_EpicAccountId EpicAccountId, FUniqueNetIdEOSPtr UniqueNetId, FOnlineUserPtr OnlineUser, IAttributeAccessInterfaceRef AttributeRef)
 {
-	NetIdStringToOnlineUserMap.Add(NetId, OnlineUser);
-	EpicAccountIdToOnlineUserMap.Add(EpicAccountId, OnlineUser);
-	NetIdStringToAttributeAccessMap.Add(NetId, AttributeRef);
-	EpicAccountIdToAttributeAccessMap.Add(EpicAccountId, AttributeRef);
-
-	StringToAccountIdMap.Add(NetId, EpicAccountId);
-	AccountIdToStringMap.Add(EpicAccountId, NetId);
-
-	// Read the user info for this player
-	ReadUserInfo(EpicAccountId);
-	// Read presence for this remote player
-	QueryPresence(*UniqueNetId, IgnoredPresenceDelegate);
-	// Get their product id mapping
-	FUniqueNetIdEOSPtr LocalNetId = GetLocalUniqueNetIdEOS(DefaultLocalUser);
-	if (LocalNetId.IsValid())
+	FUserHandleEOS Handle = UserRecords.FindHandle(EpicAccountId);
+	if (Handle == INDEX_NONE)
 	{
-		TArray<FString> ExternalIds;
-		ExternalIds.Add(NetId);
-		QueryExternalIdMappings(*LocalNetId, FExternalIdQueryOptions(), ExternalIds, IgnoredMappingDelegate);
+		Handle = UserRecords.Add(NetId, EpicAccountId, nullptr);
 	}
+	FUserRecordEOS& Record = *UserRecords.Get(Handle);
+	Record.NetId = UniqueNetId;
+	Record.OnlineUser = OnlineUser;
+	Record.AttributeAccess = AttributeRef;
+
+	// Read the user info, presence and product id mapping for this player, together with anyone else added this tick
+	UserLookups->Request(EpicAccountId, EUserLookupEOS::All);
 }
 
 void FUserManagerEOS::UpdateRemotePlayerProductUserId(EOS_EpicAccountId AccountId, EOS_ProductUserId UserId)
 {
+	const FUserHandleEOS Handle = UserRecords.FindHandle(AccountId);
+	FUserRecordEOS* Record = UserRecords.Get(Handle);
+	if (Record == nullptr)
+	{
+		return;
+	}
 	// See if the net ids have changed for this user and bail if they are the same
 	FString NewNetIdStr = MakeNetIdStringFromIds(AccountId, UserId);
-	const FString PrevNetIdStr = AccountIdToStringMap[AccountId];
-	if (PrevNetIdStr == NewNetIdStr)
+	if (Record->NetIdStr == NewNetIdStr)
 	{
 		// No change, so skip any work
 		return;
 	}
 
-	FString AccountIdStr = MakeStringFromEpicAccountId(AccountId);
-	FString UserIdStr = MakeStringFromProductUserId(UserId);
-
-	// Get the unique net id and rebuild the string for it
-	IAttributeAccessInterfaceRef AttrAccess = NetIdStringToAttributeAccessMap[PrevNetIdStr];
-	FUniqueNetIdEOSPtr NetIdEOS = AttrAccess->GetUniqueNetIdEOS();
-	if (NetIdEOS.IsValid())
+	// Rebuild the string of the unique net id we handed out for them
+	if (Record->NetId.IsValid())
 	{
-		NetIdEOS->UpdateNetIdStr(NewNetIdStr);
-	}
-	// Update any old friends entries with the new net id key
-	for (TMap<int32, FFriendsListEOSRef>::TConstIterator It(LocalUserNumToFriendsListMap); It; ++It)
-	{
-		FFriendsListEOSRef FriendsList = It.Value();
-		FOnlineFriendEOSPtr FoundFriend = FriendsList->GetByNetIdString(PrevNetIdStr);
-		if (FoundFriend.IsValid())
-		{
-			FriendsList->UpdateNetIdStr(PrevNetIdStr, NewNetIdStr);
-		}
-	}
-	// Update all of the other net id to X mappings
-	AccountIdToStringMap.Remove(AccountId);
-	AccountIdToStringMap.Add(AccountId, NewNetIdStr);
-	ProductUserIdToStringMap.Remove(UserId);
-	ProductUserIdToStringMap.Add(UserId, *NewNetIdStr);
-	StringToAccountIdMap.Remove(PrevNetIdStr);
-	StringToAccountIdMap.Add(NewNetIdStr, AccountId);
-	StringToProductUserIdMap.Add(NewNetIdStr, UserId);
-	FOnlineUserPtr OnlineUser = NetIdStringToOnlineUserMap[PrevNetIdStr];
-	NetIdStringToOnlineUserMap.Remove(PrevNetIdStr);
-	NetIdStringToOnlineUserMap.Add(NewNetIdStr, OnlineUser);
-	NetIdStringToAttributeAccessMap.Remove(PrevNetIdStr);
-	NetIdStringToAttributeAccessMap.Add(NewNetIdStr, AttrAccess);
-	// Presence may not be available for all online users
-	if (NetIdStringToOnlineUserPresenceMap.Contains(PrevNetIdStr))
-	{
-		FOnlineUserPresenceRef UserPresence = NetIdStringToOnlineUserPresenceMap[PrevNetIdStr];
-		NetIdStringToOnlineUserPresenceMap.Remove(PrevNetIdStr);
-		NetIdStringToOnlineUserPresenceMap.Add(NewNetIdStr, UserPresence);
+		Record->NetId->UpdateNetIdStr(NewNetIdStr);
 	}
+	// Friends lists are keyed by account id and everything else hangs off the record, so only its indices change
+	UserRecords.SetProductUserId(Handle, UserId, NewNetIdStr);
 }
 
 void FUserManagerEOS::SetFriendAlias(int32 LocalUserNum, const FUniqueNetId& FriendId, const FString& ListName, const FString& Alias, const FOnSetFriendAliasComplete& Delegate)
@@ -1136,15 +1491,16 @@ typedef TEOSCallback<EOS_Friends_OnSendInviteCallback, EOS_Friends_SendInviteCal
 
 bool FUserManagerEOS::SendInvite(int32 LocalUserNum, const FUniqueNetId& FriendId, const FString& ListName, const FOnSendInviteComplete& Delegate)
 {
-	if (!UserNumToNetIdMap.Contains(LocalUserNum))
+	EOS_EpicAccountId LocalAccountId = GetLocalEpicAccountId(LocalUserNum);
+	if (LocalAccountId == nullptr)
 	{
 		UE_LOG_ONLINE(Warning, TEXT("Can't AcceptInvite() for user (%d) since they are not logged in"), LocalUserNum);
 		Delegate.ExecuteIfBound(LocalUserNum, false, FriendId, ListName, FString(TEXT("Can't AcceptInvite() for user (%d) since they are not logged in"), LocalUserNum));
 		return false;
 	}
 
-	FUniqueNetIdEOS EOSID(FriendId);
-	if (!StringToAccountIdMap.Contains(EOSID.UniqueNetIdStr))
+	const FUserRecordEOS* FriendRecord = FindUserRecord(FriendId);
+	if (FriendRecord == nullptr)
 	{
 		UE_LOG_ONLINE(Warning, TEXT("Can't SendInvite() for user (%d) since the potential player id is unknown"), LocalUserNum);
 		Delegate.ExecuteIfBound(LocalUserNum, false, FriendId, ListName, FString(TEXT("Can't AcceptInvite() for user (%d) since the player id is unknown"), LocalUserNum));
@@ -1154,7 +1510,8 @@ bool FUserManagerEOS::SendInvite(int32 LocalUserNum, const FUniqueNetId& FriendI
 	FSendInviteCallback* CallbackObj = new FSendInviteCallback();
 	CallbackObj->CallbackLambda = [LocalUserNum, ListName, this, Delegate](const EOS_Friends_SendInviteCallbackInfo* Data)
 	{
-		FString NetId = AccountIdToStringMap[Data->TargetUserId];
+		const FUserRecordEOS* TargetRecord = UserRecords.Find(Data->TargetUserId);
+		FString NetId = TargetRecord != nullptr ? TargetRecord->NetIdStr : MakeStringFromEpicAccountId(Data->TargetUserId);
 		FUniqueNetIdEOS EOSID(NetId);
 
 		FString ErrorString;
@@ -1168,8 +1525,8 @@ bool FUserManagerEOS::SendInvite(int32 LocalUserNum, const FUniqueNetId& FriendI
 
 	EOS_Friends_SendInviteOptions Options = { };
 	Options.ApiVersion = EOS_FRIENDS_SENDINVITE_API_LATEST;
-	Options.LocalUserId = UserNumToAccountIdMap[LocalUserNum];
-	Options.TargetUserId = StringToAccountIdMap[EOSID.UniqueNetIdStr];
+	Options.LocalUserId = LocalAccountId;
+	Options.TargetUserId = FriendRecord->AccountId;
 	EOS_Friends_SendInvite(EOSSubsystem->FriendsHandle, &Options, CallbackObj, CallbackObj->GetCallbackPtr());
 
 	return true;
@@ -1179,15 +1536,16 @@ typedef TEOSCallback<EOS_Friends_OnAcceptInviteCallback, EOS_Friends_AcceptInvit
 
 bool FUserManagerEOS::AcceptInvite(int32 LocalUserNum, const FUniqueNetId& FriendId, const FString& ListName, const FOnAcceptInviteComplete& Delegate)
 {
-	if (!UserNumToNetIdMap.Contains(LocalUserNum))
+	EOS_EpicAccountId LocalAccountId = GetLocalEpicAccountId(LocalUserNum);
+	if (LocalAccountId == nullptr)
 	{
 		UE_LOG_ONLINE(Warning, TEXT("Can't AcceptInvite() for user (%d) since they are not logged in"), LocalUserNum);
 		Delegate.ExecuteIfBound(LocalUserNum, false, FriendId, ListName, FString(TEXT("Can't AcceptInvite() for user (%d) since they are not logged in"), LocalUserNum));
 		return false;
 	}
 
-	FUniqueNetIdEOS EOSID(FriendId);
-	if (!StringToAccountIdMap.Contains(EOSID.UniqueNetIdStr))
+	const FUserRecordEOS* FriendRecord = FindUserRecord(FriendId);
+	if (FriendRecord == nullptr)
 	{
 		UE_LOG_ONLINE(Warning, TEXT("Can't AcceptInvite() for user (%d) since the friend is not in their list"), LocalUserNum);
 		Delegate.ExecuteIfBound(LocalUserNum, false, FriendId, ListName, FString(TEXT("Can't AcceptInvite() for user (%d) since the friend is not in their list"), LocalUserNum));
@@ -1197,7 +1555,8 @@ bool FUserManagerEOS::AcceptInvite(int32 LocalUserNum, const FUniqueNetId& Frien
 	FAcceptInviteCallback* CallbackObj = new FAcceptInviteCallback();
 	CallbackObj->CallbackLambda = [LocalUserNum, ListName, this, Delegate](const EOS_Friends_AcceptInviteCallbackInfo* Data)
 	{
-		FString NetId = AccountIdToStringMap[Data->TargetUserId];
+		const FUserRecordEOS* TargetRecord = UserRecords.Find(Data->TargetUserId);
+		FString NetId = TargetRecord != nullptr ? TargetRecord->NetIdStr : MakeStringFromEpicAccountId(Data->TargetUserId);
 		FUniqueNetIdEOS EOSID(NetId);
 
 		FString ErrorString;
@@ -1211,8 +1570,8 @@ bool FUserManagerEOS::AcceptInvite(int32 LocalUserNum, const FUniqueNetId& Frien
 
 	EOS_Friends_AcceptInviteOptions Options = { };
 	Options.ApiVersion = EOS_FRIENDS_ACCEPTINVITE_API_LATEST;
-	Options.LocalUserId = UserNumToAccountIdMap[LocalUserNum];
-	Options.TargetUserId = StringToAccountIdMap[EOSID.UniqueNetIdStr];
+	Options.LocalUserId = LocalAccountId;
+	Options.TargetUserId = FriendRecord->AccountId;
 	EOS_Friends_AcceptInvite(EOSSubsystem->FriendsHandle, &Options, CallbackObj, CallbackObj->GetCallbackPtr());
 	return true;
 }
@@ -1224,14 +1583,15 @@ void EOS_CALL EOSRejectInviteCallback(const EOS_Friends_RejectInviteCallbackInfo
 
 bool FUserManagerEOS::RejectInvite(int32 LocalUserNum, const FUniqueNetId& FriendId, const FString& ListName)
 {
-	if (!UserNumToNetIdMap.Contains(LocalUserNum))
+	EOS_EpicAccountId LocalAccountId = GetLocalEpicAccountId(LocalUserNum);
+	if (LocalAccountId == nullptr)
 	{
 		UE_LOG_ONLINE(Warning, TEXT("Can't RejectInvite() for user (%d) since they are not logged in"), LocalUserNum);
 		return false;
 	}
 
-	FUniqueNetIdEOS EOSID(FriendId);
-	if (!StringToAccountIdMap.Contains(EOSID.UniqueNetIdStr))
+	const FUserRecordEOS* FriendRecord = FindUserRecord(FriendId);
+	if (FriendRecord == nullptr)
 	{
 		UE_LOG_ONLINE(Warning, TEXT("Can't RejectInvite() for user (%d) since the friend is not in their list"), LocalUserNum);
 		return false;
@@ -1239,8 +1599,8 @@ bool FUserManagerEOS::RejectInvite(int32 LocalUserNum, const FUniqueNetId& Frien
 
 	EOS_Friends_RejectInviteOptions Options{ 0 };
 	Options.ApiVersion = EOS_FRIENDS_REJECTINVITE_API_LATEST;
-	Options.LocalUserId = UserNumToAccountIdMap[LocalUserNum];
-	Options.TargetUserId = StringToAccountIdMap[EOSID.UniqueNetIdStr];
+	Options.LocalUserId = LocalAccountId;
+	Options.TargetUserId = FriendRecord->AccountId;
 	EOS_Friends_RejectInvite(EOSSubsystem->FriendsHandle, &Options, nullptr, &EOSRejectInviteCallback);
 	return true;
 }
@@ -1254,53 +1614,29 @@ bool FUserManagerEOS::DeleteFriend(int32 LocalUserNum, const FUniqueNetId& Frien
 bool FUserManagerEOS::GetFriendsList(int32 LocalUserNum, const FString& ListName, TArray<TSharedRef<FOnlineFriend>>& OutFriends)
 {
 	OutFriends.Reset();
-	if (LocalUserNumToFriendsListMap.Contains(LocalUserNum))
+	const FUserRecordEOS* LocalRecord = GetLocalUserRecord(LocalUserNum);
+	if (LocalRecord != nullptr)
 	{
-		FFriendsListEOSRef FriendsList = LocalUserNumToFriendsListMap[LocalUserNum];
-		for (FOnlineFriendEOSRef Friend : FriendsList->GetList())
+		EFriendsLists::Type List = EFriendsLists::Default;
+		// See if they only want online only
+		if (ListName == EFriendsLists::ToString(EFriendsLists::OnlinePlayers))
 		{
-			const FOnlineUserPresence& Presence = Friend->GetPresence();
-			// See if they only want online only
-			if (ListName == EFriendsLists::ToString(EFriendsLists::OnlinePlayers) && !Presence.bIsOnline)
-			{
-				continue;
-			}
-			// Of if they only want friends playing this game
-			else if (ListName == EFriendsLists::ToString(EFriendsLists::InGamePlayers) && !Presence.bIsPlayingThisGame)
-			{
-				continue;
-			}
-			// If the service hasn't returned the info yet, skip them
-			else if (Friend->GetDisplayName().IsEmpty())
-			{
-				continue;
-			}
-			OutFriends.Add(Friend);
+			List = EFriendsLists::OnlinePlayers;
 		}
-		// Sort these by those playing the game first, alphabetically, then not playing, then not online
-		OutFriends.Sort([](TSharedRef<FOnlineFriend> A, TSharedRef<FOnlineFriend> B)
+		// Of if they only want friends playing this game
+		else if (ListName == EFriendsLists::ToString(EFriendsLists::InGamePlayers))
 		{
-			const FOnlineUserPresence& APres = A->GetPresence();
-			const FOnlineUserPresence& BPres = B->GetPresence();
-			// If they are the same, then check playing this game
-			if (APres.bIsOnline == BPres.bIsOnline)
-			{
-				// If they are the same, then sort by name
-				if (APres.bIsPlayingThisGame == APres.bIsPlayingThisGame)
-				{
-					const EInviteStatus::Type AFriendStatus = A->GetInviteStatus();
-					const EInviteStatus::Type BFriendStatus = B->GetInviteStatus();
-					// Sort pending friends below accepted friends
-					if (AFriendStatus == BFriendStatus && AFriendStatus == EInviteStatus::Accepted)
-					{
-						const FString& AName = A->GetDisplayName();
-						const FString& BName = B->GetDisplayName();
-						return AName < BName;
-					}
-				}
-			}
-			return false;
-		});
+			List = EFriendsLists::InGamePlayers;
+		}
+		// Already sorted by those playing the game first, then online, then not online, pending friends below
+		// accepted ones and alphabetically from there. Friends the service hasn't returned the info for are left out
+		const TArray<TPair<FFriendSortKeyEOS, FOnlineFriendEOSRef>>& SortedFriends = LocalRecord->FriendsList->GetSortedList();
+		const int32 NumFriends = LocalRecord->FriendsList->GetNumSorted(List);
+		OutFriends.Reserve(NumFriends);
+		for (int32 Index = 0; Index < NumFriends; Index++)
+		{
+			OutFriends.Add(SortedFriends[Index].Value);
+		}
 		return true;
 	}
 	return false;
@@ -1308,11 +1644,11 @@ bool FUserManagerEOS::GetFriendsList(int32 LocalUserNum, const FString& ListName
 
 TSharedPtr<FOnlineFriend> FUserManagerEOS::GetFriend(int32 LocalUserNum, const FUniqueNetId& FriendId, const FString& ListName)
 {
-	if (LocalUserNumToFriendsListMap.Contains(LocalUserNum))
+	const FUserRecordEOS* LocalRecord = GetLocalUserRecord(LocalUserNum);
+	const FUserRecordEOS* FriendRecord = FindUserRecord(FriendId);
+	if (LocalRecord != nullptr && FriendRecord != nullptr)
 	{
-		FFriendsListEOSRef FriendsList = LocalUserNumToFriendsListMap[LocalUserNum];
-		FUniqueNetIdEOS EosId(FriendId);
-		FOnlineFriendEOSPtr FoundFriend = FriendsList->GetByNetIdString(EosId.UniqueNetIdStr);
+		FOnlineFriendEOSPtr FoundFriend = LocalRecord->FriendsList->GetByAccountId(FriendRecord->AccountId);
 		if (FoundFriend.IsValid())
 		{
 			const FOnlineUserPresence& Presence = FoundFriend->GetPresence();
@@ -1345,11 +1681,10 @@ bool FUserManagerEOS::QueryRecentPlayers(const FUniqueNetId& UserId, const FStri
 bool FUserManagerEOS::GetRecentPlayers(const FUniqueNetId& UserId, const FString& Namespace, TArray<TSharedRef<FOnlineRecentPlayer>>& OutRecentPlayers)
 {
 	OutRecentPlayers.Reset();
-	FUniqueNetIdEOS EosId(UserId);
-	if (NetIdStringToRecentPlayerListMap.Contains(EosId.UniqueNetIdStr))
+	const FUserRecordEOS* Record = FindUserRecord(UserId);
+	if (Record != nullptr && Record->RecentPlayersList.IsValid())
 	{
-		FRecentPlayersListEOSRef List = NetIdStringToRecentPlayerListMap[EosId.UniqueNetIdStr];
-		OutRecentPlayers.Append(List->GetList());
+		OutRecentPlayers.Append(Record->RecentPlayersList->GetList());
 		return true;
 	}
 	return false;
@@ -1373,11 +1708,10 @@ bool FUserManagerEOS::QueryBlockedPlayers(const FUniqueNetId& UserId)
 bool FUserManagerEOS::GetBlockedPlayers(const FUniqueNetId& UserId, TArray<TSharedRef<FOnlineBlockedPlayer>>& OutBlockedPlayers)
 {
 	OutBlockedPlayers.Reset();
-	FUniqueNetIdEOS EosId(UserId);
-	if (NetIdStringToBlockedPlayerListMap.Contains(EosId.UniqueNetIdStr))
+	const FUserRecordEOS* Record = FindUserRecord(UserId);
+	if (Record != nullptr && Record->BlockedPlayersList.IsValid())
 	{
-		FBlockedPlayersListEOSRef List = NetIdStringToBlockedPlayerListMap[EosId.UniqueNetIdStr];
-		OutBlockedPlayers.Append(List->GetList());
+		OutBlockedPlayers.Append(Record->BlockedPlayersList->GetList());
 		return true;
 	}
 	return false;
@@ -1391,110 +1725,26 @@ void FUserManagerEOS::DumpRecentPlayers() const
 {
 }
 
-struct FPresenceStrings
-{
-	char Key[EOS_PRESENCE_DATA_MAX_KEY_LENGTH];
-	char Value[EOS_PRESENCE_DATA_MAX_VALUE_LENGTH];
-};
-
-struct FRichTextOptions :
-	public EOS_PresenceModification_SetRawRichTextOptions
-{
-	FRichTextOptions() :
-		EOS_PresenceModification_SetRawRichTextOptions()
-	{
-		ApiVersion = EOS_PRESENCE_SETRAWRICHTEXT_API_LATEST;
-		RichText = RichTextAnsi;
-	}
-	char RichTextAnsi[EOS_PRESENCE_RICH_TEXT_MAX_VALUE_LENGTH];
-};
-
-typedef TEOSCallback<EOS_Presence_SetPresenceCompleteCallback, EOS_Presence_SetPresenceCallbackInfo> FSetPresenceCallback;
-
 void FUserManagerEOS::SetPresence(const FUniqueNetId& UserId, const FOnlineUserPresenceStatus& Status, const FOnPresenceTaskCompleteDelegate& Delegate)
 {
-	FUniqueNetIdEOS EOSID(UserId);
-	if (!StringToAccountIdMap.Contains(EOSID.UniqueNetIdStr))
+	const FUserRecordEOS* Record = FindUserRecord(UserId);
+	if (Record == nullptr)
 	{
-		UE_LOG_ONLINE(Error, TEXT("Can't SetPresence() for user (%s) since they are not logged in"), *EOSID.UniqueNetIdStr);
+		UE_LOG_ONLINE(Error, TEXT("Can't SetPresence() for user (%s) since they are not logged in"), *UserId.ToString());
 		return;
 	}
 
-	EOS_HPresenceModification ChangeHandle = nullptr;
-	EOS_Presence_CreatePresenceModificationOptions Options = { };
-	Options.ApiVersion = EOS_PRESENCE_CREATEPRESENCEMODIFICATION_API_LATEST;
-	Options.LocalUserId = StringToAccountIdMap[EOSID.UniqueNetIdStr];
-	EOS_Presence_CreatePresenceModification(EOSSubsystem->PresenceHandle, &Options, &ChangeHandle);
-	if (ChangeHandle == nullptr)
+	// Only what changed since EOS last took our presence is written, and at most once per PresenceUpdateInterval
+	FUniqueNetIdEOSRef NetId = Record->NetId.ToSharedRef();
+	PresenceUpdater->SetPresence(Record->AccountId, Status, [NetId, Delegate](bool bWasSuccessful)
 	{
-		UE_LOG_ONLINE(Error, TEXT("Failed to create a modification handle for setting presence"));
-		return;
-	}
-
-	EOS_PresenceModification_SetStatusOptions StatusOptions = { };
-	StatusOptions.ApiVersion = EOS_PRESENCE_SETSTATUS_API_LATEST;
-	StatusOptions.Status = ToEOS_Presence_EStatus(Status.State);
-	EOS_EResult SetStatusResult = EOS_PresenceModification_SetStatus(ChangeHandle, &StatusOptions);
-	if (SetStatusResult != EOS_EResult::EOS_Success)
-	{
-		UE_LOG_ONLINE(Error, TEXT("EOS_PresenceModification_SetStatus() failed with result code (%d)"), (int32)SetStatusResult);
-	}
-
-	// Convert the status string as the rich text string
-	FRichTextOptions TextOptions;
-	FCStringAnsi::Strncpy(TextOptions.RichTextAnsi, TCHAR_TO_UTF8(*Status.StatusStr), EOS_PRESENCE_RICH_TEXT_MAX_VALUE_LENGTH);
-	EOS_EResult SetRichTextResult = EOS_PresenceModification_SetRawRichText(ChangeHandle, &TextOptions);
-	if (SetRichTextResult != EOS_EResult::EOS_Success)
-	{
-		UE_LOG_ONLINE(Error, TEXT("EOS_PresenceModification_SetRawRichText() failed with result code (%s)"), ANSI_TO_TCHAR(EOS_EResult_ToString(SetRichTextResult)));
-	}
-
-	FPresenceStrings RawStrings[EOS_PRESENCE_DATA_MAX_KEYS];
-	TArray<EOS_Presence_DataRecord, TInlineAllocator<EOS_PRESENCE_DATA_MAX_KEYS>> Records;
-	int32 CurrentIndex = 0;
-	// Loop through the properties building records
-	for (FPresenceProperties::TConstIterator It(Status.Properties); It && CurrentIndex < EOS_PRESENCE_DATA_MAX_KEYS; ++It, ++CurrentIndex)
-	{
-		// Since the TCHAR_TO_UTF8 macros are scoped, we need to copy to a chunk of memory while building the data up
-		FCStringAnsi::Strncpy(RawStrings[CurrentIndex].Key, TCHAR_TO_UTF8(*It.Key()), EOS_PRESENCE_DATA_MAX_KEY_LENGTH);
-		FCStringAnsi::Strncpy(RawStrings[CurrentIndex].Value, TCHAR_TO_UTF8(*It.Value().ToString()), EOS_PRESENCE_DATA_MAX_VALUE_LENGTH);
-
-		EOS_Presence_DataRecord Record;
-		Record.ApiVersion = EOS_PRESENCE_DATARECORD_API_LATEST;
-		Record.Key = RawStrings[CurrentIndex].Key;
-		Record.Value = RawStrings[CurrentIndex].Value;
-		Records.Add(Record);
-	}
-	EOS_PresenceModification_SetDataOptions DataOptions = { };
-	DataOptions.ApiVersion = EOS_PRESENCE_SETDATA_API_LATEST;
-	DataOptions.RecordsCount = Records.Num();
-	DataOptions.Records = Records.GetData();
-	EOS_EResult SetDataResult = EOS_PresenceModification_SetData(ChangeHandle, &DataOptions);
-	if (SetDataResult != EOS_EResult::EOS_Success)
-	{
-		UE_LOG_ONLINE(Error, TEXT("EOS_PresenceModification_SetData() failed with result code (%s)"), ANSI_TO_TCHAR(EOS_EResult_ToString(SetDataResult)));
-	}
-
-	FSetPresenceCallback* CallbackObj = new FSetPresenceCallback();
-	CallbackObj->CallbackLambda = [this, Delegate](const EOS_Presence_SetPresenceCallbackInfo* Data)
-	{
-		if (Data->ResultCode == EOS_EResult::EOS_Success && AccountIdToStringMap.Contains(Data->LocalUserId))
+		if (bWasSuccessful)
 		{
-			FUniqueNetIdEOS EOSID(AccountIdToStringMap[Data->LocalUserId]);
-			Delegate.ExecuteIfBound(EOSID, true);
+			Delegate.ExecuteIfBound(*NetId, true);
 			return;
 		}
-		UE_LOG_ONLINE(Error, TEXT("SetPresence() failed with result code (%s)"), ANSI_TO_TCHAR(EOS_EResult_ToString(Data->ResultCode)));
 		Delegate.ExecuteIfBound(FUniqueNetIdEOS(), false);
-	};
-
-	EOS_Presence_SetPresenceOptions PresOptions = { };
-	PresOptions.ApiVersion = EOS_PRESENCE_SETPRESENCE_API_LATEST;
-	PresOptions.LocalUserId = StringToAccountIdMap[EOSID.UniqueNetIdStr];
-	PresOptions.PresenceModificationHandle = ChangeHandle;
-	// Last step commit the changes
-	EOS_Presence_SetPresence(EOSSubsystem->PresenceHandle, &PresOptions, CallbackObj, CallbackObj->GetCallbackPtr());
-	EOS_PresenceModification_Release(ChangeHandle);
+	});
 }
 
 typedef TEOSCallback<EOS_Presence_OnQueryPresenceCompleteCallback, EOS_Presence_QueryPresenceCallbackInfo> FQueryPresenceCallback;
@@ -1508,30 +1758,30 @@ void FUserManagerEOS::QueryPresence(const FUniqueNetId& UserId, const FOnPresenc
 		return;
 	}
 
-	FUniqueNetIdEOS EOSID(UserId);
-	const FString& NetId = EOSID.UniqueNetIdStr;
-	if (!StringToAccountIdMap.Contains(NetId))
+	const FUserRecordEOS* Record = FindUserRecord(UserId);
+	if (Record == nullptr)
 	{
-		UE_LOG_ONLINE(Error, TEXT("Can't QueryPresence(%s) for unknown unique net id"), *NetId);
+		UE_LOG_ONLINE(Error, TEXT("Can't QueryPresence(%s) for unknown unique net id"), *UserId.ToString());
 		Delegate.ExecuteIfBound(UserId, false);
 		return;
 	}
 
 	EOS_Presence_HasPresenceOptions HasOptions = { };
 	HasOptions.ApiVersion = EOS_PRESENCE_HASPRESENCE_API_LATEST;
-	HasOptions.LocalUserId = UserNumToAccountIdMap[DefaultLocalUser];
-	HasOptions.TargetUserId = StringToAccountIdMap[NetId];
+	HasOptions.LocalUserId = GetLocalEpicAccountId(DefaultLocalUser);
+	HasOptions.TargetUserId = Record->AccountId;
 	EOS_Bool bHasPresence = EOS_Presence_HasPresence(EOSSubsystem->PresenceHandle, &HasOptions);
 	if (bHasPresence == EOS_FALSE)
 	{
 		FQueryPresenceCallback* CallbackObj = new FQueryPresenceCallback();
 		CallbackObj->CallbackLambda = [this, Delegate](const EOS_Presence_QueryPresenceCallbackInfo* Data)
 		{
-			if (Data->ResultCode == EOS_EResult::EOS_Success && EpicAccountIdToOnlineUserMap.Contains(Data->TargetUserId))
+			const FUserRecordEOS* TargetRecord = UserRecords.Find(Data->TargetUserId);
+			if (Data->ResultCode == EOS_EResult::EOS_Success && TargetRecord != nullptr && !TargetRecord->IsLocal())
 			{
+				FOnlineUserPtr OnlineUser = TargetRecord->OnlineUser;
 				// Update the presence data to the most recent
 				UpdatePresence(Data->TargetUserId);
-				FOnlineUserPtr OnlineUser = EpicAccountIdToOnlineUserMap[Data->TargetUserId];
 				Delegate.ExecuteIfBound(*OnlineUser->GetUserId(), true);
 				return;
 			}
@@ -1557,23 +1807,27 @@ void FUserManagerEOS::QueryPresence(const FUniqueNetId& UserId, const FOnPresenc
 
 void FUserManagerEOS::UpdatePresence(EOS_EpicAccountId AccountId)
 {
+	FUserRecordEOS* UserRecord = UserRecords.Find(AccountId);
+	if (UserRecord == nullptr)
+	{
+		return;
+	}
+
 	EOS_Presence_Info* PresenceInfo = nullptr;
 	EOS_Presence_CopyPresenceOptions Options = { };
 	Options.ApiVersion = EOS_PRESENCE_COPYPRESENCE_API_LATEST;
-	Options.LocalUserId = UserNumToAccountIdMap[DefaultLocalUser];
+	Options.LocalUserId = GetLocalEpicAccountId(DefaultLocalUser);
 	Options.TargetUserId = AccountId;
 	EOS_EResult CopyResult = EOS_Presence_CopyPresence(EOSSubsystem->PresenceHandle, &Options, &PresenceInfo);
 	if (CopyResult == EOS_EResult::EOS_Success)
 	{
-		const FString& NetId = AccountIdToStringMap[AccountId];
 		// Create it on demand if we don't have one yet
-		if (!NetIdStringToOnlineUserPresenceMap.Contains(NetId))
+		if (!UserRecord->Presence.IsValid())
 		{
-			FOnlineUserPresenceRef PresenceRef = MakeShareable(new FOnlineUserPresence());
-			NetIdStringToOnlineUserPresenceMap.Add(NetId, PresenceRef);
+			UserRecord->Presence = MakeShareable(new FOnlineUserPresence());
 		}
 
-		FOnlineUserPresenceRef PresenceRef = NetIdStringToOnlineUserPresenceMap[NetId];
+		FOnlineUserPresenceRef PresenceRef = UserRecord->Presence.ToSharedRef();
 		FString ProductId(UTF8_TO_TCHAR(PresenceInfo->ProductId));
 		FString ProdVersion(UTF8_TO_TCHAR(PresenceInfo->ProductVersion));
 		FString Platform(UTF8_TO_TCHAR(PresenceInfo->Platform));
@@ -1596,7 +1850,7 @@ void FUserManagerEOS::UpdatePresence(EOS_EpicAccountId AccountId)
 		}
 
 		// Copy the presence if this is a friend that was updated, so that their data is in sync
-		UpdateFriendPresence(NetId, PresenceRef);
+		UpdateFriendPresence(AccountId, PresenceRef);
 
 		EOS_Presence_Info_Release(PresenceInfo);
 	}
@@ -1606,25 +1860,38 @@ void FUserManagerEOS::UpdatePresence(EOS_EpicAccountId AccountId)
 	}
 }
 
-void FUserManagerEOS::UpdateFriendPresence(const FString& FriendId, FOnlineUserPresenceRef Presence)
+void FUserManagerEOS::UpdateFriendPresence(EOS_EpicAccountId FriendId, FOnlineUserPresenceRef Presence)
 {
-	for (TMap<int32, FFriendsListEOSRef>::TConstIterator It(LocalUserNumToFriendsListMap); It; ++It)
+	for (TMap<int32, FUserHandleEOS>::TConstIterator It(LocalUserHandles); It; ++It)
 	{
-		FFriendsListEOSRef FriendsList = It.Value();
-		FOnlineFriendEOSPtr Friend = FriendsList->GetByNetIdString(FriendId);
+		const FUserRecordEOS* LocalRecord = UserRecords.Get(It.Value());
+		FOnlineFriendEOSPtr Friend = LocalRecord != nullptr ? LocalRecord->FriendsList->GetByAccountId(FriendId) : nullptr;
 		if (Friend.IsValid())
 		{
 			Friend->SetPresence(Presence);
+			LocalRecord->FriendsList->UpdateSortOrder(FriendId);
+		}
+	}
+}
+
+void FUserManagerEOS::UpdateFriendSortOrder(EOS_EpicAccountId FriendId)
+{
+	for (TMap<int32, FUserHandleEOS>::TConstIterator It(LocalUserHandles); It; ++It)
+	{
+		const FUserRecordEOS* LocalRecord = UserRecords.Get(It.Value());
+		if (LocalRecord != nullptr && LocalRecord->FriendsList.IsValid())
+		{
+			LocalRecord->FriendsList->UpdateSortOrder(FriendId);
 		}
 	}
 }
 
 EOnlineCachedResult::Type FUserManagerEOS::GetCachedPresence(const FUniqueNetId& UserId, TSharedPtr<FOnlineUserPresence>& OutPresence)
 {
-	FUniqueNetIdEOS EOSID(UserId);
-	if (NetIdStringToOnlineUserPresenceMap.Contains(EOSID.UniqueNetIdStr))
+	const FUserRecordEOS* Record = FindUserRecord(UserId);
+	if (Record != nullptr && Record->Presence.IsValid())
 	{
-		OutPresence = NetIdStringToOnlineUserPresenceMap[EOSID.UniqueNetIdStr];
+		OutPresence = Record->Presence;
 		return EOnlineCachedResult::Success;
 	}
 	return EOnlineCachedResult::NotFound;
@@ -1640,26 +1907,25 @@ bool FUserManagerEOS::QueryUserInfo(int32 LocalUserNum, const TArray<TSharedRef<
 	// Trigger a query for each user in the list
 	for (FUniqueNetIdRef NetId : UserIds)
 	{
-		FUniqueNetIdEOS EOSID(*NetId);
-		// Skip querying for local users since we already have that data
-		if (StringToUserAccountMap.Contains(EOSID.UniqueNetIdStr))
-		{
-			continue;
-		}
 		// Check to see if we know about this user or not
-		if (StringToAccountIdMap.Contains(EOSID.UniqueNetIdStr))
+		const FUserRecordEOS* Record = FindUserRecord(*NetId);
+		if (Record != nullptr)
 		{
-			EOS_EpicAccountId AccountId = StringToAccountIdMap[EOSID.UniqueNetIdStr];
-			ReadUserInfo(AccountId);
+			// Skip querying for local users since we already have that data
+			if (!Record->IsLocal())
+			{
+				UserLookups->Request(Record->AccountId, EUserLookupEOS::Info);
+			}
 		}
 		else
 		{
-			// We need to build this one from the string
-			EOS_EpicAccountId AccountId = EOS_EpicAccountId_FromString(TCHAR_TO_UTF8(*EOSID.EpicAccountIdStr));
+			FUniqueNetIdEOS EOSID(*NetId);
+			// Parsed from the string when the id was interned
+			EOS_EpicAccountId AccountId = EOSID.GetEpicAccountId();
 			if (EOS_EpicAccountId_IsValid(AccountId) == EOS_TRUE)
 			{
 				// Registering the player will also query the user info data
-				AddRemotePlayer(EOSID.UniqueNetIdStr, AccountId);
+				AddRemotePlayer(EOSID.GetNetIdStr(), AccountId);
 			}
 		}
 	}
@@ -1668,21 +1934,25 @@ bool FUserManagerEOS::QueryUserInfo(int32 LocalUserNum, const TArray<TSharedRef<
 
 typedef TEOSCallback<EOS_UserInfo_OnQueryUserInfoCallback, EOS_UserInfo_QueryUserInfoCallbackInfo> FReadUserInfoCallback;
 
-void FUserManagerEOS::ReadUserInfo(EOS_EpicAccountId EpicAccountId)
+void FUserManagerEOS::ReadUserInfo(EOS_EpicAccountId EpicAccountId, FOnUserLookupCompleteEOS&& OnComplete)
 {
 	FReadUserInfoCallback* CallbackObj = new FReadUserInfoCallback();
-	CallbackObj->CallbackLambda = [this](const EOS_UserInfo_QueryUserInfoCallbackInfo* Data)
+	CallbackObj->CallbackLambda = [this, OnComplete = MoveTemp(OnComplete)](const EOS_UserInfo_QueryUserInfoCallbackInfo* Data)
 	{
 		if (Data->ResultCode == EOS_EResult::EOS_Success)
 		{
-			IAttributeAccessInterfaceRef AttributeAccessRef = EpicAccountIdToAttributeAccessMap[Data->TargetUserId];
-			UpdateUserInfo(AttributeAccessRef, Data->LocalUserId, Data->TargetUserId);
+			const FUserRecordEOS* Record = UserRecords.Find(Data->TargetUserId);
+			if (Record != nullptr && Record->AttributeAccess.IsValid())
+			{
+				UpdateUserInfo(Record->AttributeAccess.ToSharedRef(), Data->LocalUserId, Data->TargetUserId);
+			}
 		}
+		OnComplete(Data->ResultCode == EOS_EResult::EOS_Success);
 	};
 
 	EOS_UserInfo_QueryUserInfoOptions Options = { };
 	Options.ApiVersion = EOS_USERINFO_QUERYUSERINFO_API_LATEST;
-	Options.LocalUserId = UserNumToAccountIdMap[DefaultLocalUser];
+	Options.LocalUserId = GetLocalEpicAccountId(DefaultLocalUser);
 	Options.TargetUserId = EpicAccountId;
 	EOS_UserInfo_QueryUserInfo(EOSSubsystem->UserInfoHandle, &Options, CallbackObj, CallbackObj->GetCallbackPtr());
 }
@@ -1690,29 +1960,24 @@ void FUserManagerEOS::ReadUserInfo(EOS_EpicAccountId EpicAccountId)
 bool FUserManagerEOS::GetAllUserInfo(int32 LocalUserNum, TArray<TSharedRef<FOnlineUser>>& OutUsers)
 {
 	OutUsers.Reset();
-	// Get remote users
-	for (TMap<FString, FOnlineUserPtr>::TConstIterator It(NetIdStringToOnlineUserMap); It; ++It)
+	// Local users are included through their user account
+	for (const FUserRecordEOS& Record : UserRecords.GetRecords())
 	{
-		if (It.Value().IsValid())
+		if (Record.OnlineUser.IsValid())
 		{
-			OutUsers.Add(It.Value().ToSharedRef());
+			OutUsers.Add(Record.OnlineUser.ToSharedRef());
 		}
 	}
-	// Get local users
-	for (TMap<FString, FUserOnlineAccountEOSRef>::TConstIterator It(StringToUserAccountMap); It; ++It)
-	{
-		OutUsers.Add(It.Value());
-	}
 	return true;
 }
 
 TSharedPtr<FOnlineUser> FUserManagerEOS::GetUserInfo(int32 LocalUserNum, const class FUniqueNetId& UserId)
 {
 	TSharedPtr<FOnlineUser> OnlineUser;
-	FUniqueNetIdEOS EOSID(UserId);
-	if (NetIdStringToOnlineUserMap.Contains(EOSID.UniqueNetIdStr))
+	const FUserRecordEOS* Record = FindUserRecord(UserId);
+	if (Record != nullptr)
 	{
-		OnlineUser = NetIdStringToOnlineUserMap[EOSID.UniqueNetIdStr];
+		OnlineUser = Record->OnlineUser;
 	}
 	return OnlineUser;
 }
@@ -1733,14 +1998,15 @@ typedef TEOSCallback<EOS_UserInfo_OnQueryUserInfoByDisplayNameCallback, EOS_User
 
 bool FUserManagerEOS::QueryUserIdMapping(const FUniqueNetId& UserId, const FString& DisplayNameOrEmail, const FOnQueryUserMappingComplete& Delegate)
 {
-	FUniqueNetIdEOS EOSID(UserId);
-	const FString& NetId = EOSID.UniqueNetIdStr;
-	if (!StringToAccountIdMap.Contains(NetId))
+	const FUserRecordEOS* Record = FindUserRecord(UserId);
+	if (Record == nullptr)
 	{
-		UE_LOG_ONLINE(Error, TEXT("Specified local user (%s) is not known"), *EOSID.UniqueNetIdStr);
-		Delegate.ExecuteIfBound(false, UserId, DisplayNameOrEmail, FUniqueNetIdEOS(), FString::Printf(TEXT("Specified local user (%s) is not known"), *EOSID.UniqueNetIdStr));
+		const FString NetId = UserId.ToString();
+		UE_LOG_ONLINE(Error, TEXT("Specified local user (%s) is not known"), *NetId);
+		Delegate.ExecuteIfBound(false, UserId, DisplayNameOrEmail, FUniqueNetIdEOS(), FString::Printf(TEXT("Specified local user (%s) is not known"), *NetId));
 		return false;
 	}
+	EOS_EpicAccountId LocalAccountId = Record->AccountId;
 	int32 LocalUserNum = GetLocalUserNumFromUniqueNetId(UserId);
 
 	FQueryInfoByNameCallback* CallbackObj = new FQueryInfoByNameCallback();
@@ -1758,8 +2024,8 @@ bool FUserManagerEOS::QueryUserIdMapping(const FUniqueNetId& UserId, const FStri
 		if (bWasSuccessful)
 		{
 			const FString& NetIdStr = MakeStringFromEpicAccountId(Data->TargetUserId);
-			FUniqueNetIdEOSPtr LocalUserId = UserNumToNetIdMap[DefaultLocalUser];
-			if (!EpicAccountIdToOnlineUserMap.Contains(Data->TargetUserId))
+			FUniqueNetIdEOSPtr LocalUserId = GetLocalUniqueNetIdEOS(DefaultLocalUser);
+			if (UserRecords.FindHandle(Data->TargetUserId) == INDEX_NONE)
 			{
 				// Registering the player will also query the presence/user info data
 				AddRemotePlayer(NetIdStr, Data->TargetUserId);
@@ -1776,7 +2042,7 @@ bool FUserManagerEOS::QueryUserIdMapping(const FUniqueNetId& UserId, const FStri
 
 	FQueryByDisplayNameOptions Options;
 	FCStringAnsi::Strncpy(Options.DisplayNameAnsi, TCHAR_TO_UTF8(*DisplayNameOrEmail), EOS_PRODUCTNAME_MAX_BUFFER_LEN);
-	Options.LocalUserId = StringToAccountIdMap[NetId];
+	Options.LocalUserId = LocalAccountId;
 	EOS_UserInfo_QueryUserInfoByDisplayName(EOSSubsystem->UserInfoHandle, &Options, CallbackObj, CallbackObj->GetCallbackPtr());
 
 	return true;
@@ -1827,16 +2093,16 @@ typedef TEOSCallback<EOS_Connect_OnQueryExternalAccountMappingsCallback, EOS_Con
 
 bool FUserManagerEOS::QueryExternalIdMappings(const FUniqueNetId& UserId, const FExternalIdQueryOptions& QueryOptions, const TArray<FString>& ExternalIds, const FOnQueryExternalIdMappingsComplete& Delegate)
 {
-	FUniqueNetIdEOS EOSID(UserId);
-	if (!StringToProductUserIdMap.Contains(EOSID.UniqueNetIdStr))
+	const FUserRecordEOS* Record = FindUserRecord(UserId);
+	if (Record == nullptr || Record->ProductUserId == nullptr)
 	{
-		Delegate.ExecuteIfBound(false, UserId, QueryOptions, ExternalIds, FString::Printf(TEXT("User (%s) is not logged in, so can't query external account ids"), *EOSID.UniqueNetIdStr));
+		Delegate.ExecuteIfBound(false, UserId, QueryOptions, ExternalIds, FString::Printf(TEXT("User (%s) is not logged in, so can't query external account ids"), *UserId.ToString()));
 		return false;
 	}
 	int32 LocalUserNum = GetLocalUserNumFromUniqueNetId(UserId);
 
-	EOS_ProductUserId LocalUserId = StringToProductUserIdMap[EOSID.UniqueNetIdStr];
-	const int32 NumBatches = (ExternalIds.Num() / EOS_CONNECT_QUERYEXTERNALACCOUNTMAPPINGS_MAX_ACCOUNT_IDS) + 1;
+	EOS_ProductUserId LocalUserId = Record->ProductUserId;
+	const int32 NumBatches = FMath::DivideAndRoundUp(ExternalIds.Num(), EOS_CONNECT_QUERYEXTERNALACCOUNTMAPPINGS_MAX_ACCOUNT_IDS);
 	int32 QueryStart = 0;
 	// Process queries in batches since there's a max that can be done at once
 	for (int32 BatchCount = 0; BatchCount < NumBatches; BatchCount++)
@@ -1848,8 +2114,8 @@ bool FUserManagerEOS::QueryExternalIdMappings(const FUniqueNetId& UserId, const
 		// Build an options up per batch
 		for (uint32 ProcessedCount = 0; ProcessedCount < AmountToProcess; ProcessedCount++, QueryStart++)
 		{
-			FCStringAnsi::Strncpy(Options.PointerArray[ProcessedCount], TCHAR_TO_UTF8(*ExternalIds[ProcessedCount]), EOS_CONNECT_EXTERNAL_ACCOUNT_ID_MAX_LENGTH);
-			BatchIds.Add(ExternalIds[ProcessedCount]);
+			FCStringAnsi::Strncpy(Options.PointerArray[ProcessedCount], TCHAR_TO_UTF8(*ExternalIds[QueryStart]), EOS_CONNECT_EXTERNAL_ACCOUNT_ID_MAX_LENGTH);
+			BatchIds.Add(ExternalIds[QueryStart]);
 		}
 		FQueryByStringIdsCallback* CallbackObj = new FQueryByStringIdsCallback();
 		CallbackObj->CallbackLambda = [LocalUserNum, QueryOptions, BatchIds, this, Delegate](const EOS_Connect_QueryExternalAccountMappingsCallbackInfo* Data)
@@ -1865,10 +2131,10 @@ bool FUserManagerEOS::QueryExternalIdMappings(const FUniqueNetId& UserId, const
 			FUniqueNetIdEOS EOSID;
 			if (Result == EOS_EResult::EOS_Success)
 			{
-				EOSID = *UserNumToNetIdMap[LocalUserNum];
+				EOSID = *GetLocalUniqueNetIdEOS(LocalUserNum);
 
 				FGetAccountMappingOptions Options;
-				Options.LocalUserId = UserNumToProductUserIdMap[DefaultLocalUser];
+				Options.LocalUserId = GetLocalProductUserId(DefaultLocalUser);
 				// Get the product id for each epic account passed in
 				for (const FString& StringId : BatchIds)
 				{
@@ -1885,7 +2151,7 @@ bool FUserManagerEOS::QueryExternalIdMappings(const FUniqueNetId& UserId, const
 			{
 				ErrorString = FString::Printf(TEXT("EOS_Connect_QueryExternalAccountMappings() failed with result code (%s)"), ANSI_TO_TCHAR(EOS_EResult_ToString(Result)));
 			}
-			Delegate.ExecuteIfBound(false, EOSID, QueryOptions, BatchIds, ErrorString);
+			Delegate.ExecuteIfBound(Result == EOS_EResult::EOS_Success, EOSID, QueryOptions, BatchIds, ErrorString);
 		};
 
 		EOS_Connect_QueryExternalAccountMappings(EOSSubsystem->ConnectHandle, &Options, CallbackObj, CallbackObj->GetCallbackPtr());
@@ -1906,10 +2172,13 @@ TSharedPtr<const FUniqueNetId> FUserManagerEOS::GetExternalIdMapping(const FExte
 {
 	TSharedPtr<const FUniqueNetId> NetId;
 	EOS_EpicAccountId AccountId = EOS_EpicAccountId_FromString(TCHAR_TO_UTF8(*ExternalId));
-	if (EOS_EpicAccountId_IsValid(AccountId) == EOS_TRUE && AccountIdToStringMap.Contains(AccountId))
+	if (EOS_EpicAccountId_IsValid(AccountId) == EOS_TRUE)
 	{
-		const FString& NetIdStr = AccountIdToStringMap[AccountId];
-		NetId = NetIdStringToOnlineUserMap[NetIdStr]->GetUserId();
+		const FUserRecordEOS* Record = UserRecords.Find(AccountId);
+		if (Record != nullptr && Record->OnlineUser.IsValid())
+		{
+			NetId = Record->OnlineUser->GetUserId();
+		}
 	}
 	return NetId;
 }
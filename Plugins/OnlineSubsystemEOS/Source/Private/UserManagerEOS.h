@@ -6,6 +6,8 @@
 #include "UObject/CoreOnline.h"
 #include "OnlineSubsystemTypes.h"
 #include "OnlineSubsystemEOSTypes.h"
+#include "UserLookupEOS.h"
+#include "PresenceUpdaterEOS.h"
 
 #if WITH_EOS_SDK
 	#include "eos_auth_types.h"
@@ -111,8 +113,8 @@ class TOnlinePlayerList
 	FUniqueNetIdEOSRef OwningNetId;
 	/** The array of list class entries */
 	TArray<ListClass> ListEntries;
-	/** Indexed by string form of account id for fast look up */
-	TMap<FString, ListClass> NetIdStringToListEntryMap;
+	/** Indexed by account id for fast look up, account ids don't change when the product user id is learned */
+	TMap<EOS_EpicAccountId, ListClass> AccountIdToListEntryMap;
 
 public:
 	TOnlinePlayerList(int32 InLocalUserNum, FUniqueNetIdEOSRef InOwningNetId)
@@ -126,17 +128,10 @@ public:
 		return ListEntries;
 	}
 
-	void Add(const FString& InNetId, ListClass InListEntry)
+	void Add(EOS_EpicAccountId InAccountId, ListClass InListEntry)
 	{
 		ListEntries.Add(InListEntry);
-		NetIdStringToListEntryMap.Add(InNetId, InListEntry);
-	}
-
-	void UpdateNetIdStr(const FString& PrevNetId, const FString& NewNetId)
-	{
-		ListClass ListEntry = NetIdStringToListEntryMap[PrevNetId];
-		NetIdStringToListEntryMap.Remove(PrevNetId);
-		NetIdStringToListEntryMap.Add(NewNetId, ListEntry);
+		AccountIdToListEntryMap.Add(InAccountId, InListEntry);
 	}
 
 	ListClassReturnType GetByIndex(int32 Index)
@@ -148,9 +143,9 @@ public:
 		return ListClassReturnType();
 	}
 
-	ListClassReturnType GetByNetIdString(const FString& NetId)
+	ListClassReturnType GetByAccountId(EOS_EpicAccountId AccountId)
 	{
-		const ListClass* Found = NetIdStringToListEntryMap.Find(NetId);
+		const ListClass* Found = AccountIdToListEntryMap.Find(AccountId);
 		if (Found != nullptr)
 		{
 			return *Found;
@@ -159,15 +154,96 @@ public:
 	}
 };
 
+/** Where a friend goes in the sorted view, a strict order so equal looking friends keep their place */
+struct FFriendSortKeyEOS
+{
+	/** 0 playing this game, 1 online, 2 offline */
+	uint8 Rank;
+	/** Friends we haven't accepted, or who haven't accepted us, go below the accepted ones */
+	bool bIsPending;
+	FString DisplayName;
+	/** When the friend was added, breaks ties between equal names */
+	uint32 Sequence;
+
+	FFriendSortKeyEOS()
+		: Rank(2)
+		, bIsPending(false)
+		, Sequence(0)
+	{
+	}
+
+	bool operator<(const FFriendSortKeyEOS& Other) const
+	{
+		if (Rank != Other.Rank)
+		{
+			return Rank < Other.Rank;
+		}
+		if (bIsPending != Other.bIsPending)
+		{
+			return !bIsPending;
+		}
+		const int32 NameCompare = DisplayName.Compare(Other.DisplayName, ESearchCase::IgnoreCase);
+		if (NameCompare != 0)
+		{
+			return NameCompare < 0;
+		}
+		return Sequence < Other.Sequence;
+	}
+
+	bool operator==(const FFriendSortKeyEOS& Other) const
+	{
+		return Rank == Other.Rank && bIsPending == Other.bIsPending && Sequence == Other.Sequence && DisplayName.Equals(Other.DisplayName, ESearchCase::CaseSensitive);
+	}
+};
+
+/**
+ * The friends of a local user, along with a view of the named ones sorted by online state then display name.
+ * The view is kept up to date one friend at a time as their presence, invite status or name changes, so
+ * reading it never sorts. The online and playing this game lists are prefixes of it
+ */
 class FFriendsListEOS :
 	public TOnlinePlayerList<FOnlineFriendEOSRef, FOnlineFriendEOSPtr>
 {
 public:
 	FFriendsListEOS(int32 InLocalUserNum, FUniqueNetIdEOSRef InOwningNetId)
 		: TOnlinePlayerList<FOnlineFriendEOSRef, FOnlineFriendEOSPtr>(InLocalUserNum, InOwningNetId)
+		, NextSequence(0)
 	{
 	}
 	virtual ~FFriendsListEOS() = default;
+
+	void Add(EOS_EpicAccountId InAccountId, FOnlineFriendEOSRef InListEntry);
+
+	/** Moves a friend to where their current presence, invite status and name put them in the sorted view */
+	void UpdateSortOrder(EOS_EpicAccountId AccountId);
+
+	/** Friends with a display name, sorted, in the first GetNumSorted(List) entries */
+	const TArray<TPair<FFriendSortKeyEOS, FOnlineFriendEOSRef>>& GetSortedList() const
+	{
+		return SortedFriends;
+	}
+
+	/** @return how many of the sorted friends belong to one of the EFriendsLists */
+	int32 GetNumSorted(EFriendsLists::Type List) const;
+
+private:
+	/** @return the key for a friend as they are now, Sequence is left for the caller */
+	static FFriendSortKeyEOS MakeSortKey(const FOnlineFriendEOS& Friend);
+
+	/** @return the index of the first sorted friend that doesn't go before Key */
+	int32 LowerBound(const FFriendSortKeyEOS& Key) const;
+
+	/** Named friends in order */
+	TArray<TPair<FFriendSortKeyEOS, FOnlineFriendEOSRef>> SortedFriends;
+	struct FSortState
+	{
+		/** The key the friend was last sorted with */
+		FFriendSortKeyEOS Key;
+		/** False while they have no display name and are left out of the view */
+		bool bIsSorted;
+	};
+	TMap<EOS_EpicAccountId, FSortState> SortStates;
+	uint32 NextSequence;
 };
 
 typedef TSharedRef<FFriendsListEOS> FFriendsListEOSRef;
@@ -198,6 +274,109 @@ public:
 
 typedef TSharedRef<FRecentPlayersListEOS> FRecentPlayersListEOSRef;
 
+/** Index of a user in FUserRecordStoreEOS, INDEX_NONE for none */
+typedef int32 FUserHandleEOS;
+
+/**
+ * Everything known about one local or remote user
+ */
+struct FUserRecordEOS
+{
+	/** The "<EOS_EpicAccountId>|<EOS_ProductAccountId>" string carried by the user's net ids */
+	FString NetIdStr;
+	EOS_EpicAccountId AccountId;
+	/** Null for remote users until their external account mapping has been read */
+	EOS_ProductUserId ProductUserId;
+	/** The local user num of signed in users, INDEX_NONE for remote users */
+	int32 LocalUserNum;
+
+	FUniqueNetIdEOSPtr NetId;
+	/** The user account for local users, the user, friend, etc. entry for remote users */
+	FOnlineUserPtr OnlineUser;
+	IAttributeAccessInterfacePtr AttributeAccess;
+	/** Created the first time presence is read for the user */
+	TSharedPtr<FOnlineUserPresence> Presence;
+
+	/** Only set for local users */
+	FUserOnlineAccountEOSPtr UserAccount;
+	TSharedPtr<FFriendsListEOS> FriendsList;
+	TSharedPtr<FBlockedPlayersListEOS> BlockedPlayersList;
+	TSharedPtr<FRecentPlayersListEOS> RecentPlayersList;
+
+	FUserRecordEOS()
+		: AccountId(nullptr)
+		, ProductUserId(nullptr)
+		, LocalUserNum(INDEX_NONE)
+	{
+	}
+
+	bool IsLocal() const
+	{
+		return LocalUserNum != INDEX_NONE;
+	}
+};
+
+/**
+ * Holds one record per known user, addressed by handle, with an index per kind of id so that any id finds
+ * the user with a single lookup and learning a user's product user id only rekeys two indices
+ */
+class FUserRecordStoreEOS
+{
+public:
+	/**
+	 * Adds a user that isn't in the store yet
+	 *
+	 * @param NetIdStr the user's net id string
+	 * @param AccountId the user's epic account id
+	 * @param ProductUserId the user's product user id, may be null
+	 *
+	 * @return the handle of the new record
+	 */
+	FUserHandleEOS Add(const FString& NetIdStr, EOS_EpicAccountId AccountId, EOS_ProductUserId ProductUserId);
+	/** Removes a user, their handle may be reused by a later Add() */
+	void Remove(FUserHandleEOS Handle);
+	/** Sets a user's product user id along with the net id string that includes it */
+	void SetProductUserId(FUserHandleEOS Handle, EOS_ProductUserId ProductUserId, const FString& NetIdStr);
+
+	FUserHandleEOS FindHandle(const FString& NetIdStr) const;
+	FUserHandleEOS FindHandle(EOS_EpicAccountId AccountId) const;
+	FUserHandleEOS FindHandle(EOS_ProductUserId ProductUserId) const;
+
+	FUserRecordEOS* Get(FUserHandleEOS Handle)
+	{
+		return Records.IsValidIndex(Handle) ? &Records[Handle] : nullptr;
+	}
+
+	const FUserRecordEOS* Get(FUserHandleEOS Handle) const
+	{
+		return Records.IsValidIndex(Handle) ? &Records[Handle] : nullptr;
+	}
+
+	template<typename IdType>
+	FUserRecordEOS* Find(const IdType& Id)
+	{
+		return Get(FindHandle(Id));
+	}
+
+	template<typename IdType>
+	const FUserRecordEOS* Find(const IdType& Id) const
+	{
+		return Get(FindHandle(Id));
+	}
+
+	/** All records, for iterating over every known user */
+	const TSparseArray<FUserRecordEOS>& GetRecords() const
+	{
+		return Records;
+	}
+
+private:
+	TSparseArray<FUserRecordEOS> Records;
+	TMap<FString, FUserHandleEOS> NetIdStrToHandle;
+	TMap<EOS_EpicAccountId, FUserHandleEOS> AccountIdToHandle;
+	TMap<EOS_ProductUserId, FUserHandleEOS> ProductUserIdToHandle;
+};
+
 struct FNotificationIdCallbackPair
 {
 	EOS_NotificationId NotificationId;
@@ -341,6 +520,9 @@ PACKAGE_SCOPE:
 
 	int32 GetDefaultLocalUser() const { return DefaultLocalUser; }
 
+	/** Issues the remote player lookups gathered since the last tick and writes due presence updates */
+	void Tick(float DeltaTime);
+
 private:
 	void RemoveLocalUser(int32 LocalUserNum);
 	void AddLocalUser(int32 LocalUserNum, EOS_EpicAccountId EpicAccountId, EOS_ProductUserId UserId);
@@ -349,12 +531,20 @@ private:
 	void AddRemotePlayer(const FString& NetId, EOS_EpicAccountId EpicAccountId);
 	void AddRemotePlayer(const FString& NetId, EOS_EpicAccountId EpicAccountId, FUniqueNetIdEOSPtr UniqueNetId, FOnlineUserPtr OnlineUser, IAttributeAccessInterfaceRef AttributeRef);
 	void UpdateRemotePlayerProductUserId(EOS_EpicAccountId AccountId, EOS_ProductUserId UserId);
-	void ReadUserInfo(EOS_EpicAccountId EpicAccountId);
+	void ReadUserInfo(EOS_EpicAccountId EpicAccountId, FOnUserLookupCompleteEOS&& OnComplete);
 
 	void UpdateUserInfo(IAttributeAccessInterfaceRef AttriubteAccessRef, EOS_EpicAccountId LocalId, EOS_EpicAccountId TargetId);
 
 	void UpdatePresence(EOS_EpicAccountId AccountId);
-	void UpdateFriendPresence(const FString& FriendId, FOnlineUserPresenceRef Presence);
+	void UpdateFriendPresence(EOS_EpicAccountId FriendId, FOnlineUserPresenceRef Presence);
+	/** Repositions a friend in the sorted friend views of every local user that has them */
+	void UpdateFriendSortOrder(EOS_EpicAccountId FriendId);
+
+	FUserRecordEOS* GetLocalUserRecord(int32 LocalUserNum);
+	const FUserRecordEOS* GetLocalUserRecord(int32 LocalUserNum) const;
+	/** @return the record for a net id of any kind, converted to an EOS one when needed */
+	FUserRecordEOS* FindUserRecord(const FUniqueNetId& NetId);
+	const FUserRecordEOS* FindUserRecord(const FUniqueNetId& NetId) const;
 
 	/** Cached pointer to owning subsystem */
 	FOnlineSubsystemEOS* EOSSubsystem;
@@ -371,38 +561,17 @@ private:
 	FCallbackBase* PresenceNotificationCallback;
 	TMap<int32, FNotificationIdCallbackPair*> LocalUserNumToConnectLoginNotifcationMap;
 
-	/** Ids mapped to locally registered users */
-	TMap<int32, EOS_EpicAccountId> UserNumToAccountIdMap;
-	TMap<EOS_EpicAccountId, int32> AccountIdToUserNumMap;
-	TMap<int32, FUniqueNetIdEOSPtr> UserNumToNetIdMap;
-	TMap<int32, EOS_ProductUserId> UserNumToProductUserIdMap;
-	TMap<EOS_ProductUserId, int32> ProductUserIdToUserNumMap;
-	TMap<FString, FUserOnlineAccountEOSRef> StringToUserAccountMap;
-
-	/** General account mappings */
-	TMap<EOS_EpicAccountId, FString> AccountIdToStringMap;
-	TMap<EOS_ProductUserId, FString> ProductUserIdToStringMap;
-	TMap<FString, EOS_EpicAccountId> StringToAccountIdMap;
-	TMap<FString, EOS_ProductUserId> StringToProductUserIdMap;
-
-	/** Per user friends lists accessible by user num or net id */
-	TMap<int32, FFriendsListEOSRef> LocalUserNumToFriendsListMap;
-	TMap<FString, FFriendsListEOSRef> NetIdStringToFriendsListMap;
-	/** Per user blocked player lists accessible by user num or net id */
-	TMap<int32, FBlockedPlayersListEOSRef> LocalUserNumToBlockedPlayerListMap;
-	TMap<FString, FBlockedPlayersListEOSRef> NetIdStringToBlockedPlayerListMap;
-	/** Per user recent player lists accessible by user num or net id */
-	TMap<int32, FRecentPlayersListEOSRef> LocalUserNumToRecentPlayerListMap;
-	TMap<FString, FRecentPlayersListEOSRef> NetIdStringToRecentPlayerListMap;
-
-	/** Ids mapped to remote users */
-	TMap<FString, FOnlineUserPtr> NetIdStringToOnlineUserMap;
-	TMap<EOS_EpicAccountId, FOnlineUserPtr> EpicAccountIdToOnlineUserMap;
-	TMap<FString, IAttributeAccessInterfaceRef> NetIdStringToAttributeAccessMap;
-	TMap<EOS_EpicAccountId, IAttributeAccessInterfaceRef> EpicAccountIdToAttributeAccessMap;
-
-	/** Ids mapped to remote user presence */
-	TMap<FString, FOnlineUserPresenceRef> NetIdStringToOnlineUserPresenceMap;
+	/** Every local and remote user we know about */
+	FUserRecordStoreEOS UserRecords;
+	/** Handles of the signed in users by local user num */
+	TMap<int32, FUserHandleEOS> LocalUserHandles;
+
+	/** Gathers the info, presence and mapping lookups for remote players into fewer requests */
+	TUniquePtr<FUserLookupCoalescerEOS> UserLookups;
+	/** Diffs and throttles the local users' presence writes */
+	TUniquePtr<FPresenceUpdaterEOS> PresenceUpdater;
+
+	friend class FUserManagerLookupBackendEOS;
 };
 
 #endif